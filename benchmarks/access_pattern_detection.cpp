@@ -0,0 +1,55 @@
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "access_pattern_detection.h"
+#include "synthetic_data.h"
+
+using access_pattern_detection::AccessPattern;
+
+/* Largest nr of accesses, 1e8 accesses take up to 1.2 GB of memory (random offsets delta-encode worst), set
+ * OTFPROFILER_BENCH_MAX_ACCESSES to reduce it */
+static int64_t max_accesses() {
+	const char* env = std::getenv("OTFPROFILER_BENCH_MAX_ACCESSES");
+	return env ? std::stoll(env) : 100000000;
+}
+
+static void BM_DetectLocalAccessPattern(benchmark::State& state) {
+	const auto     pattern  = static_cast<AccessPattern>(state.range(0));
+	const uint64_t accesses = state.range(1);
+	state.SetLabel(access_pattern_detection::access_pattern_to_string(pattern));
+
+	const auto io_accesses = synthetic::make_accesses(pattern, accesses);
+	for (auto _ : state) {
+		auto result = access_pattern_detection::detect_local_access_pattern(io_accesses);
+		benchmark::DoNotOptimize(result);
+	}
+	state.SetItemsProcessed(state.iterations() * accesses);
+}
+BENCHMARK(BM_DetectLocalAccessPattern)
+	->Apply([](benchmark::internal::Benchmark* b) {
+		for (auto pattern : {AccessPattern::CONTIGUOUS, AccessPattern::STRIDED, AccessPattern::RANDOM})
+			for (int64_t accesses = 1000; accesses <= max_accesses(); accesses *= 10)
+				b->Args({static_cast<int64_t>(pattern), accesses});
+	})
+	->Unit(benchmark::kMillisecond);
+
+static void BM_DetectGlobalAccessPattern(benchmark::State& state) {
+	const uint64_t handles  = state.range(0);
+	const uint64_t accesses = 1000000;
+
+	// N-1 writes: each handle writes every `handles`-th block of the file
+	std::vector<IOAccesses> io_accesses(handles);
+	for (uint64_t i = 0; i < accesses; ++i)
+		io_accesses[i % handles].push_back(IoAccess{i * 100, i * 100 + 50, i * 4096, 4096, 50, false});
+	std::vector<const IOAccesses*> io_accesses_per_handle;
+	for (const auto& handle : io_accesses)
+		io_accesses_per_handle.push_back(&handle);
+
+	for (auto _ : state) {
+		auto result = access_pattern_detection::detect_global_access_pattern(io_accesses_per_handle);
+		benchmark::DoNotOptimize(result);
+	}
+	state.SetItemsProcessed(state.iterations() * accesses);
+}
+BENCHMARK(BM_DetectGlobalAccessPattern)->RangeMultiplier(16)->Range(1, 1 << 16)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,90 @@
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include "all_data.h"
+#include "create_json.h"
+#include "synthetic_data.h"
+
+using namespace definitions;
+
+namespace {
+
+/* AllData as left behind by reading a trace with `nodes` call-path nodes, `locations` locations (1 per process) and
+ * `handles` IoHandles (4 per file) */
+void fill_alldata(AllData& alldata, uint64_t nodes, uint64_t locations, uint64_t handles) {
+	synthetic::Rng rng(1);
+	auto&          defs = alldata.definitions;
+
+	alldata.metaData.timerResolution = 1000000000;
+	for (paradigm_id_t p = 0; p < 8; ++p)
+		defs.paradigms.add(p, {"PARADIGM_" + std::to_string(p)});
+	for (uint64_t r = 0; r < nodes; ++r)
+		defs.regions.add(r, {"region_" + std::to_string(r), static_cast<paradigm_id_t>(r % 8), 1, 2, "app.c"});
+
+	synthetic::build_call_tree(alldata.call_path_tree, nodes, locations);
+
+	defs.system_tree.insert_node("machine cluster", 0, SystemClass::MACHINE, (uint32_t)-1);
+	for (uint64_t l = 0; l < locations; ++l) {
+		defs.system_tree.insert_node("rank " + std::to_string(l), l, SystemClass::LOCATION_GROUP, 0);
+		defs.system_tree.insert_node("Master thread", l, SystemClass::LOCATION, l);
+	}
+
+	defs.io_paradigms.add(0, {"POSIX"});
+	auto& paradigm_io = alldata.io_data_per_paradigm[0];
+	for (OTF2_IoHandleRef h = 0; h < handles; ++h) {
+		const auto name            = "/scratch/file_" + std::to_string(h / 4);
+		auto [file_it, inserted]   = defs.filehandles.emplace(name, std::make_shared<File>(name));
+		file_it->second->io_handles.push_back(h);
+		defs.iohandles.add(h, {h, file_it->second, 0, h / 4, (uint32_t)-1});
+
+		auto* ioh     = defs.iohandles.get(h);
+		ioh->location = h % locations;
+		ioh->modes.insert("W");
+		ioh->io_data_stats.mode = "W";
+		for (uint64_t i = 0; i < 256; ++i) {
+			const uint64_t fpos = h % 3 == 2 ? rng.below(1 << 20) * 4096 : i * (h % 3 + 1) * 4096;
+			const IoAccess io{i * 100, i * 100 + 50, fpos, 4096, 50, false};
+			ioh->access_pattern_detector.add(io);
+			ioh->io_accesses.push_back(io);
+			ioh->io_data_stats.num_operations++;
+			ioh->io_data_stats.num_bytes += 4096;
+			ioh->io_data_stats.transfer_time += 50;
+		}
+		paradigm_io += ioh->io_data_stats;
+	}
+
+	for (uint64_t l = 0; l < locations; ++l) {
+		auto& io_data  = alldata.io_data_per_location[l];
+		io_data.mode   = "W";
+		io_data.region = l % nodes;
+		alldata.parent_regions_by_callcount[io_data.region][0] += 1;
+	}
+}
+
+}  // namespace
+
+static void BM_CreateJSON(benchmark::State& state) {
+	const uint64_t nodes     = state.range(0);
+	const uint64_t locations = state.range(1);
+	const uint64_t handles   = state.range(2);
+
+	AllData alldata;
+	fill_alldata(alldata, nodes, locations, handles);
+	const auto prefix = std::filesystem::temp_directory_path() / "otf-profiler-benchmark";
+	alldata.params.output_file_prefix = prefix.string();
+	alldata.params.create_json        = true;
+	alldata.params.create_binary      = false;
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize(CreateProfile(alldata));
+
+	std::error_code ec;
+	state.counters["json_bytes"] = std::filesystem::file_size(prefix.string() + ".json", ec);
+	std::filesystem::remove(prefix.string() + ".json", ec);
+}
+BENCHMARK(BM_CreateJSON)
+	->Args({1 << 10, 16, 64})
+	->Args({1 << 14, 64, 1024})
+	->Args({1 << 16, 256, 4096})
+	->Unit(benchmark::kMillisecond);
@@ -0,0 +1,92 @@
+#include <benchmark/benchmark.h>
+#include <map>
+#include <vector>
+#include "data_tree.h"
+#include "synthetic_data.h"
+
+/* One event worth of data per iteration, the locations take turns like in a trace read by location groups */
+static void BM_TreeNodeAddData(benchmark::State& state) {
+	const uint64_t locations = state.range(0);
+
+	data_tree  tree;
+	tree_node* node     = tree.get_node(1, nullptr);
+	uint64_t   location = 0;
+	for (auto _ : state) {
+		node->add_data(location, FunctionData{1, 10, 5});
+		if (++location == locations)
+			location = 0;
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TreeNodeAddData)->Arg(1)->Arg(64)->Arg(4096);
+
+static void BM_DataTreeInsertNode(benchmark::State& state) {
+	const uint64_t nodes = state.range(0);
+
+	for (auto _ : state) {
+		data_tree               tree;
+		synthetic::Rng          rng(1);
+		std::vector<tree_node*> inserted{tree.insert_node(0, nullptr)};
+		inserted.reserve(nodes);
+		for (uint64_t i = 1; i < nodes; ++i)
+			inserted.push_back(tree.insert_node(i, inserted[rng.below(inserted.size())]));
+		benchmark::DoNotOptimize(tree.size());
+	}
+	state.SetItemsProcessed(state.iterations() * nodes);
+}
+BENCHMARK(BM_DataTreeInsertNode)->RangeMultiplier(16)->Range(1 << 8, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+/* Trees of two readers with the same call paths (as read from the processes of an SPMD program) */
+static void BM_DataTreeMergeTree(benchmark::State& state) {
+	const uint64_t nodes = state.range(0);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		data_tree lhs, rhs;
+		synthetic::build_call_tree(lhs, nodes, 1);
+		synthetic::build_call_tree(rhs, nodes, 1);
+		state.ResumeTiming();
+
+		lhs.merge_tree(rhs);
+		benchmark::DoNotOptimize(lhs.size());
+	}
+	state.SetItemsProcessed(state.iterations() * nodes);
+}
+BENCHMARK(BM_DataTreeMergeTree)->RangeMultiplier(16)->Range(1 << 8, 1 << 20)->Unit(benchmark::kMicrosecond);
+
+static void BM_DataTreeSerializeData(benchmark::State& state) {
+	const uint64_t nodes     = state.range(0);
+	const uint64_t locations = state.range(1);
+
+	data_tree tree;
+	synthetic::build_call_tree(tree, nodes, locations);
+
+	for (auto _ : state) {
+		SerializedTree serialized;
+		tree.serialize_data(serialized);
+		benchmark::DoNotOptimize(serialized.functions.data());
+	}
+	state.SetItemsProcessed(state.iterations() * nodes * locations);
+}
+BENCHMARK(BM_DataTreeSerializeData)
+	->ArgsProduct({{1 << 10, 1 << 14, 1 << 18}, {1, 16}})
+	->Unit(benchmark::kMicrosecond);
+
+static void BM_DataTreeMergeSerializedData(benchmark::State& state) {
+	const uint64_t nodes     = state.range(0);
+	const uint64_t locations = state.range(1);
+
+	data_tree tree;
+	synthetic::build_call_tree(tree, nodes, locations);
+	SerializedTree serialized;
+	tree.serialize_data(serialized);
+
+	for (auto _ : state) {
+		data_tree rebuilt;
+		benchmark::DoNotOptimize(rebuilt.merge_serialized_data(serialized));
+	}
+	state.SetItemsProcessed(state.iterations() * nodes * locations);
+}
+BENCHMARK(BM_DataTreeMergeSerializedData)
+	->ArgsProduct({{1 << 10, 1 << 14, 1 << 18}, {1, 16}})
+	->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,126 @@
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/* Runs the otf-profiler binary on traces written by otf2-trace-generator (paths are set by CMake), each run in its own
+ * process so that its peak memory can be taken from the rusage of the child
+ * @note ru_maxrss of the child includes the memory of this process at fork time, which is why this is a separate
+ * executable that allocates next to nothing */
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/* Largest trace in events, set OTFPROFILER_BENCH_MAX_EVENTS to go beyond the default of 1e7 */
+int64_t max_events() {
+	const char* env = std::getenv("OTFPROFILER_BENCH_MAX_EVENTS");
+	return env ? std::stoll(env) : 10000000;
+}
+
+/* Generates the trace with (about) `events` events once, later runs reuse it from BENCHMARK_TRACE_DIR
+ * @return nr of events actually written, 0 on error */
+uint64_t generate_trace(int64_t events, const fs::path& dir) {
+	const fs::path count_file = dir.string() + ".events";
+	uint64_t       written    = 0;
+	if (std::ifstream in(count_file); in >> written && fs::exists(dir / "traces.otf2"))
+		return written;
+
+	fs::remove_all(dir);
+	const std::string command = std::string(OTF2_TRACE_GENERATOR) + " -o " + dir.string() + " -n " +
+		std::to_string(events) + " --seed 1 --processes 16 --threads 2 --io-handles 4 --metric-classes 1";
+	FILE* generator = popen(command.c_str(), "r");
+	if (generator == nullptr)
+		return 0;
+	char line[512];
+	while (fgets(line, sizeof(line), generator) != nullptr) {
+		unsigned long long n;
+		if (sscanf(line, "Wrote %llu events", &n) == 1)
+			written = n;
+	}
+	if (pclose(generator) != 0)
+		return 0;
+
+	std::ofstream(count_file) << written;
+	return written;
+}
+
+/* Runs `argv` with stdout discarded, returns false if it did not exit successfully */
+bool run(const std::vector<std::string>& args, struct rusage& usage) {
+	std::vector<char*> argv;
+	for (const auto& arg : args)
+		argv.push_back(const_cast<char*>(arg.c_str()));
+	argv.push_back(nullptr);
+
+	const pid_t pid = fork();
+	if (pid < 0)
+		return false;
+	if (pid == 0) {
+		const int devnull = open("/dev/null", O_WRONLY);
+		dup2(devnull, STDOUT_FILENO);
+		execv(argv[0], argv.data());
+		_exit(127);
+	}
+
+	int status = 0;
+	if (wait4(pid, &status, 0, &usage) < 0)
+		return false;
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+}  // namespace
+
+static void BM_EndToEnd(benchmark::State& state) {
+	const int64_t  events  = state.range(0);
+	const int64_t  threads = state.range(1);
+	const bool     io_only = state.range(2);
+	const fs::path trace   = fs::path(BENCHMARK_TRACE_DIR) / ("synthetic_" + std::to_string(events));
+
+	const uint64_t written = generate_trace(events, trace);
+	if (written == 0) {
+		state.SkipWithError("could not generate the trace");
+		return;
+	}
+
+	std::vector<std::string> args = {OTF_PROFILER_BINARY,   "-i", (trace / "traces.otf2").string(),
+	                                  "-o", (trace / "result").string(), "--threads", std::to_string(threads), "--json"};
+	if (io_only)
+		args.push_back("--io-only");
+
+	long peak_rss_kb = 0;
+	for (auto _ : state) {
+		struct rusage usage;
+		const auto    begin = std::chrono::steady_clock::now();
+		const bool    ok    = run(args, usage);
+		const auto    end   = std::chrono::steady_clock::now();
+		if (!ok) {
+			state.SkipWithError("otf-profiler failed");
+			return;
+		}
+		state.SetIterationTime(std::chrono::duration<double>(end - begin).count());
+		peak_rss_kb = std::max(peak_rss_kb, usage.ru_maxrss);
+	}
+
+	state.counters["events"]            = written;
+	state.counters["events_per_second"] = benchmark::Counter(written, benchmark::Counter::kIsIterationInvariantRate);
+	state.counters["peak_rss_MB"]       = peak_rss_kb / 1024.0;
+}
+BENCHMARK(BM_EndToEnd)
+	->Apply([](benchmark::internal::Benchmark* b) {
+		b->ArgNames({"events", "threads", "io_only"});
+		for (int64_t events = 1000000; events <= max_events(); events *= 10)
+			for (int64_t threads : {1, 4})
+				for (int64_t io_only : {0, 1})
+					b->Args({events, threads, io_only});
+	})
+	->UseManualTime()
+	->Unit(benchmark::kSecond)
+	->Iterations(3);
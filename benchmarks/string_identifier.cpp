@@ -0,0 +1,53 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "OTF2Reader.h"
+#include "synthetic_data.h"
+
+/* String refs of a trace with `strings` definitions, looked up in random order like the definition callbacks do */
+static void BM_StringIdentifierGet(benchmark::State& state) {
+	const uint64_t strings = state.range(0);
+
+	StringIdentifier<OTF2_StringRef> string_id;
+	for (uint64_t ref = 0; ref < strings; ++ref)
+		string_id.add(ref, "region_" + std::to_string(ref));
+
+	synthetic::Rng              rng(1);
+	std::vector<OTF2_StringRef> refs(1 << 16);
+	for (auto& ref : refs)
+		ref = rng.below(strings);
+
+	size_t next = 0;
+	for (auto _ : state) {
+		auto result = string_id.get(refs[next]);
+		benchmark::DoNotOptimize(result);
+		next = (next + 1) & (refs.size() - 1);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StringIdentifierGet)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
+
+/* Regions resolve their name, canonical name and file in one call */
+static void BM_StringIdentifierGetThree(benchmark::State& state) {
+	const uint64_t strings = state.range(0);
+
+	StringIdentifier<OTF2_StringRef> string_id;
+	for (uint64_t ref = 0; ref < strings; ++ref)
+		string_id.add(ref, "region_" + std::to_string(ref));
+
+	synthetic::Rng              rng(1);
+	std::vector<OTF2_StringRef> refs(1 << 16);
+	for (auto& ref : refs)
+		ref = rng.below(strings);
+
+	size_t next = 0;
+	for (auto _ : state) {
+		auto result = string_id.get(refs[next], refs[next + 1], refs[next + 2]);
+		benchmark::DoNotOptimize(result);
+		next += 3;
+		if (next + 3 > refs.size())
+			next = 0;
+	}
+	state.SetItemsProcessed(state.iterations() * 3);
+}
+BENCHMARK(BM_StringIdentifierGetThree)->RangeMultiplier(16)->Range(1 << 8, 1 << 20);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+#include "access_pattern_detection.h"
+#include "data_tree.h"
+
+/* Deterministic inputs of the benchmarks */
+namespace synthetic {
+
+/* splitmix64, same stream on every platform */
+class Rng {
+   public:
+    explicit Rng(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z          = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z          = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    /** Uniform in [0, n) */
+    uint64_t below(uint64_t n) { return n > 0 ? next() % n : 0; }
+
+   private:
+    uint64_t state;
+};
+
+/** Adds a call tree of `nodes` nodes (below one root) with function data of `locations` locations to `tree`
+ * - the parent of a node is one of the nodes inserted before, so the shape only depends on `seed` */
+inline void build_call_tree(data_tree& tree, uint64_t nodes, uint64_t locations, uint64_t seed = 1) {
+    Rng                     rng(seed);
+    std::vector<tree_node*> inserted;
+    inserted.reserve(nodes);
+
+    inserted.push_back(tree.get_node(0, nullptr));
+    for (uint64_t i = 1; i < nodes; ++i)
+        inserted.push_back(tree.get_node(i, inserted[rng.below(inserted.size())]));
+
+    for (auto* node : inserted)
+        for (uint64_t location = 0; location < locations; ++location)
+            node->add_data(location, FunctionData{1 + rng.below(100), 1000, 1 + rng.below(1000)});
+}
+
+/** `n` accesses of 4 KiB each, issued every 100 ticks */
+inline IOAccesses make_accesses(access_pattern_detection::AccessPattern pattern, uint64_t n, uint64_t seed = 1) {
+    using access_pattern_detection::AccessPattern;
+    constexpr uint64_t SIZE = 4096;
+
+    Rng        rng(seed);
+    IOAccesses accesses;
+    for (uint64_t i = 0; i < n; ++i) {
+        uint64_t fpos;
+        switch (pattern) {
+            case AccessPattern::CONTIGUOUS:
+                fpos = i * SIZE;
+                break;
+            case AccessPattern::STRIDED:
+                fpos = i * 8 * SIZE;
+                break;
+            default:
+                fpos = rng.below(1 << 20) * SIZE;
+                break;
+        }
+        accesses.push_back(IoAccess{i * 100, i * 100 + 50, fpos, SIZE, 50, false});
+    }
+    return accesses;
+}
+
+}  // namespace synthetic
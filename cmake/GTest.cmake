@@ -12,7 +12,21 @@ set(gtest_force_shared_crt ON CACHE BOOL "" FORCE)
 
 FetchContent_MakeAvailable(googletest)
 
-add_executable(my_tests ${CMAKE_CURRENT_SOURCE_DIR}/tests/unittests/detect_local_access_pattern.cpp)
+add_executable(my_tests
+	${CMAKE_CURRENT_SOURCE_DIR}/tests/unittests/detect_local_access_pattern.cpp
+	${CMAKE_CURRENT_SOURCE_DIR}/tests/unittests/detect_global_access_pattern.cpp
+	${CMAKE_CURRENT_SOURCE_DIR}/tests/unittests/location_scheduler.cpp
+	${CMAKE_CURRENT_SOURCE_DIR}/tests/unittests/io_accesses.cpp
+	${CMAKE_CURRENT_SOURCE_DIR}/tests/unittests/data_tree.cpp
+	${CMAKE_CURRENT_SOURCE_DIR}/tests/unittests/dense_id_map.cpp
+	${CMAKE_CURRENT_SOURCE_DIR}/tests/unittests/time_window.cpp
+	${CMAKE_CURRENT_SOURCE_DIR}/tests/unittests/id_ranges.cpp
+	${CMAKE_CURRENT_SOURCE_DIR}/tests/unittests/definitions_cache.cpp
+	${CMAKE_CURRENT_SOURCE_DIR}/tests/unittests/progress_reporter.cpp
+	${CMAKE_CURRENT_SOURCE_DIR}/tests/unittests/time_measurement.cpp
+	${CMAKE_CURRENT_SOURCE_DIR}/tests/unittests/binary_profile.cpp
+	${CMAKE_CURRENT_SOURCE_DIR}/tests/unittests/reduce_io_data.cpp
+)
 
 add_test(
 	NAME unittests
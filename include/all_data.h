@@ -29,6 +29,12 @@ struct AllData {
     /* program parameters */
     Params params;
 
+    /* Analysed time window (absolute timestamps), resolved from --begin/--end by @ref resolveTimeWindow
+     * - the call-path tree & I/O statistics only contain the time spent inside the window
+     * - events before the window are only used to keep track of the open regions and file positions
+     * */
+    TimeWindow time_window;
+
     /* runtime measurement */
     TimeMeasurement tm;
 
@@ -52,6 +58,21 @@ struct AllData {
         metaData.numRanks = num_ranks;
     }
 
+    /* Resolves --begin/--end into `time_window`, needs the clock properties of the trace */
+    bool resolveTimeWindow() {
+        if (params.window_begin.set)
+            time_window.begin = params.window_begin.resolve(metaData.timerResolution, metaData.globalOffset);
+        if (params.window_end.set)
+            time_window.end = params.window_end.resolve(metaData.timerResolution, metaData.globalOffset);
+
+        if (time_window.begin >= time_window.end) {
+            std::cerr << "ERROR: Empty time window, --begin has to be before --end." << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
     void verbosePrint(uint8_t vlevel, bool master_only, std::string msg) {
         if (params.verbose_level < vlevel)
             return;
@@ -4,9 +4,14 @@
 #include <boost/container_hash/hash.hpp>
 #include <cassert>
 #include <cstdint>
+#include <optional>
+#include <sstream>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "io_accesses.h"
+
 struct AllData;
 // forward declaration
 namespace definitions {
@@ -14,20 +19,8 @@ namespace definitions {
 
 }
 
-struct IoAccess {
-	uint64_t start_time_ns;
-	uint64_t end_time_ns;
-	uint64_t fpos;
-	uint64_t size;
-	uint64_t duration;
-	bool is_meta;
-};
-
 using Fpos = uint64_t;
 using StartTime = OTF2_TimeStamp;
-/** vector of (endTime, (fpos,request_size,startTime)) */
-// using IOAccesses = std::vector<std::pair<OTF2_TimeStamp, std::tuple<Fpos,size_t,StartTime>>>;
-using IOAccesses = std::vector<IoAccess>;
 using TimeInterval = std::pair<OTF2_TimeStamp,OTF2_TimeStamp>;
 
 namespace access_pattern_detection {
@@ -150,6 +143,104 @@ struct AnalysisResult {
 	}
 };
 
+/**
+ * @brief Classes of the accesses of an @ref IoAccessBlock as bitsets (bit `i%64` of word `i/64` = access `i`), computed
+ * in one (vectorized) pass so the detection can skip over runs of accesses that don't change its state
+ *
+ * Only accesses `i>=2` that are no meta operations are classified, since the state transitions depend on the access
+ * and its 2 predecessors (see `detect_access_pattern_from_3_acccesses`)
+ */
+struct AccessClasses {
+	static constexpr size_t WORDS = IoAccessBlock::CAPACITY / 64;
+
+	/** Access continues where the previous one ended (`fpos[i-1]+size[i-1]==fpos[i]`) -> stays CONTIGUOUS */
+	uint64_t contiguous[WORDS];
+	/** Access is equi-distant to its predecessors, but the live pattern is not CONTIGUOUS -> stays STRIDED */
+	uint64_t strided[WORDS];
+	/** Live pattern is RANDOM -> stays RANDOM */
+	uint64_t random[WORDS];
+};
+
+/** Classifies the accesses of `block` with AVX2 or SSE4.1 if supported by the CPU */
+void classify_accesses(const IoAccessBlock& block, AccessClasses& classes);
+/** Same as @ref classify_accesses without SIMD instructions */
+void classify_accesses_scalar(const IoAccessBlock& block, AccessClasses& classes);
+
+/** Vectorized classifications, @ref classify_accesses picks the widest one the CPU supports */
+enum class ClassifySimd { SSE41, AVX2 };
+/** Same as @ref classify_accesses with the instruction set `simd` (so every path can be tested on a CPU with AVX2)
+ * @returns false if `simd` is not compiled in or not supported by the CPU, `classes` is not set then */
+bool classify_accesses(ClassifySimd simd, const IoAccessBlock& block, AccessClasses& classes);
+
+/**
+ * @brief Detects the local access pattern of a single IoHandle while its I/O accesses are read (see
+ * @ref detect_local_access_pattern for the detected patterns)
+ *
+ * Instead of storing all I/O accesses, only the last @ref NR_ACCESSES_THRESHOLD accesses (as ringbuffer) and the
+ * statistics of the interval that is currently being detected are kept.
+ * - accesses ending at the same time as the most recent one are held back until an access with a later end time
+ *   arrives (the detection treats accesses ending at the timestamp of the very last access differently)
+ *   -> I/O accesses are expected to be added in order of their end time
+ */
+class LocalAccessPatternDetector {
+   public:
+	/** Feeds the next I/O access (in the order they have been performed in) into the detection */
+	void add(const IoAccess& io);
+	/** Same as adding all accesses of `block` one by one, but skips over runs of accesses that keep the current
+	 * pattern (see @ref AccessClasses) */
+	void add(const IoAccessBlock& block);
+
+	/** Nr of I/O accesses added so far */
+	uint64_t size() const { return nr_accesses; }
+
+	/** Returns the access pattern of all I/O accesses added so far, more accesses can be added afterwards */
+	AnalysisResult result() const;
+
+	/** Adds the accesses detected by `rhs` (eg on a reader-local copy of the same IoHandle)
+	 * - if accesses were already added to both detectors, their accesses are analyzed as two separate streams
+	 */
+	void merge(const LocalAccessPatternDetector& rhs);
+	/** Adds the result of a stream that has been analyzed elsewhere (eg by another MPI rank, see reduce_io_data.h) */
+	void merge(const AnalysisResult& rhs);
+
+   private:
+	/** Processes one I/O access after the first @ref NR_ACCESSES_THRESHOLD accesses
+	 * @returns true if `io` has to be processed once more (as first access of a new interval)
+	 */
+	bool step(const IoAccess& io, bool is_last, bool ends_at_last_timestamp);
+	/** Processes all held back accesses */
+	void flush_pending(bool at_end);
+	/** Processes the accesses `[from,to)` of `block` (none of them ends at the timestamp of the last access) */
+	void process(const IoAccessBlock& block, const AccessClasses& classes, size_t from, size_t to);
+	/** Moves the ringbuffer forward over the accesses `[from,to)` of `block` as if they had been processed one by one */
+	void skip(const IoAccessBlock& block, size_t from, size_t to);
+	/** Checks in the remaining accesses, called on a copy in @ref result */
+	AnalysisResult finish();
+
+	uint64_t nr_accesses = 0;
+	/** Accesses not yet processed since they (might) end at the timestamp of the last access */
+	std::vector<IoAccess> pending;
+	/** End of the access processed last (meta operations included) */
+	OTF2_TimeStamp prev_end_time = 0;
+	/** Results of other, separately analyzed streams (see @ref merge) */
+	std::optional<AnalysisResult> merged;
+
+	std::unordered_map<TimeInterval, AccessPattern, pair_hash> pattern_per_timeinterval;
+	std::unordered_map<AccessPattern, PatternStatistics> stats_per_pattern;
+
+	IoAccess last_x_accesses[NR_ACCESSES_THRESHOLD];
+	short id_into_last_x_accesses = 2;
+	OTF2_TimeStamp interval_start = 0;
+	OTF2_TimeStamp last_x_accesses_prev_interval_end = 0;
+	bool is_equi_distant = false;
+	uint64_t next_fpos_if_contiguous = 0;
+	uint64_t nr_io_access_in_current_access_pattern = 0;
+	uint64_t last_fpos_distance = 0;
+	PatternStatistics curr_stats{0, 0};
+	AccessPattern curr_pattern = AccessPattern::NONE;
+	bool do_start_new_interval = false;
+};
+
 /**
  * @brief Returns access pattern based on the sequentially ordered offsets and I/O sizes requested by the single location
  *
@@ -166,14 +257,19 @@ struct AnalysisResult {
  *		- @ref AccessPattern::RANDOM if none of the above conditions are met
  *		- `EQUALLY_SIZED`-variants if @ref ALMOST_EQUAL_THRESHOLD of differences between offsets are equal
  */
-AnalysisResult detect_local_access_pattern(IOAccesses& io_accesses);
+AnalysisResult detect_local_access_pattern(const IOAccesses& io_accesses);
 
 /**
  * @brief Returns access pattern based on the sequentially ordered offsets and I/O sizes requested by all locations onto a single file
  *
- * @param offsets (Absolute) Offsets in the same ordered they have been requested by the location via e.g. seeking
- * @param size Request I/O sizes in the same ordered they have been requested by the location during read/write
+ * The accesses of all IoHandles are merged by their end time (k-way merge via a min-heap, O(N log k) for N accesses on
+ * k handles) and fed into the same detection as @ref detect_local_access_pattern, without copying them
+ *
+ * @param io_accesses_per_handle I/O accesses of each IoHandle, each in the order they have been performed in
  */
-AccessPattern detect_global_access_pattern(AllData& alldata, definitions::File* file);
+AnalysisResult detect_global_access_pattern(const std::vector<const IOAccesses*>& io_accesses_per_handle);
+
+/** @brief Returns the global access pattern on `file` from the I/O accesses of all its IoHandles (see @ref File::io_handles) */
+AnalysisResult detect_global_access_pattern(const AllData& alldata, const definitions::File& file);
 
 } // namespace access_pattern_detection
@@ -0,0 +1,359 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+struct IoAccess {
+	uint64_t start_time_ns;
+	uint64_t end_time_ns;
+	uint64_t fpos;
+	uint64_t size;
+	uint64_t duration;
+	bool is_meta;
+};
+
+/** Up to @ref CAPACITY consecutive I/O accesses stored column-wise, to be processed in bulk (see @ref IOAccesses::BlockReader) */
+struct IoAccessBlock {
+	static constexpr size_t CAPACITY = 256;
+
+	size_t   nr_accesses = 0;
+	uint64_t start_time_ns[CAPACITY];
+	uint64_t end_time_ns[CAPACITY];
+	uint64_t fpos[CAPACITY];
+	uint64_t size[CAPACITY];
+	uint64_t duration[CAPACITY];
+	/** bitset: bit `i%64` of word `i/64` is set if access `i` is a meta operation */
+	uint64_t is_meta[CAPACITY / 64];
+
+	bool full() const { return nr_accesses == CAPACITY; }
+	bool meta(size_t i) const { return (is_meta[i / 64] >> (i % 64)) & 1; }
+
+	IoAccess operator[](size_t i) const {
+		return IoAccess{start_time_ns[i], end_time_ns[i], fpos[i], size[i], duration[i], meta(i)};
+	}
+
+	void push_back(const IoAccess& io) {
+		start_time_ns[nr_accesses] = io.start_time_ns;
+		end_time_ns[nr_accesses]   = io.end_time_ns;
+		fpos[nr_accesses]          = io.fpos;
+		size[nr_accesses]          = io.size;
+		duration[nr_accesses]      = io.duration;
+		if (nr_accesses % 64 == 0)
+			is_meta[nr_accesses / 64] = 0;
+		is_meta[nr_accesses / 64] |= static_cast<uint64_t>(io.is_meta) << (nr_accesses % 64);
+		++nr_accesses;
+	}
+};
+
+/**
+ * @brief Columnar storage of all I/O accesses performed on an IoHandle (in the order they have been performed in)
+ *
+ * Every field of @ref IoAccess is stored in its own column:
+ * - `start_time_ns`: difference to the start of the previous access, stored as difference to the previous difference
+ *   (so accesses issued at a regular interval take a single byte)
+ * - `end_time_ns`: difference to its own start, stored as difference to that of the previous access
+ * - `fpos`: difference to the end of the previous access (`fpos+size`), so contiguous accesses take a single byte
+ * - `size`: index into a dictionary of all requested sizes
+ * - `duration`: difference to the duration of the previous access
+ * - `is_meta`: bitset
+ * All differences are zigzag-encoded and stored as varint (7 bit per byte).
+ *
+ * Accesses can only be appended and read sequentially via @ref const_iterator, or block-wise via @ref BlockReader.
+ */
+class IOAccesses {
+   public:
+	class const_iterator {
+	   public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type        = IoAccess;
+		using difference_type   = std::ptrdiff_t;
+		using pointer           = const IoAccess*;
+		using reference         = const IoAccess&;
+
+		const_iterator() = default;
+
+		reference operator*() const { return current; }
+		pointer operator->() const { return &current; }
+
+		const_iterator& operator++() {
+			++index;
+			decode();
+			return *this;
+		}
+		const_iterator operator++(int) {
+			auto tmp = *this;
+			++*this;
+			return tmp;
+		}
+
+		bool operator==(const const_iterator& other) const { return index == other.index; }
+		bool operator!=(const const_iterator& other) const { return index != other.index; }
+
+	   private:
+		friend class IOAccesses;
+
+		const_iterator(const IOAccesses* accesses, size_t index) : accesses(accesses), index(index) { decode(); }
+
+		/** Decodes access `index` (called in order, so the previous access is still in `current`) */
+		void decode() {
+			if (index >= accesses->nr_accesses)
+				return;
+
+			uint64_t prev_end_fpos = current.fpos + current.size;
+			start_delta += unzigzag(read_varint(accesses->start_times.data(), start_pos, accesses->start_times.size()));
+			end_delta += unzigzag(read_varint(accesses->end_times.data(), end_pos, accesses->end_times.size()));
+			current.start_time_ns += start_delta;
+			current.end_time_ns = current.start_time_ns + end_delta;
+			current.fpos        = prev_end_fpos + unzigzag(read_varint(accesses->fposs.data(), fpos_pos, accesses->fposs.size()));
+			current.size        = accesses->size_dictionary[read_varint(accesses->sizes.data(), size_pos, accesses->sizes.size())];
+			current.duration += unzigzag(read_varint(accesses->durations.data(), duration_pos, accesses->durations.size()));
+			current.is_meta = (accesses->is_meta[index / 64] >> (index % 64)) & 1;
+		}
+
+		const IOAccesses* accesses = nullptr;
+		size_t            index    = 0;
+		IoAccess          current{0, 0, 0, 0, 0, false};
+		uint64_t          start_delta = 0, end_delta = 0;
+		size_t            start_pos = 0, end_pos = 0, fpos_pos = 0, size_pos = 0, duration_pos = 0;
+	};
+
+	/** Decodes the accesses block by block into columns (see @ref IoAccessBlock) */
+	class BlockReader {
+	   public:
+		BlockReader(const IOAccesses& accesses) : accesses(accesses) {}
+
+		/** Decodes the next (up to @ref IoAccessBlock::CAPACITY) accesses into `block`, false if all have been read
+		 * - the running state is kept in locals, since the compiler has to assume that writes into `block` alias it */
+		bool next(IoAccessBlock& block) {
+			const size_t n = std::min(IoAccessBlock::CAPACITY, accesses.nr_accesses - index);
+			block.nr_accesses = n;
+			if (n == 0)
+				return false;
+
+			const uint8_t*  start_times     = accesses.start_times.data();
+			const uint8_t*  end_times       = accesses.end_times.data();
+			const uint8_t*  fposs           = accesses.fposs.data();
+			const uint8_t*  sizes           = accesses.sizes.data();
+			const uint8_t*  durations       = accesses.durations.data();
+			const uint64_t* size_dictionary = accesses.size_dictionary.data();
+			const size_t start_times_size = accesses.start_times.size(), end_times_size = accesses.end_times.size(),
+						 fposs_size = accesses.fposs.size(), sizes_size = accesses.sizes.size(),
+						 durations_size = accesses.durations.size();
+
+			size_t   start_pos = this->start_pos, end_pos = this->end_pos, fpos_pos = this->fpos_pos,
+				   size_pos = this->size_pos, duration_pos = this->duration_pos;
+			uint64_t start_delta = this->start_delta, end_delta = this->end_delta;
+			uint64_t start_time = last.start_time_ns, end_fpos = last.fpos + last.size, duration = last.duration;
+			for (size_t i = 0; i < n; ++i) {
+				start_delta += unzigzag(read_varint(start_times, start_pos, start_times_size));
+				end_delta += unzigzag(read_varint(end_times, end_pos, end_times_size));
+				start_time += start_delta;
+				block.start_time_ns[i] = start_time;
+				block.end_time_ns[i]   = start_time + end_delta;
+
+				const uint64_t size = size_dictionary[read_varint(sizes, size_pos, sizes_size)];
+				block.fpos[i]       = end_fpos + unzigzag(read_varint(fposs, fpos_pos, fposs_size));
+				block.size[i]       = size;
+				end_fpos            = block.fpos[i] + size;
+
+				duration += unzigzag(read_varint(durations, duration_pos, durations_size));
+				block.duration[i] = duration;
+			}
+			// blocks start at multiples of the capacity, so the bitset can be copied word by word
+			std::memcpy(block.is_meta, accesses.is_meta.data() + index / 64, (n + 63) / 64 * sizeof(uint64_t));
+
+			this->start_pos    = start_pos;
+			this->end_pos      = end_pos;
+			this->fpos_pos     = fpos_pos;
+			this->size_pos     = size_pos;
+			this->duration_pos = duration_pos;
+			this->start_delta  = start_delta;
+			this->end_delta    = end_delta;
+			last.start_time_ns = start_time;
+			last.fpos          = block.fpos[n - 1];
+			last.size          = block.size[n - 1];
+			last.duration      = duration;
+			index += n;
+			return true;
+		}
+
+	   private:
+		const IOAccesses& accesses;
+		size_t            index = 0;
+		IoAccess          last{0, 0, 0, 0, 0, false};
+		uint64_t          start_delta = 0, end_delta = 0;
+		size_t            start_pos = 0, end_pos = 0, fpos_pos = 0, size_pos = 0, duration_pos = 0;
+	};
+
+	IOAccesses() = default;
+	IOAccesses(std::initializer_list<IoAccess> accesses) {
+		for (const auto& io : accesses)
+			push_back(io);
+	}
+
+	void push_back(const IoAccess& io) {
+		uint64_t start_delta = io.start_time_ns - last.start_time_ns;
+		uint64_t end_delta   = io.end_time_ns - io.start_time_ns;
+		write_varint(start_times, zigzag(start_delta - last_start_delta));
+		write_varint(end_times, zigzag(end_delta - last_end_delta));
+		last_start_delta = start_delta;
+		last_end_delta   = end_delta;
+		write_varint(fposs, zigzag(io.fpos - (last.fpos + last.size)));
+
+		auto [size_it, inserted] = size_index.emplace(io.size, size_dictionary.size());
+		if (inserted)
+			size_dictionary.push_back(io.size);
+		write_varint(sizes, size_it->second);
+
+		write_varint(durations, zigzag(io.duration - last.duration));
+
+		if (nr_accesses % 64 == 0)
+			is_meta.push_back(0);
+		is_meta.back() |= static_cast<uint64_t>(io.is_meta) << (nr_accesses % 64);
+
+		last = io;
+		++nr_accesses;
+	}
+
+	/** Appends all accesses of `other` */
+	void append(const IOAccesses& other) {
+		for (const auto& io : other)
+			push_back(io);
+	}
+
+	size_t size() const { return nr_accesses; }
+	bool empty() const { return nr_accesses == 0; }
+
+	/** Last access that has been added */
+	const IoAccess& back() const { return last; }
+
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, nr_accesses); }
+
+	/** Nr of bytes allocated to store the accesses */
+	size_t memory_usage() const {
+		return start_times.capacity() + end_times.capacity() + fposs.capacity() + sizes.capacity() +
+			   durations.capacity() + is_meta.capacity() * sizeof(uint64_t) +
+			   size_dictionary.capacity() * sizeof(uint64_t) +
+			   size_index.size() * (sizeof(uint64_t) + sizeof(uint32_t) + 2 * sizeof(void*));
+	}
+
+	/** Appends the encoded accesses to `out` as they are (eg to send them to another MPI rank), see @ref deserialize */
+	void serialize(std::vector<uint8_t>& out) const {
+		const uint64_t header[] = {nr_accesses, last.start_time_ns, last.end_time_ns, last.fpos, last.size,
+								   last.duration, last.is_meta, last_start_delta, last_end_delta, start_times.size(),
+								   end_times.size(), fposs.size(), sizes.size(), durations.size(),
+								   size_dictionary.size()};
+		append_bytes(out, header, sizeof(header));
+		append_bytes(out, start_times.data(), start_times.size());
+		append_bytes(out, end_times.data(), end_times.size());
+		append_bytes(out, fposs.data(), fposs.size());
+		append_bytes(out, sizes.data(), sizes.size());
+		append_bytes(out, durations.data(), durations.size());
+		append_bytes(out, is_meta.data(), is_meta.size() * sizeof(uint64_t));
+		append_bytes(out, size_dictionary.data(), size_dictionary.size() * sizeof(uint64_t));
+	}
+
+	/** Replaces the accesses by those written by @ref serialize at `pos` of `data` (`size` bytes) & advances `pos`
+	 * @returns false if `data` is too short
+	 */
+	bool deserialize(const uint8_t* data, size_t size, size_t& pos) {
+		uint64_t header[15];
+		if (!read_bytes(data, size, pos, header, std::size(header)))
+			return false;
+		*this       = IOAccesses();
+		nr_accesses = header[0];
+		last        = IoAccess{header[1], header[2], header[3], header[4], header[5], header[6] != 0};
+		last_start_delta = header[7];
+		last_end_delta   = header[8];
+		if (!read_bytes(data, size, pos, start_times, header[9]) || !read_bytes(data, size, pos, end_times, header[10]) ||
+			!read_bytes(data, size, pos, fposs, header[11]) || !read_bytes(data, size, pos, sizes, header[12]) ||
+			!read_bytes(data, size, pos, durations, header[13]) ||
+			!read_bytes(data, size, pos, is_meta, (nr_accesses + 63) / 64) ||
+			!read_bytes(data, size, pos, size_dictionary, header[14]))
+			return false;
+		for (uint32_t i = 0; i < size_dictionary.size(); ++i)
+			size_index.emplace(size_dictionary[i], i);
+		return true;
+	}
+
+   private:
+	static void append_bytes(std::vector<uint8_t>& out, const void* data, size_t size) {
+		const auto* bytes = static_cast<const uint8_t*>(data);
+		out.insert(out.end(), bytes, bytes + size);
+	}
+	/** Reads `count` values of type `T` into `values` (a fixed-size array or vector) */
+	template <typename T>
+	static bool read_bytes(const uint8_t* data, size_t size, size_t& pos, T& values, uint64_t count) {
+		const size_t elem_size = sizeof(values[0]);
+		if (pos > size || count > (size - pos) / elem_size)
+			return false;
+		if constexpr (!std::is_array_v<T>)
+			values.resize(count);
+		if (count > 0)
+			std::memcpy(std::data(values), data + pos, count * elem_size);
+		pos += count * elem_size;
+		return true;
+	}
+
+	static uint64_t zigzag(uint64_t delta) {
+		return (delta << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(delta) >> 63);
+	}
+	static uint64_t unzigzag(uint64_t value) { return (value >> 1) ^ (~(value & 1) + 1); }
+
+	static void write_varint(std::vector<uint8_t>& column, uint64_t value) {
+		while (value >= 0x80) {
+			column.push_back(static_cast<uint8_t>(value) | 0x80);
+			value >>= 7;
+		}
+		column.push_back(static_cast<uint8_t>(value));
+	}
+	static uint64_t read_varint(const uint8_t* column, size_t& pos) {
+		uint64_t value = column[pos] & 0x7f;
+		for (unsigned shift = 7; column[pos++] & 0x80; shift += 7)
+			value |= static_cast<uint64_t>(column[pos] & 0x7f) << shift;
+		return value;
+	}
+	/** Same as above, but decodes varints of up to 8 bytes without a loop if 8 bytes can be read at `pos` */
+	static uint64_t read_varint(const uint8_t* column, size_t& pos, size_t column_size) {
+		if (column[pos] < 0x80) // most differences are small
+			return column[pos++];
+		uint64_t word;
+		if (pos + 8 > column_size)
+			return read_varint(column, pos);
+		std::memcpy(&word, column + pos, 8);
+		const uint64_t last_bytes = ~word & 0x8080808080808080ULL;
+		if (last_bytes == 0)
+			return read_varint(column, pos);
+
+		const unsigned bits = std::countr_zero(last_bytes) + 1;
+		pos += bits / 8;
+		word &= bits == 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+		// concatenate the 7 bit groups
+		word = (word & 0x007f007f007f007fULL) | ((word & 0x7f007f007f007f00ULL) >> 1);
+		word = (word & 0x00003fff00003fffULL) | ((word & 0x3fff00003fff0000ULL) >> 2);
+		return (word & 0x000000000fffffffULL) | ((word & 0x0fffffff00000000ULL) >> 4);
+	}
+
+	size_t   nr_accesses = 0;
+	IoAccess last{0, 0, 0, 0, 0, false};
+	uint64_t last_start_delta = 0, last_end_delta = 0;
+
+	std::vector<uint8_t>  start_times;
+	std::vector<uint8_t>  end_times;
+	std::vector<uint8_t>  fposs;
+	std::vector<uint8_t>  sizes;
+	std::vector<uint8_t>  durations;
+	std::vector<uint64_t> is_meta;
+
+	std::vector<uint64_t>                  size_dictionary;
+	std::unordered_map<uint64_t, uint32_t> size_index;
+};
@@ -8,48 +8,251 @@
 
 #include "main_structs.h"
 
-#include <deque>
+#include <algorithm>
+#include <cassert>
 #include <memory>
-#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 class tree_iter;
 class tree_node;
 
 /**
- * Used for storing call-path of regions (=functions)
+ * Call-path tree & its data as contiguous arrays of trivially copyable records (one array per kind of data), the
+ * format in which ReduceData sends a tree to another rank
+ * - nodes are numbered by their index in the tree, so parents come before their children & siblings keep their order
+ * - message & collop data is only stored for nodes that have such data (see `tree_node::has_p2p`/`has_collop`)
  */
-class data_tree {
+struct SerializedTree {
+    static constexpr uint64_t NO_PARENT = (uint64_t)-1;
+
+    struct Node {
+        uint64_t function_id;
+        uint64_t parent;
+    };
+
+    struct Function {
+        uint64_t     node;
+        uint64_t     location;
+        FunctionData data;
+    };
+
+    struct Message {
+        uint64_t    node;
+        uint64_t    location;
+        MessageData data;
+    };
+
+    struct Collop {
+        uint64_t   node;
+        uint64_t   location;
+        CollopData data;
+    };
+
+    struct Metric {
+        uint64_t   node;
+        uint64_t   location;
+        uint64_t   metric_id;
+        MetricData data;
+    };
+
+    std::vector<Node>     nodes;
+    std::vector<Function> functions;
+    std::vector<Message>  messages;
+    std::vector<Collop>   collops;
+    std::vector<Metric>   metrics;
+
+    /* keeps the capacity for the next tree */
+    void clear() {
+        nodes.clear();
+        functions.clear();
+        messages.clear();
+        collops.clear();
+        metrics.clear();
+    }
+};
+
+static_assert(std::is_trivially_copyable_v<SerializedTree::Node> &&
+                  std::is_trivially_copyable_v<SerializedTree::Function> &&
+                  std::is_trivially_copyable_v<SerializedTree::Message> &&
+                  std::is_trivially_copyable_v<SerializedTree::Collop> &&
+                  std::is_trivially_copyable_v<SerializedTree::Metric>,
+              "records of a SerializedTree are sent as raw bytes");
+
+/* Index of a node inside the node arena of its data_tree */
+using node_index_t = uint32_t;
+
+static constexpr node_index_t NO_NODE = (node_index_t)-1;
+
+/**
+ * Tree-local dense numbering of the locations that have data in a data_tree (in order of their first appearance)
+ */
+class LocationIndex {
    public:
-    data_tree();
+    uint32_t get(uint64_t location_id) {
+        return index.emplace(location_id, static_cast<uint32_t>(index.size())).first->second;
+    }
 
-    data_tree(std::map<uint64_t, std::tuple<uint64_t, uint64_t, std::shared_ptr<tree_node>>>& mapping);
+    size_t size() const { return index.size(); }
 
-    tree_node*                 insert_node(uint64_t function_id, tree_node* parent);
-    std::shared_ptr<tree_node> insert_node(uint64_t function_id, std::shared_ptr<tree_node> parent);
-    void                       insert_node(std::shared_ptr<tree_node> aNode);
+   private:
+    std::unordered_map<uint64_t, uint32_t> index;
+};
 
-    void merge_tree(data_tree& rhs_tree);
-    void insert_sub_tree(std::shared_ptr<tree_node>& parent, std::shared_ptr<tree_node>& n_node);
+/**
+ * Per-location data of a call-path node, stored in an array ordered by the tree-local location index
+ * (see @ref LocationIndex)
+ * - dense: only the range of location indices that actually have data in this node is allocated, unused slots within
+ *   that range are marked with the location id `NO_LOCATION`
+ * - sparse: if less than 1/4 of that range would be used (eg a node only reached by the first & the last process),
+ *   only the used slots are stored, with their location indices in the sorted `indices`
+ * - iterates like a map of <location id, NodeData>
+ */
+class NodeDataArray {
+   public:
+    using value_type = std::pair<uint64_t, NodeData>;
 
-    /* map< node,parent > */  // mapping darf !NICHT! unordered sein -> Reihenfolge ist wichtig!
-    void serialize_data(std::map<uint64_t, std::pair<uint64_t, uint64_t>>&                 mapping,
-                        std::deque<std::tuple<uint64_t, uint64_t, FunctionData*>>&         f_data,
-                        std::deque<std::tuple<uint64_t, uint64_t, MessageData*>>&          m_data,
-                        std::deque<std::tuple<uint64_t, uint64_t, CollopData*>>&           c_data,
-                        std::deque<std::tuple<uint64_t, uint64_t, uint64_t, MetricData*>>& met_data);
+    static constexpr uint64_t NO_LOCATION = (uint64_t)-1;
 
-    /* functionId , node* */
-    std::map<uint64_t, std::shared_ptr<tree_node>> root_nodes;
+    template <typename Slot>
+    class iterator_t {
+       public:
+        iterator_t(Slot* _pos, Slot* _end) : pos(_pos), end(_end) { skip_unused(); }
 
-    /* <rank, data> */
+        Slot& operator*() const { return *pos; }
+        Slot* operator->() const { return pos; }
 
-    // bringts irgendwie nicht -> aufteilung public/private
+        iterator_t& operator++() {
+            ++pos;
+            skip_unused();
+            return *this;
+        }
 
-    tree_iter begin();
-    tree_iter end();
+        bool operator==(const iterator_t& rhs) const { return pos == rhs.pos; }
+        bool operator!=(const iterator_t& rhs) const { return pos != rhs.pos; }
+
+       private:
+        void skip_unused() {
+            while (pos != end && pos->first == NO_LOCATION)
+                ++pos;
+        }
+
+        Slot* pos;
+        Slot* end;
+    };
+
+    using iterator       = iterator_t<value_type>;
+    using const_iterator = iterator_t<const value_type>;
+
+    /* data of location `loc_index`, nullptr if there is none */
+    NodeData* find(uint32_t loc_index) {
+        if (sparse()) {
+            auto it = std::lower_bound(indices.begin(), indices.end(), loc_index);
+            return it != indices.end() && *it == loc_index ? &slots[it - indices.begin()].second : nullptr;
+        }
+
+        if (loc_index < base || loc_index - base >= slots.size() || slots[loc_index - base].first == NO_LOCATION)
+            return nullptr;
+
+        return &slots[loc_index - base].second;
+    }
+
+    /* data of location `loc_index` (with id `location_id`), inserted empty if there is none -> <data, inserted> */
+    std::pair<NodeData*, bool> emplace(uint32_t loc_index, uint64_t location_id) {
+        if (sparse())
+            return emplace_sparse(loc_index, location_id);
+
+        if (slots.empty()) {
+            base = loc_index;
+            slots.emplace_back(NO_LOCATION, NodeData());
+        } else if (loc_index < base || loc_index - base >= slots.size()) {
+            const uint64_t span = std::max<uint64_t>(base + slots.size(), loc_index + 1) - std::min(base, loc_index);
+            if (span > MIN_SPARSE_SPAN && (used + 1) * 4 < span) {
+                to_sparse();
+                return emplace_sparse(loc_index, location_id);
+            }
+
+            if (loc_index < base) {
+                slots.insert(slots.begin(), base - loc_index, value_type(NO_LOCATION, NodeData()));
+                base = loc_index;
+            } else {
+                slots.resize(loc_index - base + 1, value_type(NO_LOCATION, NodeData()));
+            }
+        }
+
+        auto& slot     = slots[loc_index - base];
+        bool  inserted = slot.first == NO_LOCATION;
+        if (inserted) {
+            slot.first = location_id;
+            ++used;
+        }
+
+        return std::make_pair(&slot.second, inserted);
+    }
+
+    size_t size() const { return used; }
+    bool   empty() const { return used == 0; }
+    /* true if only the used slots are stored */
+    bool sparse() const { return !indices.empty(); }
+
+    iterator       begin() { return iterator(slots.data(), slots.data() + slots.size()); }
+    iterator       end() { return iterator(slots.data() + slots.size(), slots.data() + slots.size()); }
+    const_iterator begin() const { return const_iterator(slots.data(), slots.data() + slots.size()); }
+    const_iterator end() const { return const_iterator(slots.data() + slots.size(), slots.data() + slots.size()); }
 
    private:
-    void merge_node(std::shared_ptr<tree_node>& lhs_node, std::shared_ptr<tree_node>& rhs_node);
+    /* ranges up to this size are always stored dense */
+    static constexpr uint64_t MIN_SPARSE_SPAN = 16;
+
+    std::pair<NodeData*, bool> emplace_sparse(uint32_t loc_index, uint64_t location_id) {
+        auto it  = std::lower_bound(indices.begin(), indices.end(), loc_index);
+        auto pos = it - indices.begin();
+        if (it != indices.end() && *it == loc_index)
+            return std::make_pair(&slots[pos].second, false);
+
+        indices.insert(it, loc_index);
+        slots.insert(slots.begin() + pos, value_type(location_id, NodeData()));
+        ++used;
+
+        // back to dense once half of the range is used
+        if (uint64_t(used) * 2 >= uint64_t(indices.back()) - indices.front() + 1) {
+            to_dense();
+            return std::make_pair(&slots[loc_index - base].second, true);
+        }
+        return std::make_pair(&slots[pos].second, true);
+    }
+
+    void to_sparse() {
+        std::vector<value_type> used_slots;
+        used_slots.reserve(used + 1);
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].first == NO_LOCATION)
+                continue;
+            indices.push_back(base + static_cast<uint32_t>(i));
+            used_slots.push_back(std::move(slots[i]));
+        }
+        slots = std::move(used_slots);
+        base  = 0;
+    }
+
+    void to_dense() {
+        std::vector<value_type> dense(indices.back() - indices.front() + 1, value_type(NO_LOCATION, NodeData()));
+        for (size_t i = 0; i < indices.size(); ++i)
+            dense[indices[i] - indices.front()] = std::move(slots[i]);
+        base  = indices.front();
+        slots = std::move(dense);
+        indices.clear();
+        indices.shrink_to_fit();
+    }
+
+    /* location index of `slots[0]` (dense) */
+    uint32_t                base = 0;
+    uint32_t                used = 0;
+    std::vector<value_type> slots;
+    /* location index of each of the `slots` (sparse), empty if dense */
+    std::vector<uint32_t> indices;
 };
 
 class tree_node {
@@ -59,33 +262,29 @@ class tree_node {
     // receiver seite vorhanden sein)
     // -> ist für circos wenn überhaupt wichtig -> links von x zu y usw.
    public:
-    tree_node(const uint64_t _function_id, tree_node* _parent);
-    tree_node(const uint64_t _function_id, const std::shared_ptr<tree_node>& _parent);
-    tree_node(const uint64_t _function_id, const std::shared_ptr<tree_node>& _parent, const uint64_t process_num);
-    tree_node(const uint64_t _function_id);
-
-    ~tree_node();
+    tree_node(const uint64_t _function_id, tree_node* _parent, node_index_t _index, LocationIndex* _locations);
 
     void add_data(const uint64_t location_id, const FunctionData& fdata);
     void add_data(const uint64_t location_id, const MessageData& mdata);
     void add_data(const uint64_t location_id, const CollopData& cdata);
     void add_data(const uint64_t location_id, const uint64_t metric_id, const MetricData& metdata);
 
-    // std::shared_ptr<tree_node> parent;
     tree_node* parent;
 
 	/* Function/Region id (eg `OTF2_Locationref` in OTF2) */
     uint64_t function_id;
 
-    /* function_id, pointer to node */
-    std::map<uint64_t, std::shared_ptr<tree_node>> children;
+    /* position in the arena of the tree */
+    node_index_t index;
+    /* children in order of their insertion, linked via `next_sibling` */
+    node_index_t first_child  = NO_NODE;
+    node_index_t last_child   = NO_NODE;
+    node_index_t next_sibling = NO_NODE;
 
     /* data containers */
-    /* maps with location id as key -> value = NodeData -> function, p2p or collop */
-    std::map<uint64_t, NodeData> node_data;
+    /* location id -> NodeData -> function, p2p or collop */
+    NodeDataArray node_data;
 
-    std::map<uint64_t, MessageData*> have_message;  // TODO raus damit -> sinnlos und fehleranfällig
-    std::map<uint64_t, CollopData*>  have_collop;   // TODO raus damit -> sinnlos und fehleranfällig
     // TODO workaround
     //--->TODO funktion implementieren die aus node_data heraus findet ob collop bzw p2p da ist -> umständlich
     bool has_p2p    = false;
@@ -93,15 +292,113 @@ class tree_node {
 
     uint64_t  last_loc;
     NodeData* last_data;
+
+   private:
+    /* data of `location_id` (inserted if not present), remembered in `last_loc`/`last_data` */
+    NodeData* data_of(const uint64_t location_id);
+
+    LocationIndex* locations;
 };
 
-class tree_iter {
+/**
+ * Used for storing call-path of regions (=functions)
+ *
+ * - nodes live in an arena of fixed-size chunks (so pointers to nodes stay valid) and are addressed by their index
+ * - children of a node are found through one open-addressing table keyed by <parent index, function id>, the children
+ *   of a node (and the root nodes) are additionally linked in order of their insertion for iteration
+ */
+class data_tree {
    public:
-    tree_iter(data_tree& _tree) {
-        node_ptr = _tree.root_nodes.begin()->second.get();
-        tree_ptr = &_tree;
+    data_tree();
+
+    data_tree(data_tree&&)            = default;
+    data_tree& operator=(data_tree&&) = default;
+
+    /* child `function_id` of `parent` (root node if `parent==nullptr`), inserted if it doesn't exist yet */
+    tree_node* get_node(uint64_t function_id, tree_node* parent);
+    /* child `function_id` of `parent` (root node if `parent==nullptr`), nullptr if it doesn't exist */
+    tree_node* find_node(uint64_t function_id, const tree_node* parent) const;
+    /* adds a node without data, nullptr if it already exists */
+    tree_node* insert_node(uint64_t function_id, tree_node* parent);
+
+    /* moves all nodes & their data of `rhs_tree` into this tree
+     * should only be used if one knows that the data inside a node is unique (location wise) */
+    void merge_tree(data_tree& rhs_tree);
+
+    /* replaces the content of `out` with all nodes & their data, in one pass over the tree */
+    void serialize_data(SerializedTree& out) const;
+    /* adds the nodes & data of a tree serialized by another rank (see @ref SerializedTreeMerger), false if a record
+     * refers to a node that doesn't precede it */
+    bool merge_serialized_data(const SerializedTree& in);
+
+    tree_node*       node(node_index_t index) { return &chunks[index >> CHUNK_BITS][index & (CHUNK_SIZE - 1)]; }
+    const tree_node* node(node_index_t index) const {
+        return &chunks[index >> CHUNK_BITS][index & (CHUNK_SIZE - 1)];
+    }
+
+    /* nr of nodes */
+    size_t size() const { return num_nodes; }
+    bool   empty() const { return num_nodes == 0; }
+
+    tree_iter begin();
+    tree_iter end();
+
+   private:
+    friend class tree_iter;
+
+    static constexpr unsigned CHUNK_BITS = 12;
+    static constexpr size_t   CHUNK_SIZE = size_t(1) << CHUNK_BITS;
+
+    struct ChildSlot {
+        uint64_t     function_id;
+        node_index_t parent;
+        node_index_t child = NO_NODE;
     };
 
+    /* slot of child `function_id` of node `parent` in `child_table`, either holding it or the empty slot to insert it */
+    size_t find_slot(uint64_t function_id, node_index_t parent) const;
+    void   grow_child_table();
+
+    std::vector<std::vector<tree_node>> chunks;
+    size_t                              num_nodes = 0;
+
+    node_index_t first_root = NO_NODE;
+    node_index_t last_root  = NO_NODE;
+
+    /* open addressing (linear probing), size is a power of 2 and at most half of it is used */
+    std::vector<ChildSlot> child_table;
+
+    /* kept on the heap so the nodes can refer to it even if the tree is moved */
+    std::unique_ptr<LocationIndex> locations;
+};
+
+/**
+ * Merges a @ref SerializedTree into a data_tree part by part, eg while the rest of it is still being received
+ * - the nodes have to be added (in order) before the data referring to them
+ * - like @ref data_tree::merge_tree the data has to be unique (location wise)
+ */
+class SerializedTreeMerger {
+   public:
+    explicit SerializedTreeMerger(data_tree& _tree) : tree(_tree) {}
+
+    /* false if a node refers to a parent that doesn't precede it */
+    bool add(const SerializedTree::Node* records, size_t count);
+    /* false if a record refers to a node that hasn't been added yet */
+    bool add(const SerializedTree::Function* records, size_t count);
+    bool add(const SerializedTree::Message* records, size_t count);
+    bool add(const SerializedTree::Collop* records, size_t count);
+    bool add(const SerializedTree::Metric* records, size_t count);
+
+   private:
+    data_tree& tree;
+    /* node number -> corresponding node of `tree` */
+    std::vector<tree_node*> nodes;
+};
+
+class tree_iter {
+   public:
+    tree_iter(data_tree& _tree) : node_ptr(_tree.node(_tree.first_root)), tree_ptr(&_tree){};
+
     tree_iter(tree_node* _rhs_node, data_tree* _rhs_tree) : node_ptr(_rhs_node), tree_ptr(_rhs_tree){};
 
     tree_iter(const tree_iter& _rhs_it) : node_ptr(_rhs_it.node_ptr), tree_ptr(_rhs_it.tree_ptr){};
@@ -116,45 +413,23 @@ class tree_iter {
 
     tree_node& operator*() { return *node_ptr; };
 
+    /* pre-order: children before the next sibling */
     tree_iter& operator++() {
         assert((node_ptr != nullptr) || (tree_ptr != nullptr));
 
-        if (!node_ptr->children.empty()) {
-            node_ptr = node_ptr->children.begin()->second.get();
-
-        } else {
-            while (true) {
-                if (node_ptr->parent != nullptr) {
-                    auto child_it = node_ptr->parent->children.find(node_ptr->function_id);
-
-                    ++child_it;
-
-                    if (child_it == node_ptr->parent->children.end()) {
-                        node_ptr = node_ptr->parent;
-
-                        continue;
-                    }
-
-                    node_ptr = child_it->second.get();
-
-                    break;
-
-                } else {
-                    auto child_it = tree_ptr->root_nodes.find(node_ptr->function_id);
-
-                    ++child_it;
-
-                    if (child_it != tree_ptr->root_nodes.end()) {
-                        node_ptr = child_it->second.get();
+        if (node_ptr->first_child != NO_NODE) {
+            node_ptr = tree_ptr->node(node_ptr->first_child);
+            return *this;
+        }
 
-                    } else {
-                        node_ptr = nullptr;
-                        tree_ptr = nullptr;
-                    }
+        while (node_ptr->next_sibling == NO_NODE && node_ptr->parent != nullptr)
+            node_ptr = node_ptr->parent;
 
-                    break;
-                }
-            }
+        if (node_ptr->next_sibling != NO_NODE) {
+            node_ptr = tree_ptr->node(node_ptr->next_sibling);
+        } else {
+            node_ptr = nullptr;
+            tree_ptr = nullptr;
         }
 
         return *this;
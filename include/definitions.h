@@ -20,6 +20,7 @@
 #include <unordered_set>
 #include <vector>
 
+#include "dense_id_map.h"
 #include "main_structs.h"
 
 using namespace access_pattern_detection;
@@ -82,29 +83,29 @@ struct Group {
     std::vector<uint64_t> members;
 };
 
+/* Definitions of one kind, stored densely by their id (see @ref DenseIdMap) since `get` is called on every event */
 template <typename Id, typename TypeProperties>
 class DefinitionType {
    public:
-    using ContainerTypeProps_t = std::map<Id, TypeProperties>;
+    using ContainerTypeProps_t = DenseIdMap<Id, TypeProperties>;
     using TypeProperties_t     = TypeProperties;
 
     DefinitionType() = default;
 
-    DefinitionType(const ContainerTypeProps_t& props) : all_properties(props) {}
-
     void add(Id id, const TypeProperties_t& props) { all_properties[id] = props; }
 
     const TypeProperties_t* get(Id id) const {
-        const auto props_it = all_properties.find(id);
-
-        if (props_it == all_properties.end())
-            // TODO Error handling
-            return nullptr;
+        // TODO Error handling (nullptr if not defined)
+        return all_properties.find(id);
+    }
 
-        return &(props_it->second);
+    /* calls `f(id, props)` for all definitions */
+    template <typename F>
+    void for_each(F&& f) const {
+        all_properties.for_each(std::forward<F>(f));
     }
 
-    const ContainerTypeProps_t& get_all() const { return all_properties; }
+    size_t size() const { return all_properties.size(); }
 
    private:
     ContainerTypeProps_t all_properties;
@@ -407,6 +408,8 @@ struct File
 	 * */
 	mutable std::unique_ptr<std::mutex> fsize_mutex;
 	/** Track `fsize` to account for file-size-relative offset
+	 * - while reading events every location group tracks its own size (see @ref PartialEventData::file_size),
+	 *   this is the max. of them once the groups are merged
 	 * @note The file-size is relative to the file-size which the file had BEFORE the traced program
 	 * was run (since we do not know how large the file actually was before and thus during the run)
 	 */
@@ -422,6 +425,11 @@ struct File
 		fsize(0)
 	{};
 
+	/** The global access pattern of a file with a single IoHandle is the local one of that handle, so the raw I/O
+	 *  accesses (see @ref IoHandle::io_accesses) only have to be kept for files with several IoHandles
+	 */
+	inline bool keeps_io_accesses() const { return io_handles.size() > 1; }
+
 	/** Updates file size to new value by performing required synchronization
 	 *
 	 *	TODO: synchronize MPI-parallel runs
@@ -466,19 +474,26 @@ struct IoHandle {
 	*/
 	mutable std::map<uint64_t, std::string> used_io_mode;
 
-	/* @brief List of I/O Accesses (timestamp of I/O completion,file position,I/O size))
-	 * @note Set in @ref OTF2Reader::io_operation_begin_callback
+	/* @brief Detects the local access pattern while the I/O accesses (timestamp of I/O completion,file position,I/O size)
+	 * on this IoHandle are read, without storing the accesses themselves
+	 * @note Fed in @ref OTF2Reader::io_operation_complete_callback
 	 *
 	 * @note fpos is relative to the `fsize` the  corresponding File had BEFORE the traced program was run
 	 * (since we can't know whether there was already sth written in that file from the trace)
 	 * */
+	mutable LocalAccessPatternDetector access_pattern_detector;
+	/* @brief All I/O Accesses performed on this IoHandle, in the order of their completion
+	 * - only kept if the global access pattern of the file is computed from them (see @ref File::keeps_io_accesses),
+	 *   empty otherwise
+	 * @note Set in @ref OTF2Reader::io_operation_complete_callback, stored column-wise&delta-encoded (see @ref IOAccesses)
+	 * */
 	mutable IOAccesses io_accesses;
 
 	/** Track current `fpos` into file, determines position at which I/O is being performed
 	 * @note `fpos` could be different from the actual fpos during the run (since the original fsize before the program
 	 * executed is not given). But since our analysis works on relative offsets anyways, this shouldn't matter
 	 * */
-	mutable uint64_t fpos;
+	mutable uint64_t fpos = 0;
 
 	IoHandle() = default;
 
@@ -488,11 +503,27 @@ struct IoHandle {
 		  io_data_stats(IoData(self))
 	{}
 
+	/** Merges I/O that has been recorded on a reader-local copy of this IoHandle (see @ref PartialEventData)
+	 * @note `rhs` has to hold the I/O performed after the I/O already recorded here, since `io_accesses` are appended
+	 * and `fpos` is taken over
+	 */
+	void merge(const IoHandle& rhs) const {
+		io_data_stats += rhs.io_data_stats;
+		if (rhs.location.has_value())
+			location = rhs.location;
+		modes.insert(rhs.modes.begin(), rhs.modes.end());
+		for (const auto& [matching_id, mode] : rhs.used_io_mode)
+			used_io_mode[matching_id] = mode;
+		access_pattern_detector.merge(rhs.access_pattern_detector);
+		io_accesses.append(rhs.io_accesses);
+		fpos = rhs.fpos;
+	}
+
 	/** Local Access Patterns are computed per IoHandle
 	 * since the assumption is that local access patterns don't stretch btw opening&closing a file
 	 */
 	AnalysisResult get_local_access_pattern_stats() const{
-		return access_pattern_detection::detect_local_access_pattern(io_accesses);
+		return access_pattern_detector.result();
 	};
 };
 
@@ -537,52 +568,7 @@ struct meta_data {
     uint32_t myRank;
     uint32_t numRanks;
 
-#ifdef OTFPROFILER_MPI
-
-    uint32_t packBufferSize;
-    char*    packBuffer;
-
-#endif
-
-    meta_data(uint32_t my_rank = 0, uint32_t num_ranks = 1) : myRank(my_rank), numRanks(num_ranks), timerResolution(0) {
-#ifdef OTFPROFILER_MPI
-
-        packBufferSize = 0;
-        packBuffer     = NULL;
-
-#endif
-    }
-
-    ~meta_data() {
-#ifdef OTFPROFILER_MPI
-
-        freePackBuffer();
-
-#endif
-    }
-
-#ifdef OTFPROFILER_MPI
-    char* guaranteePackBuffer(uint32_t size) {
-        if (packBufferSize < size) {
-            packBufferSize = size;
-            packBuffer     = (char*)realloc(packBuffer, packBufferSize * sizeof(char));
-
-            assert(NULL != packBuffer);
-        }
-
-        return packBuffer;
-    }
-
-    void freePackBuffer() {
-        if (packBuffer) {
-            free(packBuffer);
-            packBuffer = NULL;
-        }
-    }
-
-    char* getPackBuffer() { return packBuffer; }
-
-#endif /* OTFPROFILER_MPI */
+    meta_data(uint32_t my_rank = 0, uint32_t num_ranks = 1) : myRank(my_rank), numRanks(num_ranks), timerResolution(0) {}
 };
 
 #endif  // DEFINITIONS_H
@@ -0,0 +1,90 @@
+/*
+ This is part of the OTF-Profiler. Copyright by ZIH, TU Dresden 2016-2018.
+ Authors: Maximillian Neumann, Denis Hünich, Jens Doleschal
+*/
+
+#ifndef DENSE_ID_MAP_H
+#define DENSE_ID_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Map of (nearly dense) definition ids (eg OTF2 refs) to `T`
+ *
+ * - ids that keep the id space compact are stored in a vector indexed by the id, so a lookup is a bounds check and an
+ *   index
+ * - an id is stored in the vector if it is below `DENSE_MIN_SPAN` or at most twice the nr of ids stored there,
+ *   all other ids (eg `OTF2_UNDEFINED_*` or ids of sparse traces) are kept in a hash map
+ * - pointers to values are invalidated by inserting
+ */
+template <typename Id, typename T>
+class DenseIdMap {
+   public:
+    static constexpr size_t DENSE_MIN_SPAN = 1024;
+
+    T* find(Id id) {
+        const auto idx = static_cast<uint64_t>(id);
+        if (idx < used.size() && used[idx])
+            return &dense[idx];
+
+        if (sparse.empty())
+            return nullptr;
+
+        auto it = sparse.find(id);
+        return it != sparse.end() ? &it->second : nullptr;
+    }
+
+    const T* find(Id id) const { return const_cast<DenseIdMap*>(this)->find(id); }
+
+    /* value of `id`, default constructed if it didn't exist */
+    T& operator[](Id id) {
+        const auto idx = static_cast<uint64_t>(id);
+        if (idx < used.size()) {
+            if (!used[idx]) {
+                // may have been stored sparse before the vector covered it
+                auto it = sparse.find(id);
+                if (it != sparse.end()) {
+                    dense[idx] = std::move(it->second);
+                    sparse.erase(it);
+                }
+                used[idx] = 1;
+                ++num_dense;
+            }
+            return dense[idx];
+        }
+
+        if (idx < DENSE_MIN_SPAN || idx <= 2 * num_dense) {
+            dense.resize(idx + 1);
+            used.resize(idx + 1, 0);
+            return (*this)[id];
+        }
+
+        return sparse[id];
+    }
+
+    size_t size() const { return num_dense + sparse.size(); }
+    bool   empty() const { return size() == 0; }
+
+    /* calls `f(id, value)` for all stored ids, the densely stored ones in ascending order first */
+    template <typename F>
+    void for_each(F&& f) const {
+        for (size_t idx = 0; idx < used.size(); ++idx) {
+            if (used[idx])
+                f(static_cast<Id>(idx), dense[idx]);
+        }
+        for (const auto& it : sparse)
+            f(it.first, it.second);
+    }
+
+   private:
+    std::vector<T>            dense;
+    std::vector<uint8_t>      used;
+    size_t                    num_dense = 0;
+    std::unordered_map<Id, T> sparse;
+};
+
+#endif
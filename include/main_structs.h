@@ -304,6 +304,14 @@ struct NodeData {
     NodeData(const CollopData& _c_data) : f_data(), m_data(), c_data(_c_data) {}
 };
 
+/* Time window [begin, end] (in ticks) to which the analysis is restricted */
+struct TimeWindow {
+    uint64_t begin = 0;
+    uint64_t end   = (uint64_t)-1;
+
+    bool is_set() const { return begin != 0 || end != (uint64_t)-1; }
+};
+
 /* Stores I/O Statistics per eg paradigm / location / @ref IoHandle */
 struct IoData {
 	/* Nr of I/O Ops that operated on the I/O Handle with which this IoData is associated */
@@ -326,6 +334,22 @@ struct IoData {
 		: num_operations(0), num_bytes(0), transfer_time(0), nontransfer_time(0), mode("-") ,
 		  io_handle(ioh)
 	{}
+
+	/* Accumulates the statistics of I/O performed after the I/O already accounted for in this IoData
+	 * (eg collected by another reader thread), the per-op fields are taken from the later I/O */
+	IoData& operator+=(const IoData& rhs) {
+		num_operations += rhs.num_operations;
+		num_bytes += rhs.num_bytes;
+		transfer_time += rhs.transfer_time;
+		nontransfer_time += rhs.nontransfer_time;
+		if (rhs.num_operations > 0) {
+			io_handle = rhs.io_handle;
+			mode = rhs.mode;
+			region = rhs.region;
+		}
+
+		return *this;
+	}
 };
 
 #endif
@@ -0,0 +1,215 @@
+/*
+ This is part of the OTF-Profiler. Copyright by ZIH, TU Dresden 2016-2018.
+ Authors: Maximillian Neumann, Denis Hünich, Jens Doleschal
+*/
+
+#ifndef BINARY_PROFILE_H
+#define BINARY_PROFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+struct WorkflowProfile;
+
+/*
+ * Binary profile (--binary): the content of the JSON profile as versioned, little-endian, columnar container
+ *
+ * Layout (offsets in bytes, all sections & columns start 8-byte aligned):
+ *   header:         char magic[8] ("OTFPROF\0"), u32 version, u32 nr of sections
+ *   section table:  per section: u32 id (SectionID), u32 reserved, u64 offset (from file start), u64 size
+ *   section:        u64 nr of rows, u32 nr of columns, u32 reserved,
+ *                   per column: u32 width (1, 4 or 8 bytes), u32 reserved, u64 nr of values, u64 offset (from
+ *                   section start), followed by the values of the columns
+ *
+ * Columns of a section are indexed by the enums below. All strings are stored once in section STRINGS and referenced
+ * by their index (NO_REF if not set). A list per row (eg the paradigms of a file) is a `*_OFFSETS` column with
+ * `rows+1` values and the columns following it, the list of row `i` are their values `[offsets[i], offsets[i+1])`.
+ *
+ * The runtime of the profiler itself (SelfProfile of the JSON output) is not stored.
+ */
+namespace binary_profile {
+
+constexpr char     MAGIC[8] = {'O', 'T', 'F', 'P', 'R', 'O', 'F', '\0'};
+constexpr uint32_t VERSION  = 1;
+constexpr uint32_t NO_REF   = UINT32_MAX;
+
+enum class SectionID : uint32_t {
+    STRINGS = 1,
+    TRACE,
+    COUNTERS,
+    PARADIGM_STATS,
+    FILES,
+    LOCATIONS,
+    REGIONS,
+};
+
+/* String table, string `i` are the chars `[OFFSETS[i], OFFSETS[i+1])` */
+namespace strings {
+enum Column : uint32_t { OFFSETS, CHARS, NR_COLUMNS };
+}
+
+/* Single row, metadata & filters of the trace */
+namespace trace {
+enum Column : uint32_t {
+    FILENAME,
+    TRACE_ID,
+    JOB_ID,
+    NODE_COUNT,
+    PROCESS_COUNT,
+    THREAD_COUNT,
+    TIMER_RESOLUTION,
+    PARALLEL_REGION_TIME,
+    SERIAL_TIME,
+    NUM_FUNCTIONS,
+    NUM_INVOCATIONS,
+    WINDOW_BEGIN,
+    WINDOW_END,
+    FILTER_RANKS,
+    FILTER_THREADS,
+    FILTER_NODES_OFFSETS,
+    FILTER_NODES,
+    NR_COLUMNS
+};
+}
+
+/* Hardware counters */
+namespace counters {
+enum Column : uint32_t { NAME, VALUE, NR_COLUMNS };
+}
+
+/* Entries of Functions, Messages, CollectiveOperations & IOOperations per paradigm
+ * - a paradigm without entries has one row with KEY=NO_REF */
+namespace paradigm_stats {
+enum Category : uint32_t { FUNCTIONS, MESSAGES, COLLECTIVE_OPERATIONS, IO_OPERATIONS };
+enum Column : uint32_t { CATEGORY, PARADIGM, KEY, VALUE, NR_COLUMNS };
+}
+
+/* Files, parent files (KEY=NO_REF) are stored as rows of their own after the files & referenced by their row
+ * - PATTERN_STAT_*: ticks & I/O sizes per access pattern (local & global) as (PatternStatKind, AccessPattern, value) */
+namespace files {
+enum PatternStatKind : uint32_t { LOCAL_TICKS, LOCAL_IO_SIZE, GLOBAL_TICKS, GLOBAL_IO_SIZE };
+enum Column : uint32_t {
+    KEY,
+    FILENAME,
+    PARENT,
+    BYTES_READ,
+    BYTES_WRITE,
+    TICKS,
+    PARADIGM_OFFSETS,
+    PARADIGMS,
+    MODE_OFFSETS,
+    MODES,
+    LOCATION_OFFSETS,
+    LOCATIONS,
+    PATTERN_STAT_OFFSETS,
+    PATTERN_STAT_KIND,
+    PATTERN_STAT_PATTERN,
+    PATTERN_STAT_VALUE,
+    NR_COLUMNS
+};
+}
+
+/* Access pattern per time interval of each location, intervals sorted by (begin, end)
+ - KEY is the location the info is stored under, LOCATION the value written to the JSON output */
+namespace locations {
+enum Column : uint32_t { KEY, LOCATION, INTERVAL_OFFSETS, INTERVAL_BEGIN, INTERVAL_END, INTERVAL_PATTERN, NR_COLUMNS };
+}
+
+/* I/O per region */
+namespace regions {
+enum Column : uint32_t {
+    KEY,
+    NAME,
+    BEGIN_SRC_LINE,
+    END_SRC_LINE,
+    BYTES_READ,
+    BYTES_WRITE,
+    TICKS,
+    PARADIGM_OFFSETS,
+    PARADIGMS,
+    MODE_OFFSETS,
+    MODES,
+    CALLEE_OFFSETS,
+    CALLEE_NAMES,
+    CALLEE_CALLS,
+    NR_COLUMNS
+};
+}
+
+/* Values of a column, points directly into the mapped file */
+template <typename T>
+struct ColumnView {
+    const T* values = nullptr;
+    uint64_t size   = 0;
+
+    const T& operator[](uint64_t i) const { return values[i]; }
+    const T* begin() const { return values; }
+    const T* end() const { return values + size; }
+};
+
+/* A section of a mapped binary profile, empty if it is not contained in the file */
+class Section {
+   public:
+    uint64_t rows() const { return nr_rows; }
+    uint32_t columns() const { return nr_columns; }
+
+    /* Returns column `index`, empty if it doesn't exist or its width is not `sizeof(T)` */
+    template <typename T>
+    ColumnView<T> column(uint32_t index) const {
+        static_assert(std::is_integral_v<T>, "columns only contain integers");
+        ColumnView<T> col;
+        const uint8_t* values;
+        if (columnData(index, sizeof(T), values, col.size))
+            col.values = reinterpret_cast<const T*>(values);
+        return col;
+    }
+
+   private:
+    friend class Reader;
+    bool columnData(uint32_t index, uint32_t width, const uint8_t*& values, uint64_t& size) const;
+
+    const uint8_t* data       = nullptr;
+    uint64_t       nr_rows    = 0;
+    uint32_t       nr_columns = 0;
+};
+
+/* Maps a binary profile into memory, sections are accessed without reading the rest of the file */
+class Reader {
+   public:
+    Reader() = default;
+    ~Reader();
+    Reader(const Reader&)            = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    /* Maps `fname` & validates its header, section table & column descriptors, prints errors to std::cerr */
+    bool open(const std::string& fname);
+
+    uint32_t version() const { return file_version; }
+    bool     has(SectionID id) const;
+    Section  section(SectionID id) const;
+    /* Returns string `ref` of the string table, empty for NO_REF */
+    std::string_view string(uint32_t ref) const;
+
+   private:
+    void close();
+
+    const uint8_t*       data         = nullptr;
+    size_t               size         = 0;
+    uint32_t             file_version = 0;
+    uint32_t             nr_sections  = 0;
+    ColumnView<uint64_t> string_offsets;
+    ColumnView<uint8_t>  string_chars;
+};
+
+/* Writes `profile` (without its self profile) to `fname` */
+bool WriteBinaryProfile(const WorkflowProfile& profile, const std::string& fname);
+
+/* Restores the profile stored in `reader`, eg to convert it to JSON (see --to-json) */
+bool ReadBinaryProfile(const Reader& reader, WorkflowProfile& profile);
+
+}  // namespace binary_profile
+
+#endif
@@ -6,8 +6,21 @@
 #ifndef CREATE_JSON_H
 #define CREATE_JSON_H
 
+#include <string>
 #include "all_data.h"
 
-bool CreateJSON(AllData& alldata);
+struct WorkflowProfile;
 
-#endif
\ No newline at end of file
+/* Collects the profile of `alldata` (counts, statistics per paradigm, file, location & region) */
+void CollectProfile(AllData& alldata, WorkflowProfile& profile);
+
+/* Writes `profile` as JSON to `fname`, without indentation & line breaks if `compact` */
+bool WriteJSON(const WorkflowProfile& profile, const std::string& fname, bool compact);
+
+/* Collects the profile once & writes the requested outputs (--json: `<prefix>.json`, --binary: `<prefix>.otfprof`) */
+bool CreateProfile(AllData& alldata);
+
+/* Converts the binary profile `binary_file` to JSON (--to-json) */
+bool ConvertBinaryProfile(const std::string& binary_file, const std::string& json_file, bool compact);
+
+#endif
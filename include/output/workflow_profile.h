@@ -0,0 +1,573 @@
+/*
+ This is part of the OTF-Profiler. Copyright by ZIH, TU Dresden 2016-2018.
+ Authors: Maximillian Neumann, Denis Hünich, Jens Doleschal
+*/
+
+#ifndef WORKFLOW_PROFILE_H
+#define WORKFLOW_PROFILE_H
+
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "definitions.h"
+#include "utils.h"
+
+/*
+ * Profile written by the JSON (see CreateProfile) and the binary output (see binary_profile.h), the `Write*` methods
+ * take any writer with the SAX-interface of rapidjson's Writer
+ */
+
+/* Arbitrary labeled Uint64-typed data associated with a statistic */
+struct ProfileEntry {
+	/* Internal storage of labeled integer-data */
+    std::map<std::string, uint64_t> entries;
+
+    void add_data(const std::string& key, uint64_t value) {
+        if (value == 0 || value == (uint64_t)(-1))
+            return;
+        entries[key] += value;
+    }
+
+    template <typename Writer>
+    void WriteProfile(Writer& w) const {
+        w.StartObject();
+        for (const auto& kv : entries) {
+            w.Key(kv.first.c_str());
+            w.Uint64(kv.second);
+        }
+        w.EndObject();
+    }
+};
+
+struct LocationInfo {
+	OTF2_LocationRef location;
+	std::unordered_map<TimeInterval, AccessPattern, pair_hash> pattern_per_timeinterval;
+
+    template <typename Writer>
+    void WriteLocationInfo(Writer& w) const {
+        w.StartObject();
+        w.Key("Location");
+        w.Uint64(location);
+
+		w.Key("Per time interval");
+		w.StartObject();
+		for (auto& v: pattern_per_timeinterval) {
+			auto time_interval = std::to_string(v.first.first) + "-" + std::to_string(v.first.second);
+			auto pattern = access_pattern_to_string(v.second);
+			w.Key(time_interval.c_str());
+			w.String(pattern);
+		}
+		w.EndObject();
+
+        // w.Key("IoParadigm");
+        // w.StartArray();
+        // for (const auto& pstr : paradigm) {
+        //     w.String(pstr.c_str());
+        // }
+        // w.EndArray();
+        // w.Key("AccessModes");
+        // std::string merged_modes;
+        // for (const auto& modestr : modes) {
+        //     merged_modes += modestr;
+        // }
+        // w.String(merged_modes.c_str());
+
+		// w.Key("#Bytes read");
+		// w.Uint64(bytes_read);
+		// w.Key("#Bytes write");
+		// w.Uint64(bytes_write);
+		// w.Key("Ticks spent");
+		// w.Uint64(time_spent_in_ticks);
+
+		// w.Key("Nr accessed files");
+		// w.Uint64();
+
+		// // store which access patterns have been used for accessin the files (both how many locations accessed file by this access pattern & % of time of accessing file in this pattern
+		// w.Key("Ticks spent per Access Pattern");
+		// w.StartObject();
+		// for(auto& [access_pattern, ticks_spent] : ticks_spent_per_access_pattern) {
+		// 	w.Key(access_pattern_to_string(access_pattern));
+		// 	w.Uint64(ticks_spent);
+		// }
+		// w.EndObject();
+		// w.Key("I/O sizes per Access Pattern");
+		// w.StartObject();
+		// for(auto& [access_pattern, io_size] : iosize_per_access_pattern) {
+		// 	w.Key(access_pattern_to_string(access_pattern));
+		// 	w.Uint64(io_size);
+		// }
+		// w.EndObject();
+
+        w.EndObject();
+    }
+
+    void operator+=(const LocationInfo& rhs) {
+		pattern_per_timeinterval.insert(rhs.pattern_per_timeinterval.begin(), rhs.pattern_per_timeinterval.end());
+	}
+};
+
+/**
+ *	Statistics stored per file
+ */
+struct FileInfo {
+    FileInfo() : parentfile(NULL) {}
+	/* Construct FileInfo given file_ref-id (from Definitions) */
+    FileInfo(const definitions::Definitions& defs, OTF2_IoHandleRef id) {
+        parentfile           = NULL;
+        const definitions::IoHandle* ioh = defs.iohandles.get(id);
+        if (!ioh)
+            return;
+        const definitions::IoHandle* parent = defs.iohandles.get(ioh->parent);
+        if (parent)
+            parentfile = new FileInfo(defs, ioh->parent);
+        filename = ioh->file_handle->file_name;
+        paradigm.insert(defs.io_paradigms.get(ioh->io_paradigm)->name);
+        modes = ioh->modes;
+
+
+		// some io-handles might not contain a location (TODO: check!), reported by @ref AnalyzeFile
+		if (ioh->location.has_value()) {
+			auto location = ioh->location.value();
+			locations.insert(location);
+		}
+    }
+
+	// TODO: Remove Operator Overloading, make function more explicit
+    void operator+=(const FileInfo& rhs) {
+        filename = rhs.filename; // TODO: the file names should be always equal, right?
+        if (rhs.parentfile && !parentfile)
+            parentfile = rhs.parentfile;
+        std::copy(rhs.paradigm.begin(), rhs.paradigm.end(), std::inserter(paradigm, paradigm.begin()));
+        std::copy(rhs.modes.begin(), rhs.modes.end(), std::inserter(modes, modes.begin()));
+
+        std::copy(rhs.locations.begin(), rhs.locations.end(), std::inserter(locations, locations.begin()));
+		// TODO: Size/Timing stats are collected elsewhere (`bytes_read`,`bytes_write`,`time_spent_in_ticks`)
+	}
+
+    std::string           filename;
+	/* I/O Paradigms used to perform I/O on file */
+    std::set<std::string> paradigm;
+	/* Modes in which file was opened (read/write) */
+	std::set<std::string> modes;
+    FileInfo*             parentfile;
+	/* Bytes read from this file */
+	std::uint64_t		  bytes_read=0;
+	/* Bytes written to this file */
+	std::uint64_t		  bytes_write=0;
+	/* Time spent reading/writing the file */
+	std::uint64_t		  time_spent_in_ticks=0;
+
+	// === Access Patterns (NEXT: TODO)
+	/* @brief Store list of locations that accessed this file
+	 * - implicitly determines whether file-access is exclusive ("E") or shared ("S") (just check whether .size==1?)
+	 */
+	std::unordered_set<OTF2_LocationRef> locations;
+
+	/** How many ticks have been spent in each access pattern */
+	std::map<AccessPattern, uint64_t> ticks_spent_per_access_pattern{};
+	/** How many bytes have been worked upon per access pattern */
+	std::map<AccessPattern, uint64_t> iosize_per_access_pattern{};
+	/** Same as above, but for the accesses of all locations on the file merged in time (global access pattern) */
+	std::map<AccessPattern, uint64_t> global_ticks_spent_per_access_pattern{};
+	std::map<AccessPattern, uint64_t> global_iosize_per_access_pattern{};
+
+
+	// TODO: time spent for meta-ops
+
+    template <typename Writer>
+    void WriteFileInfo(Writer& w) const {
+        w.StartObject();
+        w.Key("FileName");
+        w.String(filename.c_str());
+
+        w.Key("IoParadigm");
+        w.StartArray();
+        for (const auto& pstr : paradigm) {
+            w.String(pstr.c_str());
+        }
+        w.EndArray();
+        w.Key("AccessModes");
+        std::string merged_modes;
+        for (const auto& modestr : modes) {
+            merged_modes += modestr;
+        }
+        w.String(merged_modes.c_str());
+        w.Key("ParentFile");
+        if (parentfile && parentfile->filename != filename) {
+            parentfile->WriteFileInfo(w);
+        } else {
+            w.Null();
+        }
+
+		w.Key("#Bytes read");
+		w.Uint64(bytes_read);
+		w.Key("#Bytes write");
+		w.Uint64(bytes_write);
+		w.Key("Ticks spent");
+		w.Uint64(time_spent_in_ticks);
+
+		w.Key("Nr accesses from different locations");
+		w.Uint64(locations.size());
+
+		// store which access patterns have been used for accessin the files (both how many locations accessed file by this access pattern & % of time of accessing file in this pattern
+		w.Key("Ticks spent per Access Pattern");
+		w.StartObject();
+		for(auto& [access_pattern, ticks_spent] : ticks_spent_per_access_pattern) {
+			w.Key(access_pattern_to_string(access_pattern));
+			w.Uint64(ticks_spent);
+		}
+		w.EndObject();
+		w.Key("I/O sizes per Access Pattern");
+		w.StartObject();
+		for(auto& [access_pattern, io_size] : iosize_per_access_pattern) {
+			w.Key(access_pattern_to_string(access_pattern));
+			w.Uint64(io_size);
+		}
+		w.EndObject();
+		w.Key("Global ticks spent per Access Pattern");
+		w.StartObject();
+		for(auto& [access_pattern, ticks_spent] : global_ticks_spent_per_access_pattern) {
+			w.Key(access_pattern_to_string(access_pattern));
+			w.Uint64(ticks_spent);
+		}
+		w.EndObject();
+		w.Key("Global I/O sizes per Access Pattern");
+		w.StartObject();
+		for(auto& [access_pattern, io_size] : global_iosize_per_access_pattern) {
+			w.Key(access_pattern_to_string(access_pattern));
+			w.Uint64(io_size);
+		}
+		w.EndObject();
+
+        w.EndObject();
+    }
+};
+
+/** @brief Stores stats per region for output
+ * TODO: NEXT
+ * */
+struct RegionInfo {
+    RegionInfo() {}
+	/* Construct Region info given io_handle-id (from Definitions) */
+    RegionInfo(const definitions::Definitions& defs, uint64_t id) {
+        const definitions::IoHandle* self = defs.iohandles.get(id);
+        if (!self)
+            return;
+        const definitions::IoHandle* parent = defs.iohandles.get(self->parent);
+        region_name= self->file_handle->file_name;
+        paradigm.insert(defs.io_paradigms.get(self->io_paradigm)->name);
+        modes = self->modes;
+    }
+
+    void operator+=(const FileInfo& rhs) {
+        region_name = rhs.filename;
+        std::copy(rhs.paradigm.begin(), rhs.paradigm.end(), std::inserter(paradigm, paradigm.begin()));
+        std::copy(rhs.modes.begin(), rhs.modes.end(), std::inserter(modes, modes.begin()));
+
+		// TODO: Size/Timing stats are collected elsewhere (`bytes_read`,`bytes_write`,`time_spent_in_ticks`)
+    }
+
+	/* Region/Function name */
+    std::string           region_name;
+	std::string			  region_begin_src_line;
+	std::string			  region_end_src_line;
+	/* File in which this region/functions is defined */
+	/* I/O Paradigms used to perform I/O on file */
+    std::set<std::string> paradigm;
+	/* Modes in which file was opened (read/write) */
+	std::set<std::string> modes;
+	// WIP:
+	/* Bytes read from by this region */
+	std::uint64_t		  bytes_read=0;
+	/* Bytes written by this region */
+	std::uint64_t		  bytes_write=0;
+	/* Time spent reading/writing by this region */
+	std::uint64_t		  time_spent_in_ticks=0;
+	/* Top 5 other regions that called this region (by nr of calls) with `std::string` being the name of the calling region
+	 * @note data is taken from @ref{AllData} (field `const_cast<std::map<const Region*, uint64_t>&>(my_map);`)
+	 * */
+	std::map<std::string, uint64_t> region_callees_top5; // TODO
+	// TODO: time spent for meta-ops
+
+    template <typename Writer>
+    void WriteRegionInfo(Writer& w, const std::map<std::string, RegionInfo>* io_per_region) const {
+		if(io_per_region == nullptr) {
+			std::cerr << "Encountered io_per_region=nullptr" << std::endl;
+			return;
+		}
+
+        w.StartObject();
+        w.Key("RegionName");
+        w.String(region_name.c_str());
+
+        w.Key("IoParadigm");
+        w.StartArray();
+        for (const auto& pstr : paradigm) {
+            w.String(pstr.c_str());
+        }
+        w.EndArray();
+        w.Key("AccessModes");
+        std::string merged_modes;
+        for (const auto& modestr : modes) {
+            merged_modes += modestr;
+        }
+        w.String(merged_modes.c_str());
+
+		w.Key("#Bytes read");
+		w.Uint64(bytes_read);
+		w.Key("#Bytes write");
+		w.Uint64(bytes_write);
+		w.Key("Ticks spent");
+		w.Uint64(time_spent_in_ticks);
+
+		w.Key("Top 5 Callees");
+        w.StartArray();
+        for (const auto& pstr : region_callees_top5) {
+			std::string parent_begin_src_line = "?", parent_end_src_line = "?";
+			if(io_per_region->find(pstr.first) != io_per_region->end()) {
+				// TODO: src-lines not working (yet)
+				auto parent_region_info = io_per_region->find(pstr.first)->second;
+				parent_begin_src_line = parent_region_info.region_begin_src_line;
+				parent_end_src_line = parent_region_info.region_end_src_line;
+			}
+
+			w.StartObject();
+			w.Key("Region name");
+            w.String(pstr.first.c_str());
+			w.Key("Source lines");
+			w.String((parent_begin_src_line + "-" + parent_end_src_line).c_str());
+			w.Key("Nr calls");
+			w.Uint64(pstr.second);
+			w.EndObject();
+        }
+        w.EndArray();
+
+        w.EndObject();
+    }
+};
+
+/**
+ * Data structure for storing resulting profile to output
+ */
+struct WorkflowProfile {
+    uint64_t                            job_id;
+	/* Nr of Nodes used during execution of traced program */
+    uint32_t                            node_count;
+	/* Nr of Processes used during execution of traced program */
+    uint32_t                            process_count;
+	/* Nr of Threads used during execution of traced program */
+    uint32_t                            thread_count;
+	/* Ticks per second */
+    uint64_t                            timer_resolution;
+    std::map<std::string, uint64_t>     counters;
+    std::map<std::string, ProfileEntry> functions_by_paradigm;
+    std::map<std::string, ProfileEntry> messages_by_paradigm;
+	/* Nr of collective operations executed per paradigm */
+    std::map<std::string, ProfileEntry> collops_by_paradigm;
+	/* Nr of I/O operations executed per I/O paradigm */
+    std::map<std::string, ProfileEntry> io_ops_by_paradigm;
+	/* Statistics per file */
+    std::map<std::string, FileInfo>     file_data;
+	/* Statistics per location (rank/process) */
+    std::map<OTF2_LocationRef, LocationInfo>     location_data;
+	/* Statistics per srcline in a region */
+	std::map<std::string, RegionInfo>   io_per_region; // TODO !
+	/* Time (in ticks) spent executing parallel regions */
+    uint64_t                            parallel_region_time;
+	/* Time (in ticks) spent executing serial regions */
+    uint64_t                            serial_time;
+    uint64_t                            num_functions;
+    uint64_t                            num_invocations;
+	/* Path to otf2 trace-file (for which profile is being generated) */
+    std::string                         filename;
+    uint64_t                            traceID;
+	/* Analysed time window (--begin/--end), not written if the whole trace is analysed */
+    TimeWindow                          time_window;
+	/* Selected locations (--rank/--thread/--node), not written if all locations are read */
+    std::string                         filter_ranks;
+    std::string                         filter_threads;
+    std::vector<std::string>            filter_nodes;
+	/* Runtime of the profiler itself (--self-profile), not written if nullptr */
+    const TimeMeasurement*              self_profile = nullptr;
+    template <typename Writer>
+    void WriteProfile(Writer& w) const;
+    WorkflowProfile()
+        : job_id(0),
+          node_count(0),
+          process_count(0),
+          thread_count(0),
+          parallel_region_time(0),
+          serial_time(0),
+          num_functions(0),
+          num_invocations(0) {}
+};
+
+template <typename Map, typename Writer>
+void WriteMapUnderKey(std::string key, const Map& m, Writer& w) {
+    if (m.empty())
+        return;
+    w.Key(key.c_str());
+    w.StartObject();
+    for (const auto& kv : m) {
+        w.Key(kv.first.c_str());
+        kv.second.WriteProfile(w);
+    }
+    w.EndObject();
+}
+
+/* Phases (scopes of `tm`, nested by their "Parent") and event callbacks of the profiler run */
+template <typename Writer>
+void WriteSelfProfile(const TimeMeasurement& tm, Writer& w) {
+    w.Key("SelfProfile");
+    w.StartObject();
+    w.Key("Phases");
+    w.StartArray();
+    tm.forEachScope([&](ScopeID, const TimeMeasurement::Scope& scope) {
+        w.StartObject();
+        w.Key("Name");
+        w.String(scope.desc.c_str());
+        if (scope.parent.has_value()) {
+            w.Key("Parent");
+            w.String(tm.getScope(*scope.parent).desc.c_str());
+        }
+        w.Key("Seconds");
+        w.Double(scope.seconds());
+        // scopes around the JSON output are still running
+        w.Key("Finished");
+        w.Bool(!scope.running);
+        if (!scope.running) {
+            w.Key("PeakRSS_KiB");
+            w.Uint64(scope.peak_rss);
+            w.Key("RSSGrowth_KiB");
+            w.Uint64(scope.rss_growth);
+        }
+        w.EndObject();
+    });
+    w.EndArray();
+
+    w.Key("Callbacks");
+    w.StartObject();
+    w.Key("SampleInterval");
+    w.Uint64(CallbackProfile::SAMPLE_INTERVAL);
+    for (size_t i = 0; i < tm.callbacks.counters.size(); ++i) {
+        const auto& counter = tm.callbacks.counters[i];
+        if (counter.count == 0)
+            continue;
+        w.Key(callbackName(static_cast<CallbackID>(i)));
+        w.StartObject();
+        w.Key("Count");
+        w.Uint64(counter.count);
+        w.Key("Samples");
+        w.Uint64(counter.samples);
+        w.Key("EstimatedSeconds");
+        w.Double(counter.estimated_seconds());
+        w.EndObject();
+    }
+    w.EndObject();
+    w.EndObject();
+}
+
+template <typename Writer>
+void WorkflowProfile::WriteProfile(Writer& w) const {
+    w.StartObject();
+    w.Key("Trace");
+    w.StartObject();
+    w.Key("FileName");
+    w.String(filename.c_str());
+    w.Key("Id");
+    w.Uint64(traceID);
+    if (time_window.is_set()) {
+        w.Key("TimeWindow");
+        w.StartObject();
+        w.Key("Begin");
+        w.Uint64(time_window.begin);
+        w.Key("End");
+        w.Uint64(time_window.end);
+        w.EndObject();
+    }
+    if (!filter_ranks.empty() || !filter_threads.empty() || !filter_nodes.empty()) {
+        w.Key("LocationFilter");
+        w.StartObject();
+        if (!filter_ranks.empty()) {
+            w.Key("Ranks");
+            w.String(filter_ranks.c_str());
+        }
+        if (!filter_threads.empty()) {
+            w.Key("Threads");
+            w.String(filter_threads.c_str());
+        }
+        if (!filter_nodes.empty()) {
+            w.Key("Nodes");
+            w.StartArray();
+            for (const auto& node : filter_nodes)
+                w.String(node.c_str());
+            w.EndArray();
+        }
+        w.EndObject();
+    }
+    w.EndObject();
+    w.Key("JobId");
+    w.Uint64(job_id);
+    w.Key("NodeCount");
+    w.Uint(node_count);
+    w.Key("ProcessCount");
+    w.Uint(process_count);
+    w.Key("ThreadCount");
+    w.Uint(thread_count);
+    w.Key("TimerResolution");
+    w.Uint64(timer_resolution);
+    w.Key("HardwareCounters");
+    w.StartArray();
+    for (const auto& c : counters) {
+        w.Key(c.first.c_str());
+        w.Uint64(c.second);
+    }
+    w.EndArray();
+    WriteMapUnderKey("Functions", functions_by_paradigm, w);
+    WriteMapUnderKey("Messages", messages_by_paradigm, w);
+    WriteMapUnderKey("CollectiveOperations", collops_by_paradigm, w);
+    WriteMapUnderKey("IOOperations", io_ops_by_paradigm, w);
+
+    w.Key("Files");
+    w.StartArray();
+    for (const auto& f : file_data) {
+        f.second.WriteFileInfo(w);
+    }
+    w.EndArray();
+
+
+    w.Key("Locations");
+    w.StartArray();
+    for (const auto& l : location_data) {
+        l.second.WriteLocationInfo(w);
+    }
+    w.EndArray();
+
+    w.Key("Regions");
+    w.StartArray();
+    for (const auto& f : io_per_region) {
+        f.second.WriteRegionInfo(w, &io_per_region);
+    }
+    w.EndArray();
+
+    // WriteMapUnderKey("Regions", io_per_region, w);
+
+    w.Key("ParallelRegionTime");
+    w.Uint64(parallel_region_time);
+    w.Key("SerialRegionTime");
+    w.Uint64(serial_time);
+    w.Key("TotalFunctions");
+    w.Uint64(num_functions);
+    w.Key("TotalCalls");
+    w.Uint64(num_invocations);
+    if (self_profile != nullptr)
+        WriteSelfProfile(*self_profile, w);
+    w.EndObject();
+}
+
+#endif
@@ -11,30 +11,39 @@
 #include "otf2/OTF2_GeneralDefinitions.h"
 #include "tracereader.h"
 #include <array>
+#include <functional>
+#include <string_view>
+#include "definitions_cache.h"
+#include "dense_id_map.h"
 
 /**
  * Used to translater `OTF2_StringRef` (for OTf2) into actual strings
+ * - all strings are interned into one contiguous arena, a ref only maps to its position in there
+ * - the returned views are invalidated by the next `add`
  */
 template <typename RefT>
 class StringIdentifier {
    public:
     template <typename... Refs>
-    using Result_t = std::array<std::string*, sizeof...(Refs)>;
+    using Result_t = std::array<std::string_view, sizeof...(Refs)>;
 
    public:
-    StringIdentifier() { string_definitions[OTF2_UNDEFINED_STRING] = ""; }
+    StringIdentifier() { add(OTF2_UNDEFINED_STRING, ""); }
 
-    void add(RefT ref, const char* string_def) { string_definitions[ref] = string_def; }
+    void add(RefT ref, std::string_view string_def) {
+        string_definitions[ref] = {arena.size(), string_def.size()};
+        arena.append(string_def);
+    }
 
     template <typename... Refs>
-    const std::pair<Result_t<Refs...>, OTF2_CallbackCode> get(Refs... refs) {
+    const std::pair<Result_t<Refs...>, OTF2_CallbackCode> get(Refs... refs) const {
         auto              pos = 0;
         Result_t<Refs...> result{};
 
         for (const auto& ref : {refs...}) {
-            auto it = string_definitions.find(ref);
-            if (it != string_definitions.end())
-                result[pos] = &it->second;
+            const auto* def = string_definitions.find(ref);
+            if (def != nullptr)
+                result[pos] = std::string_view(arena.data() + def->offset, def->length);
             else
                 return std::make_pair(result, OTF2_CALLBACK_INTERRUPT);
 
@@ -45,7 +54,114 @@ class StringIdentifier {
     }
 
    private:
-    std::map<RefT, std::string> string_definitions;
+    struct ArenaSlice {
+        size_t offset;
+        size_t length;
+    };
+
+    std::string                  arena;
+    DenseIdMap<RefT, ArenaSlice> string_definitions;
+};
+
+/**
+ * Definition tables of one trace, filled by the global definition callbacks (passed to them as `userData`)
+ */
+struct TraceContext {
+    AllData* alldata = nullptr;
+
+    /* Mapping of `OTF2_StringRef`s & `OTF2_IoFileRef`s to strings */
+    StringIdentifier<OTF2_StringRef> string_id;
+    StringIdentifier<OTF2_IoFileRef> filesystem_entries;
+    /* CPU/GPU locations whose events are read */
+    std::vector<LocationDef> locationList;
+};
+
+/** Keeps track of I/O operations that have begun but not yet completed */
+struct PendingIoEvt {
+    OTF2_TimeStamp begin_time;
+    uint64_t       bytes_request;
+};
+
+/**
+ * State of the location whose events are currently read, reset before reading the next location
+ */
+struct LocationContext {
+    /* Stack of entered regions: used to determine which region we are currently in */
+    std::deque<StackData> node_stack;
+    // metric id (real), data
+    std::map<uint64_t, MetricData> tmp_metric;
+    /* Keep track of open I/O events (since `IO_OPERATION_BEGIN`&`IO_OPERATION_END` might be nested arbitrarily
+     * - used to keep track of eg statistics inside @ref IoData
+     */
+    std::map<uint64_t, PendingIoEvt> open_io_events;
+    /* Regions entered before the analysed time window that have not been left yet, they are added to `node_stack`
+     * (as entered at the begin of the window) by the first event inside the window */
+    std::vector<OTF2_RegionRef> skipped_regions;
+    /* Set by the first event after the analysed time window, reading of the location is interrupted there */
+    bool past_window = false;
+    /* Stack of entered regions in --io-only mode (instead of `node_stack`) */
+    std::vector<OTF2_RegionRef> region_stack;
+
+    /* Region the location is currently in, OTF2_UNDEFINED_REGION if it is in none */
+    OTF2_RegionRef current_region() const {
+        if (!node_stack.empty())
+            return node_stack.front().node_p->function_id;
+        if (!region_stack.empty())
+            return region_stack.back();
+        return OTF2_UNDEFINED_REGION;
+    }
+};
+
+/**
+ * Statistics collected from the events of one location group (=process)
+ * - every reader thread fills its own PartialEventData, which are merged into @ref AllData in the order of the
+ *   location groups once all events are read (so the result does not depend on the nr of threads)
+ * - IoHandles are copied on first access, so the shared definitions are not modified while other threads are reading
+ */
+struct PartialEventData {
+    /* Definitions & meta data, only read while reading events */
+    AllData* alldata;
+
+    data_tree                                                     call_path_tree;
+    std::map<uint64_t, IoData>                                    io_data_per_paradigm;
+    std::map<OTF2_LocationRef, IoData>                            io_data_per_location;
+    std::map<OTF2_RegionRef, std::map<OTF2_RegionRef, uint64_t>> parent_regions_by_callcount;
+    /* Local copies of all IoHandles that have been used by the events of this location group */
+    std::map<OTF2_IoHandleRef, definitions::IoHandle> iohandles;
+    /* Sizes of the files as written by this location group, see @ref file_size */
+    std::map<const definitions::File*, uint64_t> file_sizes;
+
+    LocationContext location_ctx;
+
+    /* see --self-profile */
+    CallbackProfile callbacks;
+
+    PartialEventData(AllData* alldata) : alldata(alldata) { callbacks.enabled = alldata->tm.callbacks.enabled; }
+
+    /** Returns local copy of IoHandle `handle` (without the statistics collected so far), nullptr if it is undefined */
+    definitions::IoHandle* iohandle(OTF2_IoHandleRef handle) {
+        auto it = iohandles.find(handle);
+        if (it != iohandles.end())
+            return &it->second;
+
+        const auto* def = alldata->definitions.iohandles.get(handle);
+        if (def == nullptr)
+            return nullptr;
+
+        definitions::IoHandle local(def->self, def->file_handle, def->io_paradigm, def->file, def->parent);
+        local.location = def->location;
+        local.modes    = def->modes;
+        local.fpos     = def->fpos;
+        return &iohandles.emplace(handle, std::move(local)).first->second;
+    }
+
+    /** Size of `file` (relative to its size before the traced program) as written by this location group
+     *  @note Not shared with the other groups, so offsets from the end of a file don't depend on the order the groups
+     *  are read in (or on the nr of threads), the sizes of all groups are combined by @ref merge_into */
+    uint64_t& file_size(const definitions::File& file) { return file_sizes[&file]; }
+
+    /** Adds the collected statistics to `alldata`, called once per location group in the order of the groups */
+    void merge_into(AllData& alldata);
 };
 
 class OTF2Reader : public TraceReader {
@@ -61,7 +177,20 @@ class OTF2Reader : public TraceReader {
     bool readStatistics(AllData& alldata) override;
 
    private:
-    OTF2_Reader* _reader;
+    OTF2_Reader* _reader = nullptr;
+    TraceContext _trace;
+
+    /** Reads the global definitions (or loads them from the --def-cache), without resolving the time window */
+    bool readGlobalDefinitions(AllData& alldata);
+
+    /** Removes the locations not selected by --rank/--thread/--node from the location list, before any of their
+     *  event files is opened */
+    void selectLocations(AllData& alldata);
+
+    /** Reads local definitions and events of all `locations` (of one location group) into `partial`
+     *  @param progress called with the nr of events read after every batch of events */
+    bool readLocationGroup(const std::vector<LocationDef>& locations, OTF2_EvtReaderCallbacks* evt_callbacks,
+                           PartialEventData& partial, const std::function<void(uint64_t)>& progress);
 
    private:
     /* ************************************************************** */
@@ -196,6 +325,15 @@ class OTF2Reader : public TraceReader {
                                                  uint64_t eventPosition, void* userData,
                                                  OTF2_AttributeList* attributeList, OTF2_RegionRef region);
 
+    /** @brief Enter/Leave callbacks of the --io-only mode: only keep track of the region a location is in (to which
+     *  its I/O operations are attributed), without building the call-path tree */
+    static inline OTF2_CallbackCode handle_enter_io_only(OTF2_LocationRef locationID, OTF2_TimeStamp time,
+                                                         uint64_t eventPosition, void* userData,
+                                                         OTF2_AttributeList* attributeList, OTF2_RegionRef region);
+    static inline OTF2_CallbackCode handle_leave_io_only(OTF2_LocationRef locationID, OTF2_TimeStamp time,
+                                                         uint64_t eventPosition, void* userData,
+                                                         OTF2_AttributeList* attributeList, OTF2_RegionRef region);
+
     /** @brief Callback for the MpiSend event record.
      *
      *  A MpiSend record indicates that a MPI message send process was
@@ -0,0 +1,30 @@
+/*
+ This is part of the OTF-Profiler. Copyright by ZIH, TU Dresden 2016-2018.
+ Authors: Maximillian Neumann, Denis Hünich, Jens Doleschal
+*/
+
+#ifndef DEFINITIONS_BROADCAST_H
+#define DEFINITIONS_BROADCAST_H
+
+#include <vector>
+
+#include "definitions_cache.h"
+
+/**
+ * @brief Distribution of the global definitions read by rank 0 (see --bcast-defs, otf-profiler-mpi only)
+ *
+ * Rank 0 serializes the snapshot of @ref definitions_cache & broadcasts it, the other ranks decode it instead of
+ * opening & parsing the global definition file themselves.
+ * With --shared-defs the snapshot is only sent to one rank per node, which receives it into a shared memory window
+ * (MPI_Win_allocate_shared) the other ranks of the node decode it from.
+ */
+namespace definitions_broadcast {
+
+/** Collective over MPI_COMM_WORLD, rank 0 passes the definitions it has read in `alldata` & `locations`
+ *  @param have_definitions false on rank 0 if it couldn't read the definitions (ignored on the other ranks)
+ *  @returns false on all ranks if rank 0 had no definitions, false on a rank that couldn't decode them */
+bool broadcast(AllData& alldata, std::vector<LocationDef>& locations, bool have_definitions);
+
+}  // namespace definitions_broadcast
+
+#endif /* DEFINITIONS_BROADCAST_H */
@@ -0,0 +1,70 @@
+/*
+ This is part of the OTF-Profiler. Copyright by ZIH, TU Dresden 2016-2018.
+ Authors: Maximillian Neumann, Denis Hünich, Jens Doleschal
+*/
+
+#ifndef DEFINITIONS_CACHE_H
+#define DEFINITIONS_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "all_data.h"
+
+/** Location whose events are read, as announced by its global definition */
+struct LocationDef {
+    OTF2_LocationRef      id;
+    OTF2_LocationGroupRef group;
+    uint64_t              number_of_events;
+};
+
+/**
+ * A cache file is only used for the trace it was written from:
+ * the trace id of the archive, the modification time of its anchor file and the options that change which
+ * definitions are read have to match
+ */
+struct DefinitionsCacheKey {
+    uint64_t trace_id     = 0;
+    int64_t  anchor_mtime = 0;
+    bool     read_metrics = true;
+
+    bool operator==(const DefinitionsCacheKey& rhs) const {
+        return trace_id == rhs.trace_id && anchor_mtime == rhs.anchor_mtime && read_metrics == rhs.read_metrics;
+    }
+};
+
+/**
+ * @brief Snapshot of the global definitions of a trace (see --def-cache)
+ *
+ * Holds the state the global definition callbacks leave behind: `alldata.definitions`, clock properties,
+ * communicators and the list of locations whose events are read. All strings are stored once in a string table at
+ * the end of the file, the records refer to them by index. The file is read with a single read and decoded from
+ * that buffer, so loading it costs about as much as copying the definitions.
+ *
+ * The same snapshot is broadcast by rank 0 of otf-profiler-mpi with --bcast-defs (see definitions_broadcast.h).
+ */
+namespace definitions_cache {
+
+/** Serializes the snapshot into `buffer` (replacing its content), in the layout of the cache file */
+void serialize(const DefinitionsCacheKey& key, const AllData& alldata, const std::vector<LocationDef>& locations,
+               std::string& buffer);
+
+/** Restores a snapshot serialized by @ref serialize, false (without touching `alldata` & `locations`) if it is
+ *  damaged or doesn't match `key` */
+bool deserialize(std::string_view buffer, const DefinitionsCacheKey& key, AllData& alldata,
+                 std::vector<LocationDef>& locations);
+
+/** Writes the snapshot to `path` (via a temporary file that is renamed, so readers never see a partial cache) */
+bool store(const std::string& path, const DefinitionsCacheKey& key, const AllData& alldata,
+           const std::vector<LocationDef>& locations);
+
+/** Loads the snapshot from `path` into `alldata` & `locations`, false (without touching them) if there is no cache,
+ *  it is damaged or doesn't match `key` */
+bool load(const std::string& path, const DefinitionsCacheKey& key, AllData& alldata,
+          std::vector<LocationDef>& locations);
+
+}  // namespace definitions_cache
+
+#endif /* DEFINITIONS_CACHE_H */
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Distributes the location groups of a trace to the workers (reader threads or MPI ranks) that read them
+ *
+ * - every unit of work (=location group) is weighted by its nr of events (`numberOfEvents` of its locations)
+ * - units are handed out largest-first: in order of descending weight every unit is appended to the queue of the
+ *   worker with the least total weight so far (ties go to the lower worker/unit index, so all ranks compute the same
+ *   assignment)
+ * - a worker processes its own queue front to back; once it ran out of work it steals the next pending unit of the
+ *   worker with the most pending weight
+ *
+ * Only the position of the next pending unit of every queue (its "head") is shared between the workers. How the heads
+ * are stored is up to the caller, see @ref next.
+ */
+class LocationScheduler {
+   public:
+    LocationScheduler(const std::vector<uint64_t>& weights, uint32_t num_workers);
+
+    uint32_t num_workers() const { return _queues.size(); }
+
+    /** Units assigned to `worker`, in the order they are processed */
+    const std::vector<size_t>& queue(uint32_t worker) const { return _queues[worker]; }
+
+    /** Total weight of the units of `worker`'s queue starting at position `head` */
+    uint64_t pending_weight(uint32_t worker, uint64_t head) const {
+        return head < _queues[worker].size() ? _suffix_weights[worker][head] : 0;
+    }
+
+    /**
+     * @brief Returns the next unit `worker` should process, std::nullopt if all units have been taken
+     *
+     * @param heads provides atomic access to the heads of the queues:
+     *        `uint64_t load(uint32_t w)` and `uint64_t fetch_inc(uint32_t w)` (returns the head before incrementing)
+     * @param stolen set to true if the unit was taken from the queue of another worker
+     */
+    template <typename Heads>
+    std::optional<size_t> next(uint32_t worker, Heads& heads, bool& stolen) const {
+        stolen = false;
+
+        auto pos = heads.fetch_inc(worker);
+        if (pos < _queues[worker].size())
+            return _queues[worker][pos];
+
+        while (true) {
+            // victim: worker with the most pending weight
+            uint32_t victim      = worker;
+            uint64_t max_pending = 0;
+            for (uint32_t w = 0; w < _queues.size(); ++w) {
+                auto head = heads.load(w);
+                if (w == worker || head >= _queues[w].size())
+                    continue;
+
+                auto pending = pending_weight(w, head);
+                if (victim == worker || pending > max_pending) {
+                    victim      = w;
+                    max_pending = pending;
+                }
+            }
+
+            if (victim == worker)
+                return std::nullopt;
+
+            pos = heads.fetch_inc(victim);
+            if (pos < _queues[victim].size()) {
+                stolen = true;
+                return _queues[victim][pos];
+            }
+        }
+    }
+
+   private:
+    std::vector<std::vector<size_t>>   _queues;
+    std::vector<std::vector<uint64_t>> _suffix_weights;
+};
+
+/** Heads of the queues of a @ref LocationScheduler shared between threads of one process */
+class LocalSchedulerHeads {
+   public:
+    LocalSchedulerHeads(uint32_t num_workers) : _heads(new std::atomic<uint64_t>[num_workers]) {
+        for (uint32_t w = 0; w < num_workers; ++w)
+            _heads[w] = 0;
+    }
+
+    uint64_t load(uint32_t worker) { return _heads[worker].load(); }
+    uint64_t fetch_inc(uint32_t worker) { return _heads[worker]++; }
+
+   private:
+    std::unique_ptr<std::atomic<uint64_t>[]> _heads;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Progress of reading the events of a trace, reported at verbose level 1
+ *
+ * - readers add the nr of events they have read once per batch (see @ref OTF2Reader::readLocationGroup), so the
+ *   counters are not touched per event
+ * - `total_events` is the sum of `numberOfEvents` of the read locations
+ * - the bytes read are estimated from the size of the event files of the archive, the profiler doesn't see the I/O
+ *   OTF2 does
+ */
+class ProgressReporter {
+   public:
+    using clock = std::chrono::steady_clock;
+
+    /** @param interval min. time between two reports in seconds
+     *  @param bytes_per_event estimated size of an event in the archive, 0 if unknown (no MB/s is reported then) */
+    ProgressReporter(uint64_t total_events, double bytes_per_event, double interval = 5.0)
+        : total_events(total_events),
+          bytes_per_event(bytes_per_event),
+          interval_ms(static_cast<int64_t>(interval * 1000)),
+          start(clock::now()),
+          next_report_ms(interval_ms) {}
+
+    /** Adds `events` read by one batch, returns the nr of events read so far (thread-safe) */
+    uint64_t add(uint64_t events) { return processed.fetch_add(events) + events; }
+
+    uint64_t events_processed() const { return processed.load(); }
+
+    /** True at most once per interval, for the caller that should print the next report (thread-safe) */
+    bool report_due() { return report_due(elapsed_ms()); }
+
+    /** As @ref report_due, at `now_ms` ms since reading started */
+    bool report_due(int64_t now_ms);
+
+    /** Seconds since reading started */
+    double elapsed() const { return std::chrono::duration<double>(clock::now() - start).count(); }
+
+    /** Milliseconds since reading started */
+    int64_t elapsed_ms() const {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+    }
+
+    /** Report after `events` were read in `elapsed` seconds, eg
+     *  "OTF2: 42.0% of 1000000 events, 21000 events/s, 3.2 MB/s, ETA 0:00:27" */
+    std::string format(uint64_t events, double elapsed) const;
+
+    /** Summary once all events are read */
+    std::string format_summary(uint64_t events, double elapsed) const;
+
+   private:
+    uint64_t              total_events;
+    double                bytes_per_event;
+    int64_t               interval_ms;
+    clock::time_point     start;
+    std::atomic<uint64_t> processed{0};
+    /* ms since `start` at which the next report is due */
+    std::atomic<int64_t> next_report_ms;
+};
+
+/** Size of all event files of the OTF2 archive `archive_dir` in bytes, 0 if it couldn't be determined */
+uint64_t archive_event_bytes(const std::string& archive_dir);
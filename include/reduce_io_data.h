@@ -0,0 +1,28 @@
+/*
+ This is part of the OTF-Profiler. Copyright by ZIH, TU Dresden 2016-2018.
+ Authors: Maximillian Neumann, Denis Hünich, Jens Doleschal
+*/
+
+#ifndef REDUCE_IO_DATA_H
+#define REDUCE_IO_DATA_H
+
+#include <cstdint>
+#include <vector>
+#include "all_data.h"
+
+/*
+ * I/O statistics sent to the master process by ReduceData (next to the call-path tree)
+ * - `io_data_per_paradigm`, `io_data_per_location` & `parent_regions_by_callcount`
+ * - per IoHandle with I/O on the sending rank: its IoData, location & modes, the result of its local access pattern
+ *   detection (already finished by the sender) & its I/O accesses (needed for the global access pattern of a file,
+ *   whose IoHandles might be spread across ranks)
+ */
+
+/* Appends the I/O statistics of `alldata` to `out` */
+void serialize_io_data(const AllData& alldata, std::vector<uint8_t>& out);
+
+/* Adds the I/O statistics serialized by another rank to `alldata`
+ * @returns false if `data` is truncated or refers to IoHandles that are not defined */
+bool merge_io_data(AllData& alldata, const uint8_t* data, size_t size);
+
+#endif /* REDUCE_IO_DATA_H */
@@ -6,9 +6,14 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <sys/resource.h>
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <iostream>
 #include <map>
+#include <optional>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -28,13 +33,160 @@ You then surround the function call of the new module like this:
     <module_call>(alldata);
     alldata.tm.stop(ScopeID::<scope_id>);
 
+Scopes started while another scope is running are nested into it (eg DEFINITIONS & EVENTS into COLLECT).
+
 Example for CUBE:
 */
 
-enum class ScopeID : uint8_t { TOTAL, COLLECT, REDUCE, CUBE, JSON ,DOT};
+enum class ScopeID : uint8_t { TOTAL, COLLECT, DEFINITIONS, EVENTS, REDUCE, CUBE, JSON, JSON_FILES, JSON_WRITE, BINARY_WRITE, DOT };
+
+/* Event callbacks whose invocations are counted by the self profile (see --self-profile) */
+enum class CallbackID : uint8_t {
+    ENTER,
+    LEAVE,
+    METRIC,
+    MPI_SEND,
+    MPI_ISEND,
+    MPI_RECV,
+    MPI_IRECV,
+    MPI_COLLECTIVE_END,
+    IO_CREATE_HANDLE,
+    IO_OPERATION_BEGIN,
+    IO_OPERATION_COMPLETE,
+    IO_SEEK,
+    NUM_CALLBACKS
+};
+
+inline const char* callbackName(CallbackID id) {
+    static const char* names[] = {"Enter",
+                                  "Leave",
+                                  "Metric",
+                                  "MpiSend",
+                                  "MpiIsend",
+                                  "MpiRecv",
+                                  "MpiIrecv",
+                                  "MpiCollectiveEnd",
+                                  "IoCreateHandle",
+                                  "IoOperationBegin",
+                                  "IoOperationComplete",
+                                  "IoSeek"};
+    return names[static_cast<size_t>(id)];
+}
+
+/**
+ * Invocation counts & time spent in the event callbacks
+ * - collected per reader (see PartialEventData) and summed up afterwards, so no synchronization is needed
+ * - every invocation is counted, only every SAMPLE_INTERVAL-th one is timed: the time of all invocations is
+ *   extrapolated from the samples, which keeps the clock reads out of most callbacks
+ */
+struct CallbackProfile {
+    static constexpr uint64_t SAMPLE_INTERVAL = 64;
+
+    struct Counter {
+        uint64_t count      = 0;
+        uint64_t samples    = 0;
+        uint64_t sampled_ns = 0;
+
+        double estimated_seconds() const { return samples > 0 ? 1e-9 * sampled_ns * count / samples : 0; }
+    };
+
+    bool                                                                   enabled = false;
+    std::array<Counter, static_cast<size_t>(CallbackID::NUM_CALLBACKS)> counters{};
+
+    void merge(const CallbackProfile& rhs) {
+        for (size_t i = 0; i < counters.size(); ++i) {
+            counters[i].count += rhs.counters[i].count;
+            counters[i].samples += rhs.counters[i].samples;
+            counters[i].sampled_ns += rhs.counters[i].sampled_ns;
+        }
+    }
+};
+
+/* Counts one invocation of a callback and times it if it is sampled, for the lifetime of the object */
+class CallbackTimer {
+   public:
+    CallbackTimer(CallbackProfile& profile, CallbackID id) {
+        if (!profile.enabled)
+            return;
+
+        auto& counter = profile.counters[static_cast<size_t>(id)];
+        if (counter.count++ % CallbackProfile::SAMPLE_INTERVAL == 0) {
+            sampled    = &counter;
+            start_time = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~CallbackTimer() {
+        if (sampled == nullptr)
+            return;
+
+        ++sampled->samples;
+        sampled->sampled_ns +=
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time)
+                .count();
+    }
+
+    CallbackTimer(const CallbackTimer&)            = delete;
+    CallbackTimer& operator=(const CallbackTimer&) = delete;
+
+   private:
+    CallbackProfile::Counter*             sampled = nullptr;
+    std::chrono::steady_clock::time_point start_time;
+};
+
+/* High-water mark of the resident set size of this process in KiB */
+inline uint64_t peakRSS() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return static_cast<uint64_t>(usage.ru_maxrss);
+}
 
 class TimeMeasurement {
    public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Scope {
+        // Description of scope
+        std::string desc;
+        // scope that was running when this scope was started the first time, nullopt for top level scopes
+        std::optional<ScopeID> parent;
+        uint32_t               depth = 0;
+        // start timestamp of the current measurement, if running
+        Clock::time_point start_time;
+        // sum of all measurements of this scope
+        Clock::duration duration{};
+        uint32_t        count   = 0;
+        bool            running = false;
+        // high-water mark of the resident set size at the end of the scope, and by how much the scope raised it (KiB)
+        uint64_t peak_rss     = 0;
+        uint64_t rss_growth   = 0;
+        uint64_t rss_at_start = 0;
+
+        Scope(const std::string _desc) : desc(_desc) {}
+
+        /* seconds measured so far, including the current measurement if it is still running */
+        double seconds() const {
+            auto total = duration;
+            if (running)
+                total += Clock::now() - start_time;
+            return std::chrono::duration<double>(total).count();
+        }
+
+        friend std::ostream& operator<<(std::ostream& os, const Scope& scope) {
+            if (scope.count == 0)
+                return os;
+
+            os << std::string(2 * scope.depth, ' ') << scope.desc << ": " << scope.seconds() << "s (peak RSS "
+               << scope.peak_rss / 1024 << " MiB";
+            if (scope.rss_growth > 0)
+                os << ", +" << scope.rss_growth / 1024 << " MiB";
+            os << ")";
+
+            return os;
+        }
+    };
+
     TimeMeasurement() = default;
 
     void registerScope(ScopeID scope_id, std::string desc) { scopes.insert(std::make_pair(scope_id, Scope(desc))); }
@@ -48,74 +200,202 @@ class TimeMeasurement {
 
     void start(ScopeID scope_id) {
         auto it = scopes.find(scope_id);
-        if (it == scopes.end())
+        if (it == scopes.end() || it->second.running)
             return;
 
-        it->second.start_time = std::chrono::system_clock::now();
+        auto& scope = it->second;
+        if (scope.count == 0) {
+            if (!open_scopes.empty()) {
+                scope.parent = open_scopes.back();
+                scope.depth  = scopes.at(open_scopes.back()).depth + 1;
+            }
+            order.push_back(scope_id);
+        }
+
+        open_scopes.push_back(scope_id);
+        scope.running      = true;
+        scope.rss_at_start = peakRSS();
+        scope.start_time   = Clock::now();
     }
 
     void stop(ScopeID scope_id) {
         auto it = scopes.find(scope_id);
-        if (it == scopes.end())
+        if (it == scopes.end() || !it->second.running)
             return;
 
-        it->second.stop_time = std::chrono::system_clock::now();
+        auto& scope = it->second;
+        scope.duration += Clock::now() - scope.start_time;
+        scope.running  = false;
+        ++scope.count;
+        scope.peak_rss = peakRSS();
+        scope.rss_growth += scope.peak_rss - scope.rss_at_start;
+
+        auto open = std::find(open_scopes.rbegin(), open_scopes.rend(), scope_id);
+        open_scopes.erase(std::next(open).base());
+    }
+
+    const Scope& getScope(ScopeID scope_id) const { return scopes.at(scope_id); }
+
+    /* calls `f(scope_id, scope)` for all scopes that have been started, parents before their children */
+    template <typename F>
+    void forEachScope(F&& f) const {
+        for (auto scope_id : order)
+            f(scope_id, scopes.at(scope_id));
     }
 
     void printAll() {
-        for (const auto& scope : scopes)
-            std::cout << scope.second << std::endl;
+        forEachScope([](ScopeID, const Scope& scope) { std::cout << scope << std::endl; });
     }
 
+    /* invocation counts & time of the event callbacks, only collected with --self-profile */
+    CallbackProfile callbacks;
+
    private:
-    struct Scope {
-        using TimePoint = std::chrono::system_clock::time_point;
+    // stores all registered scopes
+    std::map<ScopeID, Scope> scopes;
+    // scopes in the order they were started the first time
+    std::vector<ScopeID> order;
+    // currently running scopes, innermost last
+    std::vector<ScopeID> open_scopes;
+};
 
-        // Description of scope
-        const std::string desc;
-        // start timestamp of measurement scope
-        TimePoint start_time;
-        // end timestamp of measurement scope
-        TimePoint stop_time;
+/* Bound of the analysed time window (--begin/--end), either in seconds relative to the start of the trace
+ * (`globalOffset`) or in raw ticks (value with suffix `t`) */
+struct TimeBound {
+    bool     set      = false;
+    bool     in_ticks = false;
+    double   seconds  = 0;
+    uint64_t ticks    = 0;
+
+    bool parse(const std::string& value) {
+        try {
+            size_t pos;
+            if (!value.empty() && value.back() == 't') {
+                ticks    = std::stoull(value.substr(0, value.size() - 1), &pos);
+                in_ticks = true;
+                if (pos != value.size() - 1 || value[0] == '-')
+                    return false;
+            } else {
+                seconds = std::stod(value, &pos);
+                if (pos != value.size() || seconds < 0)
+                    return false;
+            }
+        } catch (const std::logic_error&) {
+            return false;
+        }
 
-        Scope(const std::string _desc) : desc(_desc), start_time(), stop_time() {}
+        set = true;
+        return true;
+    }
 
-        friend std::ostream& operator<<(std::ostream& os, const Scope& scope) {
-            if (scope.start_time == TimePoint() || scope.stop_time == TimePoint())
-                return os;
+    /* absolute timestamp (in ticks) */
+    uint64_t resolve(uint64_t timer_resolution, uint64_t global_offset) const {
+        if (in_ticks)
+            return ticks;
 
-            os << scope.desc << ": " << std::chrono::duration<double>(scope.stop_time - scope.start_time).count()
-               << "s";
+        return global_offset + static_cast<uint64_t>(seconds * timer_resolution);
+    }
+};
 
-            return os;
+/* Set of ids given as comma separated list of ids and ranges (eg `0-7,12`), an empty set selects all ids */
+struct IdRanges {
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+
+    bool parse(const std::string& list) {
+        ranges.clear();
+
+        size_t begin = 0;
+        while (begin <= list.size()) {
+            size_t end = list.find(',', begin);
+            if (end == std::string::npos)
+                end = list.size();
+
+            const std::string item = list.substr(begin, end - begin);
+            const size_t      dash = item.find('-');
+            try {
+                size_t   pos;
+                uint64_t first = std::stoull(item.substr(0, dash), &pos);
+                if (item.empty() || item[0] == '-' || pos != (dash == std::string::npos ? item.size() : dash))
+                    return false;
+
+                uint64_t last = first;
+                if (dash != std::string::npos) {
+                    const std::string last_str = item.substr(dash + 1);
+                    last                       = std::stoull(last_str, &pos);
+                    if (last_str.empty() || last_str[0] == '-' || pos != last_str.size() || last < first)
+                        return false;
+                }
+                ranges.emplace_back(first, last);
+            } catch (const std::logic_error&) {
+                return false;
+            }
+
+            begin = end + 1;
         }
-    };
 
-    // stores all registered scopes
-    std::map<ScopeID, Scope> scopes;
+        return true;
+    }
+
+    bool selects(uint64_t id) const {
+        if (ranges.empty())
+            return true;
+
+        for (const auto& range : ranges) {
+            if (range.first <= id && id <= range.second)
+                return true;
+        }
+        return false;
+    }
+
+    bool empty() const { return ranges.empty(); }
+
+    std::string to_string() const {
+        std::string list;
+        for (const auto& range : ranges) {
+            if (!list.empty())
+                list += ",";
+            list += std::to_string(range.first);
+            if (range.second != range.first)
+                list += "-" + std::to_string(range.second);
+        }
+        return list;
+    }
 };
 
 struct Params {
     uint32_t max_file_handles = 50;           // TODO sinn/unsinn?
     uint32_t buffer_size      = 1024 * 1024;  // TODO sinn/unsinn?
+    uint32_t num_threads      = 1;            // reader threads per rank
     // uint32_t    max_groups         = 16;
     // bool        logaxis            = true;
     uint8_t verbose_level = 0;
     // bool        read_from_stats    = false;
     double       node_min_ratio     = 0;
-    int32_t     rank               = -1;
+    IdRanges    ranks;                       // only read these location groups (=processes/ranks)
+    IdRanges    threads;                     // only read these locations (by their index inside their process)
+    std::vector<std::string> nodes;          // only read locations below these system tree nodes
     uint32_t    top_nodes          = 0;
     bool        read_metrics       = true;  // counter
     bool        output_type_set    = false;
     bool        create_cube        = false;
     bool        create_json        = false;
+    bool        compact_json       = false;  // JSON output without indentation & line breaks
+    bool        create_binary      = false;  // binary profile (same content as the JSON output, see binary_profile.h)
     bool        create_io_csv	   = false;
     bool        create_dot         = false;
     bool        data_dump           = false;
     bool        summarize_it       = false;  // TODO added for testing
+    bool        io_only            = false;  // only collect I/O statistics, no call-path tree
+    bool        self_profile       = false;  // count callbacks & write the SelfProfile section of the JSON output
+    TimeBound   window_begin;                // only analyse events inside [window_begin, window_end]
+    TimeBound   window_end;
     std::string input_file_name    = "";
     std::string input_file_prefix  = "";
     std::string output_file_prefix = "result";
+    std::string definitions_cache  = "";  // cache file of the global definitions, not used if empty
+    bool        broadcast_definitions = false;  // only rank 0 reads the global definitions & broadcasts them
+    bool        shared_definitions    = false;  // broadcast them once per node into a shared memory window
+    std::string binary_to_convert  = "";  // binary profile converted to JSON (--to-json), no trace is read
 
     bool parseCommandLine(int argc, char** argv) {
         // TODO help text and check for no arguments
@@ -135,21 +415,47 @@ struct Params {
                           << std::endl
                           << "      --cube              generates CUBE xml profile" << std::endl
                           << "      --json              generates json ouptut file" << std::endl
+                          << "      --compact-json      write the json output without indentation and line breaks" << std::endl
+                          << "      --binary            generates binary profile (<prefix>.otfprof) with the content of" << std::endl
+                          << "                          the json output (without SelfProfile)" << std::endl
+                          << "      --to-json <file>    converts the binary profile <file> to <prefix>.json, no trace is" << std::endl
+                          << "                          read" << std::endl
                           << "      --io 				collect detailed metrics about I/O, only supported with OTF2 (WIP)" << std::endl
+                          << "      --io-only           only collect I/O statistics (Files, IOOperations, Locations," << std::endl
+                          << "                          Regions without callers), skips call-path tree, metrics and MPI" << std::endl
+                          << "      --self-profile      add the runtime of the profiler's phases and callbacks to the" << std::endl
+                          << "                          json output (section SelfProfile)" << std::endl
                           << "      --dot               generates dot file for drawing graphs" << std::endl
                           << "        -fi, --filter <percent>    only show path, where a node took at least num \% of total time" << std::endl
                           << "        -t, --top <n>     only show top num nodes" << std::endl
-                          << "        -r, --rank <n>    only show specific rank" << std::endl
                           << "      --datadump          dump all data into json file" << std::endl
                           << std::endl
+                          << "      -r, --rank <list>   only read the events of these ranks (location groups)," << std::endl
+                          << "                          eg 0-7,12" << std::endl
+                          << "      --thread <list>     only read the events of these threads (index of a location" << std::endl
+                          << "                          inside its process, same format as --rank)" << std::endl
+                          << "      --node <name>       only read the events of locations below the system tree" << std::endl
+                          << "                          node <name> (can be given several times)" << std::endl
+                          << "      --begin <time>      only analyse events after <time>, given in seconds since the" << std::endl
+                          << "                          start of the trace or in ticks with suffix t (eg 1000t)" << std::endl
+                          << "      --end <time>        only analyse events before <time> (same format as --begin)" << std::endl
+                          << std::endl
                           << "      -b <size>           set buffersize of the reader in Byte" << std::endl
                           << "                          (default: 1 M)" << std::endl
                           << "      -f <n>              max. number of filehandles available per rank" << std::endl
                           << "                          (default: 50)" << std::endl
                           << "      -i <file>           specify the input tracefile name or json dump file" << std::endl
+                          << "      --def-cache <file>  load the global definitions from <file> if it was written for this" << std::endl
+                          << "                          trace, otherwise read them from the trace and write <file>" << std::endl
+                          << "      --bcast-defs        only rank 0 reads the global definitions and broadcasts them to" << std::endl
+                          << "                          the other ranks (otf-profiler-mpi)" << std::endl
+                          << "      --shared-defs       like --bcast-defs, but the definitions are sent once per node" << std::endl
+                          << "                          into memory shared by the ranks of the node" << std::endl
                           << "      -nm, --no-metrics   neglect metric events" << std::endl
                           << "      -o <prefix>         specify the prefix of output file(s)" << std::endl
                           << "                          (default: result)" << std::endl
+                          << "      --threads <n>       threads reading the locations of the trace and" << std::endl
+                          << "                          analyzing the I/O handles (default: 1)" << std::endl
                           << "      -v <level>          set verbosity level" << std::endl
                           << "      --version           prints version information" << std::endl;
 
@@ -174,6 +480,21 @@ struct Params {
                 create_json = true;
                 output_type_set = true;
 
+            } else if (arguments[i] == "--compact-json") {
+                compact_json = true;
+            } else if (arguments[i] == "--binary") {
+                create_binary   = true;
+                output_type_set = true;
+            } else if (arguments[i] == "--to-json") {
+                if (!checkNext(arguments, i))
+                    return false;
+
+                binary_to_convert = arguments[++i];
+                output_type_set   = true;
+            } else if (arguments[i] == "--io-only") {
+                io_only = true;
+            } else if (arguments[i] == "--self-profile") {
+                self_profile = true;
             } else if (arguments[i] == "--dot") {
                 create_dot = true;
                 output_type_set = true;
@@ -185,13 +506,21 @@ struct Params {
 
                 node_min_ratio = value;
                 ++i;
-            } else if (arguments[i] == "--rank" || arguments[i] == "-r") {
-                auto value = checkNextValue(arguments, i);
-                if (value < 0)
+            } else if (arguments[i] == "--rank" || arguments[i] == "-r" || arguments[i] == "--thread") {
+                if (!checkNext(arguments, i))
                     return false;
 
-                rank = value;
+                auto& ids = arguments[i] == "--thread" ? threads : ranks;
+                if (!ids.parse(arguments[i + 1])) {
+                    std::cerr << "ERROR: Invalid argument for option '" << arguments[i] << "'" << std::endl;
+                    return false;
+                }
                 ++i;
+            } else if (arguments[i] == "--node") {
+                if (!checkNext(arguments, i))
+                    return false;
+
+                nodes.push_back(arguments[++i]);
             } else if (arguments[i] == "--top" || arguments[i] == "-t") {
             auto value = checkNextValue(arguments, i);
             if (value < 0)
@@ -208,6 +537,16 @@ struct Params {
                     return false;
 
                 input_file_name = arguments[++i];
+            } else if (arguments[i] == "--def-cache") {
+                if (!checkNext(arguments, i))
+                    return false;
+
+                definitions_cache = arguments[++i];
+            } else if (arguments[i] == "--bcast-defs") {
+                broadcast_definitions = true;
+            } else if (arguments[i] == "--shared-defs") {
+                broadcast_definitions = true;
+                shared_definitions    = true;
             } else if (arguments[i] == "-f") {
                 auto value = checkNextValue(arguments, i);
                 if (value < 0)
@@ -222,6 +561,23 @@ struct Params {
 
                 buffer_size = value;
                 ++i;
+            } else if (arguments[i] == "--threads") {
+                auto value = checkNextValue(arguments, i);
+                if (value < 1)
+                    return false;
+
+                num_threads = value;
+                ++i;
+            } else if (arguments[i] == "--begin" || arguments[i] == "--end") {
+                if (!checkNext(arguments, i))
+                    return false;
+
+                auto& bound = arguments[i] == "--begin" ? window_begin : window_end;
+                if (!bound.parse(arguments[i + 1])) {
+                    std::cerr << "ERROR: Invalid argument for option '" << arguments[i] << "'" << std::endl;
+                    return false;
+                }
+                ++i;
             } else if (arguments[i] == "-o") {
                 auto value = checkNext(arguments, i);
                 if (value < 1)
@@ -235,7 +591,7 @@ struct Params {
             }
         }
 
-        if (input_file_name == "") {
+        if (input_file_name == "" && binary_to_convert == "") {
             std::cerr << "ERROR: No input tracefile name given. See --help | -h for further information." << std::endl;
             return false;
         }
@@ -4,6 +4,7 @@
 #include "access_pattern_detection.h"
 
 #include <algorithm>
+#include <bit>
 #include <boost/container_hash/hash.hpp>
 #include <cassert>
 #include <cstdint>
@@ -16,6 +17,11 @@
 #include "definitions.h"
 #include "otf2/OTF2_GeneralDefinitions.h"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define ACCESS_PATTERN_X86_SIMD
+#endif
+
 using namespace std;
 
 namespace access_pattern_detection {
@@ -23,9 +29,8 @@ namespace access_pattern_detection {
 /** Helper function that takes in the last `NR_ACCESSES_THRESHOLD` I/O Accesses and determines their
  * AccessPattern
  */
-AccessPattern detect_access_pattern_from_3_acccesses(IOAccesses& io_accesses_ringbuffer, short ringbuffer_start) {
-	assert(io_accesses_ringbuffer.size()==3);
-	IOAccesses io_accesses(3);
+AccessPattern detect_access_pattern_from_3_acccesses(const IoAccess* io_accesses_ringbuffer, short ringbuffer_start) {
+	IoAccess io_accesses[3];
 	for(short i=0; i<3; ++i){
 		io_accesses[i] = io_accesses_ringbuffer[(ringbuffer_start+i)%3];
 	}
@@ -47,227 +52,515 @@ int mod(int a, int b) {
     return (a % b + b) % b;
 }
 
-void init_stats(PatternStatistics& stats, IOAccesses& accesses)
+void init_stats(PatternStatistics& stats, const IoAccess* accesses, short nr_accesses)
 {
-	for(auto& io: accesses) {
-		stats += PatternStatistics(io.size, io.duration); // added to result when `io_accesses` are checked in
+	for(short i=0; i<nr_accesses; ++i) {
+		stats += PatternStatistics(accesses[i].size, accesses[i].duration); // added to result when `io_accesses` are checked in
 	}
 }
 
-AnalysisResult detect_local_access_pattern(IOAccesses& io_accesses)
+/**
+ * Classifies the accesses `[from,to)` (`from>=2`) by comparing their offsets with those of their 2 predecessors
+ * - the live pattern in `step` is detected from the ringbuffer in the order (`i`, `i-2`, `i-1`), see
+ *   `detect_access_pattern_from_3_acccesses`, hence the comparisons with `i-2`
+ */
+static void classify_range_scalar(const IoAccessBlock& block, AccessClasses& classes, size_t from, size_t to)
 {
-	if (io_accesses.empty())
-		return AnalysisResult({}, {});
+	const uint64_t* fpos = block.fpos;
+	const uint64_t* size = block.size;
+	for (size_t i = from; i < to; ++i) {
+		const bool contiguous      = fpos[i - 1] + size[i - 1] == fpos[i];
+		const bool equi_distant    = fpos[i] - fpos[i - 1] == fpos[i - 1] - fpos[i - 2];
+		const bool live_contiguous = fpos[i] + size[i] == fpos[i - 2] && fpos[i - 2] + size[i - 2] == fpos[i - 1];
+		const bool live_strided    = fpos[i - 2] - fpos[i] == fpos[i - 1] - fpos[i - 2];
+		classes.contiguous[i / 64] |= static_cast<uint64_t>(contiguous) << (i % 64);
+		classes.strided[i / 64] |= static_cast<uint64_t>(equi_distant && !live_contiguous) << (i % 64);
+		classes.random[i / 64] |= static_cast<uint64_t>(!live_strided && !live_contiguous) << (i % 64);
+	}
+}
 
-	std::unordered_map<TimeInterval, AccessPattern, pair_hash> pattern_per_timeinterval;
-	// NOTE: for less then `NR_ACCESSES_THRESHOLD` requests we can't really speak of an access pattern
-	if (io_accesses.size() < NR_ACCESSES_THRESHOLD) {
-		pattern_per_timeinterval[std::pair(io_accesses[0].start_time_ns, io_accesses.back().end_time_ns)] = AccessPattern::NONE;
-		uint64_t io_size = std::accumulate(io_accesses.begin(), io_accesses.end(), 0,
-				[](uint64_t acc, auto& io) {
-					return acc + io.size;
-				});;
-		uint64_t ticks_spent = std::accumulate(io_accesses.begin(), io_accesses.end(), 0,
-				[](uint64_t acc, auto& io) {
-					return acc + io.duration;
-				});;
-		PatternStatistics stats (io_size, ticks_spent);
-		std::unordered_map<AccessPattern, PatternStatistics> stats_per_pattern = {
-			{AccessPattern::NONE, stats}
+#ifdef ACCESS_PATTERN_X86_SIMD
+__attribute__((target("avx2"))) static inline __m256i load_256(const uint64_t* p)
+{
+	return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+__attribute__((target("avx2"))) static inline uint64_t mask(__m256i lanes)
+{
+	return _mm256_movemask_pd(_mm256_castsi256_pd(lanes));
+}
+
+/** Same as @ref classify_range_scalar for 4 accesses at once (as long as there are 4 left), `from` has to be a multiple of 4
+ * @returns first access not classified yet */
+__attribute__((target("avx2")))
+static size_t classify_range_avx2(const IoAccessBlock& block, AccessClasses& classes, size_t from, size_t to)
+{
+	// groups of 4 never span two words -> collect the bits of a word before storing them
+	uint64_t contiguous = 0, strided = 0, random = 0;
+	size_t   i = from;
+	for (; i + 4 <= to; i += 4) {
+		const __m256i fpos   = load_256(block.fpos + i);
+		const __m256i fpos_1 = load_256(block.fpos + i - 1);
+		const __m256i fpos_2 = load_256(block.fpos + i - 2);
+		const __m256i dist_1 = _mm256_sub_epi64(fpos_1, fpos_2);
+
+		const __m256i is_contiguous   = _mm256_cmpeq_epi64(_mm256_add_epi64(fpos_1, load_256(block.size + i - 1)), fpos);
+		const __m256i is_equi_distant = _mm256_cmpeq_epi64(_mm256_sub_epi64(fpos, fpos_1), dist_1);
+		const __m256i is_live_contiguous = _mm256_and_si256(
+			_mm256_cmpeq_epi64(_mm256_add_epi64(fpos, load_256(block.size + i)), fpos_2),
+			_mm256_cmpeq_epi64(_mm256_add_epi64(fpos_2, load_256(block.size + i - 2)), fpos_1));
+		const __m256i is_live_strided = _mm256_cmpeq_epi64(_mm256_sub_epi64(fpos_2, fpos), dist_1);
+
+		contiguous |= mask(is_contiguous) << (i % 64);
+		strided |= mask(_mm256_andnot_si256(is_live_contiguous, is_equi_distant)) << (i % 64);
+		random |= (~mask(_mm256_or_si256(is_live_contiguous, is_live_strided)) & 0xf) << (i % 64);
+		if ((i + 4) % 64 == 0) {
+			classes.contiguous[i / 64] |= contiguous;
+			classes.strided[i / 64] |= strided;
+			classes.random[i / 64] |= random;
+			contiguous = strided = random = 0;
+		}
+	}
+	if (i % 64 != 0) {
+		classes.contiguous[i / 64] |= contiguous;
+		classes.strided[i / 64] |= strided;
+		classes.random[i / 64] |= random;
+	}
+	return i;
+}
+
+__attribute__((target("sse4.1"))) static inline __m128i load_128(const uint64_t* p)
+{
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+__attribute__((target("sse4.1"))) static inline uint64_t mask(__m128i lanes)
+{
+	return _mm_movemask_pd(_mm_castsi128_pd(lanes));
+}
+
+/** Same as @ref classify_range_avx2 for 2 accesses at once */
+__attribute__((target("sse4.1")))
+static size_t classify_range_sse41(const IoAccessBlock& block, AccessClasses& classes, size_t from, size_t to)
+{
+	uint64_t contiguous = 0, strided = 0, random = 0;
+	size_t   i = from;
+	for (; i + 2 <= to; i += 2) {
+		const __m128i fpos   = load_128(block.fpos + i);
+		const __m128i fpos_1 = load_128(block.fpos + i - 1);
+		const __m128i fpos_2 = load_128(block.fpos + i - 2);
+		const __m128i dist_1 = _mm_sub_epi64(fpos_1, fpos_2);
+
+		const __m128i is_contiguous   = _mm_cmpeq_epi64(_mm_add_epi64(fpos_1, load_128(block.size + i - 1)), fpos);
+		const __m128i is_equi_distant = _mm_cmpeq_epi64(_mm_sub_epi64(fpos, fpos_1), dist_1);
+		const __m128i is_live_contiguous = _mm_and_si128(
+			_mm_cmpeq_epi64(_mm_add_epi64(fpos, load_128(block.size + i)), fpos_2),
+			_mm_cmpeq_epi64(_mm_add_epi64(fpos_2, load_128(block.size + i - 2)), fpos_1));
+		const __m128i is_live_strided = _mm_cmpeq_epi64(_mm_sub_epi64(fpos_2, fpos), dist_1);
+
+		contiguous |= mask(is_contiguous) << (i % 64);
+		strided |= mask(_mm_andnot_si128(is_live_contiguous, is_equi_distant)) << (i % 64);
+		random |= (~mask(_mm_or_si128(is_live_contiguous, is_live_strided)) & 0x3) << (i % 64);
+		if ((i + 2) % 64 == 0) {
+			classes.contiguous[i / 64] |= contiguous;
+			classes.strided[i / 64] |= strided;
+			classes.random[i / 64] |= random;
+			contiguous = strided = random = 0;
+		}
+	}
+	if (i % 64 != 0) {
+		classes.contiguous[i / 64] |= contiguous;
+		classes.strided[i / 64] |= strided;
+		classes.random[i / 64] |= random;
+	}
+	return i;
+}
+#endif
+
+using ClassifyRange = size_t (*)(const IoAccessBlock&, AccessClasses&, size_t, size_t);
+
+static void classify_accesses(const IoAccessBlock& block, AccessClasses& classes, ClassifyRange classify_vectorized)
+{
+	classes = AccessClasses{};
+	const size_t n = block.nr_accesses;
+	// vectors start at access 4, so they are aligned to the words of the bitsets
+	classify_range_scalar(block, classes, 2, std::min<size_t>(n, 4));
+	if (n > 4)
+		classify_range_scalar(block, classes, classify_vectorized ? classify_vectorized(block, classes, 4, n) : 4, n);
+
+	// meta operations don't belong to any run, nor do accesses past the end of the block
+	for (size_t w = 0; w < AccessClasses::WORDS; ++w) {
+		const size_t   first = w * 64;
+		const uint64_t valid = first >= n        ? 0
+		                       : n - first >= 64 ? ~block.is_meta[w]
+		                                         : ~block.is_meta[w] & ((uint64_t(1) << (n - first)) - 1);
+		classes.contiguous[w] &= valid;
+		classes.strided[w] &= valid;
+		classes.random[w] &= valid;
+	}
+}
+
+void classify_accesses_scalar(const IoAccessBlock& block, AccessClasses& classes)
+{
+	classify_accesses(block, classes, nullptr);
+}
+
+void classify_accesses(const IoAccessBlock& block, AccessClasses& classes)
+{
+	static const ClassifyRange classify_vectorized = []() -> ClassifyRange {
+#ifdef ACCESS_PATTERN_X86_SIMD
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			return classify_range_avx2;
+		if (__builtin_cpu_supports("sse4.1"))
+			return classify_range_sse41;
+#endif
+		return nullptr;
+	}();
+	classify_accesses(block, classes, classify_vectorized);
+}
+
+bool classify_accesses(ClassifySimd simd, const IoAccessBlock& block, AccessClasses& classes)
+{
+#ifdef ACCESS_PATTERN_X86_SIMD
+	__builtin_cpu_init();
+	if (simd == ClassifySimd::AVX2 && __builtin_cpu_supports("avx2")) {
+		classify_accesses(block, classes, classify_range_avx2);
+		return true;
+	}
+	if (simd == ClassifySimd::SSE41 && __builtin_cpu_supports("sse4.1")) {
+		classify_accesses(block, classes, classify_range_sse41);
+		return true;
+	}
+#endif
+	return false;
+}
+
+/** Index of the first access `>=from` whose bit in `bits` is not set, `to` if there is none before */
+static size_t run_end(const uint64_t* bits, size_t from, size_t to)
+{
+	for (size_t i = from; i < to; i = (i / 64 + 1) * 64) {
+		const uint64_t unset = ~bits[i / 64] >> (i % 64);
+		if (unset != 0)
+			return std::min(to, i + std::countr_zero(unset));
+	}
+	return to;
+}
+
+void LocalAccessPatternDetector::add(const IoAccess& io)
+{
+	if (nr_accesses < NR_ACCESSES_THRESHOLD) {
+		last_x_accesses[nr_accesses++] = io;
+		if (nr_accesses < NR_ACCESSES_THRESHOLD)
+			return;
+
+		// first three io-accesses are inserted -> setup the detection
+		stats_per_pattern = {
+			{AccessPattern::NONE, PatternStatistics(0,0)},
+			{AccessPattern::CONTIGUOUS, PatternStatistics(0,0)},
+			{AccessPattern::STRIDED, PatternStatistics(0,0)},
+			{AccessPattern::RANDOM, PatternStatistics(0,0)},
 		};
-		AnalysisResult result (pattern_per_timeinterval, stats_per_pattern);
-		return result;
+		interval_start = last_x_accesses[0].start_time_ns;
+		id_into_last_x_accesses = 2;					// pretend `last_x_accesses` is a ringbuffer (with 2 elements already inserted) ->so first elem is inserted at [0]
+		next_fpos_if_contiguous = last_x_accesses[2].fpos + last_x_accesses[2].size; 	// used to determine if access pattern is still contiguous (by comparing to next fpos)
+		nr_io_access_in_current_access_pattern = NR_ACCESSES_THRESHOLD;
+		last_fpos_distance = last_x_accesses[2].fpos - last_x_accesses[1].fpos;			// used to determine whether access pattern is (still) equidistant (for STRIDED) access
+		curr_stats = PatternStatistics(0, 0); // keeps track of IO_Size & Ticks_spent until actual pattern is clear
+		init_stats(curr_stats, last_x_accesses, NR_ACCESSES_THRESHOLD);
+		curr_pattern = detect_access_pattern_from_3_acccesses(last_x_accesses, 0);
+		do_start_new_interval = false;					// interval with different accesss pattern -> track separately
+		prev_end_time = last_x_accesses[2].end_time_ns;
+		return;
 	}
 
-	std::unordered_map<AccessPattern, PatternStatistics> stats_per_pattern = {
-		{AccessPattern::NONE, PatternStatistics(0,0)},
-		{AccessPattern::CONTIGUOUS, PatternStatistics(0,0)},
-		{AccessPattern::STRIDED, PatternStatistics(0,0)},
-		{AccessPattern::RANDOM, PatternStatistics(0,0)},
-	};
+	++nr_accesses;
+	// accesses held back so far end before `io` -> they can't end at the timestamp of the last access
+	if (!pending.empty() && pending.back().end_time_ns != io.end_time_ns)
+		flush_pending(false);
+	pending.push_back(io);
+}
+
+void LocalAccessPatternDetector::add(const IoAccessBlock& block)
+{
+	size_t i = 0;
+	// first accesses set up the detection
+	for (; i < block.nr_accesses && nr_accesses < NR_ACCESSES_THRESHOLD; ++i)
+		add(block[i]);
+
+	// accesses ending at the same time as the last access of the block are held back (like in `add(const IoAccess&)`)
+	size_t held_back = block.nr_accesses;
+	while (held_back > i && block.end_time_ns[held_back - 1] == block.end_time_ns[block.nr_accesses - 1])
+		--held_back;
+
+	// all other accesses are followed by an access with a later end time -> process them right away
+	if (i < held_back) {
+		flush_pending(false);
+		AccessClasses classes;
+		classify_accesses(block, classes);
+		nr_accesses += held_back - i;
+		process(block, classes, i, held_back);
+	}
+
+	for (i = held_back; i < block.nr_accesses; ++i)
+		add(block[i]);
+}
 
-	// these vars will be needed
-	OTF2_TimeStamp interval_start = io_accesses.front().start_time_ns;
-	OTF2_TimeStamp last_timestamp = io_accesses.back().end_time_ns;
-	bool is_equi_distant;								// used to determine whether access pattern is strided
-	OTF2_TimeStamp last_x_accesses_prev_interval_end;
-	IOAccesses last_x_accesses {
-		// insert first three io-accesses
-		io_accesses[0], io_accesses[1], io_accesses[2]
-	};													// tracks the access pattern of the last 3 I/O-accesses (eg to check whether diff btw fpos / size / ...
-														// of the current IoAccess changed (compared to previous I/O accesses)
-	short id_into_last_x_accesses = 2;					// pretend `last_x_accesses` is a ringbuffer (with 2 elements already inserted) ->so first elem is inserted at [0]
-
-	uint64_t next_fpos_if_contiguous = last_x_accesses.back().fpos + last_x_accesses.back().size; 	// used to determine if access pattern is still contiguous (by comparing to next fpos)
-	uint64_t nr_io_access_in_current_access_pattern = last_x_accesses.size();
-	uint64_t prev_fpos = last_x_accesses.back().fpos;
-	uint64_t last_fpos_distance = last_x_accesses.back().fpos - last_x_accesses[1].fpos;			// used to determine whether access pattern is (still) equidistant (for STRIDED) access
-
-	PatternStatistics curr_stats{}; // keeps track of IO_Size & Ticks_spent until actual pattern is clear
-	init_stats(curr_stats, last_x_accesses);
-	AccessPattern curr_pattern = detect_access_pattern_from_3_acccesses(last_x_accesses, 0);
-	bool do_start_new_interval = false;					// interval with different accesss pattern -> track separately
-
-	// ! GOAL: single pass over all accesses (which can be a lot)
-	// TODO: output AccessPattern for exactly 3 IoAccesses
-	for(int i=3; i<io_accesses.size(); ++i) {
-		if (io_accesses[i].is_meta) // meta operations don't contribute to file access pattern
+void LocalAccessPatternDetector::process(const IoAccessBlock& block, const AccessClasses& classes, size_t from, size_t to)
+{
+	// nr of accesses to process one by one before runs can be skipped: the classes of an access are computed from its
+	// predecessors in the block, which have to be the last accesses in the ringbuffer
+	short exact = 2;
+	for (size_t i = from; i < to;) {
+		if (block.meta(i)) { // meta operations don't contribute to file access pattern
+			prev_end_time = block.end_time_ns[i++];
+			exact = 2;
+			continue;
+		}
+
+		// skip the run of accesses that keeps the current pattern (each would just be counted by `step`)
+		size_t end = i;
+		if (exact == 0 && !do_start_new_interval) {
+			switch (curr_pattern) {
+				case AccessPattern::CONTIGUOUS:
+					if (block.fpos[i] == next_fpos_if_contiguous)
+						end = run_end(classes.contiguous, i + 1, to);
+					break;
+				case AccessPattern::STRIDED:
+					end = run_end(classes.strided, i, to);
+					break;
+				case AccessPattern::RANDOM:
+					end = run_end(classes.random, i, to);
+					break;
+				default:
+					break;
+			}
+		}
+		if (end > i) {
+			for (size_t j = i; j < end; ++j)
+				curr_stats += PatternStatistics(block.size[j], block.duration[j]);
+			nr_io_access_in_current_access_pattern += end - i;
+			if (curr_pattern == AccessPattern::CONTIGUOUS)
+				next_fpos_if_contiguous = block.fpos[end - 1] + block.size[end - 1];
+			else if (curr_pattern == AccessPattern::STRIDED)
+				is_equi_distant = true;
+			skip(block, i, end);
+			i = end;
 			continue;
+		}
 
-		auto io = io_accesses[i];
+		const IoAccess io    = block[i++];
+		short          steps = 1;
+		while (step(io, false, false))
+			++steps; // make this last io be part of next pattern
+		prev_end_time = io.end_time_ns;
+		// processing `io` twice puts it twice into the ringbuffer
+		exact = steps > 1 ? 2 : std::max(exact - 1, 0);
+	}
+}
 
+void LocalAccessPatternDetector::skip(const IoAccessBlock& block, size_t from, size_t to)
+{
+	const size_t nr_skipped = to - from;
+	// only the last `NR_ACCESSES_THRESHOLD` accesses end up in the ringbuffer
+	if (nr_skipped > NR_ACCESSES_THRESHOLD) {
+		id_into_last_x_accesses = (id_into_last_x_accesses + nr_skipped - NR_ACCESSES_THRESHOLD) % NR_ACCESSES_THRESHOLD;
+		from = to - NR_ACCESSES_THRESHOLD;
+	}
+	for (size_t i = from; i < to; ++i) {
 		id_into_last_x_accesses = (id_into_last_x_accesses+1) % NR_ACCESSES_THRESHOLD;
 		last_x_accesses_prev_interval_end = last_x_accesses[id_into_last_x_accesses].end_time_ns;
-		last_x_accesses[id_into_last_x_accesses] = io;
+		last_x_accesses[id_into_last_x_accesses] = block[i];
+	}
+	if (nr_skipped > NR_ACCESSES_THRESHOLD)
+		last_x_accesses_prev_interval_end = block.end_time_ns[to - NR_ACCESSES_THRESHOLD - 1];
 
-		last_fpos_distance = last_x_accesses[mod(id_into_last_x_accesses-1,NR_ACCESSES_THRESHOLD)].fpos
-								- last_x_accesses[mod(id_into_last_x_accesses-2, NR_ACCESSES_THRESHOLD)].fpos;
+	last_fpos_distance = last_x_accesses[mod(id_into_last_x_accesses-1,NR_ACCESSES_THRESHOLD)].fpos
+							- last_x_accesses[mod(id_into_last_x_accesses-2, NR_ACCESSES_THRESHOLD)].fpos;
+	prev_end_time = block.end_time_ns[to - 1];
+}
 
-		// init things for new interval (with potentially new access pattern)
-		if (do_start_new_interval) {
-			curr_pattern = AccessPattern::CONTIGUOUS;			// start with CONTIGUOUS as default bc it is the most strict one
-			next_fpos_if_contiguous = io_accesses[i].fpos;
-			curr_stats = PatternStatistics(0, 0);
-			nr_io_access_in_current_access_pattern = 0; // counts how many I/O accesses were assigned to the current access pattern
+void LocalAccessPatternDetector::flush_pending(bool at_end)
+{
+	for (size_t i = 0; i < pending.size(); ++i) {
+		const auto& io = pending[i];
+		if (!io.is_meta) { // meta operations don't contribute to file access pattern
+			bool is_last = at_end && i == pending.size() - 1;
+			while (step(io, is_last, at_end))
+				; // make this last io be part of next pattern
+		}
+		prev_end_time = io.end_time_ns;
+	}
+	pending.clear();
+}
 
-			interval_start = io.start_time_ns;
+bool LocalAccessPatternDetector::step(const IoAccess& io, bool is_last, bool ends_at_last_timestamp)
+{
+	id_into_last_x_accesses = (id_into_last_x_accesses+1) % NR_ACCESSES_THRESHOLD;
+	last_x_accesses_prev_interval_end = last_x_accesses[id_into_last_x_accesses].end_time_ns;
+	last_x_accesses[id_into_last_x_accesses] = io;
 
-			is_equi_distant = true; // no access yet
-			do_start_new_interval = false;
-		}
-		curr_stats += PatternStatistics(io.size, io.duration); 	// added to result when `io_accesses` are checked in
-																// TODO: for time take actual time spent in io-access !
-
-		// implement Transition btw AccessPattern states
-		switch (curr_pattern) {
-			case AccessPattern::CONTIGUOUS:
-				// `CONTIGUOUS->STRIDED` possible if all accesses were equidistant so far, else `CONTIGUOUS->RANDOM`
-				// (`do_start_new_interval==true` means this is the only access analyzed so far, so let's be optimistic and see if coming
-				// I/O accesses will show that the access pattern is indeed contiguous
-				if (!do_start_new_interval && io.fpos!=next_fpos_if_contiguous) {
-					// if we have already enough access in this pattern let's save it as being CONTIGUOUS..
-					if (nr_io_access_in_current_access_pattern > NR_ACCESSES_THRESHOLD) {
-						// END --- check in this contiguous interval
-						pattern_per_timeinterval[std::pair(interval_start, io.end_time_ns)] = AccessPattern::CONTIGUOUS;
-						stats_per_pattern[AccessPattern::CONTIGUOUS] += curr_stats;
-						do_start_new_interval = true;
-						break;
-					} else if (is_equi_distant) {
-						// CONTIGUOUS -> STRIDED
-						// could still be strided
-						curr_pattern = AccessPattern::STRIDED;
-					} else {
-						// CONTIGUOUS -> RANDOM
-						curr_pattern = AccessPattern::RANDOM;
-					}
-				} else {
-					// CONTIGUOUS -> CONTIGUOUS
-					// we are still in CONTIGUOUS access pattern
-					next_fpos_if_contiguous = io.fpos + io.size; 	// next fpos is determined by currently read/written size
-															// (if AccessPattern is contiguous)
+	last_fpos_distance = last_x_accesses[mod(id_into_last_x_accesses-1,NR_ACCESSES_THRESHOLD)].fpos
+							- last_x_accesses[mod(id_into_last_x_accesses-2, NR_ACCESSES_THRESHOLD)].fpos;
 
-				}
-				nr_io_access_in_current_access_pattern++;
-				break;
-			case AccessPattern::STRIDED:
-			{
-				// `STRIDED->CONTIGUOUS` not possible (only vice versa), `STRIDED->RANDOM`: if not equidistant anymore
-				if (io.end_time_ns == last_timestamp) {
-					// END --- check in all io_accesses
-					// if only the last access is not equidistant the whole interval still counts as being accessed via STRIDED pattern
-					pattern_per_timeinterval[std::pair(interval_start,io.end_time_ns)] = AccessPattern::STRIDED;
-					stats_per_pattern[AccessPattern::STRIDED] += curr_stats;
-					nr_io_access_in_current_access_pattern = 0;
-					break;
-				}
+	// init things for new interval (with potentially new access pattern)
+	if (do_start_new_interval) {
+		curr_pattern = AccessPattern::CONTIGUOUS;			// start with CONTIGUOUS as default bc it is the most strict one
+		next_fpos_if_contiguous = io.fpos;
+		curr_stats = PatternStatistics(0, 0);
+		nr_io_access_in_current_access_pattern = 0; // counts how many I/O accesses were assigned to the current access pattern
+
+		interval_start = io.start_time_ns;
 
-				// check if `STRIDED -> CONTIGUOUS` is possible
-				AccessPattern live_pattern = detect_access_pattern_from_3_acccesses(last_x_accesses, id_into_last_x_accesses);
-				if (live_pattern == AccessPattern::CONTIGUOUS) {
-					curr_pattern = AccessPattern::CONTIGUOUS;
-					nr_io_access_in_current_access_pattern = NR_ACCESSES_THRESHOLD;
-
-					interval_start = last_x_accesses[mod(id_into_last_x_accesses-1,NR_ACCESSES_THRESHOLD)].start_time_ns; // update when the interval of those last `x` accesses started
-																											   // (=first of those recorded x events)
-					// leave `is_equi_distant==true` (STRIDED implies equi-distant)
-					assert(is_equi_distant);
-
-					cout << "SWITCHING" << endl;
-					if (nr_io_access_in_current_access_pattern > NR_ACCESSES_THRESHOLD*2) {
-						// there were still some strided accesses before the contiguous ones -> check them in !
-						pattern_per_timeinterval[std::pair(interval_start, last_x_accesses_prev_interval_end)] = AccessPattern::STRIDED;
-						// stats of these 3 last accesses go into newly detected pattern
-						auto stats_new = PatternStatistics(last_x_accesses[0].size+last_x_accesses[1].size+last_x_accesses[2].size, last_x_accesses[0].duration+last_x_accesses[1].duration+last_x_accesses[2].duration);
-						stats_per_pattern[AccessPattern::STRIDED] += curr_stats - stats_new;
-						curr_stats = stats_new;
-					}
+		is_equi_distant = true; // no access yet
+		do_start_new_interval = false;
+	}
+	curr_stats += PatternStatistics(io.size, io.duration); 	// added to result when `io_accesses` are checked in
+															// TODO: for time take actual time spent in io-access !
+
+	// implement Transition btw AccessPattern states
+	switch (curr_pattern) {
+		case AccessPattern::CONTIGUOUS:
+			// `CONTIGUOUS->STRIDED` possible if all accesses were equidistant so far, else `CONTIGUOUS->RANDOM`
+			// (`do_start_new_interval==true` means this is the only access analyzed so far, so let's be optimistic and see if coming
+			// I/O accesses will show that the access pattern is indeed contiguous
+			if (!do_start_new_interval && io.fpos!=next_fpos_if_contiguous) {
+				// if we have already enough access in this pattern let's save it as being CONTIGUOUS..
+				if (nr_io_access_in_current_access_pattern > NR_ACCESSES_THRESHOLD) {
+					// END --- check in this contiguous interval
+					pattern_per_timeinterval[std::pair(interval_start, io.end_time_ns)] = AccessPattern::CONTIGUOUS;
+					stats_per_pattern[AccessPattern::CONTIGUOUS] += curr_stats;
+					do_start_new_interval = true;
 					break;
+				} else if (is_equi_distant) {
+					// CONTIGUOUS -> STRIDED
+					// could still be strided
+					curr_pattern = AccessPattern::STRIDED;
+				} else {
+					// CONTIGUOUS -> RANDOM
+					curr_pattern = AccessPattern::RANDOM;
 				}
+			} else {
+				// CONTIGUOUS -> CONTIGUOUS
+				// we are still in CONTIGUOUS access pattern
+				next_fpos_if_contiguous = io.fpos + io.size; 	// next fpos is determined by currently read/written size
+														// (if AccessPattern is contiguous)
 
-				if (io.fpos - last_x_accesses[mod(id_into_last_x_accesses-1,NR_ACCESSES_THRESHOLD)].fpos == last_fpos_distance) {
-					// STRIDED -> STRIDED
-					// we are still equidistant (INVARIANT: `is_equi_distant==true` only if `curr_pattern == AccessPattern::STRIDED`)
-					is_equi_distant = true;
-					nr_io_access_in_current_access_pattern +=1;
-				} else {
-					// next access is not STRIDED anymore -> start new interval (or if <NR_ACCESSES_THRESHOLD count as RANDOM pattern)
-					if (nr_io_access_in_current_access_pattern < NR_ACCESSES_THRESHOLD) {
-						// STRIDED -> RANDOM
-						is_equi_distant = false;
-						curr_pattern = AccessPattern::RANDOM;
-					} else {
-						// INTERVAL FINISHED: check in
-						bool is_last_strided = i==io_accesses.size()-1; // if this is last io: also belongs to strided i guess (last acc might be limited by file size)
-						auto end_time = is_last_strided ? io.end_time_ns : io_accesses[i-1].end_time_ns;
-						pattern_per_timeinterval[std::pair(interval_start,end_time)] = AccessPattern::STRIDED;
-						curr_stats -= PatternStatistics(io.size, io.duration);
-						stats_per_pattern[AccessPattern::STRIDED] += curr_stats;
-						do_start_new_interval = true;
-
-						if (!is_last_strided) {
-							i--; // make this last io be part of next pattern
-						}
-						continue;
-					}
+			}
+			nr_io_access_in_current_access_pattern++;
+			break;
+		case AccessPattern::STRIDED:
+		{
+			// `STRIDED->CONTIGUOUS` not possible (only vice versa), `STRIDED->RANDOM`: if not equidistant anymore
+			if (ends_at_last_timestamp) {
+				// END --- check in all io_accesses
+				// if only the last access is not equidistant the whole interval still counts as being accessed via STRIDED pattern
+				pattern_per_timeinterval[std::pair(interval_start,io.end_time_ns)] = AccessPattern::STRIDED;
+				stats_per_pattern[AccessPattern::STRIDED] += curr_stats;
+				nr_io_access_in_current_access_pattern = 0;
+				break;
+			}
+
+			// check if `STRIDED -> CONTIGUOUS` is possible
+			AccessPattern live_pattern = detect_access_pattern_from_3_acccesses(last_x_accesses, id_into_last_x_accesses);
+			if (live_pattern == AccessPattern::CONTIGUOUS) {
+				curr_pattern = AccessPattern::CONTIGUOUS;
+				nr_io_access_in_current_access_pattern = NR_ACCESSES_THRESHOLD;
+
+				interval_start = last_x_accesses[mod(id_into_last_x_accesses-1,NR_ACCESSES_THRESHOLD)].start_time_ns; // update when the interval of those last `x` accesses started
+																										   // (=first of those recorded x events)
+				// leave `is_equi_distant==true` (STRIDED implies equi-distant)
+				assert(is_equi_distant);
+
+				if (nr_io_access_in_current_access_pattern > NR_ACCESSES_THRESHOLD*2) {
+					// there were still some strided accesses before the contiguous ones -> check them in !
+					pattern_per_timeinterval[std::pair(interval_start, last_x_accesses_prev_interval_end)] = AccessPattern::STRIDED;
+					// stats of these 3 last accesses go into newly detected pattern
+					auto stats_new = PatternStatistics(last_x_accesses[0].size+last_x_accesses[1].size+last_x_accesses[2].size, last_x_accesses[0].duration+last_x_accesses[1].duration+last_x_accesses[2].duration);
+					stats_per_pattern[AccessPattern::STRIDED] += curr_stats - stats_new;
+					curr_stats = stats_new;
 				}
 				break;
 			}
-				case AccessPattern::RANDOM:
-			{
-				AccessPattern live_pattern = detect_access_pattern_from_3_acccesses(last_x_accesses, id_into_last_x_accesses);
-
-				if (live_pattern!=AccessPattern::RANDOM) {
-					// RANDOM -> CONTIGUOUS | STRIDED
-					curr_pattern = live_pattern;
-					nr_io_access_in_current_access_pattern = NR_ACCESSES_THRESHOLD; // all elements in `last_x_accesses` indicate `live_pattern`
-
-					// setup vars for this new access pattern
-					interval_start = last_x_accesses[mod(id_into_last_x_accesses-1,NR_ACCESSES_THRESHOLD)].start_time_ns; // update when the interval of those last `x` accesses started
-																											   // (=first of those recorded x events)
-					is_equi_distant = curr_pattern==AccessPattern::STRIDED || (
-							// if first two accesses were equidistant all of them must have been
-							(last_x_accesses[mod(id_into_last_x_accesses-1,NR_ACCESSES_THRESHOLD)].size - last_x_accesses[mod(id_into_last_x_accesses-2,NR_ACCESSES_THRESHOLD)].size) // distance btw 1st&2nd access
-						==	(last_x_accesses[mod(id_into_last_x_accesses-2,NR_ACCESSES_THRESHOLD)].size - last_x_accesses[mod(id_into_last_x_accesses-3,NR_ACCESSES_THRESHOLD)].size) // distance btw 2nd&3rd access
-					);
-
-					if (nr_io_access_in_current_access_pattern > NR_ACCESSES_THRESHOLD*2) {
-						// there were still some random accesses before -> check them in !
-						pattern_per_timeinterval[make_pair(interval_start, last_x_accesses_prev_interval_end)] = AccessPattern::RANDOM;
-						stats_per_pattern[AccessPattern::RANDOM] += curr_stats;
-					}
+
+			if (io.fpos - last_x_accesses[mod(id_into_last_x_accesses-1,NR_ACCESSES_THRESHOLD)].fpos == last_fpos_distance) {
+				// STRIDED -> STRIDED
+				// we are still equidistant (INVARIANT: `is_equi_distant==true` only if `curr_pattern == AccessPattern::STRIDED`)
+				is_equi_distant = true;
+				nr_io_access_in_current_access_pattern +=1;
+			} else {
+				// next access is not STRIDED anymore -> start new interval (or if <NR_ACCESSES_THRESHOLD count as RANDOM pattern)
+				if (nr_io_access_in_current_access_pattern < NR_ACCESSES_THRESHOLD) {
+					// STRIDED -> RANDOM
+					is_equi_distant = false;
+					curr_pattern = AccessPattern::RANDOM;
 				} else {
-					// RANDOM -> RANDOM
-					nr_io_access_in_current_access_pattern += 1;
+					// INTERVAL FINISHED: check in
+					bool is_last_strided = is_last; // if this is last io: also belongs to strided i guess (last acc might be limited by file size)
+					auto end_time = is_last_strided ? io.end_time_ns : prev_end_time;
+					pattern_per_timeinterval[std::pair(interval_start,end_time)] = AccessPattern::STRIDED;
+					curr_stats -= PatternStatistics(io.size, io.duration);
+					stats_per_pattern[AccessPattern::STRIDED] += curr_stats;
+					do_start_new_interval = true;
+
+					return !is_last_strided; // make this last io be part of next pattern
 				}
-				break;
 			}
-			case AccessPattern::NONE:
-				cerr << "AccessPattern::NONE should have been filtered out previously\n";
-				abort();  // Immediately terminates the program
-				break;
+			break;
+		}
+			case AccessPattern::RANDOM:
+		{
+			AccessPattern live_pattern = detect_access_pattern_from_3_acccesses(last_x_accesses, id_into_last_x_accesses);
+
+			if (live_pattern!=AccessPattern::RANDOM) {
+				// RANDOM -> CONTIGUOUS | STRIDED
+				curr_pattern = live_pattern;
+				nr_io_access_in_current_access_pattern = NR_ACCESSES_THRESHOLD; // all elements in `last_x_accesses` indicate `live_pattern`
+
+				// setup vars for this new access pattern
+				interval_start = last_x_accesses[mod(id_into_last_x_accesses-1,NR_ACCESSES_THRESHOLD)].start_time_ns; // update when the interval of those last `x` accesses started
+																										   // (=first of those recorded x events)
+				is_equi_distant = curr_pattern==AccessPattern::STRIDED || (
+						// if first two accesses were equidistant all of them must have been
+						(last_x_accesses[mod(id_into_last_x_accesses-1,NR_ACCESSES_THRESHOLD)].size - last_x_accesses[mod(id_into_last_x_accesses-2,NR_ACCESSES_THRESHOLD)].size) // distance btw 1st&2nd access
+					==	(last_x_accesses[mod(id_into_last_x_accesses-2,NR_ACCESSES_THRESHOLD)].size - last_x_accesses[mod(id_into_last_x_accesses-3,NR_ACCESSES_THRESHOLD)].size) // distance btw 2nd&3rd access
+				);
+
+				if (nr_io_access_in_current_access_pattern > NR_ACCESSES_THRESHOLD*2) {
+					// there were still some random accesses before -> check them in !
+					pattern_per_timeinterval[make_pair(interval_start, last_x_accesses_prev_interval_end)] = AccessPattern::RANDOM;
+					stats_per_pattern[AccessPattern::RANDOM] += curr_stats;
+				}
+			} else {
+				// RANDOM -> RANDOM
+				nr_io_access_in_current_access_pattern += 1;
+			}
+			break;
 		}
+		case AccessPattern::NONE:
+			cerr << "AccessPattern::NONE should have been filtered out previously\n";
+			abort();  // Immediately terminates the program
+			break;
+	}
+	return false;
+}
+
+AnalysisResult LocalAccessPatternDetector::finish()
+{
+	if (nr_accesses == 0)
+		return AnalysisResult({}, {});
+
+	// NOTE: for less then `NR_ACCESSES_THRESHOLD` requests we can't really speak of an access pattern
+	if (nr_accesses < NR_ACCESSES_THRESHOLD) {
+		pattern_per_timeinterval[std::pair(last_x_accesses[0].start_time_ns, last_x_accesses[nr_accesses-1].end_time_ns)] = AccessPattern::NONE;
+		PatternStatistics stats (0, 0);
+		init_stats(stats, last_x_accesses, nr_accesses);
+		std::unordered_map<AccessPattern, PatternStatistics> stats_per_pattern = {
+			{AccessPattern::NONE, stats}
+		};
+		return AnalysisResult(pattern_per_timeinterval, stats_per_pattern);
 	}
 
+	flush_pending(true);
+
 	if (nr_io_access_in_current_access_pattern>0) {
 		// check in remaining accesses
 		auto last_io = last_x_accesses[mod(id_into_last_x_accesses,NR_ACCESSES_THRESHOLD)];
@@ -278,16 +571,115 @@ AnalysisResult detect_local_access_pattern(IOAccesses& io_accesses)
 	return AnalysisResult(pattern_per_timeinterval, stats_per_pattern);
 }
 
-AccessPattern detect_global_access_pattern(AllData& alldata, definitions::File* file)
+/** Adds intervals & statistics of `from` to `into` */
+void add_results(AnalysisResult& into, const AnalysisResult& from)
 {
-	// analyze all IoHandles that were used to perform I/O on `file`
+	for (const auto& [interval, pattern] : from.pattern_per_timeinterval)
+		into.pattern_per_timeinterval[interval] = pattern;
+	for (const auto& [pattern, stats] : from.stats_per_pattern) {
+		auto [it, inserted] = into.stats_per_pattern.emplace(pattern, stats);
+		if (!inserted)
+			it->second += stats;
+	}
+}
+
+AnalysisResult LocalAccessPatternDetector::result() const
+{
+	AnalysisResult result = LocalAccessPatternDetector(*this).finish();
+	if (merged.has_value())
+		add_results(result, *merged);
+	return result;
+}
+
+void LocalAccessPatternDetector::merge(const LocalAccessPatternDetector& rhs)
+{
+	if (rhs.nr_accesses == 0 && !rhs.merged.has_value())
+		return;
+
+	if (nr_accesses == 0 && !merged.has_value()) {
+		*this = rhs;
+		return;
+	}
+
+	// both streams have accesses -> keep analyzing this stream, `rhs` is finished
+	merge(rhs.result());
+}
+
+void LocalAccessPatternDetector::merge(const AnalysisResult& rhs)
+{
+	if (rhs.pattern_per_timeinterval.empty() && rhs.stats_per_pattern.empty())
+		return;
+
+	if (merged.has_value())
+		add_results(*merged, rhs);
+	else
+		merged = rhs;
+}
+
+AnalysisResult detect_local_access_pattern(const IOAccesses& io_accesses)
+{
+	LocalAccessPatternDetector detector;
+	IOAccesses::BlockReader    reader(io_accesses);
+	IoAccessBlock              block;
+	while (reader.next(block))
+		detector.add(block);
+	return detector.result();
+}
+
+AnalysisResult detect_global_access_pattern(const std::vector<const IOAccesses*>& io_accesses_per_handle)
+{
+	// next (not yet merged) access of each handle
+	std::vector<std::pair<IOAccesses::const_iterator, IOAccesses::const_iterator>> cursors;
+	cursors.reserve(io_accesses_per_handle.size());
+	for (const auto* io_accesses : io_accesses_per_handle)
+		if (!io_accesses->empty())
+			cursors.emplace_back(io_accesses->begin(), io_accesses->end());
+
+	// min-heap of cursors by end time of their next access, ties go to the earlier handle to stay deterministic
+	auto ends_later = [&cursors](size_t a, size_t b) {
+		const auto end_a = cursors[a].first->end_time_ns, end_b = cursors[b].first->end_time_ns;
+		return end_a != end_b ? end_a > end_b : a > b;
+	};
+	std::vector<size_t> heap(cursors.size());
+	std::iota(heap.begin(), heap.end(), 0);
+	std::make_heap(heap.begin(), heap.end(), ends_later);
+
+	LocalAccessPatternDetector detector;
+	IoAccessBlock              block;
+	while (!heap.empty()) {
+		std::pop_heap(heap.begin(), heap.end(), ends_later);
+		auto& [next, end] = cursors[heap.back()];
+		block.push_back(*next);
+		if (block.full()) {
+			detector.add(block);
+			block.nr_accesses = 0;
+		}
+		if (++next != end)
+			std::push_heap(heap.begin(), heap.end(), ends_later);
+		else
+			heap.pop_back();
+	}
+	detector.add(block);
+	return detector.result();
+}
 
-	// sequentialize accesses from all I/O handles sorted by timestamp and then proceed with *local access pattern detection*
-	for (auto& handle: file->io_handles){
-		auto* ioh = alldata.definitions.iohandles.get(handle);
-		std::cout << ioh->io_accesses.size() << std::endl;
+AnalysisResult detect_global_access_pattern(const AllData& alldata, const definitions::File& file)
+{
+	// only the accesses of files with several IoHandles are kept, with one the global pattern is the local one
+	if (!file.keeps_io_accesses()) {
+		const auto* ioh = file.io_handles.empty() ? nullptr : alldata.definitions.iohandles.get(file.io_handles.front());
+		return ioh != nullptr ? ioh->get_local_access_pattern_stats() : AnalysisResult();
+	}
+
+	// analyze all IoHandles that were used to perform I/O on `file`
+	std::vector<const IOAccesses*> io_accesses_per_handle;
+	io_accesses_per_handle.reserve(file.io_handles.size());
+	for (auto handle : file.io_handles) {
+		const auto* ioh = alldata.definitions.iohandles.get(handle);
+		if (ioh != nullptr)
+			io_accesses_per_handle.push_back(&ioh->io_accesses);
 	}
-	throw std::logic_error("TODO: not implemented");
+	return detect_global_access_pattern(io_accesses_per_handle);
 }
 
 } // namespace access_pattern_detection
@@ -5,205 +5,155 @@
 
 #include "data_tree.h"
 
-#include <stack>
-
 using namespace std;
 
-data_tree::data_tree() {}
-
-// generating a tree out of a mapping sent with MPI - ReduceData - (has no data inside a tree node)
-data_tree::data_tree(std::map<uint64_t, std::tuple<uint64_t, uint64_t, std::shared_ptr<tree_node>>>& mapping) {
-    shared_ptr<tree_node> tmp_node;
-
-    for (auto it = mapping.begin(); it != mapping.end(); it++) {
-        if (get<1>(it->second) != (uint64_t)-1) {
-            tmp_node = insert_node(get<0>(it->second), get<2>(mapping.find(get<1>(it->second))->second));
+data_tree::data_tree() : child_table(64), locations(new LocationIndex()) {}
 
-        } else {
-            tmp_node = insert_node(get<0>(it->second), (shared_ptr<tree_node>)nullptr);
-        }
-
-        get<2>(it->second) = tmp_node;
-    }
+static inline size_t hash_child(uint64_t function_id, node_index_t parent) {
+    uint64_t h = (function_id ^ ((uint64_t)parent << 32 | parent)) * 0x9E3779B97F4A7C15ull;
+    return (size_t)(h ^ (h >> 29));
 }
 
-// add a node without data
-shared_ptr<tree_node> data_tree::insert_node(uint64_t function_id, std::shared_ptr<tree_node> parent) {
-    if (parent == nullptr) {
-        shared_ptr<tree_node> tmp = std::make_shared<tree_node>(function_id, parent);
-
-        root_nodes.insert(make_pair(function_id, tmp));
-
-        return tmp;
+size_t data_tree::find_slot(uint64_t function_id, node_index_t parent) const {
+    size_t mask = child_table.size() - 1;
+    size_t pos  = hash_child(function_id, parent) & mask;
 
-    } else {
-        auto node = parent->children.find(function_id);
-
-        if (node == parent->children.end()) {
-            shared_ptr<tree_node> tmp = std::make_shared<tree_node>(function_id, parent);
+    while (child_table[pos].child != NO_NODE &&
+           (child_table[pos].function_id != function_id || child_table[pos].parent != parent))
+        pos = (pos + 1) & mask;
 
-            parent->children.insert(node, make_pair(function_id, tmp));
+    return pos;
+}
 
-            return tmp;
+void data_tree::grow_child_table() {
+    vector<ChildSlot> old_table(child_table.size() * 2);
+    old_table.swap(child_table);
 
-        } else {
-            return nullptr;
-        }
+    for (const auto& slot : old_table) {
+        if (slot.child != NO_NODE)
+            child_table[find_slot(slot.function_id, slot.parent)] = slot;
     }
 }
 
-// same as above with different intake and return
-tree_node* data_tree::insert_node(uint64_t function_id, tree_node* parent) {
-    if (parent == nullptr) {
-        shared_ptr<tree_node> tmp = std::make_shared<tree_node>(function_id, parent);
-
-        root_nodes.insert(make_pair(function_id, tmp));
+tree_node* data_tree::find_node(uint64_t function_id, const tree_node* parent) const {
+    const auto& slot = child_table[find_slot(function_id, parent == nullptr ? NO_NODE : parent->index)];
 
-        return tmp.get();
+    return slot.child == NO_NODE ? nullptr : const_cast<tree_node*>(node(slot.child));
+}
 
-    } else {
-        auto node = parent->children.find(function_id);
+// find a node or add it without data
+tree_node* data_tree::get_node(uint64_t function_id, tree_node* parent) {
+    node_index_t parent_index = parent == nullptr ? NO_NODE : parent->index;
+    size_t       pos          = find_slot(function_id, parent_index);
 
-        if (node == parent->children.end()) {
-            shared_ptr<tree_node> tmp = std::make_shared<tree_node>(function_id, parent);
+    if (child_table[pos].child != NO_NODE)
+        return node(child_table[pos].child);
 
-            parent->children.insert(make_pair(function_id, tmp));
+    // keep the load of the table at most 1/2
+    if (2 * (num_nodes + 1) > child_table.size()) {
+        grow_child_table();
+        pos = find_slot(function_id, parent_index);
+    }
 
-            return tmp.get();
+    node_index_t index = static_cast<node_index_t>(num_nodes);
 
-        } else {
-            return nullptr;
-        }
+    // chunks are never reallocated -> pointers to nodes stay valid while the tree grows
+    if ((num_nodes & (CHUNK_SIZE - 1)) == 0) {
+        chunks.emplace_back();
+        chunks.back().reserve(CHUNK_SIZE);
     }
-}
+    chunks.back().emplace_back(function_id, parent, index, locations.get());
+    ++num_nodes;
 
-// copy a node into the tree - with it's data
-void data_tree::insert_node(std::shared_ptr<tree_node> aNode) {
-    if (aNode->parent == NULL) {
-        root_nodes.insert(make_pair(aNode->function_id, aNode));
-    } else {
-        auto node = aNode->parent->children.find(aNode->function_id);
+    child_table[pos] = ChildSlot{function_id, parent_index, index};
 
-        if (node == aNode->parent->children.end()) {
-            aNode->parent->children.insert(make_pair(aNode->function_id, aNode));
-        }
+    node_index_t& last = parent == nullptr ? last_root : parent->last_child;
+    if (last == NO_NODE) {
+        (parent == nullptr ? first_root : parent->first_child) = index;
+    } else {
+        node(last)->next_sibling = index;
     }
+    last = index;
+
+    return node(index);
 }
 
-// merge a (temporary) tree into "main" tree
-void data_tree::merge_tree(data_tree& rhs_tree) {
-    for (auto it : rhs_tree.root_nodes) {
-        auto lhs_node = root_nodes.find(it.first);
+// add a node without data
+tree_node* data_tree::insert_node(uint64_t function_id, tree_node* parent) {
+    size_t old_size = num_nodes;
 
-        if (lhs_node == root_nodes.end()) {
-            root_nodes.insert(it);
+    tree_node* tmp = get_node(function_id, parent);
 
-        } else {
-            merge_node(lhs_node->second, it.second);
-        }
-    }
+    return num_nodes != old_size ? tmp : nullptr;
 }
 
-// merge two nodes -- copying rhs_node's content into lhs's
+// merge a (temporary) tree into "main" tree
 // should only be used if one knows that the data inside a node is unique (location wise)
-void data_tree::merge_node(std::shared_ptr<tree_node>& lhs_node, std::shared_ptr<tree_node>& rhs_node) {
-    for (auto it : rhs_node->node_data) {
-        lhs_node->node_data.insert(it);
-    }
+void data_tree::merge_tree(data_tree& rhs_tree) {
+    // rhs node index -> corresponding lhs node, parents are visited (pre-order) before their children
+    vector<tree_node*> lhs_nodes(rhs_tree.size(), nullptr);
 
-    lhs_node->have_collop.insert(rhs_node->have_collop.begin(), rhs_node->have_collop.end());
-    lhs_node->have_message.insert(rhs_node->have_message.begin(), rhs_node->have_message.end());
+    for (auto& rhs_node : rhs_tree) {
+        tree_node* lhs_parent = rhs_node.parent == nullptr ? nullptr : lhs_nodes[rhs_node.parent->index];
+        tree_node* lhs_node   = get_node(rhs_node.function_id, lhs_parent);
 
-    // test for children == children
-    for (auto it : rhs_node->children) {
-        auto lhs_node_o = lhs_node->children.find(it.first);
+        lhs_nodes[rhs_node.index] = lhs_node;
 
-        if (lhs_node_o != lhs_node->children.end()) {
-            merge_node(lhs_node_o->second, it.second);
-        } else {
-            insert_sub_tree(lhs_node, it.second);
+        for (auto& it : rhs_node.node_data) {
+            auto data = lhs_node->node_data.emplace(locations->get(it.first), it.first);
+
+            if (data.second)
+                *data.first = std::move(it.second);
         }
-    }
-}
 
-// TODO zu geringe funktionalität? -> benötigen wir es gesondert?
-void data_tree::insert_sub_tree(std::shared_ptr<tree_node>& parent, std::shared_ptr<tree_node>& n_node) {
-    n_node->parent = parent.get();  // shared_ptr<tree_node>(parent);
+        // emplace may have moved the data of this node
+        lhs_node->last_loc  = (uint64_t)-1;
+        lhs_node->last_data = nullptr;
 
-    parent->children.insert(make_pair(n_node->function_id, n_node));
+        // TODO workaround
+        lhs_node->has_p2p    = lhs_node->has_p2p || rhs_node.has_p2p;
+        lhs_node->has_collop = lhs_node->has_collop || rhs_node.has_collop;
+    }
 }
 
-/*
-    TODO ist aufgebläht -> wird schlimmer um so mehr daten kommen -> andere implementation möglich?
-    ohne die kombinierte funktionalität zu zerfasern
-    -> evtl neuimplementation mit iterrator
-*/
-// iterate through the tree, generate a mapping and fill the given data deques
+// walk through the node arena (parents are created before their children) and store the nodes and their data
 // for communication via MPI
-// only getting called by serialize_data - not intended for usage on it's own
-void getting_serial(std::map<uint64_t, std::pair<uint64_t, uint64_t>>& mapping,
-                    std::deque<tuple<uint64_t, uint64_t, FunctionData*>>& f_data,
-                    std::deque<tuple<uint64_t, uint64_t, MessageData*>>& m_data,
-                    std::deque<tuple<uint64_t, uint64_t, CollopData*>>& c_data,
-                    std::deque<tuple<uint64_t, uint64_t, uint64_t, MetricData*>>& met_data, std::shared_ptr<tree_node>& aNode,
-                    uint64_t& counter, stack<uint64_t>& node_stack) {
-    if (!node_stack.empty()) {
-        // insert as common node
-        mapping.insert(make_pair(counter, make_pair(aNode->function_id, node_stack.top())));
-        node_stack.push(counter);
+void data_tree::serialize_data(SerializedTree& out) const {
+    out.clear();
+    out.nodes.reserve(num_nodes);
+    out.functions.reserve(num_nodes);
 
-    } else {
-        // insert as root node
-        mapping.insert(make_pair(counter, make_pair(aNode->function_id, (uint64_t)-1)));
-        node_stack.push(counter);
-    }
+    for (const auto& chunk : chunks) {
+        for (const auto& aNode : chunk) {
+            uint64_t parent = aNode.parent == nullptr ? SerializedTree::NO_PARENT : aNode.parent->index;
+            out.nodes.push_back({aNode.function_id, parent});
 
-    // add all the data \o/
-    for (auto it = aNode->node_data.begin(); it != aNode->node_data.end(); ++it) {
-        f_data.push_back(make_tuple(counter, it->first, &it->second.f_data));
+            for (const auto& it : aNode.node_data) {
+                out.functions.push_back({aNode.index, it.first, it.second.f_data});
 
-        if (aNode->has_p2p) {
-            m_data.push_back(make_tuple(counter, it->first, &it->second.m_data));
-        }
+                if (aNode.has_p2p)
+                    out.messages.push_back({aNode.index, it.first, it.second.m_data});
 
-        if (aNode->has_collop) {
-            c_data.push_back(make_tuple(counter, it->first, &it->second.c_data));
-        }
-
-        for (auto it_metric = it->second.metrics.begin(); it_metric != it->second.metrics.end(); ++it_metric)
-            met_data.push_back(make_tuple(counter, it->first, it_metric->first, &it_metric->second));
-    }
-    // counter works as an improvised node id
-    counter++;
+                if (aNode.has_collop)
+                    out.collops.push_back({aNode.index, it.first, it.second.c_data});
 
-    // recursive call
-    for (auto it = aNode->children.begin(); it != aNode->children.end(); it++) {
-        getting_serial(mapping, f_data, m_data, c_data, met_data, it->second, counter, node_stack);
+                for (const auto& metric : it.second.metrics)
+                    out.metrics.push_back({aNode.index, it.first, metric.first, metric.second});
+            }
+        }
     }
-
-    node_stack.pop();
 }
 
-// function to serialize data for the MPI communication
-void data_tree::serialize_data(std::map<uint64_t, std::pair<uint64_t, uint64_t>>&                 mapping,
-                               std::deque<tuple<uint64_t, uint64_t, FunctionData*>>&         f_data,
-                               std::deque<tuple<uint64_t, uint64_t, MessageData*>>&          m_data,
-                               std::deque<tuple<uint64_t, uint64_t, CollopData*>>&           c_data,
-                               std::deque<tuple<uint64_t, uint64_t, uint64_t, MetricData*>>& met_data) {
-    stack<uint64_t> node_stack;
-    uint64_t        counter = 0;  //<- gibt die node_id an die sonst nicht existiert, sie ist für das
-                                  // mapping allerdings wichtig -> reduce-Schritt
-
-    auto it   = root_nodes.begin();
-    auto it_e = root_nodes.end();
-
-    for (; it != it_e; it++) {
-        getting_serial(mapping, f_data, m_data, c_data, met_data, it->second, counter, node_stack);
-    }
+bool data_tree::merge_serialized_data(const SerializedTree& in) {
+    SerializedTreeMerger merger(*this);
+
+    return merger.add(in.nodes.data(), in.nodes.size()) && merger.add(in.functions.data(), in.functions.size()) &&
+           merger.add(in.messages.data(), in.messages.size()) && merger.add(in.collops.data(), in.collops.size()) &&
+           merger.add(in.metrics.data(), in.metrics.size());
 }
 
 tree_iter data_tree::begin() {
-    if (this != nullptr && !root_nodes.empty()) {
+    if (first_root != NO_NODE) {
         return tree_iter(*this);
     } else {
         return tree_iter(nullptr, nullptr);
@@ -216,118 +166,94 @@ tree_iter data_tree::end() {
     return it;
 }
 
-tree_node::tree_node(const uint64_t _function_id, tree_node* _parent)
-    : function_id(_function_id),
-      parent(_parent),
-      last_loc((uint64_t)-1),
-      last_data(nullptr),
-      has_p2p(false),
-      has_collop(false) {}
-
-tree_node::tree_node(const uint64_t _function_id, const std::shared_ptr<tree_node>& _parent)
-    : function_id(_function_id),
-      parent(_parent.get()),
-      last_loc((uint64_t)-1),
-      last_data(nullptr),
-      has_p2p(false),
-      has_collop(false) {}
-
-tree_node::tree_node(const uint64_t _function_id, const std::shared_ptr<tree_node>& _parent, const uint64_t process_num)
-    : function_id(_function_id),
-      parent(_parent.get()),
-      last_loc((uint64_t)-1),
-      last_data(nullptr),
-      has_p2p(false),
-      has_collop(false) {}
-
-tree_node::tree_node(const uint64_t _function_id)
-    : function_id(_function_id),
-      parent(nullptr),
+tree_node::tree_node(const uint64_t _function_id, tree_node* _parent, node_index_t _index, LocationIndex* _locations)
+    : parent(_parent),
+      function_id(_function_id),
+      index(_index),
       last_loc((uint64_t)-1),
       last_data(nullptr),
-      has_p2p(false),
-      has_collop(false) {}
-
-tree_node::~tree_node() {}
+      locations(_locations) {}
 
-// adding data to call path node and saving the location_id and a pointer to the last used section
-// to speed up repeatedly acces to data of the same location (useful on location/stream wise reading of traces
-void tree_node::add_data(const uint64_t location_id, const FunctionData& fdata) {
-    if (last_loc == location_id) {
-        last_data->f_data += fdata;
-    } else {
-        last_loc = location_id;
-
-        auto it = node_data.find(location_id);
-
-        if (it != node_data.end()) {
-            it->second.f_data += fdata;
-
-            last_data = &it->second;
-
-        } else {
-            last_data = &node_data.insert(make_pair(location_id, fdata)).first->second;
-        }
+// saving the location_id and a pointer to the last used section to speed up repeatedly acces to data of the same
+// location (useful on location/stream wise reading of traces)
+NodeData* tree_node::data_of(const uint64_t location_id) {
+    if (last_loc != location_id) {
+        last_loc  = location_id;
+        last_data = node_data.emplace(locations->get(location_id), location_id).first;
     }
+
+    return last_data;
 }
 
+// adding data to call path node
+void tree_node::add_data(const uint64_t location_id, const FunctionData& fdata) { data_of(location_id)->f_data += fdata; }
+
 void tree_node::add_data(const uint64_t location_id, const MessageData& mdata) {
-    if (last_loc == location_id) {
-        last_data->m_data += mdata;
-    } else {
-        last_loc = location_id;
+    data_of(location_id)->m_data += mdata;
+    // TODO workaround
+    has_p2p = true;
+}
 
-        auto it = node_data.find(location_id);
+void tree_node::add_data(const uint64_t location_id, const CollopData& cdata) {
+    data_of(location_id)->c_data += cdata;
+    // TODO workaround
+    has_collop = true;
+}
 
-        if (it != node_data.end()) {
-            it->second.m_data += mdata;
+void tree_node::add_data(const uint64_t location_id, const uint64_t metric_id, const MetricData& metdata) {
+    data_of(location_id)->metrics[metric_id] = metdata;
+}
 
-            last_data = &it->second;
+// rebuild the nodes of a tree sent with MPI - ReduceData - inside the tree, parents come before their children
+bool SerializedTreeMerger::add(const SerializedTree::Node* records, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const auto& rhs_node = records[i];
+        if (rhs_node.parent != SerializedTree::NO_PARENT && rhs_node.parent >= nodes.size())
+            return false;
 
-        } else {
-            last_data = &node_data.insert(make_pair(location_id, mdata)).first->second;
-        }
+        tree_node* parent = rhs_node.parent == SerializedTree::NO_PARENT ? nullptr : nodes[rhs_node.parent];
+        nodes.push_back(tree.get_node(rhs_node.function_id, parent));
     }
 
-    have_message.insert(make_pair(location_id, &last_data->m_data));
-    // TODO workaround
-    has_p2p = true;
+    return true;
 }
 
-void tree_node::add_data(const uint64_t location_id, const CollopData& cdata) {
-    if (last_loc == location_id) {
-        last_data->c_data += cdata;
-    } else {
-        last_loc = location_id;
-
-        auto it = node_data.find(location_id);
-
-        if (it != node_data.end()) {
-            it->second.c_data += cdata;
+bool SerializedTreeMerger::add(const SerializedTree::Function* records, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (records[i].node >= nodes.size())
+            return false;
+        nodes[records[i].node]->add_data(records[i].location, records[i].data);
+    }
 
-            last_data = &it->second;
+    return true;
+}
 
-        } else {
-            last_data = &node_data.insert(make_pair(location_id, cdata)).first->second;
-        }
+bool SerializedTreeMerger::add(const SerializedTree::Message* records, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (records[i].node >= nodes.size())
+            return false;
+        nodes[records[i].node]->add_data(records[i].location, records[i].data);
     }
 
-    have_collop.insert(make_pair(location_id, &last_data->c_data));
-    // TODO workaround
-    has_collop = true;
+    return true;
 }
 
-void tree_node::add_data(const uint64_t location_id, const uint64_t metric_id, const MetricData& metdata) {
-    if (last_loc != location_id) {
-        last_loc = location_id;
+bool SerializedTreeMerger::add(const SerializedTree::Collop* records, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (records[i].node >= nodes.size())
+            return false;
+        nodes[records[i].node]->add_data(records[i].location, records[i].data);
+    }
 
-        auto it = node_data.find(location_id);
+    return true;
+}
 
-        if (it != node_data.end())
-            last_data = &it->second;
-        else
-            last_data = &node_data.insert(make_pair(location_id, NodeData{})).first->second;
+bool SerializedTreeMerger::add(const SerializedTree::Metric* records, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (records[i].node >= nodes.size())
+            return false;
+        nodes[records[i].node]->add_data(records[i].location, records[i].metric_id, records[i].data);
     }
 
-    last_data->metrics[metric_id] = metdata;
+    return true;
 }
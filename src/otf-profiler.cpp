@@ -57,25 +57,44 @@ int main(int argc, char** argv) {
         return 1;
 #endif
 
-    } else if (alldata.params.create_json) {
+    } else if (alldata.params.create_json || alldata.params.create_binary || alldata.params.binary_to_convert != "") {
 #ifndef HAVE_JSON
         std::cerr << "ERROR: No json library found" << std::endl;
         return 1;
 #endif
     }
 
-    /* registers all scopes for time measurement depending on the verbose level */
-    if (alldata.params.verbose_level > 0)
+    /* registers all scopes for time measurement depending on the verbose level, all of them for --self-profile */
+    if (alldata.params.verbose_level > 0 || alldata.params.self_profile)
         alldata.tm.registerScope(ScopeID::TOTAL, "Total time");
 
-    if (alldata.params.verbose_level > 1) {
+    if (alldata.params.verbose_level > 1 || alldata.params.self_profile) {
         alldata.tm.registerScope(ScopeID::COLLECT, "collection data process");
+        alldata.tm.registerScope(ScopeID::DEFINITIONS, "reading definitions");
+        alldata.tm.registerScope(ScopeID::EVENTS, "reading events");
         alldata.tm.registerScope(ScopeID::REDUCE, "reduce data");
         alldata.tm.registerScope(ScopeID::CUBE, "Cube creation process");
         alldata.tm.registerScope(ScopeID::JSON, "JSON creation process");
+        alldata.tm.registerScope(ScopeID::JSON_FILES, "analyzing I/O handles");
+        alldata.tm.registerScope(ScopeID::JSON_WRITE, "writing JSON");
+        alldata.tm.registerScope(ScopeID::BINARY_WRITE, "writing binary profile");
         alldata.tm.registerScope(ScopeID::DOT, "DOT creation process");
-        alldata.tm.registerScope(ScopeID::JSON, "JSON data output creation process");
     }
+    alldata.tm.callbacks.enabled = alldata.params.self_profile;
+
+#ifdef HAVE_JSON
+    /* --to-json: converts a binary profile, no trace is read */
+    if (alldata.params.binary_to_convert != "") {
+        if (0 == alldata.metaData.myRank &&
+            !ConvertBinaryProfile(alldata.params.binary_to_convert, alldata.params.output_file_prefix + ".json",
+                                  alldata.params.compact_json))
+            return error();
+#ifdef OTFPROFILER_MPI
+        MPI_Finalize();
+#endif /* OTFPROFILER_MPI */
+        return 0;
+    }
+#endif
 
     /* starts runtime measurement for total time */
     alldata.tm.start(ScopeID::TOTAL);
@@ -91,11 +110,19 @@ int main(int argc, char** argv) {
     if (reader == nullptr)
         return error();
 
-    if (!reader->initialize(alldata) ||
-        !reader->readDefinitions(alldata) ||
-        !reader->readEvents(alldata) ||
+    if (!reader->initialize(alldata))
+        return error();
+
+    alldata.tm.start(ScopeID::DEFINITIONS);
+    if (!reader->readDefinitions(alldata))
+        return error();
+    alldata.tm.stop(ScopeID::DEFINITIONS);
+
+    alldata.tm.start(ScopeID::EVENTS);
+    if (!reader->readEvents(alldata) ||
         !reader->readStatistics(alldata))
         return error();
+    alldata.tm.stop(ScopeID::EVENTS);
 
     reader.reset(nullptr);
 #ifdef OTFPROFILER_MPI
@@ -118,10 +145,11 @@ int main(int argc, char** argv) {
     }
 #endif /* OTFPROFILER_MPI */
 #ifdef HAVE_JSON
-		if (alldata.params.create_json) {
-			/* step 6.3: create CUBE output */
+		if (alldata.params.create_json || alldata.params.create_binary) {
+			/* step 6.3: create JSON and/or binary output */
 			alldata.tm.start(ScopeID::JSON);
-			CreateJSON(alldata);
+			if (!CreateProfile(alldata))
+				return error();
 			alldata.tm.stop(ScopeID::JSON);
 		}
 #endif
@@ -134,7 +162,7 @@ int main(int argc, char** argv) {
         show_results(alldata);
 #endif /* SHOW_RESULTS */
 
-    if (0 == alldata.metaData.myRank) {
+    if (0 == alldata.metaData.myRank && alldata.params.verbose_level > 0) {
         /* print runtime measurement results to stdout */
         alldata.tm.printAll();
     }
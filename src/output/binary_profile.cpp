@@ -0,0 +1,755 @@
+/*
+ This is part of the OTF-Profiler. Copyright by ZIH, TU Dresden 2016-2018.
+ Authors: Maximillian Neumann, Denis Hünich, Jens Doleschal
+*/
+
+#include "binary_profile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include "workflow_profile.h"
+
+static_assert(std::endian::native == std::endian::little,
+              "the binary profile is written & mapped in little-endian byte order");
+
+namespace binary_profile {
+
+namespace {
+
+struct FileHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t nr_sections;
+};
+
+struct SectionEntry {
+    uint32_t id;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct SectionHeader {
+    uint64_t rows;
+    uint32_t nr_columns;
+    uint32_t reserved;
+};
+
+struct ColumnEntry {
+    uint32_t width;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t offset;
+};
+
+uint64_t align8(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+template <typename T>
+void put(std::string& out, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T get(const uint8_t* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+/* Interns the strings of the profile, strings are referred to by index */
+class StringTable {
+   public:
+    uint32_t ref(const std::string& str) {
+        auto [it, inserted] = string_index.emplace(str, strings.size());
+        if (inserted)
+            strings.push_back(&it->first);
+        return it->second;
+    }
+
+    /* Appends the refs of `strs` as list of the next row */
+    template <typename Strings>
+    void add_list(const Strings& strs, std::vector<uint64_t>& offsets, std::vector<uint32_t>& refs) {
+        for (const auto& str : strs)
+            refs.push_back(ref(str));
+        offsets.push_back(refs.size());
+    }
+
+    /* interned strings in the order of their index */
+    std::vector<const std::string*>           strings;
+    std::unordered_map<std::string, uint32_t> string_index;
+};
+
+/* Collects the columns of one section, in the order of the section's `Column` enum */
+class SectionBuilder {
+   public:
+    SectionBuilder(SectionID id, uint64_t rows) : id(id), rows(rows) {}
+
+    template <typename T>
+    void add(uint32_t index, const std::vector<T>& values) {
+        static_assert(std::is_integral_v<T>);
+        assert(index == columns.size());
+        auto& col = columns.emplace_back();
+        col.width = sizeof(T);
+        col.count = values.size();
+        col.bytes.assign(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    /* Appends the section to `out` (8-byte aligned) & returns its entry of the section table */
+    SectionEntry append(std::string& out) const {
+        out.resize(align8(out.size()));
+        SectionEntry entry{static_cast<uint32_t>(id), 0, out.size(), 0};
+
+        put(out, SectionHeader{rows, static_cast<uint32_t>(columns.size()), 0});
+        uint64_t offset = align8(sizeof(SectionHeader) + columns.size() * sizeof(ColumnEntry));
+        for (const auto& col : columns) {
+            put(out, ColumnEntry{col.width, 0, col.count, offset});
+            offset = align8(offset + col.bytes.size());
+        }
+        for (const auto& col : columns) {
+            out.resize(align8(out.size()));
+            out.append(col.bytes);
+        }
+        entry.size = out.size() - entry.offset;
+        return entry;
+    }
+
+   private:
+    struct ColumnData {
+        uint32_t    width;
+        uint64_t    count;
+        std::string bytes;
+    };
+
+    SectionID               id;
+    uint64_t                rows;
+    std::vector<ColumnData> columns;
+};
+
+SectionBuilder TraceSection(const WorkflowProfile& profile, StringTable& strs) {
+    SectionBuilder s(SectionID::TRACE, 1);
+    s.add<uint32_t>(trace::FILENAME, {strs.ref(profile.filename)});
+    s.add<uint64_t>(trace::TRACE_ID, {profile.traceID});
+    s.add<uint64_t>(trace::JOB_ID, {profile.job_id});
+    s.add<uint32_t>(trace::NODE_COUNT, {profile.node_count});
+    s.add<uint32_t>(trace::PROCESS_COUNT, {profile.process_count});
+    s.add<uint32_t>(trace::THREAD_COUNT, {profile.thread_count});
+    s.add<uint64_t>(trace::TIMER_RESOLUTION, {profile.timer_resolution});
+    s.add<uint64_t>(trace::PARALLEL_REGION_TIME, {profile.parallel_region_time});
+    s.add<uint64_t>(trace::SERIAL_TIME, {profile.serial_time});
+    s.add<uint64_t>(trace::NUM_FUNCTIONS, {profile.num_functions});
+    s.add<uint64_t>(trace::NUM_INVOCATIONS, {profile.num_invocations});
+    s.add<uint64_t>(trace::WINDOW_BEGIN, {profile.time_window.begin});
+    s.add<uint64_t>(trace::WINDOW_END, {profile.time_window.end});
+    s.add<uint32_t>(trace::FILTER_RANKS, {strs.ref(profile.filter_ranks)});
+    s.add<uint32_t>(trace::FILTER_THREADS, {strs.ref(profile.filter_threads)});
+    std::vector<uint64_t> node_offsets{0};
+    std::vector<uint32_t> nodes;
+    strs.add_list(profile.filter_nodes, node_offsets, nodes);
+    s.add(trace::FILTER_NODES_OFFSETS, node_offsets);
+    s.add(trace::FILTER_NODES, nodes);
+    return s;
+}
+
+SectionBuilder CountersSection(const WorkflowProfile& profile, StringTable& strs) {
+    std::vector<uint32_t> names;
+    std::vector<uint64_t> values;
+    for (const auto& [name, value] : profile.counters) {
+        names.push_back(strs.ref(name));
+        values.push_back(value);
+    }
+    SectionBuilder s(SectionID::COUNTERS, names.size());
+    s.add(counters::NAME, names);
+    s.add(counters::VALUE, values);
+    return s;
+}
+
+SectionBuilder ParadigmStatsSection(const WorkflowProfile& profile, StringTable& strs) {
+    using namespace paradigm_stats;
+    std::vector<uint32_t> categories, paradigms, keys;
+    std::vector<uint64_t> values;
+    auto add_category = [&](Category category, const std::map<std::string, ProfileEntry>& by_paradigm) {
+        for (const auto& [paradigm, entry] : by_paradigm) {
+            auto paradigm_ref = strs.ref(paradigm);
+            if (entry.entries.empty()) {
+                categories.push_back(category);
+                paradigms.push_back(paradigm_ref);
+                keys.push_back(NO_REF);
+                values.push_back(0);
+            }
+            for (const auto& [key, value] : entry.entries) {
+                categories.push_back(category);
+                paradigms.push_back(paradigm_ref);
+                keys.push_back(strs.ref(key));
+                values.push_back(value);
+            }
+        }
+    };
+    add_category(FUNCTIONS, profile.functions_by_paradigm);
+    add_category(MESSAGES, profile.messages_by_paradigm);
+    add_category(COLLECTIVE_OPERATIONS, profile.collops_by_paradigm);
+    add_category(IO_OPERATIONS, profile.io_ops_by_paradigm);
+
+    SectionBuilder s(SectionID::PARADIGM_STATS, categories.size());
+    s.add(CATEGORY, categories);
+    s.add(PARADIGM, paradigms);
+    s.add(KEY, keys);
+    s.add(VALUE, values);
+    return s;
+}
+
+SectionBuilder FilesSection(const WorkflowProfile& profile, StringTable& strs) {
+    using namespace files;
+    std::vector<const FileInfo*> rows;
+    std::vector<uint32_t>        keys;
+    for (const auto& [key, info] : profile.file_data) {
+        rows.push_back(&info);
+        keys.push_back(strs.ref(key));
+    }
+    // parent files are appended as rows of their own (once, even if several files share them)
+    std::unordered_map<const FileInfo*, uint32_t> parent_rows;
+    std::vector<uint32_t>                         parents;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const FileInfo* parent = rows[i]->parentfile;
+        if (parent == nullptr) {
+            parents.push_back(NO_REF);
+            continue;
+        }
+        auto [it, inserted] = parent_rows.emplace(parent, rows.size());
+        if (inserted) {
+            rows.push_back(parent);
+            keys.push_back(NO_REF);
+        }
+        parents.push_back(it->second);
+    }
+
+    std::vector<uint32_t> filenames, paradigms, modes, stat_kinds, stat_patterns;
+    std::vector<uint64_t> bytes_read, bytes_write, ticks, locations, stat_values;
+    std::vector<uint64_t> paradigm_offsets{0}, mode_offsets{0}, location_offsets{0}, stat_offsets{0};
+    for (const FileInfo* info : rows) {
+        filenames.push_back(strs.ref(info->filename));
+        bytes_read.push_back(info->bytes_read);
+        bytes_write.push_back(info->bytes_write);
+        ticks.push_back(info->time_spent_in_ticks);
+        strs.add_list(info->paradigm, paradigm_offsets, paradigms);
+        strs.add_list(info->modes, mode_offsets, modes);
+
+        std::vector<OTF2_LocationRef> sorted_locations(info->locations.begin(), info->locations.end());
+        std::sort(sorted_locations.begin(), sorted_locations.end());
+        locations.insert(locations.end(), sorted_locations.begin(), sorted_locations.end());
+        location_offsets.push_back(locations.size());
+
+        auto add_stats = [&](PatternStatKind kind, const std::map<AccessPattern, uint64_t>& stats) {
+            for (const auto& [pattern, value] : stats) {
+                stat_kinds.push_back(kind);
+                stat_patterns.push_back(static_cast<uint32_t>(pattern));
+                stat_values.push_back(value);
+            }
+        };
+        add_stats(LOCAL_TICKS, info->ticks_spent_per_access_pattern);
+        add_stats(LOCAL_IO_SIZE, info->iosize_per_access_pattern);
+        add_stats(GLOBAL_TICKS, info->global_ticks_spent_per_access_pattern);
+        add_stats(GLOBAL_IO_SIZE, info->global_iosize_per_access_pattern);
+        stat_offsets.push_back(stat_kinds.size());
+    }
+
+    SectionBuilder s(SectionID::FILES, rows.size());
+    s.add(KEY, keys);
+    s.add(FILENAME, filenames);
+    s.add(PARENT, parents);
+    s.add(BYTES_READ, bytes_read);
+    s.add(BYTES_WRITE, bytes_write);
+    s.add(TICKS, ticks);
+    s.add(PARADIGM_OFFSETS, paradigm_offsets);
+    s.add(PARADIGMS, paradigms);
+    s.add(MODE_OFFSETS, mode_offsets);
+    s.add(MODES, modes);
+    s.add(LOCATION_OFFSETS, location_offsets);
+    s.add(LOCATIONS, locations);
+    s.add(PATTERN_STAT_OFFSETS, stat_offsets);
+    s.add(PATTERN_STAT_KIND, stat_kinds);
+    s.add(PATTERN_STAT_PATTERN, stat_patterns);
+    s.add(PATTERN_STAT_VALUE, stat_values);
+    return s;
+}
+
+SectionBuilder LocationsSection(const WorkflowProfile& profile) {
+    using namespace locations;
+    std::vector<uint64_t> keys, locs, interval_offsets{0}, begins, ends;
+    std::vector<uint32_t> patterns;
+    for (const auto& [key, info] : profile.location_data) {
+        keys.push_back(key);
+        locs.push_back(info.location);
+        std::vector<std::pair<TimeInterval, AccessPattern>> intervals(info.pattern_per_timeinterval.begin(),
+                                                                      info.pattern_per_timeinterval.end());
+        std::sort(intervals.begin(), intervals.end());
+        for (const auto& [interval, pattern] : intervals) {
+            begins.push_back(interval.first);
+            ends.push_back(interval.second);
+            patterns.push_back(static_cast<uint32_t>(pattern));
+        }
+        interval_offsets.push_back(begins.size());
+    }
+
+    SectionBuilder s(SectionID::LOCATIONS, keys.size());
+    s.add(KEY, keys);
+    s.add(LOCATION, locs);
+    s.add(INTERVAL_OFFSETS, interval_offsets);
+    s.add(INTERVAL_BEGIN, begins);
+    s.add(INTERVAL_END, ends);
+    s.add(INTERVAL_PATTERN, patterns);
+    return s;
+}
+
+SectionBuilder RegionsSection(const WorkflowProfile& profile, StringTable& strs) {
+    using namespace regions;
+    std::vector<uint32_t> keys, names, begin_src_lines, end_src_lines, paradigms, modes, callee_names;
+    std::vector<uint64_t> bytes_read, bytes_write, ticks, callee_calls;
+    std::vector<uint64_t> paradigm_offsets{0}, mode_offsets{0}, callee_offsets{0};
+    for (const auto& [key, info] : profile.io_per_region) {
+        keys.push_back(strs.ref(key));
+        names.push_back(strs.ref(info.region_name));
+        begin_src_lines.push_back(strs.ref(info.region_begin_src_line));
+        end_src_lines.push_back(strs.ref(info.region_end_src_line));
+        bytes_read.push_back(info.bytes_read);
+        bytes_write.push_back(info.bytes_write);
+        ticks.push_back(info.time_spent_in_ticks);
+        strs.add_list(info.paradigm, paradigm_offsets, paradigms);
+        strs.add_list(info.modes, mode_offsets, modes);
+        for (const auto& [callee, calls] : info.region_callees_top5) {
+            callee_names.push_back(strs.ref(callee));
+            callee_calls.push_back(calls);
+        }
+        callee_offsets.push_back(callee_names.size());
+    }
+
+    SectionBuilder s(SectionID::REGIONS, keys.size());
+    s.add(KEY, keys);
+    s.add(NAME, names);
+    s.add(BEGIN_SRC_LINE, begin_src_lines);
+    s.add(END_SRC_LINE, end_src_lines);
+    s.add(BYTES_READ, bytes_read);
+    s.add(BYTES_WRITE, bytes_write);
+    s.add(TICKS, ticks);
+    s.add(PARADIGM_OFFSETS, paradigm_offsets);
+    s.add(PARADIGMS, paradigms);
+    s.add(MODE_OFFSETS, mode_offsets);
+    s.add(MODES, modes);
+    s.add(CALLEE_OFFSETS, callee_offsets);
+    s.add(CALLEE_NAMES, callee_names);
+    s.add(CALLEE_CALLS, callee_calls);
+    return s;
+}
+
+SectionBuilder StringsSection(const StringTable& strs) {
+    std::vector<uint64_t> offsets{0};
+    std::vector<uint8_t>  chars;
+    for (const std::string* str : strs.strings) {
+        chars.insert(chars.end(), str->begin(), str->end());
+        offsets.push_back(chars.size());
+    }
+    SectionBuilder s(SectionID::STRINGS, strs.strings.size());
+    s.add(strings::OFFSETS, offsets);
+    s.add(strings::CHARS, chars);
+    return s;
+}
+
+/* Returns column `index` if it holds `count` values */
+template <typename T>
+bool GetColumn(const Section& section, uint32_t index, uint64_t count, ColumnView<T>& col) {
+    col = section.column<T>(index);
+    return col.values != nullptr && col.size == count;
+}
+
+/* Returns the offsets of a list column (see binary_profile.h) if they are ascending */
+bool GetOffsets(const Section& section, uint32_t index, ColumnView<uint64_t>& offsets) {
+    if (!GetColumn(section, index, section.rows() + 1, offsets) || offsets[0] != 0)
+        return false;
+    return std::is_sorted(offsets.begin(), offsets.end());
+}
+
+template <typename Strings>
+void ReadStringList(const Reader& reader, const ColumnView<uint64_t>& offsets, const ColumnView<uint32_t>& refs,
+                    uint64_t row, Strings& strs) {
+    for (uint64_t i = offsets[row]; i < offsets[row + 1]; ++i)
+        strs.insert(strs.end(), std::string(reader.string(refs[i])));
+}
+
+bool ValidPattern(uint32_t pattern) { return pattern <= static_cast<uint32_t>(AccessPattern::RANDOM); }
+
+bool ReadTrace(const Reader& reader, WorkflowProfile& profile) {
+    using namespace trace;
+    auto                 s = reader.section(SectionID::TRACE);
+    ColumnView<uint32_t> filename, node_count, process_count, thread_count, ranks, threads, nodes;
+    ColumnView<uint64_t> trace_id, job_id, timer_resolution, parallel_time, serial_time, num_functions;
+    ColumnView<uint64_t> num_invocations, window_begin, window_end, node_offsets;
+    if (s.rows() != 1 || !GetColumn(s, FILENAME, 1, filename) || !GetColumn(s, TRACE_ID, 1, trace_id) ||
+        !GetColumn(s, JOB_ID, 1, job_id) || !GetColumn(s, NODE_COUNT, 1, node_count) ||
+        !GetColumn(s, PROCESS_COUNT, 1, process_count) || !GetColumn(s, THREAD_COUNT, 1, thread_count) ||
+        !GetColumn(s, TIMER_RESOLUTION, 1, timer_resolution) ||
+        !GetColumn(s, PARALLEL_REGION_TIME, 1, parallel_time) || !GetColumn(s, SERIAL_TIME, 1, serial_time) ||
+        !GetColumn(s, NUM_FUNCTIONS, 1, num_functions) || !GetColumn(s, NUM_INVOCATIONS, 1, num_invocations) ||
+        !GetColumn(s, WINDOW_BEGIN, 1, window_begin) || !GetColumn(s, WINDOW_END, 1, window_end) ||
+        !GetColumn(s, FILTER_RANKS, 1, ranks) || !GetColumn(s, FILTER_THREADS, 1, threads) ||
+        !GetOffsets(s, FILTER_NODES_OFFSETS, node_offsets) ||
+        !GetColumn(s, FILTER_NODES, node_offsets[1], nodes))
+        return false;
+
+    profile.filename             = reader.string(filename[0]);
+    profile.traceID              = trace_id[0];
+    profile.job_id               = job_id[0];
+    profile.node_count           = node_count[0];
+    profile.process_count        = process_count[0];
+    profile.thread_count         = thread_count[0];
+    profile.timer_resolution     = timer_resolution[0];
+    profile.parallel_region_time = parallel_time[0];
+    profile.serial_time          = serial_time[0];
+    profile.num_functions        = num_functions[0];
+    profile.num_invocations      = num_invocations[0];
+    profile.time_window.begin    = window_begin[0];
+    profile.time_window.end      = window_end[0];
+    profile.filter_ranks         = reader.string(ranks[0]);
+    profile.filter_threads       = reader.string(threads[0]);
+    ReadStringList(reader, node_offsets, nodes, 0, profile.filter_nodes);
+    return true;
+}
+
+bool ReadCounters(const Reader& reader, WorkflowProfile& profile) {
+    auto                 s = reader.section(SectionID::COUNTERS);
+    ColumnView<uint32_t> names;
+    ColumnView<uint64_t> values;
+    if (!GetColumn(s, counters::NAME, s.rows(), names) || !GetColumn(s, counters::VALUE, s.rows(), values))
+        return false;
+
+    for (uint64_t i = 0; i < s.rows(); ++i)
+        profile.counters[std::string(reader.string(names[i]))] = values[i];
+    return true;
+}
+
+bool ReadParadigmStats(const Reader& reader, WorkflowProfile& profile) {
+    using namespace paradigm_stats;
+    auto                 s = reader.section(SectionID::PARADIGM_STATS);
+    ColumnView<uint32_t> categories, paradigms, keys;
+    ColumnView<uint64_t> values;
+    if (!GetColumn(s, CATEGORY, s.rows(), categories) || !GetColumn(s, PARADIGM, s.rows(), paradigms) ||
+        !GetColumn(s, KEY, s.rows(), keys) || !GetColumn(s, VALUE, s.rows(), values))
+        return false;
+
+    std::map<std::string, ProfileEntry>* by_category[] = {&profile.functions_by_paradigm, &profile.messages_by_paradigm,
+                                                          &profile.collops_by_paradigm, &profile.io_ops_by_paradigm};
+    for (uint64_t i = 0; i < s.rows(); ++i) {
+        if (categories[i] > IO_OPERATIONS)
+            return false;
+        auto& entry = (*by_category[categories[i]])[std::string(reader.string(paradigms[i]))];
+        if (keys[i] != NO_REF)
+            entry.entries[std::string(reader.string(keys[i]))] = values[i];
+    }
+    return true;
+}
+
+bool ReadFiles(const Reader& reader, WorkflowProfile& profile) {
+    using namespace files;
+    auto                 s    = reader.section(SectionID::FILES);
+    uint64_t             rows = s.rows();
+    ColumnView<uint32_t> keys, filenames, parents, paradigms, modes, stat_kinds, stat_patterns;
+    ColumnView<uint64_t> bytes_read, bytes_write, ticks, locations, stat_values;
+    ColumnView<uint64_t> paradigm_offsets, mode_offsets, location_offsets, stat_offsets;
+    if (!GetColumn(s, KEY, rows, keys) || !GetColumn(s, FILENAME, rows, filenames) ||
+        !GetColumn(s, PARENT, rows, parents) || !GetColumn(s, BYTES_READ, rows, bytes_read) ||
+        !GetColumn(s, BYTES_WRITE, rows, bytes_write) || !GetColumn(s, TICKS, rows, ticks) ||
+        !GetOffsets(s, PARADIGM_OFFSETS, paradigm_offsets) ||
+        !GetColumn(s, PARADIGMS, paradigm_offsets[rows], paradigms) || !GetOffsets(s, MODE_OFFSETS, mode_offsets) ||
+        !GetColumn(s, MODES, mode_offsets[rows], modes) || !GetOffsets(s, LOCATION_OFFSETS, location_offsets) ||
+        !GetColumn(s, LOCATIONS, location_offsets[rows], locations) ||
+        !GetOffsets(s, PATTERN_STAT_OFFSETS, stat_offsets) ||
+        !GetColumn(s, PATTERN_STAT_KIND, stat_offsets[rows], stat_kinds) ||
+        !GetColumn(s, PATTERN_STAT_PATTERN, stat_offsets[rows], stat_patterns) ||
+        !GetColumn(s, PATTERN_STAT_VALUE, stat_offsets[rows], stat_values))
+        return false;
+
+    // parent files are heap-allocated & owned by the files referring to them (like in FileInfo(defs, id))
+    std::vector<FileInfo*> infos(rows);
+    for (uint64_t i = 0; i < rows; ++i)
+        infos[i] = keys[i] != NO_REF ? &profile.file_data[std::string(reader.string(keys[i]))] : new FileInfo();
+
+    for (uint64_t i = 0; i < rows; ++i) {
+        FileInfo& info = *infos[i];
+        if (parents[i] != NO_REF && parents[i] >= rows)
+            return false;
+        info.parentfile          = parents[i] != NO_REF ? infos[parents[i]] : nullptr;
+        info.filename            = reader.string(filenames[i]);
+        info.bytes_read          = bytes_read[i];
+        info.bytes_write         = bytes_write[i];
+        info.time_spent_in_ticks = ticks[i];
+        ReadStringList(reader, paradigm_offsets, paradigms, i, info.paradigm);
+        ReadStringList(reader, mode_offsets, modes, i, info.modes);
+        info.locations.insert(locations.begin() + location_offsets[i], locations.begin() + location_offsets[i + 1]);
+
+        std::map<AccessPattern, uint64_t>* by_kind[] = {&info.ticks_spent_per_access_pattern,
+                                                        &info.iosize_per_access_pattern,
+                                                        &info.global_ticks_spent_per_access_pattern,
+                                                        &info.global_iosize_per_access_pattern};
+        for (uint64_t j = stat_offsets[i]; j < stat_offsets[i + 1]; ++j) {
+            if (stat_kinds[j] > GLOBAL_IO_SIZE || !ValidPattern(stat_patterns[j]))
+                return false;
+            (*by_kind[stat_kinds[j]])[static_cast<AccessPattern>(stat_patterns[j])] = stat_values[j];
+        }
+    }
+    return true;
+}
+
+bool ReadLocations(const Reader& reader, WorkflowProfile& profile) {
+    using namespace locations;
+    auto                 s = reader.section(SectionID::LOCATIONS);
+    ColumnView<uint64_t> keys, locs, interval_offsets, begins, ends;
+    ColumnView<uint32_t> patterns;
+    if (!GetColumn(s, KEY, s.rows(), keys) || !GetColumn(s, LOCATION, s.rows(), locs) ||
+        !GetOffsets(s, INTERVAL_OFFSETS, interval_offsets) ||
+        !GetColumn(s, INTERVAL_BEGIN, interval_offsets[s.rows()], begins) ||
+        !GetColumn(s, INTERVAL_END, interval_offsets[s.rows()], ends) ||
+        !GetColumn(s, INTERVAL_PATTERN, interval_offsets[s.rows()], patterns))
+        return false;
+
+    for (uint64_t i = 0; i < s.rows(); ++i) {
+        auto& info    = profile.location_data[keys[i]];
+        info.location = locs[i];
+        for (uint64_t j = interval_offsets[i]; j < interval_offsets[i + 1]; ++j) {
+            if (!ValidPattern(patterns[j]))
+                return false;
+            info.pattern_per_timeinterval[{begins[j], ends[j]}] = static_cast<AccessPattern>(patterns[j]);
+        }
+    }
+    return true;
+}
+
+bool ReadRegions(const Reader& reader, WorkflowProfile& profile) {
+    using namespace regions;
+    auto                 s    = reader.section(SectionID::REGIONS);
+    uint64_t             rows = s.rows();
+    ColumnView<uint32_t> keys, names, begin_src_lines, end_src_lines, paradigms, modes, callee_names;
+    ColumnView<uint64_t> bytes_read, bytes_write, ticks, callee_calls, paradigm_offsets, mode_offsets, callee_offsets;
+    if (!GetColumn(s, KEY, rows, keys) || !GetColumn(s, NAME, rows, names) ||
+        !GetColumn(s, BEGIN_SRC_LINE, rows, begin_src_lines) || !GetColumn(s, END_SRC_LINE, rows, end_src_lines) ||
+        !GetColumn(s, BYTES_READ, rows, bytes_read) || !GetColumn(s, BYTES_WRITE, rows, bytes_write) ||
+        !GetColumn(s, TICKS, rows, ticks) || !GetOffsets(s, PARADIGM_OFFSETS, paradigm_offsets) ||
+        !GetColumn(s, PARADIGMS, paradigm_offsets[rows], paradigms) || !GetOffsets(s, MODE_OFFSETS, mode_offsets) ||
+        !GetColumn(s, MODES, mode_offsets[rows], modes) || !GetOffsets(s, CALLEE_OFFSETS, callee_offsets) ||
+        !GetColumn(s, CALLEE_NAMES, callee_offsets[rows], callee_names) ||
+        !GetColumn(s, CALLEE_CALLS, callee_offsets[rows], callee_calls))
+        return false;
+
+    for (uint64_t i = 0; i < rows; ++i) {
+        auto& info                 = profile.io_per_region[std::string(reader.string(keys[i]))];
+        info.region_name           = reader.string(names[i]);
+        info.region_begin_src_line = reader.string(begin_src_lines[i]);
+        info.region_end_src_line   = reader.string(end_src_lines[i]);
+        info.bytes_read            = bytes_read[i];
+        info.bytes_write           = bytes_write[i];
+        info.time_spent_in_ticks   = ticks[i];
+        ReadStringList(reader, paradigm_offsets, paradigms, i, info.paradigm);
+        ReadStringList(reader, mode_offsets, modes, i, info.modes);
+        for (uint64_t j = callee_offsets[i]; j < callee_offsets[i + 1]; ++j)
+            info.region_callees_top5[std::string(reader.string(callee_names[j]))] = callee_calls[j];
+    }
+    return true;
+}
+
+}  // namespace
+
+bool WriteBinaryProfile(const WorkflowProfile& profile, const std::string& fname) {
+    StringTable                 strs;
+    std::vector<SectionBuilder> sections;
+    sections.push_back(TraceSection(profile, strs));
+    sections.push_back(CountersSection(profile, strs));
+    sections.push_back(ParadigmStatsSection(profile, strs));
+    sections.push_back(FilesSection(profile, strs));
+    sections.push_back(LocationsSection(profile));
+    sections.push_back(RegionsSection(profile, strs));
+    // string table last, once all strings are interned
+    sections.push_back(StringsSection(strs));
+
+    // header & section table are filled in once the offsets of the sections are known
+    std::string out(sizeof(FileHeader) + sections.size() * sizeof(SectionEntry), '\0');
+    std::vector<SectionEntry> entries;
+    for (const auto& section : sections)
+        entries.push_back(section.append(out));
+
+    FileHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version     = VERSION;
+    header.nr_sections = entries.size();
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + sizeof(header), entries.data(), entries.size() * sizeof(SectionEntry));
+
+    FILE* file = std::fopen(fname.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "ERROR: Could not open " << fname << " for writing" << std::endl;
+        return false;
+    }
+    bool failed = std::fwrite(out.data(), 1, out.size(), file) != out.size();
+    failed |= std::fclose(file) != 0;
+    if (failed)
+        std::cerr << "ERROR: Could not write " << fname << std::endl;
+    return !failed;
+}
+
+bool ReadBinaryProfile(const Reader& reader, WorkflowProfile& profile) {
+    struct {
+        SectionID id;
+        const char* name;
+        bool (*read)(const Reader&, WorkflowProfile&);
+    } readers[] = {{SectionID::TRACE, "TRACE", ReadTrace},
+                   {SectionID::COUNTERS, "COUNTERS", ReadCounters},
+                   {SectionID::PARADIGM_STATS, "PARADIGM_STATS", ReadParadigmStats},
+                   {SectionID::FILES, "FILES", ReadFiles},
+                   {SectionID::LOCATIONS, "LOCATIONS", ReadLocations},
+                   {SectionID::REGIONS, "REGIONS", ReadRegions}};
+
+    if (!reader.has(SectionID::TRACE)) {
+        std::cerr << "ERROR: Binary profile contains no section TRACE" << std::endl;
+        return false;
+    }
+    for (const auto& r : readers) {
+        // sections that are missing are empty
+        if (reader.has(r.id) && !r.read(reader, profile)) {
+            std::cerr << "ERROR: Invalid section " << r.name << " in binary profile" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Section::columnData(uint32_t index, uint32_t width, const uint8_t*& values, uint64_t& count) const {
+    if (index >= nr_columns)
+        return false;
+    auto col = get<ColumnEntry>(data + sizeof(SectionHeader) + index * sizeof(ColumnEntry));
+    if (col.width != width)
+        return false;
+    values = data + col.offset;
+    count  = col.count;
+    return true;
+}
+
+Reader::~Reader() { close(); }
+
+void Reader::close() {
+    if (data != nullptr)
+        munmap(const_cast<uint8_t*>(data), size);
+    data           = nullptr;
+    size           = 0;
+    file_version   = 0;
+    nr_sections    = 0;
+    string_offsets = {};
+    string_chars   = {};
+}
+
+bool Reader::open(const std::string& fname) {
+    close();
+    int fd = ::open(fname.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "ERROR: Could not open " << fname << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < sizeof(FileHeader)) {
+        std::cerr << "ERROR: " << fname << " is not a binary profile" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "ERROR: Could not map " << fname << std::endl;
+        return false;
+    }
+    data = static_cast<const uint8_t*>(mapped);
+    size = st.st_size;
+
+    auto header = get<FileHeader>(data);
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        std::cerr << "ERROR: " << fname << " is not a binary profile" << std::endl;
+        close();
+        return false;
+    }
+    if (header.version == 0 || header.version > VERSION) {
+        std::cerr << "ERROR: " << fname << " has version " << header.version << ", only versions up to " << VERSION
+                  << " are supported" << std::endl;
+        close();
+        return false;
+    }
+    file_version = header.version;
+    nr_sections  = header.nr_sections;
+
+    // checks that all sections & columns lie inside the file, so they can be accessed without further checks
+    bool valid = sizeof(FileHeader) + uint64_t(nr_sections) * sizeof(SectionEntry) <= size;
+    for (uint32_t i = 0; valid && i < nr_sections; ++i) {
+        auto entry = get<SectionEntry>(data + sizeof(FileHeader) + i * sizeof(SectionEntry));
+        valid      = entry.offset % 8 == 0 && entry.offset <= size && entry.size <= size - entry.offset &&
+                entry.size >= sizeof(SectionHeader);
+        if (!valid)
+            break;
+        auto section = get<SectionHeader>(data + entry.offset);
+        valid        = section.nr_columns <= (entry.size - sizeof(SectionHeader)) / sizeof(ColumnEntry);
+        for (uint32_t c = 0; valid && c < section.nr_columns; ++c) {
+            auto col = get<ColumnEntry>(data + entry.offset + sizeof(SectionHeader) + c * sizeof(ColumnEntry));
+            valid    = (col.width == 1 || col.width == 4 || col.width == 8) && col.offset % 8 == 0 &&
+                    col.offset <= entry.size && col.count <= (entry.size - col.offset) / col.width;
+        }
+    }
+    if (!valid) {
+        std::cerr << "ERROR: " << fname << " is corrupted" << std::endl;
+        close();
+        return false;
+    }
+
+    auto strs = section(SectionID::STRINGS);
+    if (!GetColumn(strs, strings::OFFSETS, strs.rows() + 1, string_offsets) ||
+        !GetColumn(strs, strings::CHARS, string_offsets[strs.rows()], string_chars))
+        string_offsets = {};
+    return true;
+}
+
+bool Reader::has(SectionID id) const {
+    for (uint32_t i = 0; i < nr_sections; ++i) {
+        if (get<SectionEntry>(data + sizeof(FileHeader) + i * sizeof(SectionEntry)).id == static_cast<uint32_t>(id))
+            return true;
+    }
+    return false;
+}
+
+Section Reader::section(SectionID id) const {
+    Section s;
+    for (uint32_t i = 0; i < nr_sections; ++i) {
+        auto entry = get<SectionEntry>(data + sizeof(FileHeader) + i * sizeof(SectionEntry));
+        if (entry.id != static_cast<uint32_t>(id))
+            continue;
+        auto header  = get<SectionHeader>(data + entry.offset);
+        s.data       = data + entry.offset;
+        s.nr_rows    = header.rows;
+        s.nr_columns = header.nr_columns;
+        break;
+    }
+    return s;
+}
+
+std::string_view Reader::string(uint32_t ref) const {
+    if (ref == NO_REF || uint64_t(ref) + 1 >= string_offsets.size)
+        return {};
+    uint64_t begin = string_offsets[ref], end = string_offsets[ref + 1];
+    if (begin > end || end > string_chars.size)
+        return {};
+    return {reinterpret_cast<const char*>(string_chars.values) + begin, end - begin};
+}
+
+}  // namespace binary_profile
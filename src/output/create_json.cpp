@@ -3,20 +3,26 @@
  Authors: Maximillian Neumann, Denis Hünich, Jens Doleschal, Bill Williams
 */
 #include <algorithm>
+#include <atomic>
 #include <cstdint>
-#include <fstream>
+#include <cstdio>
 #include <iostream>
 #include <numeric>
 #include <string>
+#include <thread>
+#include <vector>
 #include "all_data.h"
 #include "definitions.h"
 #include "otf2/OTF2_GeneralDefinitions.h"
 #include "rapidjson/document.h"
+#include "rapidjson/filewritestream.h"
 #include "rapidjson/prettywriter.h"
-#include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
 
 #include "access_pattern_detection.h"
+#include "binary_profile.h"
+#include "create_json.h"
+#include "workflow_profile.h"
 
 using namespace rapidjson;
 using std::cout;
@@ -41,28 +47,6 @@ class PlainWriter {
     void EndArray() const {}
 };
 
-/* Arbitrary labeled Uint64-typed data associated with a statistic */
-struct ProfileEntry {
-	/* Internal storage of labeled integer-data */
-    std::map<std::string, uint64_t> entries;
-
-    void add_data(const std::string& key, uint64_t value) {
-        if (value == 0 || value == (uint64_t)(-1))
-            return;
-        entries[key] += value;
-    }
-
-    template <typename Writer>
-    void WriteProfile(Writer& w) const {
-        w.StartObject();
-        for (const auto& kv : entries) {
-            w.Key(StringRef(kv.first.c_str()));
-            w.Uint64(kv.second);
-        }
-        w.EndObject();
-    }
-};
-
 using definitions::Definitions;
 using definitions::IoHandle;
 using AccessPatternTypeString = std::string;
@@ -91,431 +75,140 @@ namespace access_pattern {
 	}
 };
 
-struct LocationInfo {
-	OTF2_LocationRef location;
-	std::unordered_map<TimeInterval, AccessPattern, pair_hash> pattern_per_timeinterval;
-
-    template <typename Writer>
-    void WriteLocationInfo(Writer& w) const {
-        w.StartObject();
-        w.Key("Location");
-        w.Uint64(location);
-
-		w.Key("Per time interval");
-		w.StartObject();
-		for (auto& v: pattern_per_timeinterval) {
-			auto time_interval = std::to_string(v.first.first) + "-" + std::to_string(v.first.second);
-			auto pattern = access_pattern_to_string(v.second);
-			w.Key(time_interval.c_str());
-			w.String(pattern);
-		}
-		w.EndObject();
-
-        // w.Key("IoParadigm");
-        // w.StartArray();
-        // for (auto pstr : paradigm) {
-        //     w.String(pstr.c_str());
-        // }
-        // w.EndArray();
-        // w.Key("AccessModes");
-        // std::string merged_modes;
-        // for (auto modestr : modes) {
-        //     merged_modes += modestr;
-        // }
-        // w.String(merged_modes.c_str());
-
-		// w.Key("#Bytes read");
-		// w.Uint64(bytes_read);
-		// w.Key("#Bytes write");
-		// w.Uint64(bytes_write);
-		// w.Key("Ticks spent");
-		// w.Uint64(time_spent_in_ticks);
-
-		// w.Key("Nr accessed files");
-		// w.Uint64();
-
-		// // store which access patterns have been used for accessin the files (both how many locations accessed file by this access pattern & % of time of accessing file in this pattern
-		// w.Key("Ticks spent per Access Pattern");
-		// w.StartObject();
-		// for(auto& [access_pattern, ticks_spent] : ticks_spent_per_access_pattern) {
-		// 	w.Key(access_pattern_to_string(access_pattern));
-		// 	w.Uint64(ticks_spent);
-		// }
-		// w.EndObject();
-		// w.Key("I/O sizes per Access Pattern");
-		// w.StartObject();
-		// for(auto& [access_pattern, io_size] : iosize_per_access_pattern) {
-		// 	w.Key(access_pattern_to_string(access_pattern));
-		// 	w.Uint64(io_size);
-		// }
-		// w.EndObject();
-
-        w.EndObject();
-    }
-
-    void operator+=(const LocationInfo& rhs) {
-		pattern_per_timeinterval.insert(rhs.pattern_per_timeinterval.begin(), rhs.pattern_per_timeinterval.end());
-	}
+/** Statistics of a chunk of files, accumulated by the thread that analyzed the chunk */
+struct FileAnalysis {
+    std::map<std::string, FileInfo>          file_data;
+    std::map<OTF2_LocationRef, LocationInfo> location_data;
+    /* printed after the chunks are merged, so they don't interleave & keep their order */
+    std::vector<std::string> warnings;
 };
 
-/**
- *	Statistics stored per file
- */
-struct FileInfo {
-    FileInfo() : parentfile(NULL) {}
-	/* Construct FileInfo given file_ref-id (from Definitions) */
-    FileInfo(const Definitions& defs, OTF2_IoHandleRef id) {
-        parentfile           = NULL;
-        const IoHandle* ioh = defs.iohandles.get(id);
-        if (!ioh)
-            return;
-        const IoHandle* parent = defs.iohandles.get(ioh->parent);
-        if (parent)
-            parentfile = new FileInfo(defs, ioh->parent);
-        filename = ioh->file_handle->file_name;
-        paradigm.insert(defs.io_paradigms.get(ioh->io_paradigm)->name);
-        modes = ioh->modes;
-
-
-		// some io-handles might not contain a location (TODO: check!)
-		if (ioh->location.has_value()) {
-			auto location = ioh->location.value();
-			locations.insert(location);
-		} else {
-			cout << "WARNING: location doesn't have a value" << std::endl;
-		}
-    }
-
-	// TODO: Remove Operator Overloading, make function more explicit
-    void operator+=(const FileInfo& rhs) {
-        filename = rhs.filename; // TODO: the file names should be always equal, right?
-        if (rhs.parentfile && !parentfile)
-            parentfile = rhs.parentfile;
-        std::copy(rhs.paradigm.begin(), rhs.paradigm.end(), std::inserter(paradigm, paradigm.begin()));
-        std::copy(rhs.modes.begin(), rhs.modes.end(), std::inserter(modes, modes.begin()));
-
-        std::copy(rhs.locations.begin(), rhs.locations.end(), std::inserter(locations, locations.begin()));
-		// TODO: Size/Timing stats are collected elsewhere (`bytes_read`,`bytes_write`,`time_spent_in_ticks`)
-	}
-
-    std::string           filename;
-	/* I/O Paradigms used to perform I/O on file */
-    std::set<std::string> paradigm;
-	/* Modes in which file was opened (read/write) */
-	std::set<std::string> modes;
-    FileInfo*             parentfile;
-	/* Bytes read from this file */
-	std::uint64_t		  bytes_read=0;
-	/* Bytes written to this file */
-	std::uint64_t		  bytes_write=0;
-	/* Time spent reading/writing the file */
-	std::uint64_t		  time_spent_in_ticks=0;
-
-	// === Access Patterns (NEXT: TODO)
-	/* @brief Store list of locations that accessed this file
-	 * - implicitly determines whether file-access is exclusive ("E") or shared ("S") (just check whether .size==1?)
-	 */
-	std::unordered_set<OTF2_LocationRef> locations;
-
-	/** How many ticks have been spent in each access pattern */
-	std::map<AccessPattern, uint64_t> ticks_spent_per_access_pattern{};
-	/** How many bytes have been worked upon per access pattern */
-	std::map<AccessPattern, uint64_t> iosize_per_access_pattern{};
-
-
-	// TODO: time spent for meta-ops
-
-    template <typename Writer>
-    void WriteFileInfo(Writer& w) const {
-        w.StartObject();
-        w.Key("FileName");
-        w.String(filename.c_str());
-
-        w.Key("IoParadigm");
-        w.StartArray();
-        for (auto pstr : paradigm) {
-            w.String(pstr.c_str());
-        }
-        w.EndArray();
-        w.Key("AccessModes");
-        std::string merged_modes;
-        for (auto modestr : modes) {
-            merged_modes += modestr;
-        }
-        w.String(merged_modes.c_str());
-        w.Key("ParentFile");
-        if (parentfile && parentfile->filename != filename) {
-            parentfile->WriteFileInfo(w);
-        } else {
-            w.Null();
-        }
-
-		w.Key("#Bytes read");
-		w.Uint64(bytes_read);
-		w.Key("#Bytes write");
-		w.Uint64(bytes_write);
-		w.Key("Ticks spent");
-		w.Uint64(time_spent_in_ticks);
-
-		w.Key("Nr accesses from different locations");
-		w.Uint64(locations.size());
-
-		// store which access patterns have been used for accessin the files (both how many locations accessed file by this access pattern & % of time of accessing file in this pattern
-		w.Key("Ticks spent per Access Pattern");
-		w.StartObject();
-		for(auto& [access_pattern, ticks_spent] : ticks_spent_per_access_pattern) {
-			w.Key(access_pattern_to_string(access_pattern));
-			w.Uint64(ticks_spent);
-		}
-		w.EndObject();
-		w.Key("I/O sizes per Access Pattern");
-		w.StartObject();
-		for(auto& [access_pattern, io_size] : iosize_per_access_pattern) {
-			w.Key(access_pattern_to_string(access_pattern));
-			w.Uint64(io_size);
+/* Analyzes all IoHandles of `file` (statistics, local & global access patterns) */
+void AnalyzeFile(const AllData& alldata, const std::string& file_name, const File& file, FileAnalysis& result) {
+	for (auto& ioh_id : file.io_handles) {
+		auto ioh = alldata.definitions.iohandles.get(ioh_id);
+		auto location = ioh->location;
+		// auto file_name = ioh->file_handle->file_name;
+		result.file_data[file_name] += FileInfo(alldata.definitions, ioh_id);
+		// FileInfo also covers the parents of the IoHandle
+		for (auto h = ioh; h != nullptr; h = alldata.definitions.iohandles.get(h->parent))
+			if (!h->location.has_value())
+				result.warnings.push_back("WARNING: location doesn't have a value");
+
+		auto io_data = ioh->io_data_stats;
+		uint64_t bytes_read = 0, bytes_write = 0;
+		if(io_data.mode=="R") {
+			bytes_read = io_data.num_bytes;
+			bytes_write = 0;
+		} else if(io_data.mode=="W") {
+			bytes_read = 0;
+			bytes_write = io_data.num_bytes;
+		} else if (io_data.num_bytes > 0) {
+			cout << "[WARNING] Invalid io-access-mode:" << io_data.mode << ", Nr bytes worked on are:" << io_data.num_bytes << std::endl;
 		}
-		w.EndObject();
-
-        w.EndObject();
-    }
-};
-
-/** @brief Stores stats per region for output
- * TODO: NEXT
- * */
-struct RegionInfo {
-    RegionInfo() {}
-	/* Construct Region info given io_handle-id (from Definitions) */
-    RegionInfo(const Definitions& defs, uint64_t id) {
-        const IoHandle* self = defs.iohandles.get(id);
-        if (!self)
-            return;
-        const IoHandle* parent = defs.iohandles.get(self->parent);
-        region_name= self->file_handle->file_name;
-        paradigm.insert(defs.io_paradigms.get(self->io_paradigm)->name);
-        modes = self->modes;
-    }
-
-    void operator+=(const FileInfo& rhs) {
-        region_name = rhs.filename;
-        std::copy(rhs.paradigm.begin(), rhs.paradigm.end(), std::inserter(paradigm, paradigm.begin()));
-        std::copy(rhs.modes.begin(), rhs.modes.end(), std::inserter(modes, modes.begin()));
-
-		// TODO: Size/Timing stats are collected elsewhere (`bytes_read`,`bytes_write`,`time_spent_in_ticks`)
-    }
-
-	/* Region/Function name */
-    std::string           region_name;
-	std::string			  region_begin_src_line;
-	std::string			  region_end_src_line;
-	/* File in which this region/functions is defined */
-	/* I/O Paradigms used to perform I/O on file */
-    std::set<std::string> paradigm;
-	/* Modes in which file was opened (read/write) */
-	std::set<std::string> modes;
-	// WIP:
-	/* Bytes read from by this region */
-	std::uint64_t		  bytes_read=0;
-	/* Bytes written by this region */
-	std::uint64_t		  bytes_write=0;
-	/* Time spent reading/writing by this region */
-	std::uint64_t		  time_spent_in_ticks=0;
-	/* Top 5 other regions that called this region (by nr of calls) with `std::string` being the name of the calling region
-	 * @note data is taken from @ref{AllData} (field `const_cast<std::map<const Region*, uint64_t>&>(my_map);`)
-	 * */
-	std::map<std::string, uint64_t> region_callees_top5; // TODO
-	// TODO: time spent for meta-ops
-
-    template <typename Writer>
-    void WriteRegionInfo(Writer& w, const std::map<std::string, RegionInfo>* io_per_region) const {
-		if(io_per_region == nullptr) {
-			std::cerr << "Encountered io_per_region=nullptr" << std::endl;
-			return;
+		// result.file_data[file_name].filename = file_name;
+		result.file_data[file_name].bytes_write += bytes_write;
+		result.file_data[file_name].bytes_read += bytes_read;
+		result.file_data[file_name].time_spent_in_ticks += io_data.transfer_time;
+		result.file_data[file_name].time_spent_in_ticks += io_data.nontransfer_time; // TODO: output `nontransfer_time` separately as metadata-ops-time?
+
+		// get local access pattern
+		auto analysis_result = ioh->get_local_access_pattern_stats();
+		for (auto& [p, stats]: analysis_result.stats_per_pattern) {
+			result.file_data[file_name].ticks_spent_per_access_pattern[p]
+				+= stats.ticks_spent;
+				// += io_data.transfer_time;
+			result.file_data[file_name].iosize_per_access_pattern[p]
+				+= stats.io_size;
 		}
+		if (location.has_value()) // TODO: check why this could be the case
+			result.location_data[location.value()] += LocationInfo { location.value(), std::move(analysis_result.pattern_per_timeinterval) };
+	}
 
-        w.StartObject();
-        w.Key("RegionName");
-        w.String(region_name.c_str());
-
-        w.Key("IoParadigm");
-        w.StartArray();
-        for (auto pstr : paradigm) {
-            w.String(pstr.c_str());
-        }
-        w.EndArray();
-        w.Key("AccessModes");
-        std::string merged_modes;
-        for (auto modestr : modes) {
-            merged_modes += modestr;
-        }
-        w.String(merged_modes.c_str());
-
-		w.Key("#Bytes read");
-		w.Uint64(bytes_read);
-		w.Key("#Bytes write");
-		w.Uint64(bytes_write);
-		w.Key("Ticks spent");
-		w.Uint64(time_spent_in_ticks);
-
-		w.Key("Top 5 Callees");
-        w.StartArray();
-        for (auto pstr : region_callees_top5) {
-			std::string parent_begin_src_line = "?", parent_end_src_line = "?";
-			if(io_per_region->find(pstr.first) != io_per_region->end()) {
-				// TODO: src-lines not working (yet)
-				auto parent_region_info = io_per_region->find(pstr.first)->second;
-				parent_begin_src_line = parent_region_info.region_begin_src_line;
-				parent_end_src_line = parent_region_info.region_end_src_line;
-			}
-
-			w.StartObject();
-			w.Key("Region name");
-            w.String(pstr.first.c_str());
-			w.Key("Source lines");
-			w.String((parent_begin_src_line + "-" + parent_end_src_line).c_str());
-			w.Key("Nr calls");
-			w.Uint64(pstr.second);
-			w.EndObject();
-        }
-        w.EndArray();
-
-        w.EndObject();
-    }
-};
+	// global access pattern (accesses of all locations on this file)
+	auto global_result = access_pattern_detection::detect_global_access_pattern(alldata, file);
+	for (auto& [p, stats]: global_result.stats_per_pattern) {
+		result.file_data[file_name].global_ticks_spent_per_access_pattern[p] += stats.ticks_spent;
+		result.file_data[file_name].global_iosize_per_access_pattern[p] += stats.io_size;
+	}
+}
 
 /**
- * Data structure for storing resulting profile to output
+ * @brief Analyzes the IoHandles of all files with `--threads` threads
+ *
+ * The files are split into chunks (in order of their names), which the threads take one after the other. Every chunk
+ * has its own @ref FileAnalysis, they are merged in the order of the chunks -> same output as with a single thread.
  */
-struct WorkflowProfile {
-    uint64_t                            job_id;
-	/* Nr of Nodes used during execution of traced program */
-    uint32_t                            node_count;
-	/* Nr of Processes used during execution of traced program */
-    uint32_t                            process_count;
-	/* Nr of Threads used during execution of traced program */
-    uint32_t                            thread_count;
-	/* Ticks per second */
-    uint64_t                            timer_resolution;
-    std::map<std::string, uint64_t>     counters;
-    std::map<std::string, ProfileEntry> functions_by_paradigm;
-    std::map<std::string, ProfileEntry> messages_by_paradigm;
-	/* Nr of collective operations executed per paradigm */
-    std::map<std::string, ProfileEntry> collops_by_paradigm;
-	/* Nr of I/O operations executed per I/O paradigm */
-    std::map<std::string, ProfileEntry> io_ops_by_paradigm;
-	/* Statistics per file */
-    std::map<std::string, FileInfo>     file_data;
-	/* Statistics per location (rank/process) */
-    std::map<OTF2_LocationRef, LocationInfo>     location_data;
-	/* Statistics per srcline in a region */
-	std::map<std::string, RegionInfo>   io_per_region; // TODO !
-	/* Time (in ticks) spent executing parallel regions */
-    uint64_t                            parallel_region_time;
-	/* Time (in ticks) spent executing serial regions */
-    uint64_t                            serial_time;
-    uint64_t                            num_functions;
-    uint64_t                            num_invocations;
-	/* Path to otf2 trace-file (for which profile is being generated) */
-    std::string                         filename;
-    uint64_t                            traceID;
-    template <typename Writer>
-    void WriteProfile(Writer& w) const;
-    WorkflowProfile()
-        : job_id(0),
-          node_count(0),
-          process_count(0),
-          thread_count(0),
-          parallel_region_time(0),
-          serial_time(0),
-          num_functions(0),
-          num_invocations(0) {}
-};
-
-template <typename Map, typename Writer>
-void WriteMapUnderKey(std::string key, const Map& m, Writer& w) {
-    if (m.empty())
-        return;
-    w.Key(StringRef(key.c_str()));
-    w.StartObject();
-    for (const auto& kv : m) {
-        w.Key(StringRef(kv.first.c_str()));
-        kv.second.WriteProfile(w);
+void AnalyzeFiles(const AllData& alldata, WorkflowProfile& profile) {
+    std::vector<std::pair<const std::string*, const File*>> files;
+    files.reserve(alldata.definitions.filehandles.size());
+    for (const auto& [file_name, file] : alldata.definitions.filehandles)
+        files.emplace_back(&file_name, file.get());
+    std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) { return *a.first < *b.first; });
+
+    const size_t num_threads = std::max<size_t>(std::min<size_t>(alldata.params.num_threads, files.size()), 1);
+    // several chunks per thread, since files with many IoHandles take much longer
+    const size_t chunk_size = std::max<size_t>(files.size() / (16 * num_threads), 1);
+    const size_t num_chunks = (files.size() + chunk_size - 1) / chunk_size;
+
+    std::vector<FileAnalysis> chunks(num_chunks);
+    std::atomic<size_t>       next_chunk{0};
+    auto                      analyze_chunks = [&]() {
+        for (size_t c = next_chunk++; c < num_chunks; c = next_chunk++)
+            for (size_t f = c * chunk_size; f < std::min(files.size(), (c + 1) * chunk_size); ++f)
+                AnalyzeFile(alldata, *files[f].first, *files[f].second, chunks[c]);
+    };
+
+    if (num_threads <= 1) {
+        analyze_chunks();
+    } else {
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < num_threads; ++t)
+            workers.emplace_back(analyze_chunks);
+        for (auto& worker : workers)
+            worker.join();
     }
-    w.EndObject();
-}
 
-template <typename Writer>
-void WorkflowProfile::WriteProfile(Writer& w) const {
-    w.StartObject();
-    w.Key("Trace");
-    w.StartObject();
-    w.Key("FileName");
-    w.String(filename.c_str());
-    w.Key("Id");
-    w.Uint64(traceID);
-    w.EndObject();
-    w.Key("JobId");
-    w.Uint64(job_id);
-    w.Key("NodeCount");
-    w.Uint(node_count);
-    w.Key("ProcessCount");
-    w.Uint(process_count);
-    w.Key("ThreadCount");
-    w.Uint(thread_count);
-    w.Key("TimerResolution");
-    w.Uint64(timer_resolution);
-    w.Key("HardwareCounters");
-    w.StartArray();
-    for (const auto& c : counters) {
-        w.Key(StringRef(c.first.c_str()));
-        w.Uint64(c.second);
+    for (auto& chunk : chunks) {
+        // every file is analyzed in exactly one chunk
+        for (auto& [file_name, file_info] : chunk.file_data)
+            profile.file_data[file_name] = std::move(file_info);
+        for (auto& [location, location_info] : chunk.location_data)
+            profile.location_data[location] += location_info;
+        for (const auto& warning : chunk.warnings)
+            std::cout << warning << std::endl;
+        chunk = FileAnalysis();
     }
-    w.EndArray();
-    WriteMapUnderKey("Functions", functions_by_paradigm, w);
-    WriteMapUnderKey("Messages", messages_by_paradigm, w);
-    WriteMapUnderKey("CollectiveOperations", collops_by_paradigm, w);
-    WriteMapUnderKey("IOOperations", io_ops_by_paradigm, w);
-
-    w.Key("Files");
-    w.StartArray();
-    for (auto f : file_data) {
-        f.second.WriteFileInfo(w);
-    }
-    w.EndArray();
-
+}
 
-    w.Key("Locations");
-    w.StartArray();
-    for (auto l : location_data) {
-        l.second.WriteLocationInfo(w);
+/* Writes `profile` directly into the file through a fixed-size buffer, so the output is never held in memory as a whole */
+bool WriteJSON(const WorkflowProfile& profile, const string& fname, bool compact) {
+    FILE* file = std::fopen(fname.c_str(), "w");
+    if (file == nullptr) {
+        std::cerr << "ERROR: Could not open " << fname << " for writing" << std::endl;
+        return false;
     }
-    w.EndArray();
 
-    w.Key("Regions");
-    w.StartArray();
-    for (auto f : io_per_region) {
-        f.second.WriteRegionInfo(w, &io_per_region);
+    char            buffer[1 << 16];
+    FileWriteStream stream(file, buffer, sizeof(buffer));
+    if (compact) {
+        Writer<FileWriteStream> w(stream);
+        profile.WriteProfile(w);
+    } else {
+        PrettyWriter<FileWriteStream> w(stream);
+        profile.WriteProfile(w);
     }
-    w.EndArray();
-
-    // WriteMapUnderKey("Regions", io_per_region, w);
-
-    w.Key("ParallelRegionTime");
-    w.Uint64(parallel_region_time);
-    w.Key("SerialRegionTime");
-    w.Uint64(serial_time);
-    w.Key("TotalFunctions");
-    w.Uint64(num_functions);
-    w.Key("TotalCalls");
-    w.Uint64(num_invocations);
-    w.EndObject();
+    stream.Put('\n');
+    stream.Flush();
+
+    bool failed = std::ferror(file) != 0;
+    failed |= std::fclose(file) != 0;
+    if (failed)
+        std::cerr << "ERROR: Could not write " << fname << std::endl;
+    return !failed;
 }
 
-bool CreateJSON(AllData& alldata) {
-    cout << "Creating JSON profile" << std::endl;
-    WorkflowProfile            profile;
-    StringBuffer               b;
-    PrettyWriter<StringBuffer> w(b);
+void CollectProfile(AllData& alldata, WorkflowProfile& profile) {
     for (const auto& n : alldata.definitions.system_tree) {
         switch (n.data.class_id) {
             case definitions::SystemClass::LOCATION:
@@ -593,59 +286,24 @@ bool CreateJSON(AllData& alldata) {
     static std::string transfer_time = "TransferOperationTime";
 
 	/* 1) Store stats per paradigm */
-    for (auto io_entry : alldata.io_data_per_paradigm) {
+    for (const auto& io_entry : alldata.io_data_per_paradigm) {
         std::string paradigm_name = alldata.definitions.io_paradigms.get(io_entry.first)->name;
-		IoData io_data = io_entry.second;
+		const IoData& io_data = io_entry.second;
         profile.io_ops_by_paradigm[paradigm_name].entries[bytestr] += io_data.num_bytes;
         profile.io_ops_by_paradigm[paradigm_name].entries[countstr] += io_data.num_operations;
         profile.io_ops_by_paradigm[paradigm_name].entries[transfer_time] += io_data.transfer_time;
         profile.io_ops_by_paradigm[paradigm_name].entries[meta_time] += io_data.nontransfer_time;
     }
 
-	/* 2) Store stats per file */
-    for (auto& [file_name, file]: alldata.definitions.filehandles) {
-		for (auto& ioh_id : file->io_handles) {
-			auto ioh = alldata.definitions.iohandles.get(ioh_id);
-			auto location = ioh->location;
-			// auto file_name = ioh->file_handle->file_name;
-			profile.file_data[file_name] += FileInfo(alldata.definitions, ioh_id);
-
-			auto io_data = ioh->io_data_stats;
-			uint64_t bytes_read = 0, bytes_write = 0;
-			if(io_data.mode=="R") {
-				bytes_read = io_data.num_bytes;
-				bytes_write = 0;
-			} else if(io_data.mode=="W") {
-				bytes_read = 0;
-				bytes_write = io_data.num_bytes;
-			} else if (io_data.num_bytes > 0) {
-				cout << "[WARNING] Invalid io-access-mode:" << io_data.mode << ", Nr bytes worked on are:" << io_data.num_bytes << std::endl;
-			}
-			// profile.file_data[file_name].filename = file_name;
-			profile.file_data[file_name].bytes_write += bytes_write;
-			profile.file_data[file_name].bytes_read += bytes_read;
-			profile.file_data[file_name].time_spent_in_ticks += io_data.transfer_time;
-			profile.file_data[file_name].time_spent_in_ticks += io_data.nontransfer_time; // TODO: output `nontransfer_time` separately as metadata-ops-time?
-
-			// get local access pattern
-			auto analysis_result = ioh->get_local_access_pattern_stats();
-			for (auto& [p, stats]: analysis_result.stats_per_pattern) {
-				profile.file_data[file_name].ticks_spent_per_access_pattern[p]
-					+= stats.ticks_spent;
-					// += io_data.transfer_time;
-				profile.file_data[file_name].iosize_per_access_pattern[p]
-					+= stats.io_size;
-			}
-			if (location.has_value()) // TODO: check why this could be the case
-				profile.location_data[location.value()] += LocationInfo { location.value(), std::move(analysis_result.pattern_per_timeinterval) };
-		}
-		// TODO: global (per file) access pattern
-	}
+	/* 2) Store stats per file (the I/O handles are analyzed in parallel, see AnalyzeFiles) */
+	alldata.tm.start(ScopeID::JSON_FILES);
+	AnalyzeFiles(alldata, profile);
+	alldata.tm.stop(ScopeID::JSON_FILES);
 
 	/* 3) Store stats per location */
-	for(auto location_io_entry: alldata.io_data_per_location) {
+	for(const auto& location_io_entry: alldata.io_data_per_location) {
 		// TODO: NEXT
-		auto io_data = location_io_entry.second;
+		const auto& io_data = location_io_entry.second;
 		auto region = alldata.definitions.regions.get(io_data.region);
 		auto region_name = region->name;
 		auto begin_src_line = region->begin_source_line == OTF2_UNDEFINED_UINT32 ? "?" : std::to_string(region->begin_source_line);
@@ -672,7 +330,7 @@ bool CreateJSON(AllData& alldata) {
 		profile.io_per_region[idx].region_end_src_line = end_src_line;
 
 		// TODO: get 5 top-calling callees from `alldata`:
-		auto all_callee_regions = alldata.parent_regions_by_callcount[io_data.region];
+		const auto& all_callee_regions = alldata.parent_regions_by_callcount[io_data.region];
 		std::vector<std::pair<OTF2_RegionRef, uint64_t>> all_callee_regions_sorted(all_callee_regions.begin(), all_callee_regions.end()); // map to vector of pairs to sort then
 		std::sort(all_callee_regions_sorted.begin(), all_callee_regions_sorted.end(), [](const std::pair<OTF2_RegionRef, uint64_t>& a, const std::pair<OTF2_RegionRef, uint64_t>& b) {
 			return a.second > b.second;  // Sort in descending order based on the value
@@ -688,11 +346,40 @@ bool CreateJSON(AllData& alldata) {
 		}
 	}
 
-    profile.filename = alldata.params.input_file_name;
-    profile.traceID  = alldata.traceID;
-    profile.WriteProfile(w);
-    string        fname = alldata.params.output_file_prefix + ".json";
-    std::ofstream outfile(fname.c_str());
-    outfile << b.GetString() << std::endl;
-    return true;
+    profile.filename       = alldata.params.input_file_name;
+    profile.traceID        = alldata.traceID;
+    profile.time_window    = alldata.time_window;
+    profile.filter_ranks   = alldata.params.ranks.to_string();
+    profile.filter_threads = alldata.params.threads.to_string();
+    profile.filter_nodes   = alldata.params.nodes;
+    if (alldata.params.self_profile)
+        profile.self_profile = &alldata.tm;
+}
+
+bool CreateProfile(AllData& alldata) {
+    cout << "Creating profile" << std::endl;
+    WorkflowProfile profile;
+    CollectProfile(alldata, profile);
+
+    // the binary profile first, so its runtime is contained in the SelfProfile of the JSON output
+    bool written = true;
+    if (alldata.params.create_binary) {
+        alldata.tm.start(ScopeID::BINARY_WRITE);
+        written &= binary_profile::WriteBinaryProfile(profile, alldata.params.output_file_prefix + ".otfprof");
+        alldata.tm.stop(ScopeID::BINARY_WRITE);
+    }
+    if (alldata.params.create_json) {
+        alldata.tm.start(ScopeID::JSON_WRITE);
+        written &= WriteJSON(profile, alldata.params.output_file_prefix + ".json", alldata.params.compact_json);
+        alldata.tm.stop(ScopeID::JSON_WRITE);
+    }
+    return written;
+}
+
+bool ConvertBinaryProfile(const std::string& binary_file, const std::string& json_file, bool compact) {
+    binary_profile::Reader reader;
+    WorkflowProfile        profile;
+    if (!reader.open(binary_file) || !binary_profile::ReadBinaryProfile(reader, profile))
+        return false;
+    return WriteJSON(profile, json_file, compact);
 }
@@ -1,10 +1,17 @@
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <numeric>
 #include <sstream>
+#include <thread>
 #include <variant>
 
 #include "OTF2Reader.h"
+#include "location_scheduler.h"
+#include "progress_reporter.h"
 #include "access_pattern_detection.h"
 #include "definitions.h"
 #include "main_structs.h"
@@ -14,31 +21,22 @@
 #include "otf2/OTF2_ErrorCodes.h"
 #include "otf2/OTF2_Events.h"
 #include "otf2/OTF2_GeneralDefinitions.h"
+#include "otf2/OTF2_Pthread_Locks.h"
 
-#ifdef OTFPROFILE_MPI
-#include <otf2/OTF2_MPI_Collectives.h>
-#endif
+#ifdef OTFPROFILER_MPI
+#include <mpi.h>
 
+// must be defined before OTF2_MPI_Collectives.h is included
 #if MPI_VERSION < 3
 #define OTF2_MPI_UINT64_T MPI_UNSIGNED_LONG
 #define OTF2_MPI_INT64_T MPI_LONG
 #endif
 
-using namespace std;
+#include <otf2/OTF2_MPI_Collectives.h>
+#include "definitions_broadcast.h"
+#endif
 
-/** OTF2 reader handle */
-// metric id (real), data
-static map<uint64_t, MetricData>        tmp_metric;
-static std::vector<uint64_t>            locationList;
-/* Store Mapping of `OTF2_StringRef`s to strings globally accessible */
-static StringIdentifier<OTF2_StringRef> string_id;
-static StringIdentifier<OTF2_IoFileRef> filesystem_entries;
-static StringIdentifier<OTF2_AttributeRef> attributeref_to_name;
-// TODO remove
-// static std::map<OTF2_StringRef, string> stringIdToString;
-static uint64_t              systemTreeNodeId;
-/* Callback of entered regions: used to determine which region we are currently in */
-static std::deque<StackData> node_stack;
+using namespace std;
 
 string OTF2ParadigmToString(OTF2_Paradigm paradigm) {
     switch (paradigm) {
@@ -179,8 +177,14 @@ bool OTF2Reader::initialize(AllData& alldata) {
         cerr << "Failed to open OTF2-Reader" << endl;
         return false;
     }
-#ifdef OTFPROFILE_MPI
+    // several threads read events concurrently -> OTF2 has to guard its internal state
+    if (alldata.params.num_threads > 1)
+        OTF2_Pthread_Reader_SetLockingCallbacks(_reader, nullptr);
+    // the collectives are used by the substrate (eg SION) to open the files of the selected locations
+#ifdef OTFPROFILER_MPI
     OTF2_MPI_Reader_SetCollectiveCallbacks(_reader, MPI_COMM_WORLD);
+#else
+    OTF2_Reader_SetSerialCollectiveCallbacks(_reader);
 #endif
 
     uint64_t number_locations;
@@ -191,7 +195,8 @@ bool OTF2Reader::initialize(AllData& alldata) {
              << "ranks " << alldata.metaData.numRanks << " to " << number_locations << endl;
     }
 
-    locationList.reserve(number_locations);
+    _trace.alldata = &alldata;
+    _trace.locationList.reserve(number_locations);
 
     // convert and add all OTF2 Paradigms
     auto& paradigms = alldata.definitions.paradigms;
@@ -220,13 +225,14 @@ OTF2_CallbackCode OTF2Reader::handle_def_io_handle(void* userData, OTF2_IoHandle
                                                    OTF2_IoFileRef file, OTF2_IoParadigmRef ioParadigm,
                                                    OTF2_IoHandleFlag ioHandleFlags, OTF2_CommRef comm,
                                                    OTF2_IoHandleRef parent) {
-    auto* alldata = static_cast<AllData*>(userData);
+    auto* trace   = static_cast<TraceContext*>(userData);
+    auto* alldata = trace->alldata;
     if (file != OTF2_UNDEFINED_IO_FILE) {
-        auto strings = filesystem_entries.get(file);
+        auto strings = trace->filesystem_entries.get(file);
         if (strings.second != OTF2_CALLBACK_SUCCESS)
             return strings.second;
 
-		std::string file_name = *strings.first[0];
+		std::string file_name(strings.first[0]);
 		// create new FileHandle if it doesn't exist yet
 		auto fh = std::make_shared<definitions::File>(file_name);
 		auto [it, inserted] = alldata->definitions.filehandles.emplace(file_name, fh);
@@ -234,11 +240,11 @@ OTF2_CallbackCode OTF2Reader::handle_def_io_handle(void* userData, OTF2_IoHandle
         alldata->definitions.iohandles.add(self, {self, fh, ioParadigm, file, parent});
         return OTF2_CALLBACK_SUCCESS;
     } else {
-        auto strings = string_id.get(name);
+        auto strings = trace->string_id.get(name);
         if (strings.second != OTF2_CALLBACK_SUCCESS)
             return strings.second;
 
-		std::string file_name = *strings.first[0];
+		std::string file_name(strings.first[0]);
 		// create new FileHandle if it doesn't exist yet
 		auto fh = std::make_shared<definitions::File>(file_name);
 		auto [it, inserted] = alldata->definitions.filehandles.emplace(file_name, fh);
@@ -251,10 +257,11 @@ OTF2_CallbackCode OTF2Reader::handle_def_io_handle(void* userData, OTF2_IoHandle
 
 OTF2_CallbackCode OTF2Reader::handle_def_io_fs_entry(void* userData, OTF2_IoFileRef self, OTF2_StringRef name,
                                                      OTF2_SystemTreeNodeRef scope) {
-    auto strings = string_id.get(name);
+    auto* trace   = static_cast<TraceContext*>(userData);
+    auto  strings = trace->string_id.get(name);
     if (strings.second != OTF2_CALLBACK_SUCCESS)
         return strings.second;
-    filesystem_entries.add(self, strings.first[0]->c_str());
+    trace->filesystem_entries.add(self, strings.first[0]);
     return OTF2_CALLBACK_SUCCESS;
 }
 
@@ -265,7 +272,7 @@ OTF2_CallbackCode OTF2Reader::handle_def_io_fs_entry(void* userData, OTF2_IoFile
     OTF2_CallbackCode OTF2Reader::handle_def_clock_properties(void* userData, uint64_t timerResolution,
                                                               uint64_t globalOffset, uint64_t traceLength) {                                    //OTF2 2.x
 #endif
-    auto* alldata = static_cast<AllData*>(userData);
+    auto* alldata = static_cast<TraceContext*>(userData)->alldata;
 
     alldata->metaData.timerResolution = timerResolution;
     alldata->metaData.globalOffset= globalOffset;
@@ -276,16 +283,17 @@ OTF2_CallbackCode OTF2Reader::handle_def_io_fs_entry(void* userData, OTF2_IoFile
 OTF2_CallbackCode OTF2Reader::handle_def_attribute(void* userData, OTF2_AttributeRef self,
                                                    OTF2_StringRef name, OTF2_StringRef description,
                                                    OTF2_Type type) {
-    auto* alldata = static_cast<AllData*>(userData);
+    auto* trace   = static_cast<TraceContext*>(userData);
+    auto* alldata = trace->alldata;
 
-	auto strings = string_id.get(name, description);
+	auto strings = trace->string_id.get(name, description);
 
     if (strings.second != OTF2_CALLBACK_SUCCESS)
         return strings.second;
 
 	definitions::Attribute attribute {
-		*strings.first[0],
-		*strings.first[1],
+		std::string(strings.first[0]),
+		std::string(strings.first[1]),
 		type
 	};
 
@@ -305,8 +313,9 @@ OTF2_CallbackCode OTF2Reader::handle_def_metrics(   void*                   user
                                         OTF2_StringRef          unit
                                     ){
 
-    auto* alldata = static_cast<AllData*>(userData);
-    auto  strings = string_id.get(name, description, unit);
+    auto* trace   = static_cast<TraceContext*>(userData);
+    auto* alldata = trace->alldata;
+    auto  strings = trace->string_id.get(name, description, unit);
 
     if (strings.second != OTF2_CALLBACK_SUCCESS)
         return strings.second;
@@ -333,14 +342,14 @@ OTF2_CallbackCode OTF2Reader::handle_def_metrics(   void*                   user
     // }
 
     definitions::Metric metric{
-        *strings.first[0],                  // name
-        *strings.first[1],                  // description
+        std::string(strings.first[0]),      // name
+        std::string(strings.first[1]),      // description
         mappingOTF2MetricType(metricType),  //PAPI, etc.
         mappingOTF2MetricMode(metricMode),  //accumulative, relative, etc.
         a_type,                             // type of the value: OTF2_TYPE_INT64, etc.
         base == OTF2_BASE_BINARY ? MetricBase::BINARY : MetricBase::DECIMAL,
         exponent,
-        *strings.first[2],                  // unit
+        std::string(strings.first[2]),      // unit
         false
     };
 
@@ -359,7 +368,7 @@ OTF2_CallbackCode OTF2Reader::handle_def_metric_class(  void*
 
 
 
-    auto* alldata = static_cast<AllData*>(userData);
+    auto* alldata = static_cast<TraceContext*>(userData)->alldata;
 
     if( recorderKind != OTF2_RECORDER_KIND_ABSTRACT) {
         if(metricOccurrence == OTF2_METRIC_SYNCHRONOUS_STRICT){
@@ -395,14 +404,15 @@ OTF2_CallbackCode OTF2Reader::handle_def_metric_class(  void*
                                                             OTF2_StringRef name, OTF2_LocationGroupType locationGroupType,
                                                             OTF2_SystemTreeNodeRef systemTreeParent) {                                                  //OTF2 2.x
 #endif
-    auto* alldata = static_cast<AllData*>(userData);
+    auto* trace   = static_cast<TraceContext*>(userData);
+    auto* alldata = trace->alldata;
 
-    auto strings = string_id.get(name);
+    auto strings = trace->string_id.get(name);
     if (strings.second != OTF2_CALLBACK_SUCCESS) {
         return strings.second;
     }
 
-    alldata->definitions.system_tree.insert_node(*strings.first[0], groupIdentifier,
+    alldata->definitions.system_tree.insert_node(std::string(strings.first[0]), groupIdentifier,
                                                  definitions::SystemClass::LOCATION_GROUP, systemTreeParent);
 
     return OTF2_CALLBACK_SUCCESS;
@@ -411,13 +421,14 @@ OTF2_CallbackCode OTF2Reader::handle_def_metric_class(  void*
 OTF2_CallbackCode OTF2Reader::handle_def_location(void* userData, OTF2_LocationRef locationIdentifier,
                                                   OTF2_StringRef name, OTF2_LocationType locationType,
                                                   uint64_t numberOfEvents, OTF2_LocationGroupRef locationGroup) {
-    auto* alldata = static_cast<AllData*>(userData);
+    auto* trace   = static_cast<TraceContext*>(userData);
+    auto* alldata = trace->alldata;
 
-    auto strings = string_id.get(name);
+    auto strings = trace->string_id.get(name);
     if (strings.second != OTF2_CALLBACK_SUCCESS) {
         return strings.second;
     }
-    auto& location_name = *strings.first[0];
+    auto location_name = strings.first[0];
 
     ostringstream os;
     if (location_name.length() == 0) {
@@ -443,7 +454,7 @@ OTF2_CallbackCode OTF2Reader::handle_def_location(void* userData, OTF2_LocationR
                                                  locationGroup);
 
     if (locationType == OTF2_LOCATION_TYPE_CPU_THREAD || locationType == OTF2_LOCATION_TYPE_GPU) {
-        locationList.push_back(locationIdentifier);
+        trace->locationList.push_back({locationIdentifier, locationGroup, numberOfEvents});
     }
 
     return OTF2_CALLBACK_SUCCESS;
@@ -453,9 +464,10 @@ OTF2_CallbackCode OTF2Reader::handle_def_group(void* userData, OTF2_GroupRef gro
                                                OTF2_GroupType groupType, OTF2_Paradigm paradigm,
                                                OTF2_GroupFlag groupFlags, uint32_t numberOfMembers,
                                                const uint64_t* members) {
-    auto* alldata = static_cast<AllData*>(userData);
+    auto* trace   = static_cast<TraceContext*>(userData);
+    auto* alldata = trace->alldata;
 
-    auto strings = string_id.get(name);
+    auto strings = trace->string_id.get(name);
     if (strings.second != OTF2_CALLBACK_SUCCESS) {
         return strings.second;
     }
@@ -465,7 +477,8 @@ OTF2_CallbackCode OTF2Reader::handle_def_group(void* userData, OTF2_GroupRef gro
     for (uint32_t i = 0; i < numberOfMembers; ++i)
         members_vec[i] = members[i];
 
-    alldata->definitions.groups.add(groupIdentifier, {*strings.first[0], groupType, paradigm, std::move(members_vec)});
+    alldata->definitions.groups.add(groupIdentifier,
+                                    {std::string(strings.first[0]), groupType, paradigm, std::move(members_vec)});
 
     return OTF2_CALLBACK_SUCCESS;
 }
@@ -479,9 +492,10 @@ OTF2_CallbackCode OTF2Reader::handle_def_region(void* userData, OTF2_RegionRef r
                                                 OTF2_RegionRole regionRole, OTF2_Paradigm paradigm,
                                                 OTF2_RegionFlag regionFlags, OTF2_StringRef sourceFile,
                                                 uint32_t beginLineNumber, uint32_t endLineNumber) {
-    auto* alldata = static_cast<AllData*>(userData);
+    auto* trace   = static_cast<TraceContext*>(userData);
+    auto* alldata = trace->alldata;
 
-    auto strings = string_id.get(name, sourceFile);
+    auto strings = trace->string_id.get(name, sourceFile);
 
 	// cout << "Src file: " << sourceFile << "Start line nr: " << beginLineNumber << ", End line nr: " << endLineNumber << std::endl; // debug why src-lines are incorrect
     if (strings.second != OTF2_CALLBACK_SUCCESS) {
@@ -489,7 +503,8 @@ OTF2_CallbackCode OTF2Reader::handle_def_region(void* userData, OTF2_RegionRef r
     }
 
     alldata->definitions.regions.add(regionIdentifier,
-                                     {*strings.first[0], paradigm, beginLineNumber, endLineNumber, *strings.first[1]});
+                                     {std::string(strings.first[0]), paradigm, beginLineNumber, endLineNumber,
+                                      std::string(strings.first[1])});
 
     return OTF2_CALLBACK_SUCCESS;
 }
@@ -497,14 +512,15 @@ OTF2_CallbackCode OTF2Reader::handle_def_region(void* userData, OTF2_RegionRef r
 OTF2_CallbackCode OTF2Reader::handle_def_system_tree_node(void* userData, OTF2_SystemTreeNodeRef systemTreeIdentifier,
                                                           OTF2_StringRef name, OTF2_StringRef className,
                                                           OTF2_SystemTreeNodeRef parent) {
-    auto* alldata = static_cast<AllData*>(userData);
+    auto* trace   = static_cast<TraceContext*>(userData);
+    auto* alldata = trace->alldata;
 
-    auto strings = string_id.get(name, className);
+    auto strings = trace->string_id.get(name, className);
     if (strings.second != OTF2_CALLBACK_SUCCESS) {
         return strings.second;
     }
 
-    auto& nameclass = *strings.first[1];
+    std::string nameclass(strings.first[1]);
 
     definitions::SystemClass classtype;
 
@@ -530,7 +546,7 @@ OTF2_CallbackCode OTF2Reader::handle_def_system_tree_node(void* userData, OTF2_S
         classtype = definitions::SystemClass::OTHER;
     }
 
-    nameclass.append(" " + *strings.first[0]);
+    nameclass.append(" ").append(strings.first[0]);
     alldata->definitions.system_tree.insert_node(nameclass, systemTreeIdentifier, classtype, parent);
 
     return OTF2_CALLBACK_SUCCESS;
@@ -543,7 +559,7 @@ OTF2_CallbackCode OTF2Reader::handle_def_system_tree_node(void* userData, OTF2_S
     OTF2_CallbackCode OTF2Reader::handle_def_comm(void* userData, OTF2_CommRef self, OTF2_StringRef name,
                                                   OTF2_GroupRef group, OTF2_CommRef parent) {                       //OTF2 2.x
 #endif
-    auto* alldata                         = static_cast<AllData*>(userData);
+    auto* alldata                         = static_cast<TraceContext*>(userData)->alldata;
     alldata->metaData.communicators[self] = group;
 
     return OTF2_CALLBACK_SUCCESS;
@@ -552,21 +568,22 @@ OTF2_CallbackCode OTF2Reader::handle_def_system_tree_node(void* userData, OTF2_S
 OTF2_CallbackCode OTF2Reader::handle_def_string(void* userData, OTF2_StringRef stringIdentifier, const char* string) {
 	// if(strcmp(string,"Offset")==0)
 	// 	cout << "Founddd Offset" << std::endl;
-    string_id.add(stringIdentifier, string);
+    static_cast<TraceContext*>(userData)->string_id.add(stringIdentifier, string);
 
     return OTF2_CALLBACK_SUCCESS;
 }
 
 OTF2_CallbackCode OTF2Reader::handle_def_paradigm(void* userData, OTF2_Paradigm paradigm, OTF2_StringRef name,
                                                   OTF2_ParadigmClass paradigmClass) {
-    auto* alldata = static_cast<AllData*>(userData);
-    auto  strings = string_id.get(name);
+    auto* trace   = static_cast<TraceContext*>(userData);
+    auto* alldata = trace->alldata;
+    auto  strings = trace->string_id.get(name);
 
     if (strings.second != OTF2_CALLBACK_SUCCESS) {
         return strings.second;
     }
 
-    alldata->definitions.paradigms.add(paradigm, {*strings.first[0]});
+    alldata->definitions.paradigms.add(paradigm, {std::string(strings.first[0])});
 
     return OTF2_CALLBACK_SUCCESS;
 }
@@ -576,21 +593,22 @@ OTF2_CallbackCode OTF2Reader::handle_def_io_paradigm(void* userData, OTF2_IoPara
                                                      OTF2_IoParadigmFlag flags, uint8_t numProperties,
                                                      const OTF2_IoParadigmProperty* properties, const OTF2_Type* types,
                                                      const OTF2_AttributeValue* values) {
-    auto* alldata = static_cast<AllData*>(userData);
-    auto  strings = string_id.get(name);
+    auto* trace   = static_cast<TraceContext*>(userData);
+    auto* alldata = trace->alldata;
+    auto  strings = trace->string_id.get(name);
 
     if (strings.second != OTF2_CALLBACK_SUCCESS) {
         return strings.second;
     }
 
-    alldata->definitions.io_paradigms.add(paradigm, {*strings.first[0]});
+    alldata->definitions.io_paradigms.add(paradigm, {std::string(strings.first[0])});
 
     return OTF2_CALLBACK_SUCCESS;
 }
 
 OTF2_CallbackCode OTF2Reader::handle_def_io_precreated_handle(void* userData, OTF2_IoHandleRef handle,
                                                               OTF2_IoAccessMode mode, OTF2_IoStatusFlag statusFlags) {
-    auto* alldata = static_cast<AllData*>(userData);
+    auto* alldata = static_cast<TraceContext*>(userData)->alldata;
     auto* ioh     = alldata->definitions.iohandles.get(handle);
     if (!ioh)
         return OTF2_CALLBACK_ERROR;
@@ -623,28 +641,72 @@ OTF2_CallbackCode OTF2Reader::handle_def_io_precreated_handle(void* userData, OT
 /*                                                                    */
 /* ****************************************************************** */
 
-struct PendingIoEvt {
-    OTF2_TimeStamp begin_time;
-    uint64_t       bytes_request;
-};
+/* Position of an event relative to the analysed time window (--begin/--end) */
+enum class WindowPos { BEFORE, INSIDE, AFTER };
 
-/* Keep track of open I/O events (since `IO_OPERATION_BEGIN`&`IO_OPERATION_END` might be nested arbitrarily
- * - used to keep track of eg statistics inside @ref IoData
+static void enter_region(PartialEventData* partial, OTF2_LocationRef locationID, OTF2_TimeStamp time,
+                         OTF2_RegionRef region);
+static void leave_region(PartialEventData* partial, OTF2_LocationRef locationID, OTF2_TimeStamp time);
+
+/* Determines where an event lies relative to the time window
+ * - the first event inside the window enters the regions that have been entered before the window (at its begin)
+ * - the first event after the window leaves all open regions (at its end), the caller interrupts reading the location
  */
-static std::map<uint64_t, PendingIoEvt> open_io_events;
+static inline WindowPos window_pos(PartialEventData* partial, OTF2_LocationRef locationID, OTF2_TimeStamp time) {
+    const auto& window = partial->alldata->time_window;
+    auto&       loc    = partial->location_ctx;
+
+    if (time < window.begin)
+        return WindowPos::BEFORE;
+
+    if (time > window.end) {
+        if (!loc.past_window) {
+            // regions spanning the whole window
+            for (auto region : loc.skipped_regions)
+                enter_region(partial, locationID, window.begin, region);
+            loc.skipped_regions.clear();
+
+            while (!loc.node_stack.empty())
+                leave_region(partial, locationID, window.end);
+            loc.past_window = true;
+        }
+        return WindowPos::AFTER;
+    }
+
+    if (!loc.skipped_regions.empty()) {
+        for (auto region : loc.skipped_regions)
+            enter_region(partial, locationID, window.begin, region);
+        loc.skipped_regions.clear();
+    }
+
+    return WindowPos::INSIDE;
+}
+
+/* Callback result for events outside of the time window, reading stops at the first event after the window */
+static inline OTF2_CallbackCode outside_window(WindowPos pos) {
+    return pos == WindowPos::AFTER ? OTF2_CALLBACK_INTERRUPT : OTF2_CALLBACK_SUCCESS;
+}
 
 OTF2_CallbackCode OTF2Reader::io_operation_begin_callback(OTF2_LocationRef locationID, OTF2_TimeStamp time, uint64_t eventPosition,
                                               void* userData, OTF2_AttributeList* attributeList,
                                               OTF2_IoHandleRef handle, OTF2_IoOperationMode mode,
                                               OTF2_IoOperationFlag flag, uint64_t bytesRequest, uint64_t matchingId) {
-    open_io_events[matchingId] = {time, bytesRequest};
-    auto* alldata              = static_cast<AllData*>(userData);
-    auto* h                    = alldata->definitions.iohandles.get(handle);
+    auto* partial = static_cast<PartialEventData*>(userData);
+    CallbackTimer timer(partial->callbacks, CallbackID::IO_OPERATION_BEGIN);
+    auto* alldata = partial->alldata;
+
+    // operations begun before the window are still tracked, their part inside the window is accounted
+    if (window_pos(partial, locationID, time) == WindowPos::AFTER)
+        return OTF2_CALLBACK_INTERRUPT;
+
+    auto* h = partial->iohandle(handle);
+
+    partial->location_ctx.open_io_events[matchingId] = {time, bytesRequest};
 
-	// assert(!h->location || h->location == locationID); // in theory `IoHandle`s should be only accessed by the same location
-	h->location = locationID;
     if (!h)
         return OTF2_CALLBACK_ERROR;
+	// assert(!h->location || h->location == locationID); // in theory `IoHandle`s should be only accessed by the same location
+	h->location = locationID;
     switch (mode) {
         case OTF2_IO_OPERATION_MODE_READ:
             h->modes.insert("R");
@@ -686,23 +748,40 @@ OTF2_CallbackCode OTF2Reader::io_operation_begin_callback(OTF2_LocationRef locat
 OTF2_CallbackCode OTF2Reader::io_operation_complete_callback(OTF2_LocationRef locationID, OTF2_TimeStamp time, uint64_t eventPosition,
                                             void* userData, OTF2_AttributeList* attributeList, OTF2_IoHandleRef handle,
                                             uint64_t bytesResult, uint64_t matchingId) {
-    auto* alldata     = static_cast<AllData*>(userData);
-    auto  found_start = open_io_events.find(matchingId);
-    if (found_start != open_io_events.end()) {
-		auto start_time = found_start->second.begin_time;
+    auto* partial     = static_cast<PartialEventData*>(userData);
+    CallbackTimer timer(partial->callbacks, CallbackID::IO_OPERATION_COMPLETE);
+    auto& loc         = partial->location_ctx;
+    auto* alldata     = partial->alldata;
+    auto  pos         = window_pos(partial, locationID, time);
+    if (pos == WindowPos::AFTER)
+        return OTF2_CALLBACK_INTERRUPT;
+
+    auto found_start = loc.open_io_events.find(matchingId);
+    if (found_start != loc.open_io_events.end()) {
+		// only the part of the operation inside the time window is accounted
+		auto start_time = std::max<uint64_t>(found_start->second.begin_time, alldata->time_window.begin);
         auto duration  = time - start_time;
         auto bytes_req = found_start->second.bytes_request;
-        open_io_events.erase(found_start);
-        auto h = alldata->definitions.iohandles.get(handle);
+        loc.open_io_events.erase(found_start);
+        auto h = partial->iohandle(handle);
         if (!h)
             return OTF2_CALLBACK_ERROR;  // event on undefined IO handle
 
+		// before the time window only the file position & size are tracked
+		if (pos == WindowPos::BEFORE) {
+			if (bytesResult != OTF2_UNDEFINED_UINT64)
+				h->fpos += bytesResult;
+			auto& fsize = partial->file_size(*h->file_handle);
+			fsize = std::max(fsize, h->fpos);
+			return OTF2_CALLBACK_SUCCESS;
+		}
+
 		uint64_t p = h->io_paradigm;
 		// Store statistics 1) per paradigm, 2) per file (IoHandle), 3) per location (process/thread, maybe region?)
 		IoData* io_data_stats[3] = {
-			&(alldata->io_data_per_paradigm[p]),
-			&(alldata->definitions.iohandles.get(handle)->io_data_stats),
-			&(alldata->io_data_per_location[locationID])
+			&(partial->io_data_per_paradigm[p]),
+			&(h->io_data_stats),
+			&(partial->io_data_per_location[locationID])
 		};
 
 		bool is_meta = false;
@@ -718,26 +797,24 @@ OTF2_CallbackCode OTF2Reader::io_operation_complete_callback(OTF2_LocationRef lo
 				is_meta = true;
 				io_data->nontransfer_time += duration;
 			}
-			auto region_id =  node_stack.front().node_p->function_id;
-			io_data->region = region_id;
+			io_data->region = loc.current_region();
 		}
 		// alldata.metaData.timerResolution;
 		std::chrono::duration<double> start_sec = std::chrono::duration<double>(start_time-alldata->metaData.globalOffset) / alldata->metaData.timerResolution;
 		auto start_ns = duration_cast<std::chrono::nanoseconds>(start_sec).count();
 		std::chrono::duration<double> end_sec = std::chrono::duration<double>(time-alldata->metaData.globalOffset) / alldata->metaData.timerResolution;
 		auto end_ns = duration_cast<std::chrono::nanoseconds>(start_sec).count();
-		h->io_accesses.push_back(IoAccess{static_cast<uint64_t>(start_ns),static_cast<uint64_t>(end_ns), h->fpos, bytesResult, duration, is_meta});
+		IoAccess io_access{static_cast<uint64_t>(start_ns),static_cast<uint64_t>(end_ns), h->fpos, bytesResult, duration, is_meta};
+		h->access_pattern_detector.add(io_access);
+		if (h->file_handle->keeps_io_accesses())
+			h->io_accesses.push_back(io_access);
 
 		// Update `fpos`
 		if (!is_meta)
 			h->fpos += bytesResult;
-		// If necessary update file-size
-		h->file_handle->fsize_mutex->lock(); // TODO: synchronize btw MPI-Processes
-		if (h->fpos > h->file_handle->fsize) {
-			// we have written bytes exceeding `fsize`
-			h->file_handle->fsize = h->fpos;
-		}
-		h->file_handle->fsize_mutex->unlock();
+		// If necessary update file-size (we have written bytes exceeding it)
+		auto& fsize = partial->file_size(*h->file_handle);
+		fsize = std::max(fsize, h->fpos);
     }
     return OTF2_CALLBACK_SUCCESS;
 }
@@ -752,8 +829,14 @@ OTF2_CallbackCode OTF2Reader::io_seek_callback ( OTF2_LocationRef    location,
                                      OTF2_IoSeekOption   whence,
                                      uint64_t            offsetResult )
 {
-    auto* alldata = static_cast<AllData*>(userData);
-    auto* ioh     = alldata->definitions.iohandles.get(handle);
+    auto* partial = static_cast<PartialEventData*>(userData);
+    CallbackTimer timer(partial->callbacks, CallbackID::IO_SEEK);
+    if (window_pos(partial, location, time) == WindowPos::AFTER)
+        return OTF2_CALLBACK_INTERRUPT;
+
+    auto* ioh = partial->iohandle(handle);
+    if (!ioh)
+        return OTF2_CALLBACK_ERROR;
 
 	if (whence == OTF2_IO_SEEK_FROM_START) {
 		ioh->fpos = offsetResult;
@@ -762,8 +845,8 @@ OTF2_CallbackCode OTF2Reader::io_seek_callback ( OTF2_LocationRef    location,
 		auto absolute_offset = ioh->fpos + offsetResult;
 		ioh->fpos = absolute_offset;
 	} else if (whence == OTF2_IO_SEEK_FROM_END) {
-		// TODO: requires tracking of current file-size (!across locations)
-		auto absolute_offset = ioh->file_handle->fsize + offsetResult; // TODO: possible race condition?
+		// TODO: only the writes of this location group are known here, not the ones of other processes
+		auto absolute_offset = partial->file_size(*ioh->file_handle) + offsetResult;
 		ioh->fpos = absolute_offset;
 	} else if (whence == OTF2_IO_SEEK_DATA) {
 		// TODO: would require to track whole file contents (alongside current fpos) ??
@@ -786,8 +869,14 @@ OTF2_CallbackCode OTF2Reader::io_create_handle_callback(OTF2_LocationRef locatio
                                                       OTF2_AttributeList* attributeList, OTF2_IoHandleRef handle,
                                                       OTF2_IoAccessMode mode, OTF2_IoCreationFlag creationFlags,
                                                       OTF2_IoStatusFlag statusFlags) {
-    auto* alldata = static_cast<AllData*>(userData);
-    auto* ioh     = alldata->definitions.iohandles.get(handle);
+    auto* partial = static_cast<PartialEventData*>(userData);
+    CallbackTimer timer(partial->callbacks, CallbackID::IO_CREATE_HANDLE);
+    if (window_pos(partial, locationID, time) == WindowPos::AFTER)
+        return OTF2_CALLBACK_INTERRUPT;
+
+    auto* ioh = partial->iohandle(handle);
+    if (!ioh)
+        return OTF2_CALLBACK_ERROR;
 	ioh->location = locationID;
     switch (mode) {
         case OTF2_IO_ACCESS_MODE_READ_ONLY:
@@ -816,7 +905,14 @@ OTF2_CallbackCode OTF2Reader::handle_metric(OTF2_LocationRef locationID, OTF2_Ti
                                             void* userData, OTF2_AttributeList* attributeList, OTF2_MetricRef metric,
                                             uint8_t numberOfMetrics, const OTF2_Type* typeIDs,
                                             const OTF2_MetricValue* metricValues) {
-    auto* alldata = static_cast<AllData*>(userData);
+    auto* partial = static_cast<PartialEventData*>(userData);
+    CallbackTimer timer(partial->callbacks, CallbackID::METRIC);
+    auto* alldata = partial->alldata;
+    auto& loc     = partial->location_ctx;
+
+    auto pos = window_pos(partial, locationID, time);
+    if (pos != WindowPos::INSIDE)
+        return outside_window(pos);
 
     auto class_mapping = alldata->definitions.metric_classes.get(metric);
     if (class_mapping != nullptr) {
@@ -841,7 +937,7 @@ OTF2_CallbackCode OTF2Reader::handle_metric(OTF2_LocationRef locationID, OTF2_Ti
                         md = {MetricDataType::DOUBLE, static_cast<uint64_t>(metricValues[i].floating_point), static_cast<int64_t>(metricValues[i].floating_point)};
                     }
 
-                    tmp_metric.insert(make_pair(metric_ref->second, md));
+                    loc.tmp_metric.insert(make_pair(metric_ref->second, md));
                 }
             }
         }
@@ -850,43 +946,25 @@ OTF2_CallbackCode OTF2Reader::handle_metric(OTF2_LocationRef locationID, OTF2_Ti
     return OTF2_CALLBACK_SUCCESS;
 }
 
-/* Region Enter */
-OTF2_CallbackCode OTF2Reader::handle_enter(OTF2_LocationRef locationID, OTF2_TimeStamp time, uint64_t eventPosition,
-                                           void* userData, OTF2_AttributeList* attributeList, OTF2_RegionRef region)
-
-{
-    auto*      alldata = static_cast<AllData*>(userData);
-    tree_node* tmp_node;
-
-    if (!node_stack.empty()) {
-        auto tmp = node_stack.front().node_p;
-
-		auto parent_region = tmp->function_id;
-		auto current_region = region;
-		alldata->parent_regions_by_callcount[region][parent_region] += 1;
-
-        auto tmp_child = tmp->children.find(region);
-        if (tmp_child == tmp->children.end()) {
-            tmp_node = alldata->call_path_tree.insert_node(region, tmp);
-        } else {
-            tmp_node = tmp_child->second.get();
-        }
+/* Enters `region` at `time`: pushes its call-path node onto the region stack */
+static void enter_region(PartialEventData* partial, OTF2_LocationRef locationID, OTF2_TimeStamp time,
+                         OTF2_RegionRef region) {
+    auto&      loc    = partial->location_ctx;
+    tree_node* parent = nullptr;
 
-    } else {
-        auto root_node = alldata->call_path_tree.root_nodes.find(region);
+    if (!loc.node_stack.empty()) {
+        parent = loc.node_stack.front().node_p;
 
-        if (root_node == alldata->call_path_tree.root_nodes.end()) {
-            tmp_node = alldata->call_path_tree.insert_node(region, nullptr);
-        } else {
-            tmp_node = root_node->second.get();
-        }
+		partial->parent_regions_by_callcount[region][parent->function_id] += 1;
     }
 
+    tree_node* tmp_node = partial->call_path_tree.get_node(region, parent);
+
     tmp_node->add_data(locationID, FunctionData{0, 0, 0});
     auto& node_metrics = tmp_node->last_data->metrics;
 
-    if (!tmp_metric.empty()) {
-        for (auto it : tmp_metric) {
+    if (!loc.tmp_metric.empty()) {
+        for (auto it : loc.tmp_metric) {
             auto metric_ref = node_metrics.find(it.first);
 
             if (metric_ref == node_metrics.end()) {
@@ -901,27 +979,25 @@ OTF2_CallbackCode OTF2Reader::handle_enter(OTF2_LocationRef locationID, OTF2_Tim
             }
         }
 
-        tmp_metric.clear();
+        loc.tmp_metric.clear();
     }
 
-    node_stack.push_front({tmp_node, time, 0});
-
-    return OTF2_CALLBACK_SUCCESS;
+    loc.node_stack.push_front({tmp_node, time, 0});
 }
 
-OTF2_CallbackCode OTF2Reader::handle_leave(OTF2_LocationRef locationID, OTF2_TimeStamp time, uint64_t eventPosition,
-                                           void* userData, OTF2_AttributeList* attributeList, OTF2_RegionRef region) {
-    auto* alldata = static_cast<AllData*>(userData);
+/* Leaves the innermost open region at `time` */
+static void leave_region(PartialEventData* partial, OTF2_LocationRef locationID, OTF2_TimeStamp time) {
+    auto& loc = partial->location_ctx;
 
-    auto&    tmp       = node_stack.front();
+    auto&    tmp       = loc.node_stack.front();
     uint64_t incl_time = time - tmp.time;
     tmp.node_p->add_data(locationID, FunctionData{1, incl_time, incl_time - tmp.child_incl});
 
     // ugly metric stuff
     auto* tmp_node(tmp.node_p);
     auto& node_metrics = tmp_node->last_data->metrics;
-    if (!tmp_metric.empty()) {
-        for (auto it = tmp_metric.begin(); it != tmp_metric.end(); it++) {
+    if (!loc.tmp_metric.empty()) {
+        for (auto it = loc.tmp_metric.begin(); it != loc.tmp_metric.end(); it++) {
             auto metric_ref = node_metrics.find(it->first);
 
             if (metric_ref == node_metrics.end()) {
@@ -935,12 +1011,72 @@ OTF2_CallbackCode OTF2Reader::handle_leave(OTF2_LocationRef locationID, OTF2_Tim
             }
         }
 
-        tmp_metric.clear();
+        loc.tmp_metric.clear();
     }
-    node_stack.pop_front();
-    if (!node_stack.empty()) {
-        node_stack.front().child_incl += incl_time;
+    loc.node_stack.pop_front();
+    if (!loc.node_stack.empty()) {
+        loc.node_stack.front().child_incl += incl_time;
     }
+}
+
+/* Region Enter */
+OTF2_CallbackCode OTF2Reader::handle_enter(OTF2_LocationRef locationID, OTF2_TimeStamp time, uint64_t eventPosition,
+                                           void* userData, OTF2_AttributeList* attributeList, OTF2_RegionRef region)
+
+{
+    auto* partial = static_cast<PartialEventData*>(userData);
+    CallbackTimer timer(partial->callbacks, CallbackID::ENTER);
+
+    auto pos = window_pos(partial, locationID, time);
+    if (pos == WindowPos::BEFORE)
+        partial->location_ctx.skipped_regions.push_back(region);
+    if (pos != WindowPos::INSIDE)
+        return outside_window(pos);
+
+    enter_region(partial, locationID, time, region);
+
+    return OTF2_CALLBACK_SUCCESS;
+}
+
+OTF2_CallbackCode OTF2Reader::handle_leave(OTF2_LocationRef locationID, OTF2_TimeStamp time, uint64_t eventPosition,
+                                           void* userData, OTF2_AttributeList* attributeList, OTF2_RegionRef region) {
+    auto* partial = static_cast<PartialEventData*>(userData);
+    CallbackTimer timer(partial->callbacks, CallbackID::LEAVE);
+
+    auto pos = window_pos(partial, locationID, time);
+    if (pos == WindowPos::BEFORE && !partial->location_ctx.skipped_regions.empty())
+        partial->location_ctx.skipped_regions.pop_back();
+    if (pos != WindowPos::INSIDE)
+        return outside_window(pos);
+
+    leave_region(partial, locationID, time);
+
+    return OTF2_CALLBACK_SUCCESS;
+}
+
+OTF2_CallbackCode OTF2Reader::handle_enter_io_only(OTF2_LocationRef locationID, OTF2_TimeStamp time,
+                                                   uint64_t eventPosition, void* userData,
+                                                   OTF2_AttributeList* attributeList, OTF2_RegionRef region) {
+    auto* partial = static_cast<PartialEventData*>(userData);
+    CallbackTimer timer(partial->callbacks, CallbackID::ENTER);
+    if (window_pos(partial, locationID, time) == WindowPos::AFTER)
+        return OTF2_CALLBACK_INTERRUPT;
+
+    partial->location_ctx.region_stack.push_back(region);
+
+    return OTF2_CALLBACK_SUCCESS;
+}
+
+OTF2_CallbackCode OTF2Reader::handle_leave_io_only(OTF2_LocationRef locationID, OTF2_TimeStamp time,
+                                                   uint64_t eventPosition, void* userData,
+                                                   OTF2_AttributeList* attributeList, OTF2_RegionRef region) {
+    auto* partial = static_cast<PartialEventData*>(userData);
+    CallbackTimer timer(partial->callbacks, CallbackID::LEAVE);
+    if (window_pos(partial, locationID, time) == WindowPos::AFTER)
+        return OTF2_CALLBACK_INTERRUPT;
+
+    if (!partial->location_ctx.region_stack.empty())
+        partial->location_ctx.region_stack.pop_back();
 
     return OTF2_CALLBACK_SUCCESS;
 }
@@ -948,9 +1084,15 @@ OTF2_CallbackCode OTF2Reader::handle_leave(OTF2_LocationRef locationID, OTF2_Tim
 OTF2_CallbackCode OTF2Reader::handle_mpi_send(OTF2_LocationRef locationID, OTF2_TimeStamp time, uint64_t eventPosition,
                                               void* userData, OTF2_AttributeList* attributeList, uint32_t receiver,
                                               OTF2_CommRef communicator, uint32_t msgTag, uint64_t msgLength) {
-    auto* alldata = static_cast<AllData*>(userData);
+    auto* partial = static_cast<PartialEventData*>(userData);
+    CallbackTimer timer(partial->callbacks, CallbackID::MPI_SEND);
+    auto& loc     = partial->location_ctx;
 
-    auto& tmp = node_stack.front();
+    auto pos = window_pos(partial, locationID, time);
+    if (pos != WindowPos::INSIDE)
+        return outside_window(pos);
+
+    auto& tmp = loc.node_stack.front();
     tmp.node_p->add_data(locationID, MessageData{1, 0, msgLength, 0});
     // TODO workaround
     tmp.node_p->has_p2p = true;
@@ -961,9 +1103,15 @@ OTF2_CallbackCode OTF2Reader::handle_mpi_send(OTF2_LocationRef locationID, OTF2_
 OTF2_CallbackCode OTF2Reader::handle_mpi_recv(OTF2_LocationRef locationID, OTF2_TimeStamp time, uint64_t eventPosition,
                                               void* userData, OTF2_AttributeList* attributeList, uint32_t sender,
                                               OTF2_CommRef communicator, uint32_t msgTag, uint64_t msgLength) {
-    auto* alldata = static_cast<AllData*>(userData);
+    auto* partial = static_cast<PartialEventData*>(userData);
+    CallbackTimer timer(partial->callbacks, CallbackID::MPI_RECV);
+    auto& loc     = partial->location_ctx;
+
+    auto pos = window_pos(partial, locationID, time);
+    if (pos != WindowPos::INSIDE)
+        return outside_window(pos);
 
-    auto& tmp = node_stack.front();
+    auto& tmp = loc.node_stack.front();
     tmp.node_p->add_data(locationID, MessageData{0, 1, 0, msgLength});
     // TODO workaround
     tmp.node_p->has_p2p = true;
@@ -975,9 +1123,15 @@ OTF2_CallbackCode OTF2Reader::handle_mpi_isend(OTF2_LocationRef locationID, OTF2
                                                void* userData, OTF2_AttributeList* attributeList, uint32_t receiver,
                                                OTF2_CommRef communicator, uint32_t msgTag, uint64_t msgLength,
                                                uint64_t requestID) {
-    auto* alldata = static_cast<AllData*>(userData);
+    auto* partial = static_cast<PartialEventData*>(userData);
+    CallbackTimer timer(partial->callbacks, CallbackID::MPI_ISEND);
+    auto& loc     = partial->location_ctx;
+
+    auto pos = window_pos(partial, locationID, time);
+    if (pos != WindowPos::INSIDE)
+        return outside_window(pos);
 
-    auto& tmp = node_stack.front();
+    auto& tmp = loc.node_stack.front();
     tmp.node_p->add_data(locationID, MessageData{1, 0, msgLength, 0});
     // TODO workaround
     tmp.node_p->has_p2p = true;
@@ -1005,9 +1159,15 @@ OTF2_CallbackCode OTF2Reader::handle_mpi_irecv(OTF2_LocationRef locationID, OTF2
                                                void* userData, OTF2_AttributeList* attributeList, uint32_t sender,
                                                OTF2_CommRef communicator, uint32_t msgTag, uint64_t msgLength,
                                                uint64_t requestID) {
-    auto* alldata = static_cast<AllData*>(userData);
+    auto* partial = static_cast<PartialEventData*>(userData);
+    CallbackTimer timer(partial->callbacks, CallbackID::MPI_IRECV);
+    auto& loc     = partial->location_ctx;
 
-    auto& tmp = node_stack.front();
+    auto pos = window_pos(partial, locationID, time);
+    if (pos != WindowPos::INSIDE)
+        return outside_window(pos);
+
+    auto& tmp = loc.node_stack.front();
     tmp.node_p->add_data(locationID, MessageData{0, 1, 0, msgLength});
     // TODO workaround
     tmp.node_p->has_p2p = true;
@@ -1044,12 +1204,18 @@ OTF2_CallbackCode OTF2Reader::handle_mpi_collective_end(OTF2_LocationRef locatio
                                                         OTF2_AttributeList* attributeList, OTF2_CollectiveOp type,
                                                         OTF2_CommRef communicator, uint32_t root, uint64_t sizeSent,
                                                         uint64_t sizeReceived) {
+    auto* partial = static_cast<PartialEventData*>(userData);
+    CallbackTimer timer(partial->callbacks, CallbackID::MPI_COLLECTIVE_END);
     if (type == OTF2_COLLECTIVE_OP_BARRIER)
         return OTF2_CALLBACK_SUCCESS;
 
-    auto* alldata = static_cast<AllData*>(userData);
+    auto& loc     = partial->location_ctx;
+
+    auto pos = window_pos(partial, locationID, time);
+    if (pos != WindowPos::INSIDE)
+        return outside_window(pos);
 
-    auto& tmp = node_stack.front();
+    auto& tmp = loc.node_stack.front();
 
     if (sizeSent > 0) {
         tmp.node_p->add_data(locationID, CollopData{1, 0, sizeSent, 0});
@@ -1134,6 +1300,42 @@ OTF2_CallbackCode OTF2Reader::handle_unknown(OTF2_LocationRef locationID, OTF2_T
 */
 
 bool OTF2Reader::readDefinitions(AllData& alldata) {
+#ifdef OTFPROFILER_MPI
+    // --bcast-defs: only rank 0 reads the global definitions, the other ranks receive them
+    if (alldata.params.broadcast_definitions && alldata.metaData.numRanks > 1) {
+        bool have_definitions = alldata.metaData.myRank != 0 || readGlobalDefinitions(alldata);
+        if (!definitions_broadcast::broadcast(alldata, _trace.locationList, have_definitions))
+            return false;
+
+        alldata.verbosePrint(1, true, "OTF2: definitions broadcast to all ranks");
+
+        return alldata.resolveTimeWindow();
+    }
+#endif
+
+    if (!readGlobalDefinitions(alldata))
+        return false;
+
+    // --begin/--end are given relative to the clock properties of the trace
+    return alldata.resolveTimeWindow();
+}
+
+bool OTF2Reader::readGlobalDefinitions(AllData& alldata) {
+    const auto&         cache_path = alldata.params.definitions_cache;
+    DefinitionsCacheKey cache_key;
+    if (!cache_path.empty()) {
+        std::error_code ec;
+        auto            anchor_mtime = std::filesystem::last_write_time(alldata.params.input_file_name, ec);
+        cache_key.trace_id           = alldata.traceID;
+        cache_key.anchor_mtime       = ec ? 0 : static_cast<int64_t>(anchor_mtime.time_since_epoch().count());
+        cache_key.read_metrics       = alldata.params.read_metrics;
+
+        if (definitions_cache::load(cache_path, cache_key, alldata, _trace.locationList)) {
+            alldata.verbosePrint(1, true, "OTF2: definitions loaded from " + cache_path);
+            return true;
+        }
+    }
+
     alldata.verbosePrint(1, true, "OTF2: read definitions");
 
     OTF2_ErrorCode status;
@@ -1227,7 +1429,7 @@ bool OTF2Reader::readDefinitions(AllData& alldata) {
     if (OTF2_SUCCESS != status)
         return false;
 
-    status = OTF2_Reader_RegisterGlobalDefCallbacks(_reader, glob_def_reader, glob_def_callbacks, &alldata);
+    status = OTF2_Reader_RegisterGlobalDefCallbacks(_reader, glob_def_reader, glob_def_callbacks, &_trace);
     if (OTF2_SUCCESS != status)
         return false;
     uint64_t definitions_read = 0;
@@ -1239,19 +1441,142 @@ bool OTF2Reader::readDefinitions(AllData& alldata) {
 
     OTF2_GlobalDefReaderCallbacks_Delete(glob_def_callbacks);
 
-    OTF2_Reader_CloseDefFiles(_reader);
+    // not OTF2_Reader_CloseDefFiles, which is collective: with --bcast-defs only rank 0 reads the global definitions
+    OTF2_Reader_CloseGlobalDefReader(_reader, glob_def_reader);
+
+    // all ranks read the same definitions, one of them writes the cache
+    if (!cache_path.empty() && alldata.metaData.myRank == 0 &&
+        definitions_cache::store(cache_path, cache_key, alldata, _trace.locationList))
+        alldata.verbosePrint(1, true, "OTF2: definitions written to " + cache_path);
 
     return true;
 }
 
-bool OTF2Reader::readEvents(AllData& alldata) {
-    alldata.verbosePrint(1, true, "OTF2: read events");
+void PartialEventData::merge_into(AllData& alldata) {
+    alldata.call_path_tree.merge_tree(call_path_tree);
 
-    uint64_t otf2_STEP = OTF2_UNDEFINED_UINT64;
-    uint64_t events_read;
+    for (const auto& [paradigm, io_data] : io_data_per_paradigm)
+        alldata.io_data_per_paradigm[paradigm] += io_data;
+
+    for (const auto& [location, io_data] : io_data_per_location)
+        alldata.io_data_per_location[location] += io_data;
+
+    for (const auto& [region, parents] : parent_regions_by_callcount) {
+        auto& all_parents = alldata.parent_regions_by_callcount[region];
+        for (const auto& [parent_region, count] : parents)
+            all_parents[parent_region] += count;
+    }
 
-    OTF2_ErrorCode  status;
-    OTF2_EvtReader* local_evt_reader;
+    for (const auto& [handle, local_ioh] : iohandles)
+        alldata.definitions.iohandles.get(handle)->merge(local_ioh);
+
+    for (const auto& [file, size] : file_sizes)
+        file->fsize = std::max(file->fsize, size);
+
+    alldata.tm.callbacks.merge(callbacks);
+}
+
+void OTF2Reader::selectLocations(AllData& alldata) {
+    const auto& params = alldata.params;
+    if (params.ranks.empty() && params.threads.empty() && params.nodes.empty())
+        return;
+
+    // true if the location group (= process) is placed below one of the selected system tree nodes
+    std::map<OTF2_LocationGroupRef, bool> group_on_node;
+    auto on_selected_node = [&](const LocationDef& location) {
+        if (params.nodes.empty())
+            return true;
+
+        auto [it, inserted] = group_on_node.emplace(location.group, false);
+        if (!inserted)
+            return it->second;
+
+        const auto* node = alldata.definitions.system_tree.location(location.id);
+        for (node = node ? node->parent : nullptr; node != nullptr && !it->second; node = node->parent) {
+            // names of system tree nodes are prefixed with their class (eg "node taurusi1234")
+            const auto& name = node->data.name;
+            for (const auto& selected : params.nodes) {
+                if (name == selected || (name.size() > selected.size() &&
+                                         name.compare(name.size() - selected.size(), selected.size(), selected) == 0 &&
+                                         name[name.size() - selected.size() - 1] == ' '))
+                    it->second = true;
+            }
+        }
+        return it->second;
+    };
+
+    // index of a location inside its location group
+    std::map<OTF2_LocationGroupRef, uint64_t> num_threads;
+
+    std::vector<LocationDef> selected;
+    for (const auto& location : _trace.locationList) {
+        uint64_t thread = num_threads[location.group]++;
+
+        if (params.ranks.selects(location.group) && params.threads.selects(thread) && on_selected_node(location))
+            selected.push_back(location);
+    }
+
+    alldata.verbosePrint(1, true, "OTF2: reading " + std::to_string(selected.size()) + " of " +
+                                      std::to_string(_trace.locationList.size()) + " locations");
+
+    _trace.locationList = std::move(selected);
+}
+
+bool OTF2Reader::readLocationGroup(const std::vector<LocationDef>& locations, OTF2_EvtReaderCallbacks* evt_callbacks,
+                                   PartialEventData& partial, const std::function<void(uint64_t)>& progress) {
+    // events are read in batches, the progress is updated once per batch
+    const uint64_t otf2_STEP = 1 << 16;
+    uint64_t       events_read;
+
+    OTF2_ErrorCode status;
+
+    for (const auto& location : locations) {
+        /*
+         * read local definitions of that location before reading local events
+         * reading local definition enables the internal mapping of OTF2 between local and global definitions
+         */
+        OTF2_DefReader* local_def_reader = OTF2_Reader_GetDefReader(_reader, location.id);
+        uint64_t        definitions_read;
+        status = OTF2_Reader_ReadAllLocalDefinitions(_reader, local_def_reader, &definitions_read);
+        if (OTF2_SUCCESS != status) {
+            std::cerr << "ERROR: Could not read local definitions from OTF2 trace." << std::endl;
+            return false;
+        }
+        OTF2_Reader_CloseDefReader(_reader, local_def_reader);
+
+        OTF2_EvtReader* local_evt_reader = OTF2_Reader_GetEvtReader(_reader, location.id);
+        if (NULL == local_evt_reader)
+            return false;
+
+        status = OTF2_Reader_RegisterEvtCallbacks(_reader, local_evt_reader, evt_callbacks, &partial);
+
+        uint64_t location_events = 0;
+        do {
+            status = OTF2_Reader_ReadLocalEvents(_reader, local_evt_reader, otf2_STEP, &events_read);
+            location_events += events_read;
+            progress(events_read);
+        } while (OTF2_SUCCESS == status && events_read == otf2_STEP);
+
+        // reading is interrupted by the first event after the time window
+        if (OTF2_SUCCESS != status &&
+            !(OTF2_ERROR_INTERRUPTED_BY_CALLBACK == status && partial.location_ctx.past_window))
+            std::cerr << "Error while reading events from OTF2 trace." << std::endl;
+
+        // events that were not read (eg after the time window) count as done
+        if (location.number_of_events > location_events)
+            progress(location.number_of_events - location_events);
+
+        OTF2_Reader_CloseEvtReader(_reader, local_evt_reader);
+
+        // state of unfinished regions/operations must not leak into the next location
+        partial.location_ctx = LocationContext();
+    }
+
+    return true;
+}
+
+bool OTF2Reader::readEvents(AllData& alldata) {
+    alldata.verbosePrint(1, true, "OTF2: read events");
 
     OTF2_EvtReaderCallbacks* evt_callbacks = OTF2_EvtReaderCallbacks_New();
     OTF2_GlobalEvtReaderCallbacks* glob_evt_callbacks = OTF2_GlobalEvtReaderCallbacks_New();
@@ -1259,129 +1584,264 @@ bool OTF2Reader::readEvents(AllData& alldata) {
     if (NULL == evt_callbacks)
         return false;
 
-    OTF2_EvtReaderCallbacks_SetEnterCallback(evt_callbacks, handle_enter);
-    OTF2_EvtReaderCallbacks_SetLeaveCallback(evt_callbacks, handle_leave);
+    if (alldata.params.io_only) {
+        alldata.verbosePrint(1, true, "OTF2: I/O only, the call-path tree is not built");
+
+        OTF2_EvtReaderCallbacks_SetEnterCallback(evt_callbacks, handle_enter_io_only);
+        OTF2_EvtReaderCallbacks_SetLeaveCallback(evt_callbacks, handle_leave_io_only);
+    } else {
+        OTF2_EvtReaderCallbacks_SetEnterCallback(evt_callbacks, handle_enter);
+        OTF2_EvtReaderCallbacks_SetLeaveCallback(evt_callbacks, handle_leave);
+
+        OTF2_EvtReaderCallbacks_SetMpiSendCallback(evt_callbacks, handle_mpi_send);
+        OTF2_EvtReaderCallbacks_SetMpiIsendCallback(evt_callbacks, handle_mpi_isend);
+        // OTF2_EvtReaderCallbacks_SetMpiIsendCompleteCallback(evt_callbacks, handle_mpi_isend_complete); TODO nicht
+        // verwendet
 
-    OTF2_EvtReaderCallbacks_SetMpiSendCallback(evt_callbacks, handle_mpi_send);
-    OTF2_EvtReaderCallbacks_SetMpiIsendCallback(evt_callbacks, handle_mpi_isend);
-    // OTF2_EvtReaderCallbacks_SetMpiIsendCompleteCallback(evt_callbacks, handle_mpi_isend_complete); TODO nicht
-    // verwendet
+        // OTF2_EvtReaderCallbacks_SetMpiIrecvRequestCallback(evt_callbacks, handle_mpi_irecv_request); TODO nicht verwendet
+        OTF2_EvtReaderCallbacks_SetMpiRecvCallback(evt_callbacks, handle_mpi_recv);
+        OTF2_EvtReaderCallbacks_SetMpiIrecvCallback(evt_callbacks, handle_mpi_irecv);
 
-    // OTF2_EvtReaderCallbacks_SetMpiIrecvRequestCallback(evt_callbacks, handle_mpi_irecv_request); TODO nicht verwendet
-    OTF2_EvtReaderCallbacks_SetMpiRecvCallback(evt_callbacks, handle_mpi_recv);
-    OTF2_EvtReaderCallbacks_SetMpiIrecvCallback(evt_callbacks, handle_mpi_irecv);
+        // OTF2_EvtReaderCallbacks_SetMpiRequestTestCallback(evt_callbacks, handle_mpi_request_test); TODO nicht verwendet
 
-    // OTF2_EvtReaderCallbacks_SetMpiRequestTestCallback(evt_callbacks, handle_mpi_request_test); TODO nicht verwendet
+        /*TODO nicht verwendet
+        OTF2_EvtReaderCallbacks_SetMpiCollectiveBeginCallback(evt_callbacks,
+                                                              handle_mpi_collective_begin);
+        */
+        OTF2_EvtReaderCallbacks_SetMpiCollectiveEndCallback(evt_callbacks, handle_mpi_collective_end);
 
-    /*TODO nicht verwendet
-    OTF2_EvtReaderCallbacks_SetMpiCollectiveBeginCallback(evt_callbacks,
-                                                          handle_mpi_collective_begin);
-    */
-    OTF2_EvtReaderCallbacks_SetMpiCollectiveEndCallback(evt_callbacks, handle_mpi_collective_end);
+        OTF2_EvtReaderCallbacks_SetMetricCallback(evt_callbacks, handle_metric);
+    }
 
-    OTF2_EvtReaderCallbacks_SetMetricCallback(evt_callbacks, handle_metric);
     OTF2_EvtReaderCallbacks_SetIoOperationBeginCallback(evt_callbacks, io_operation_begin_callback);
     OTF2_EvtReaderCallbacks_SetIoOperationCompleteCallback(evt_callbacks, io_operation_complete_callback);
     OTF2_EvtReaderCallbacks_SetIoCreateHandleCallback(evt_callbacks, io_create_handle_callback);
     OTF2_EvtReaderCallbacks_SetIoSeekCallback(evt_callbacks, io_seek_callback);
 
-#ifndef OTFPROFILE_MPI
+    // progress is reported at verbose level 1 by rank 0, the size of an event is estimated from the whole archive
+    const bool track_progress  = alldata.params.verbose_level >= 1;
+    const bool report_progress = track_progress && alldata.metaData.myRank == 0;
+    double     bytes_per_event = 0;
+    if (report_progress) {
+        uint64_t all_events = 0;
+        for (const auto& location : _trace.locationList)
+            all_events += location.number_of_events;
+        if (all_events > 0)
+            bytes_per_event = static_cast<double>(archive_event_bytes(alldata.params.input_file_prefix)) / all_events;
+    }
 
-    OTF2_DefReader* local_def_reader;
+    selectLocations(alldata);
 
-    for (const auto location : locationList) {
-        local_def_reader = OTF2_Reader_GetDefReader(_reader, location);
-        uint64_t definitions_read;
-        status = OTF2_Reader_ReadAllLocalDefinitions(_reader, local_def_reader, &definitions_read);
-        if (OTF2_SUCCESS != status) {
-            std::cerr << "ERROR: Could not read local definitions from OTF2 trace." << std::endl;
-            return false;
+    /* The substrate opens the files of the selected locations collectively (with SION: the multifiles), every
+     * location is selected on every rank since the location groups are distributed dynamically */
+    for (const auto& location : _trace.locationList)
+        OTF2_Reader_SelectLocation(_reader, location.id);
+    if (OTF2_SUCCESS != OTF2_Reader_OpenDefFiles(_reader) || OTF2_SUCCESS != OTF2_Reader_OpenEvtFiles(_reader)) {
+        std::cerr << "ERROR: Could not open the event files of the OTF2 trace." << std::endl;
+        OTF2_EvtReaderCallbacks_Delete(evt_callbacks);
+        return false;
+    }
+
+    /* all locations of a location group (=process) are read by the same thread (in the order of their definitions),
+     * since IoHandles (and their `fpos`) are shared between the locations of a process */
+    std::vector<std::vector<LocationDef>> location_groups;
+    // nr of events per location group, used to balance the load of the readers
+    std::vector<uint64_t> group_events;
+    {
+        std::map<OTF2_LocationGroupRef, size_t> group_index;
+        for (const auto& location : _trace.locationList) {
+            auto [it, inserted] = group_index.emplace(location.group, location_groups.size());
+            if (inserted) {
+                location_groups.emplace_back();
+                group_events.push_back(0);
+            }
+            location_groups[it->second].push_back(location);
+            group_events[it->second] += location.number_of_events;
         }
+    }
 
-        local_evt_reader = OTF2_Reader_GetEvtReader(_reader, location);
+    bool success = true;
 
-        if (NULL == local_evt_reader)
-            return false;
+    ProgressReporter progress(std::accumulate(group_events.begin(), group_events.end(), uint64_t(0)), bytes_per_event);
+    auto             print_progress = [&](uint64_t events) {
+        alldata.verbosePrint(1, true, progress.format(events, progress.elapsed()));
+    };
 
-        status = OTF2_Reader_RegisterEvtCallbacks(_reader, local_evt_reader, evt_callbacks, &alldata);
-        status = OTF2_Reader_ReadLocalEvents(_reader, local_evt_reader, otf2_STEP, &events_read);
-        node_stack.clear();
+    /* Load balance of the readers, reported at verbose level 2 */
+    struct WorkerStats {
+        double   busy_time = 0;
+        uint64_t groups    = 0;
+        uint64_t stolen    = 0;
+    };
+    auto print_stats = [&](uint32_t worker, const WorkerStats& stats, bool master_only) {
+        std::ostringstream os;
+        os << "OTF2: reader " << worker << " read " << stats.groups << " location groups (" << stats.stolen
+           << " stolen), busy for " << stats.busy_time << " s";
+        alldata.verbosePrint(2, master_only, os.str());
+    };
 
-        if (OTF2_SUCCESS != status)
-            std::cerr << "Error while reading events from OTF2 trace." << std::endl;
+#ifndef OTFPROFILER_MPI
+
+    uint32_t num_threads = std::min<size_t>(std::max<uint32_t>(alldata.params.num_threads, 1), location_groups.size());
+
+    // called by the readers once per batch of events
+    auto count_events = [&](uint64_t events) {
+        auto processed = progress.add(events);
+        if (report_progress && progress.report_due())
+            print_progress(processed);
+    };
+
+    if (num_threads <= 1) {
+        for (const auto& locations : location_groups) {
+            PartialEventData partial(&alldata);
+            success = readLocationGroup(locations, evt_callbacks, partial, count_events) && success;
+            partial.merge_into(alldata);
+        }
+    } else {
+        alldata.verbosePrint(2, true, "OTF2: reading " + std::to_string(location_groups.size()) +
+                                          " location groups with " + std::to_string(num_threads) + " threads");
+
+        LocationScheduler                              scheduler(group_events, num_threads);
+        LocalSchedulerHeads                            heads(num_threads);
+        std::vector<std::unique_ptr<PartialEventData>> partials(location_groups.size());
+        std::vector<WorkerStats>                       stats(num_threads);
+        std::atomic<bool>                              failed{false};
+
+        std::vector<std::thread> workers;
+        for (uint32_t t = 0; t < num_threads; ++t)
+            workers.emplace_back([&, t]() {
+                bool stolen;
+                while (auto group = scheduler.next(t, heads, stolen)) {
+                    auto start = std::chrono::steady_clock::now();
+
+                    partials[*group] = std::make_unique<PartialEventData>(&alldata);
+                    if (!readLocationGroup(location_groups[*group], evt_callbacks, *partials[*group], count_events))
+                        failed = true;
+
+                    stats[t].busy_time +=
+                        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    ++stats[t].groups;
+                    stats[t].stolen += stolen;
+                }
+            });
+        for (auto& worker : workers)
+            worker.join();
+
+        for (uint32_t t = 0; t < num_threads; ++t)
+            print_stats(t, stats[t], true);
+
+        // merge in the order of the location groups -> same result as reading sequentially
+        for (auto& partial : partials) {
+            partial->merge_into(alldata);
+            partial.reset();
+        }
+        success = !failed;
     }
+
+    if (report_progress)
+        alldata.verbosePrint(1, true, progress.format_summary(progress.events_processed(), progress.elapsed()));
+
     /* Clean up */
+    OTF2_Reader_CloseEvtFiles(_reader);
+    OTF2_Reader_CloseDefFiles(_reader);
     OTF2_EvtReaderCallbacks_Delete(evt_callbacks);
 
 #else
 
-    MPI_Win shared_space;
+    /* Every rank owns the head of its queue of location groups, other ranks steal from it via atomic RMA operations */
+    struct MpiSchedulerHeads {
+        MPI_Win win;
 
-    uint64_t* val_p;
+        uint64_t load(uint32_t rank) {
+            uint64_t head;
+            MPI_Fetch_and_op(nullptr, &head, MPI_UINT64_T, rank, 0, MPI_NO_OP, win);
+            MPI_Win_flush(rank, win);
+            return head;
+        }
+        uint64_t fetch_inc(uint32_t rank) {
+            uint64_t one = 1;
+            uint64_t head;
+            MPI_Fetch_and_op(&one, &head, MPI_UINT64_T, rank, 0, MPI_SUM, win);
+            MPI_Win_flush(rank, win);
+            return head;
+        }
+    } heads;
+
+    uint64_t* head_p;
+    MPI_Win_allocate(sizeof(uint64_t), sizeof(uint64_t), MPI_INFO_NULL, MPI_COMM_WORLD, &head_p, &heads.win);
+    *head_p = 0;
+
+    MPI_Win_fence(0, heads.win);
+    MPI_Win_lock_all(0, heads.win);
+
+    /* Progress of all ranks is summed up on rank 0: [0] = nr of events read, [1] = nr of location groups finished */
+    MPI_Win   progress_win;
+    uint64_t* progress_p;
+    MPI_Win_allocate(2 * sizeof(uint64_t), sizeof(uint64_t), MPI_INFO_NULL, MPI_COMM_WORLD, &progress_p,
+                     &progress_win);
+    progress_p[0] = progress_p[1] = 0;
+
+    MPI_Win_fence(0, progress_win);
+    MPI_Win_lock_all(0, progress_win);
+
+    auto add_progress = [&](uint64_t counter, uint64_t value) {
+        uint64_t before;
+        MPI_Fetch_and_op(&value, &before, MPI_UINT64_T, 0, counter, MPI_SUM, progress_win);
+        MPI_Win_flush(0, progress_win);
+        return before + value;
+    };
+    // called by the reader once per batch of events
+    auto count_events = [&](uint64_t events) {
+        if (!track_progress)
+            return;
+        auto processed = add_progress(0, events);
+        if (report_progress && progress.report_due())
+            print_progress(processed);
+    };
 
-    uint64_t to_read = 0;
-    uint64_t initial = -1;
-    uint64_t result;
+    LocationScheduler scheduler(group_events, alldata.metaData.numRanks);
+    WorkerStats       stats;
 
-    if (alldata.metaData.myRank == 0) {
-        MPI_Win_allocate(sizeof(uint64_t), sizeof(uint64_t), MPI_INFO_NULL, MPI_COMM_WORLD, &val_p, &shared_space);
-        MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, shared_space);
-        MPI_Put(&initial, 1, MPI_LONG_LONG_INT, 0, 0, 1, MPI_LONG_LONG_INT, shared_space);
-        MPI_Win_unlock(0, shared_space);
-    } else {
-        MPI_Win_allocate(0, sizeof(uint64_t), MPI_INFO_NULL, MPI_COMM_WORLD, &val_p, &shared_space);
-    }
+    bool stolen;
+    while (auto group = scheduler.next(alldata.metaData.myRank, heads, stolen)) {
+        auto start = std::chrono::steady_clock::now();
 
-    MPI_Win_fence(0, shared_space);
-    MPI_Win_lock_all(0, shared_space);
-
-    while (to_read < locationList.size()) {
-        MPI_Compare_and_swap(&to_read, &initial, &result, MPI_LONG_LONG_INT, 0, 0, shared_space);
-        if (result == initial) {
-            /*
-             * read local definitions of that rank before reading local events
-             * reading local definition enables the internal mapping of OTF2 between local and global definitions
-             * ->necessary and !NOT! mandatory
-             */
-            OTF2_DefReader* local_def_reader;
-            local_def_reader = OTF2_Reader_GetDefReader(_reader, locationList[to_read]);
-            uint64_t definitions_read;
-            status = OTF2_Reader_ReadAllLocalDefinitions(_reader, local_def_reader, &definitions_read);
-            if (OTF2_SUCCESS != status) {
-                std::cerr << "ERROR: Could not read local definitions from OTF2 trace." << std::endl;
-                return false;
-            }
+        PartialEventData partial(&alldata);
+        if (!readLocationGroup(location_groups[*group], evt_callbacks, partial, count_events))
+            success = false;
+        partial.merge_into(alldata);
 
-            status = OTF2_Reader_CloseDefReader(_reader, local_def_reader);
-            if (OTF2_SUCCESS != status) {
-                return false;
-            }
-            // end local def reading
+        stats.busy_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ++stats.groups;
+        stats.stolen += stolen;
 
-            local_evt_reader = OTF2_Reader_GetEvtReader(_reader, locationList[to_read]);
-            if (NULL == local_evt_reader)
-                return false;
+        if (track_progress)
+            add_progress(1, 1);
+    }
 
-            status = OTF2_Reader_RegisterEvtCallbacks(_reader, local_evt_reader, evt_callbacks, &alldata);
-            status = OTF2_Reader_ReadLocalEvents(_reader, local_evt_reader, otf2_STEP, &events_read);
+    print_stats(alldata.metaData.myRank, stats, false);
 
-            if (OTF2_SUCCESS != status) {
-                std::cerr << "Error while reading events from OTF2 trace." << std::endl;
+    // rank 0 keeps reporting until the other ranks are done
+    if (report_progress) {
+        while (true) {
+            auto processed = add_progress(0, 0);
+            if (add_progress(1, 0) >= location_groups.size()) {
+                alldata.verbosePrint(1, true, progress.format_summary(processed, progress.elapsed()));
+                break;
             }
-
-            node_stack.clear();
-            initial = to_read;
-            ++to_read;
-
-        } else {
-            MPI_Get(&initial, 1, MPI_LONG_LONG_INT, 0, 0, 1, MPI_LONG_LONG_INT, shared_space);
-            to_read = initial + 1;
+            if (progress.report_due())
+                print_progress(processed);
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
     }
 
     /* Clean up */
-    MPI_Win_unlock_all(shared_space);
-    MPI_Win_free(&shared_space);
+    OTF2_Reader_CloseEvtFiles(_reader);
+    OTF2_Reader_CloseDefFiles(_reader);
+    MPI_Win_unlock_all(progress_win);
+    MPI_Win_free(&progress_win);
+    MPI_Win_unlock_all(heads.win);
+    MPI_Win_free(&heads.win);
     OTF2_EvtReaderCallbacks_Delete(evt_callbacks);
 
 #endif
@@ -1411,7 +1871,7 @@ bool OTF2Reader::readEvents(AllData& alldata) {
      */
     OTF2_GlobalEvtReaderCallbacks_Delete(glob_evt_callbacks);
 
-    return true;
+    return success;
 }
 // TODO nicht verwendet im moment
 bool OTF2Reader::readStatistics(AllData& alldata) { return true; }
@@ -0,0 +1,107 @@
+/*
+ This is part of the OTF-Profiler. Copyright by ZIH, TU Dresden 2016-2018.
+ Authors: Maximillian Neumann, Denis Hünich, Jens Doleschal
+*/
+
+#include "definitions_broadcast.h"
+
+#include <mpi.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+/* MPI_Bcast of `size` bytes, in pieces since the count is an int */
+void broadcast_bytes(char* data, uint64_t size, MPI_Comm comm) {
+    const uint64_t max_piece = uint64_t(1) << 30;
+
+    for (uint64_t offset = 0; offset < size; offset += max_piece)
+        MPI_Bcast(data + offset, static_cast<int>(std::min(max_piece, size - offset)), MPI_BYTE, 0, comm);
+}
+
+bool decode(std::string_view snapshot, const DefinitionsCacheKey& key, AllData& alldata,
+            std::vector<LocationDef>& locations) {
+    if (definitions_cache::deserialize(snapshot, key, alldata, locations))
+        return true;
+
+    std::cerr << "ERROR: Could not decode the definitions received from rank 0" << std::endl;
+    return false;
+}
+
+}  // namespace
+
+namespace definitions_broadcast {
+
+bool broadcast(AllData& alldata, std::vector<LocationDef>& locations, bool have_definitions) {
+    const bool                root = alldata.metaData.myRank == 0;
+    const DefinitionsCacheKey key{alldata.traceID, 0, alldata.params.read_metrics};
+
+    // size 0 tells the other ranks that rank 0 couldn't read the definitions
+    std::string snapshot;
+    uint64_t    size = 0;
+    if (root && have_definitions) {
+        definitions_cache::serialize(key, alldata, locations, snapshot);
+        size = snapshot.size();
+    }
+
+    if (!alldata.params.shared_definitions) {
+        MPI_Bcast(&size, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+        if (size == 0)
+            return false;
+
+        snapshot.resize(size);
+        broadcast_bytes(snapshot.data(), size, MPI_COMM_WORLD);
+
+        return root || decode(snapshot, key, alldata, locations);
+    }
+
+    // ranks of a node, the first of them (rank 0 on its node) receives the snapshot for all of them
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, alldata.metaData.myRank, MPI_INFO_NULL, &node_comm);
+    int node_rank;
+    MPI_Comm_rank(node_comm, &node_rank);
+
+    MPI_Comm leader_comm;
+    MPI_Comm_split(MPI_COMM_WORLD, node_rank == 0 ? 0 : MPI_UNDEFINED, alldata.metaData.myRank, &leader_comm);
+
+    if (node_rank == 0)
+        MPI_Bcast(&size, 1, MPI_UINT64_T, 0, leader_comm);
+    MPI_Bcast(&size, 1, MPI_UINT64_T, 0, node_comm);
+
+    bool ok = size != 0;
+    if (ok) {
+        char*   shared;
+        MPI_Win win;
+        MPI_Win_allocate_shared(node_rank == 0 ? size : 0, 1, MPI_INFO_NULL, node_comm, &shared, &win);
+        if (node_rank != 0) {
+            MPI_Aint segment_size;
+            int      disp_unit;
+            MPI_Win_shared_query(win, 0, &segment_size, &disp_unit, &shared);
+        }
+
+        MPI_Win_fence(0, win);
+        if (node_rank == 0) {
+            if (root)
+                std::memcpy(shared, snapshot.data(), size);
+            broadcast_bytes(shared, size, leader_comm);
+        }
+        MPI_Win_fence(0, win);
+
+        if (!root)
+            ok = decode(std::string_view(shared, size), key, alldata, locations);
+
+        // nobody reads the window anymore once all ranks of the node have decoded it
+        MPI_Win_free(&win);
+    }
+
+    if (node_rank == 0)
+        MPI_Comm_free(&leader_comm);
+    MPI_Comm_free(&node_comm);
+
+    return ok;
+}
+
+}  // namespace definitions_broadcast
@@ -0,0 +1,488 @@
+/*
+ This is part of the OTF-Profiler. Copyright by ZIH, TU Dresden 2016-2018.
+ Authors: Maximillian Neumann, Denis Hünich, Jens Doleschal
+*/
+
+#include "definitions_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+using namespace definitions;
+
+namespace {
+
+constexpr char     MAGIC[8]      = {'O', 'T', 'F', 'P', 'D', 'E', 'F', 'S'};
+constexpr uint32_t VERSION       = 1;
+constexpr uint32_t ENDIAN_MARKER = 0x01020304;  // the cache is only read on machines with the same byte order
+constexpr uint32_t NO_PARENT     = static_cast<uint32_t>(-1);
+
+/* file layout: header | records | string table */
+struct Header {
+    char     magic[8];
+    uint32_t version;
+    uint32_t endian_marker;
+    uint64_t trace_id;
+    int64_t  anchor_mtime;
+    uint64_t read_metrics;
+    uint64_t records_size;
+};
+
+/* Appends fixed-width fields to the records, strings are interned into the string table and referred to by index */
+class Writer {
+   public:
+    template <typename T>
+    void put(T value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        records.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void put_string(const std::string& str) {
+        auto [it, inserted] = string_index.emplace(str, strings.size());
+        if (inserted)
+            strings.push_back(&it->first);
+        put<uint32_t>(it->second);
+    }
+
+    std::string records;
+    /* interned strings in the order of their index */
+    std::vector<const std::string*>           strings;
+    std::unordered_map<std::string, uint32_t> string_index;
+};
+
+/* Reads the fields written by @ref Writer, `ok` is false once anything was read beyond the end of the records */
+class Reader {
+   public:
+    Reader(std::string_view records, std::vector<std::string_view> strings) : records(records), strings(strings) {}
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (pos + sizeof(T) > records.size()) {
+            ok = false;
+            return value;
+        }
+        std::memcpy(&value, records.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    std::string get_string() {
+        auto idx = get<uint32_t>();
+        if (idx >= strings.size()) {
+            ok = false;
+            return {};
+        }
+        return std::string(strings[idx]);
+    }
+
+    bool at_end() const { return ok && pos == records.size(); }
+
+    bool ok = true;
+
+   private:
+    std::string_view              records;
+    std::vector<std::string_view> strings;
+    size_t                        pos = 0;
+};
+
+/* Definitions of one kind are written as their nr followed by (id, props) */
+template <typename Id, typename Props, typename F>
+void put_definitions(Writer& out, const DefinitionType<Id, Props>& defs, F&& put_props) {
+    out.put<uint64_t>(defs.size());
+    defs.for_each([&](Id id, const Props& props) {
+        out.put<Id>(id);
+        put_props(props);
+    });
+}
+
+template <typename Id, typename Props, typename F>
+void get_definitions(Reader& in, DefinitionType<Id, Props>& defs, F&& get_props) {
+    const auto num = in.get<uint64_t>();
+    for (uint64_t i = 0; i < num && in.ok; ++i) {
+        auto id = in.get<Id>();
+        defs.add(id, get_props());
+    }
+}
+
+void put_system_tree(Writer& out, const SystemTree& tree) {
+    std::vector<const SystemTree::SystemNode_t*> nodes;
+    if (tree.get_root() != nullptr) {
+        for (auto it = tree.begin(); it != tree.end(); ++it)
+            nodes.push_back(&*it);
+    }
+    // replayed in the order of insertion, so the nodes get the same ids & positions as in the original tree
+    std::sort(nodes.begin(), nodes.end(), [](auto* a, auto* b) { return a->data.node_id < b->data.node_id; });
+
+    // parents are referred to by their position in the system nodes or location groups of the tree
+    std::unordered_map<const SystemTree::SystemNode_t*, uint32_t> position;
+    uint32_t                                                      num_system_nodes = 0;
+    uint32_t                                                      num_location_grps = 0;
+
+    out.put<uint64_t>(nodes.size());
+    for (const auto* node : nodes) {
+        const auto class_id = node->data.class_id;
+        if (class_id == SystemClass::LOCATION_GROUP)
+            position[node] = num_location_grps++;
+        else if (class_id != SystemClass::LOCATION)
+            position[node] = num_system_nodes++;
+
+        out.put<uint32_t>(node->data.node_id);
+        out.put_string(node->data.name);
+        out.put<SystemClass>(class_id);
+        out.put<uint64_t>(node->data.location_id);
+        out.put<uint32_t>(node->parent != nullptr ? position[node->parent] : NO_PARENT);
+    }
+}
+
+bool get_system_tree(Reader& in, SystemTree& tree) {
+    uint32_t   num_system_nodes  = 0;
+    uint32_t   num_location_grps = 0;
+    const auto num               = in.get<uint64_t>();
+    for (uint64_t i = 0; i < num && in.ok; ++i) {
+        auto node_id     = in.get<uint32_t>();
+        auto name        = in.get_string();
+        auto class_id    = in.get<SystemClass>();
+        auto location_id = in.get<uint64_t>();
+        auto parent      = in.get<uint32_t>();
+        if (!in.ok)
+            return false;
+
+        if (class_id == SystemClass::LOCATION) {
+            if (parent >= num_location_grps)
+                return false;
+            tree.insert_node(name, node_id, class_id, NO_PARENT, location_id, parent);
+            continue;
+        }
+
+        if (parent != NO_PARENT && parent >= num_system_nodes)
+            return false;
+        tree.insert_node(name, node_id, class_id, parent, location_id, 0);
+
+        if (class_id == SystemClass::LOCATION_GROUP)
+            ++num_location_grps;
+        else
+            ++num_system_nodes;
+    }
+
+    return in.ok;
+}
+
+}  // namespace
+
+namespace definitions_cache {
+
+void serialize(const DefinitionsCacheKey& key, const AllData& alldata, const std::vector<LocationDef>& locations,
+               std::string& buffer) {
+    const auto& defs = alldata.definitions;
+    Writer      out;
+
+    out.put<uint64_t>(alldata.metaData.timerResolution);
+    out.put<uint64_t>(alldata.metaData.globalOffset);
+    out.put<uint64_t>(alldata.metaData.communicators.size());
+    for (const auto& [comm, group] : alldata.metaData.communicators) {
+        out.put<uint64_t>(comm);
+        out.put<uint64_t>(group);
+    }
+
+    put_definitions(out, defs.paradigms, [&](const Paradigm& p) { out.put_string(p.name); });
+    put_definitions(out, defs.io_paradigms, [&](const Paradigm& p) { out.put_string(p.name); });
+    put_definitions(out, defs.regions, [&](const Region& r) {
+        out.put_string(r.name);
+        out.put<paradigm_id_t>(r.paradigm_id);
+        out.put<uint32_t>(r.begin_source_line);
+        out.put<uint32_t>(r.end_source_line);
+        out.put_string(r.file_name);
+    });
+    put_definitions(out, defs.attributes, [&](const Attribute& a) {
+        out.put_string(a.name);
+        out.put_string(a.description);
+        out.put<OTF2_Type>(a.type);
+    });
+    put_definitions(out, defs.metrics, [&](const Metric& m) {
+        out.put_string(m.name);
+        out.put_string(m.description);
+        out.put<MetricType>(m.metricType);
+        out.put<MetricMode>(m.metricMode);
+        out.put<MetricDataType>(m.type);
+        out.put<MetricBase>(m.base);
+        out.put<int64_t>(m.exponent);
+        out.put_string(m.unit);
+        out.put<uint8_t>(m.allowed);
+    });
+    put_definitions(out, defs.metric_classes, [&](const Metric_Class& c) {
+        out.put<uint8_t>(c.num_of_metrics);
+        out.put<uint64_t>(c.metric_member.size());
+        for (const auto& [pos, member] : c.metric_member) {
+            out.put<uint8_t>(pos);
+            out.put<uint32_t>(member);
+        }
+        out.put<MetricOccurrence>(c.metric_occurrence);
+        out.put<RecorderKind>(c.recorder_kind);
+    });
+    put_definitions(out, defs.groups, [&](const Group& g) {
+        out.put_string(g.name);
+        out.put<uint8_t>(g.type);
+        out.put<paradigm_id_t>(g.paradigm_id);
+        out.put<uint64_t>(g.members.size());
+        for (auto member : g.members)
+            out.put<uint64_t>(member);
+    });
+
+    // files in the order their first IoHandle was defined, some IoHandles own a File that is not in `filehandles`
+    std::vector<const File*>                  files;
+    std::unordered_map<const File*, uint64_t> file_index;
+    defs.iohandles.for_each([&](OTF2_IoHandleRef, const IoHandle& ioh) {
+        if (file_index.emplace(ioh.file_handle.get(), files.size()).second)
+            files.push_back(ioh.file_handle.get());
+    });
+    out.put<uint64_t>(files.size());
+    for (const auto* file : files) {
+        auto it = defs.filehandles.find(file->file_name);
+        out.put_string(file->file_name);
+        out.put<uint8_t>(it != defs.filehandles.end() && it->second.get() == file);
+        out.put<uint64_t>(file->io_handles.size());
+        for (auto handle : file->io_handles)
+            out.put<OTF2_IoHandleRef>(handle);
+    }
+    put_definitions(out, defs.iohandles, [&](const IoHandle& ioh) {
+        out.put<uint64_t>(file_index[ioh.file_handle.get()]);
+        out.put<uint32_t>(ioh.io_paradigm);
+        out.put<OTF2_IoFileRef>(ioh.file);
+        out.put<OTF2_IoHandleRef>(ioh.parent);
+        out.put<uint64_t>(ioh.modes.size());
+        for (const auto& mode : ioh.modes)
+            out.put_string(mode);
+    });
+
+    put_system_tree(out, defs.system_tree);
+
+    out.put<uint64_t>(locations.size());
+    for (const auto& location : locations) {
+        out.put<OTF2_LocationRef>(location.id);
+        out.put<OTF2_LocationGroupRef>(location.group);
+        out.put<uint64_t>(location.number_of_events);
+    }
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version       = VERSION;
+    header.endian_marker = ENDIAN_MARKER;
+    header.trace_id      = key.trace_id;
+    header.anchor_mtime  = key.anchor_mtime;
+    header.read_metrics  = key.read_metrics;
+    header.records_size  = out.records.size();
+
+    buffer.clear();
+    buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    buffer.append(out.records);
+
+    const auto num_strings = static_cast<uint32_t>(out.strings.size());
+    buffer.append(reinterpret_cast<const char*>(&num_strings), sizeof(num_strings));
+    for (const auto* str : out.strings) {
+        const auto length = static_cast<uint32_t>(str->size());
+        buffer.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        buffer.append(*str);
+    }
+}
+
+bool store(const std::string& path, const DefinitionsCacheKey& key, const AllData& alldata,
+           const std::vector<LocationDef>& locations) {
+    std::string buffer;
+    serialize(key, alldata, locations, buffer);
+
+    const auto    tmp_path = path + ".tmp";
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    file.write(buffer.data(), buffer.size());
+    file.close();
+
+    std::error_code ec;
+    if (!file || (std::filesystem::rename(tmp_path, path, ec), ec)) {
+        std::cerr << "WARNING: Could not write definitions cache " << path << std::endl;
+        std::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+
+    return true;
+}
+
+bool deserialize(std::string_view buffer, const DefinitionsCacheKey& key, AllData& alldata,
+                 std::vector<LocationDef>& locations) {
+    if (buffer.size() < sizeof(Header))
+        return false;
+
+    Header header;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+        header.endian_marker != ENDIAN_MARKER)
+        return false;
+
+    if (!(DefinitionsCacheKey{header.trace_id, header.anchor_mtime, header.read_metrics != 0} == key))
+        return false;
+
+    if (header.records_size > buffer.size() - sizeof(Header))
+        return false;
+
+    // string table
+    std::vector<std::string_view> strings;
+    size_t                        pos = sizeof(Header) + header.records_size;
+    uint32_t                      num_strings;
+    if (pos + sizeof(num_strings) > buffer.size())
+        return false;
+    std::memcpy(&num_strings, buffer.data() + pos, sizeof(num_strings));
+    pos += sizeof(num_strings);
+    for (uint32_t i = 0; i < num_strings; ++i) {
+        uint32_t length;
+        if (pos + sizeof(length) > buffer.size())
+            return false;
+        std::memcpy(&length, buffer.data() + pos, sizeof(length));
+        pos += sizeof(length);
+        if (length > buffer.size() - pos)
+            return false;
+        strings.emplace_back(buffer.data() + pos, length);
+        pos += length;
+    }
+
+    Reader in(buffer.substr(sizeof(Header), header.records_size), std::move(strings));
+
+    // decoded into new containers first, a damaged cache leaves `alldata` untouched
+    Definitions                  defs;
+    std::map<uint64_t, uint64_t> communicators;
+    std::vector<LocationDef>     locs;
+
+    auto timer_resolution = in.get<uint64_t>();
+    auto global_offset    = in.get<uint64_t>();
+    auto num_comms        = in.get<uint64_t>();
+    for (uint64_t i = 0; i < num_comms && in.ok; ++i) {
+        auto comm            = in.get<uint64_t>();
+        communicators[comm] = in.get<uint64_t>();
+    }
+
+    get_definitions(in, defs.paradigms, [&] { return Paradigm{in.get_string()}; });
+    get_definitions(in, defs.io_paradigms, [&] { return Paradigm{in.get_string()}; });
+    get_definitions(in, defs.regions, [&] {
+        Region r;
+        r.name              = in.get_string();
+        r.paradigm_id       = in.get<paradigm_id_t>();
+        r.begin_source_line = in.get<uint32_t>();
+        r.end_source_line   = in.get<uint32_t>();
+        r.file_name         = in.get_string();
+        return r;
+    });
+    get_definitions(in, defs.attributes, [&] {
+        Attribute a;
+        a.name        = in.get_string();
+        a.description = in.get_string();
+        a.type        = in.get<OTF2_Type>();
+        return a;
+    });
+    get_definitions(in, defs.metrics, [&] {
+        Metric m;
+        m.name        = in.get_string();
+        m.description = in.get_string();
+        m.metricType  = in.get<MetricType>();
+        m.metricMode  = in.get<MetricMode>();
+        m.type        = in.get<MetricDataType>();
+        m.base        = in.get<MetricBase>();
+        m.exponent    = in.get<int64_t>();
+        m.unit        = in.get_string();
+        m.allowed     = in.get<uint8_t>() != 0;
+        return m;
+    });
+    get_definitions(in, defs.metric_classes, [&] {
+        Metric_Class c;
+        c.num_of_metrics = in.get<uint8_t>();
+        auto num         = in.get<uint64_t>();
+        for (uint64_t i = 0; i < num && in.ok; ++i) {
+            auto pos            = in.get<uint8_t>();
+            c.metric_member[pos] = in.get<uint32_t>();
+        }
+        c.metric_occurrence = in.get<MetricOccurrence>();
+        c.recorder_kind     = in.get<RecorderKind>();
+        return c;
+    });
+    get_definitions(in, defs.groups, [&] {
+        Group g;
+        g.name        = in.get_string();
+        g.type        = in.get<uint8_t>();
+        g.paradigm_id = in.get<paradigm_id_t>();
+        auto num      = in.get<uint64_t>();
+        for (uint64_t i = 0; i < num && in.ok; ++i)
+            g.members.push_back(in.get<uint64_t>());
+        return g;
+    });
+
+    std::vector<std::shared_ptr<File>> files;
+    auto                               num_files = in.get<uint64_t>();
+    for (uint64_t i = 0; i < num_files && in.ok; ++i) {
+        auto file   = std::make_shared<File>(in.get_string());
+        auto in_map = in.get<uint8_t>();
+        auto num    = in.get<uint64_t>();
+        for (uint64_t h = 0; h < num && in.ok; ++h)
+            file->io_handles.push_back(in.get<OTF2_IoHandleRef>());
+        if (in_map)
+            defs.filehandles.emplace(file->file_name, file);
+        files.push_back(std::move(file));
+    }
+    auto num_iohandles = in.get<uint64_t>();
+    for (uint64_t i = 0; i < num_iohandles && in.ok; ++i) {
+        auto self        = in.get<OTF2_IoHandleRef>();
+        auto file_idx    = in.get<uint64_t>();
+        auto io_paradigm = in.get<uint32_t>();
+        auto file_ref    = in.get<OTF2_IoFileRef>();
+        auto parent      = in.get<OTF2_IoHandleRef>();
+        if (file_idx >= files.size())
+            return false;
+
+        IoHandle ioh(self, files[file_idx], io_paradigm, file_ref, parent);
+        auto     num_modes = in.get<uint64_t>();
+        for (uint64_t m = 0; m < num_modes && in.ok; ++m)
+            ioh.modes.insert(in.get_string());
+        defs.iohandles.add(self, ioh);
+    }
+
+    if (!get_system_tree(in, defs.system_tree))
+        return false;
+
+    auto num_locations = in.get<uint64_t>();
+    for (uint64_t i = 0; i < num_locations && in.ok; ++i) {
+        LocationDef location;
+        location.id               = in.get<OTF2_LocationRef>();
+        location.group            = in.get<OTF2_LocationGroupRef>();
+        location.number_of_events = in.get<uint64_t>();
+        locs.push_back(location);
+    }
+
+    if (!in.at_end())
+        return false;
+
+    alldata.metaData.timerResolution = timer_resolution;
+    alldata.metaData.globalOffset    = global_offset;
+    alldata.metaData.communicators   = std::move(communicators);
+    alldata.definitions              = std::move(defs);
+    locations                        = std::move(locs);
+
+    return true;
+}
+
+bool load(const std::string& path, const DefinitionsCacheKey& key, AllData& alldata,
+          std::vector<LocationDef>& locations) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+
+    std::string buffer(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    if (!file.read(buffer.data(), buffer.size()))
+        return false;
+
+    return deserialize(buffer, key, alldata, locations);
+}
+
+}  // namespace definitions_cache
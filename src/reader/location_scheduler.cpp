@@ -0,0 +1,29 @@
+#include "location_scheduler.h"
+
+#include <algorithm>
+#include <numeric>
+
+LocationScheduler::LocationScheduler(const std::vector<uint64_t>& weights, uint32_t num_workers)
+    : _queues(std::max<uint32_t>(num_workers, 1)), _suffix_weights(_queues.size()) {
+    std::vector<size_t> units(weights.size());
+    std::iota(units.begin(), units.end(), 0);
+    std::stable_sort(units.begin(), units.end(), [&](size_t a, size_t b) { return weights[a] > weights[b]; });
+
+    // largest-first: assign every unit to the worker with the least weight so far
+    std::vector<uint64_t> load(_queues.size(), 0);
+    for (const auto unit : units) {
+        auto worker = std::min_element(load.begin(), load.end()) - load.begin();
+        _queues[worker].push_back(unit);
+        load[worker] += weights[unit];
+    }
+
+    for (size_t w = 0; w < _queues.size(); ++w) {
+        auto& suffix = _suffix_weights[w];
+        suffix.resize(_queues[w].size());
+        uint64_t sum = 0;
+        for (size_t pos = _queues[w].size(); pos-- > 0;) {
+            sum += weights[_queues[w][pos]];
+            suffix[pos] = sum;
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#include "progress_reporter.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <sstream>
+
+bool ProgressReporter::report_due(int64_t now_ms) {
+    auto next = next_report_ms.load();
+    if (now_ms < next)
+        return false;
+
+    // only one of the callers that see the report due wins
+    return next_report_ms.compare_exchange_strong(next, now_ms + interval_ms);
+}
+
+std::string ProgressReporter::format(uint64_t events, double elapsed) const {
+    const double rate = elapsed > 0 ? events / elapsed : 0;
+
+    std::ostringstream os;
+    os.setf(std::ios::fixed);
+    os.precision(1);
+    os << "OTF2: " << (total_events > 0 ? 100.0 * events / total_events : 100.0) << "% of " << total_events
+       << " events, ";
+    os.precision(0);
+    os << rate << " events/s";
+    if (bytes_per_event > 0) {
+        os.precision(1);
+        os << ", " << rate * bytes_per_event / (1024 * 1024) << " MB/s";
+    }
+
+    if (rate > 0 && events < total_events) {
+        const auto eta = static_cast<uint64_t>((total_events - events) / rate);
+        char       buf[32];
+        std::snprintf(buf, sizeof(buf), "%lu:%02lu:%02lu", static_cast<unsigned long>(eta / 3600),
+                      static_cast<unsigned long>(eta / 60 % 60), static_cast<unsigned long>(eta % 60));
+        os << ", ETA " << buf;
+    }
+
+    return os.str();
+}
+
+std::string ProgressReporter::format_summary(uint64_t events, double elapsed) const {
+    const double rate = elapsed > 0 ? events / elapsed : 0;
+
+    std::ostringstream os;
+    os.setf(std::ios::fixed);
+    os.precision(1);
+    os << "OTF2: read " << events << " events in " << elapsed << " s (";
+    os.precision(0);
+    os << rate << " events/s";
+    if (bytes_per_event > 0) {
+        os.precision(1);
+        os << ", " << rate * bytes_per_event / (1024 * 1024) << " MB/s";
+    }
+    os << ")";
+
+    return os.str();
+}
+
+uint64_t archive_event_bytes(const std::string& archive_dir) {
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    uint64_t        bytes = 0;
+    for (fs::recursive_directory_iterator it(archive_dir, ec), end; !ec && it != end; it.increment(ec)) {
+        // one .evt file per location, or the event containers of the SION substrate (eg traces.evt.sion)
+        const auto name = it->path().filename().string();
+        if (it->is_regular_file(ec) && name.find(".evt") != std::string::npos)
+            bytes += it->file_size(ec);
+    }
+
+    return ec ? 0 : bytes;
+}
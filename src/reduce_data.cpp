@@ -4,369 +4,186 @@
 */
 
 #include <mpi.h>
+#include <algorithm>
 #include <cmath>
+#include <iomanip>
+#include <iostream>
 #include <sstream>
 
 #include "reduce_data.h"
+#include "reduce_io_data.h"
 
 using namespace std;
 
-/* mapping and data deques for serialisation */
-static map<uint64_t, pair<uint64_t, uint64_t>>                 mapping;
-static deque<tuple<uint64_t, uint64_t, FunctionData*>>         f_data;
-static deque<tuple<uint64_t, uint64_t, MessageData*>>          m_data;
-static deque<tuple<uint64_t, uint64_t, CollopData*>>           c_data;
-static deque<tuple<uint64_t, uint64_t, uint64_t, MetricData*>> met_data;
-
-/* fence between statistics parts within the buffer for consistency checking */
-enum { FENCE = 0xDEADBEEF };
+/* call-path tree in its wire format, reused in every round */
+static SerializedTree  tree_data;
+/* serialized I/O statistics, see reduce_io_data.h */
+static vector<uint8_t> io_data;
 
+/* nr of records of each part, PACK_TOTAL_SIZE is the size of all parts in bytes */
 enum {
 
     PACK_TOTAL_SIZE    = 0,
-    PACK_MAPPING       = 1,
+    PACK_NODES         = 1,
     PACK_FUNCTION_DATA = 2,
     PACK_MESSAGE_DATA  = 3,
     PACK_COLLOP_DATA   = 4,
     PACK_METRIC_DATA   = 5,
-    PACK_NUM_PACKS     = 6
+    PACK_IO_DATA       = 6,
+    PACK_NUM_PACKS     = 7
 
 };
 
-/* pack the local alldata into a buffer, return buffer */
-static char* pack_worker_data(AllData& alldata, uint32_t sizes[PACK_NUM_PACKS]) {
-    uint64_t fence      = FENCE;
-    uint32_t num_fences = 1;
-
-    /* get the sizes of all parts that need to be transmitted */
-
-    for (uint32_t i = 1; i < PACK_NUM_PACKS; i++) {
-        sizes[i] = 0;
-    }
-
-    sizes[PACK_MAPPING] = mapping.size();
-    num_fences++;
-
-    sizes[PACK_FUNCTION_DATA] = f_data.size();
-    num_fences++;
-
-    sizes[PACK_MESSAGE_DATA] = m_data.size();
-    num_fences++;
-
-    sizes[PACK_COLLOP_DATA] = c_data.size();
-    num_fences++;
-
-    sizes[PACK_METRIC_DATA] = met_data.size();
-    num_fences++;
-
-    /* get bytesize multiplying all pieces */
-    uint32_t bytesize = 0;
-    int      s1, s2;
-
-    MPI_Pack_size(num_fences, MPI_LONG_LONG_INT, MPI_COMM_WORLD, &s1);
-    bytesize += s1;
-
-    MPI_Pack_size(sizes[PACK_MAPPING] * 3, MPI_LONG_LONG_INT, MPI_COMM_WORLD, &s1);
-    bytesize += s1;
-
-    MPI_Pack_size(sizes[PACK_FUNCTION_DATA] * 3, MPI_LONG_LONG_INT, MPI_COMM_WORLD, &s1);
-    MPI_Pack_size(sizes[PACK_FUNCTION_DATA] * 2, MPI_DOUBLE, MPI_COMM_WORLD, &s2);
-    bytesize += s1 + s2;
-
-    MPI_Pack_size(sizes[PACK_MESSAGE_DATA] * 6, MPI_LONG_LONG_INT, MPI_COMM_WORLD, &s1);
-    bytesize += s1;
-
-    MPI_Pack_size(sizes[PACK_COLLOP_DATA] * 6, MPI_LONG_LONG_INT, MPI_COMM_WORLD, &s1);
-    bytesize += s1;
-
-    MPI_Pack_size(sizes[PACK_METRIC_DATA] * 7, MPI_LONG_LONG_INT, MPI_COMM_WORLD, &s1);
-    bytesize += s1;
-
-    /* get the buffer */
-    sizes[PACK_TOTAL_SIZE] = bytesize;
-    char* buffer           = alldata.metaData.guaranteePackBuffer(bytesize);
-
-    /* pack parts */
-    int position = 0;
-
-    /* extra check that doesn't cost too much */
-    MPI_Pack((void*)&fence, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-
-    /* pack mapping (three) */
-    {
-        for (auto it = mapping.begin(); it != mapping.end(); it++) {
-            MPI_Pack((void*)&it->first, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-            MPI_Pack((void*)&it->second.first, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-            MPI_Pack((void*)&it->second.second, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-        }
-    }
-
-    /* extra check that doesn't cost too much */
-    MPI_Pack((void*)&fence, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-
-    /* pack function data */
-    {
-        for (auto it = f_data.begin(); it != f_data.end(); it++) {
-            FunctionData tmp = *get<2>(*it);
-            MPI_Pack((void*)&get<0>(*it), 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-
-            MPI_Pack((void*)&get<1>(*it), 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-            MPI_Pack((void*)&tmp.count, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-            MPI_Pack((void*)&tmp.incl_time, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-            MPI_Pack((void*)&tmp.excl_time, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-        }
-    }
-
-    /* extra check that doesn't cost too much */
-    MPI_Pack((void*)&fence, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-
-    /* pack message data */
-    {
-        for (auto it = m_data.begin(); it != m_data.end(); it++) {
-            MessageData tmp = *get<2>(*it);
-
-            MPI_Pack((void*)&get<0>(*it), 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-
-            MPI_Pack((void*)&get<1>(*it), 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-            MPI_Pack((void*)&tmp.count_send, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-            MPI_Pack((void*)&tmp.count_recv, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-            MPI_Pack((void*)&tmp.bytes_send, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-            MPI_Pack((void*)&tmp.bytes_recv, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-        }
-    }
+/* get the sizes of all parts that need to be transmitted */
+static void get_worker_data_sizes(uint64_t sizes[PACK_NUM_PACKS]) {
+    sizes[PACK_NODES]         = tree_data.nodes.size();
+    sizes[PACK_FUNCTION_DATA] = tree_data.functions.size();
+    sizes[PACK_MESSAGE_DATA]  = tree_data.messages.size();
+    sizes[PACK_COLLOP_DATA]   = tree_data.collops.size();
+    sizes[PACK_METRIC_DATA]   = tree_data.metrics.size();
+    sizes[PACK_IO_DATA]       = io_data.size();
+
+    sizes[PACK_TOTAL_SIZE] = sizes[PACK_NODES] * sizeof(SerializedTree::Node) +
+                             sizes[PACK_FUNCTION_DATA] * sizeof(SerializedTree::Function) +
+                             sizes[PACK_MESSAGE_DATA] * sizeof(SerializedTree::Message) +
+                             sizes[PACK_COLLOP_DATA] * sizeof(SerializedTree::Collop) +
+                             sizes[PACK_METRIC_DATA] * sizeof(SerializedTree::Metric) + sizes[PACK_IO_DATA];
+}
 
-    /* extra check that doesn't cost too much */
-    MPI_Pack((void*)&fence, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
+/* make room for the parts announced by a worker */
+static void prepare_worker_data(const uint64_t sizes[PACK_NUM_PACKS]) {
+    tree_data.nodes.resize(sizes[PACK_NODES]);
+    tree_data.functions.resize(sizes[PACK_FUNCTION_DATA]);
+    tree_data.messages.resize(sizes[PACK_MESSAGE_DATA]);
+    tree_data.collops.resize(sizes[PACK_COLLOP_DATA]);
+    tree_data.metrics.resize(sizes[PACK_METRIC_DATA]);
+    io_data.resize(sizes[PACK_IO_DATA]);
+}
 
-    /* pack collop data */
-    {
-        for (auto it = c_data.begin(); it != c_data.end(); it++) {
-            CollopData tmp = *get<2>(*it);
+/* parts are transferred in chunks of at most this size,
+ * the receiver merges a chunk while the next ones are still in flight */
+static constexpr size_t CHUNK_SIZE = 4 * 1024 * 1024;
+
+/* records `[first, first+count)` of part `part`, sent as message of its own */
+struct Chunk {
+    uint32_t part;
+    size_t   first;
+    size_t   count;
+    void*    data;
+    int      bytes;
+};
 
-            MPI_Pack((void*)&get<0>(*it), 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-            MPI_Pack((void*)&get<1>(*it), 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
+template <typename T>
+static void add_chunks(uint32_t part, vector<T>& values, vector<Chunk>& chunks) {
+    const size_t per_chunk = max<size_t>(1, CHUNK_SIZE / sizeof(T));
 
-            MPI_Pack((void*)&tmp.count_send, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-            MPI_Pack((void*)&tmp.count_recv, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-            MPI_Pack((void*)&tmp.bytes_send, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-            MPI_Pack((void*)&tmp.bytes_recv, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-        }
+    for (size_t first = 0; first < values.size(); first += per_chunk) {
+        size_t count = min(per_chunk, values.size() - first);
+        chunks.push_back({part, first, count, values.data() + first, static_cast<int>(count * sizeof(T))});
     }
+}
 
-    /* extra check that doesn't cost too much */
-    MPI_Pack((void*)&fence, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-
-    /* pack metrics (counter) data */
-    {
-        for (auto it = met_data.begin(); it != met_data.end(); it++) {
-            MetricData tmp = *get<3>(*it);
-
-            MPI_Pack((void*)&get<0>(*it), 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-            MPI_Pack((void*)&get<1>(*it), 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-            MPI_Pack((void*)&get<2>(*it), 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-
-            MPI_Pack((void*)&tmp.type, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-
-            switch (tmp.type) {
-                case MetricDataType::UINT64:
-                    MPI_Pack((void*)&tmp.data_incl, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-                    MPI_Pack((void*)&tmp.data_excl, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-                    break;
-                case MetricDataType::INT64:
-                    MPI_Pack((void*)&tmp.data_incl, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-                    MPI_Pack((void*)&tmp.data_excl, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
-                    break;
-                case MetricDataType::DOUBLE:
-                    MPI_Pack((void*)&tmp.data_incl, 1, MPI_DOUBLE, buffer, bytesize, &position, MPI_COMM_WORLD);
-                    MPI_Pack((void*)&tmp.data_excl, 1, MPI_DOUBLE, buffer, bytesize, &position, MPI_COMM_WORLD);
-                    break;
-            }
-        }
-    }
+/* split all parts into chunks, in the order in which they have to be merged (nodes before their data) */
+static vector<Chunk> get_chunks() {
+    vector<Chunk> chunks;
 
-    /* extra check that doesn't cost too much */
-    MPI_Pack((void*)&fence, 1, MPI_LONG_LONG_INT, buffer, bytesize, &position, MPI_COMM_WORLD);
+    add_chunks(PACK_NODES, tree_data.nodes, chunks);
+    add_chunks(PACK_FUNCTION_DATA, tree_data.functions, chunks);
+    add_chunks(PACK_MESSAGE_DATA, tree_data.messages, chunks);
+    add_chunks(PACK_COLLOP_DATA, tree_data.collops, chunks);
+    add_chunks(PACK_METRIC_DATA, tree_data.metrics, chunks);
+    add_chunks(PACK_IO_DATA, io_data, chunks);
 
-    return buffer;
+    return chunks;
 }
 
-/* prepare alldata for unpack, return buffer of sufficient size */
-static char* prepare_worker_data(AllData& alldata, uint32_t sizes[PACK_NUM_PACKS]) {
-    uint32_t bytesize = sizes[PACK_TOTAL_SIZE];
-
-    return alldata.metaData.guaranteePackBuffer(bytesize);
+/* add a received chunk of the call-path tree to the local one, false if it is inconsistent */
+static bool merge_chunk(SerializedTreeMerger& merger, const Chunk& chunk) {
+    switch (chunk.part) {
+        case PACK_NODES:
+            return merger.add(tree_data.nodes.data() + chunk.first, chunk.count);
+        case PACK_FUNCTION_DATA:
+            return merger.add(tree_data.functions.data() + chunk.first, chunk.count);
+        case PACK_MESSAGE_DATA:
+            return merger.add(tree_data.messages.data() + chunk.first, chunk.count);
+        case PACK_COLLOP_DATA:
+            return merger.add(tree_data.collops.data() + chunk.first, chunk.count);
+        case PACK_METRIC_DATA:
+            return merger.add(tree_data.metrics.data() + chunk.first, chunk.count);
+        default:
+            /* I/O statistics are merged once they are complete */
+            return true;
+    }
 }
 
-/* unpack the received worker data and add it to the local alldata */
-static void unpack_worker_data(AllData& alldata, uint32_t sizes[PACK_NUM_PACKS]) {
-    data_tree tmp_tree;
-    /* <node_id, <parent_id, function_id, pointer on object> */
-    map<uint64_t, tuple<uint64_t, uint64_t, shared_ptr<tree_node>>> tmp_map;
-
-    uint64_t fence;
-
-    /* unpack parts */
-    int   position = 0;
-    char* buffer   = alldata.metaData.getPackBuffer();
-
-    /* extra check that doesn't cost too much */
-    fence = 0;
-    MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &fence, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-    assert(FENCE == fence);
-
-    /* unpack mapping -> generate temporary tree */
-    {
-        for (uint64_t i = 0; i < sizes[PACK_MAPPING]; i++) {
-            uint64_t id, function_id, parent_id;
-
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &id, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &function_id, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &parent_id, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
+/* receive the worker data from `peer` & merge it chunk by chunk while the following chunks are still in flight */
+static bool receive_worker_data(AllData& alldata, uint32_t peer) {
+    bool error = false;
 
-            tmp_map.insert(make_pair(id, make_tuple(function_id, parent_id, shared_ptr<tree_node>(nullptr))));
-        }
+    vector<Chunk>       chunks = get_chunks();
+    vector<MPI_Request> requests(chunks.size());
 
-        // generate tree out of mapping AND add pointer to the respective node to the mapping
-        tmp_tree = data_tree(tmp_map);
+    /* chunks with the same tag are matched in the order the receives are posted */
+    for (size_t i = 0; i < chunks.size(); i++)
+        MPI_Irecv(chunks[i].data, chunks[i].bytes, MPI_BYTE, peer, 5, MPI_COMM_WORLD, &requests[i]);
 
-        /* extra check that doesn't cost too much */
-        fence = 0;
-        MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &fence, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-        assert(FENCE == fence);
-    }
+    SerializedTreeMerger merger(alldata.call_path_tree);
+    for (size_t i = 0; i < chunks.size(); i++) {
+        MPI_Wait(&requests[i], MPI_STATUS_IGNORE);
 
-    /* unpack function data -> add it to the temporary tree */
-    {
-        for (uint64_t i = 0; i < sizes[PACK_FUNCTION_DATA]; i++) {
-            uint64_t id, rank, count, incl, excl;
-
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &id, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &rank, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &count, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &incl, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &excl, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-
-            /*  IMPORTANT: tmp_map.find( id ) --- find node in mapping
-             *  ->second --- get pointer to node in tree
-             *  ->m_data.insert() --- insert data in node-data-container
-             *  -----> insert is without checks for existence because an analysis rank is working on
-             * trace ranks exclusivly
-             *  that means if analysis rank 0 has trace ranks 0-3 he does not have any clue of trace
-             * rank 4-n so an insert of
-             *  rank 4-n is safe without testing for the existence of data
-             */
-
-            get<2>(tmp_map.find(id)->second)->node_data.insert(make_pair(rank, FunctionData{count, incl, excl}));
+        if (!error && !merge_chunk(merger, chunks[i])) {
+            cerr << "ERROR: Received call-path tree is corrupted" << endl;
+            error = true;
         }
-
-        /* extra check that doesn't cost too much */
-        fence = 0;
-        MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &fence, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-        assert(FENCE == fence);
     }
 
-    /* unpack message data */
-    {
-        for (uint64_t i = 0; i < sizes[PACK_MESSAGE_DATA]; i++) {
-            uint64_t id, rank, count_send, count_recv, bytes_send, bytes_recv;
+    if (!error && !merge_io_data(alldata, io_data.data(), io_data.size()))
+        error = true;
 
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &id, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
+    return !error;
+}
 
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &rank, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &count_send, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &count_recv, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &bytes_send, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &bytes_recv, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
+/* send the worker data to `peer`, all chunks at once */
+static void send_worker_data(uint32_t peer) {
+    vector<Chunk>       chunks = get_chunks();
+    vector<MPI_Request> requests(chunks.size());
 
-            // analogous to unpack function data
-            get<2>(tmp_map.find(id)->second)
-                ->add_data(rank, MessageData{count_send, count_recv, bytes_send, bytes_recv});
-        }
-
-        /* extra check that doesn't cost too much */
-        fence = 0;
-        MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &fence, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-        assert(FENCE == fence);
-    }
+    for (size_t i = 0; i < chunks.size(); i++)
+        MPI_Isend(chunks[i].data, chunks[i].bytes, MPI_BYTE, peer, 5, MPI_COMM_WORLD, &requests[i]);
 
-    /* unpack collop data */
-    {
-        for (uint64_t i = 0; i < sizes[PACK_COLLOP_DATA]; i++) {
-            uint64_t id, rank, count_send, count_recv, bytes_send, bytes_recv;
-
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &id, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
+    MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+}
 
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &rank, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &count_send, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &count_recv, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &bytes_send, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &bytes_recv, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
+/* e.g. "12.3 MB in 0.5 s (24.6 MB/s)" */
+static string transfer_rate(uint64_t bytes, double seconds) {
+    ostringstream os;
+    os << fixed << setprecision(1) << bytes / (1024.0 * 1024.0) << " MB in " << setprecision(3) << seconds << " s";
+    if (seconds > 0)
+        os << " (" << setprecision(1) << bytes / (1024.0 * 1024.0) / seconds << " MB/s)";
+    return os.str();
+}
 
-            // analogous to unpack function data
-            get<2>(tmp_map.find(id)->second)
-                ->add_data(rank, CollopData{count_send, count_recv, bytes_send, bytes_recv});
-        }
+/* sum up the callback counters of the self profile (--self-profile) on the master */
+static void reduce_callback_profile(AllData& alldata) {
+    auto& counters = alldata.tm.callbacks.counters;
 
-        /* extra check that doesn't cost too much */
-        fence = 0;
-        MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &fence, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-        assert(FENCE == fence);
+    vector<uint64_t> values;
+    for (const auto& counter : counters) {
+        values.push_back(counter.count);
+        values.push_back(counter.samples);
+        values.push_back(counter.sampled_ns);
     }
 
-    /* unpack metrics (counter) data */
-
-    {
-        for (uint64_t i = 0; i < sizes[PACK_METRIC_DATA]; i++) {
-            uint64_t       id, rank, metric_id;
-            MetricDataType type;
-
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &id, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &rank, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &metric_id, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-
-            MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &type, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-
-            switch (type) {
-                case MetricDataType::UINT64: {
-                    uint64_t value_incl, value_excl;
-                    MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &value_incl, 1, MPI_LONG_LONG_INT,
-                               MPI_COMM_WORLD);
-                    MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &value_excl, 1, MPI_LONG_LONG_INT,
-                               MPI_COMM_WORLD);
-                    get<2>(tmp_map.find(id)->second)
-                        ->add_data(rank, metric_id, MetricData{type, value_incl, value_excl});
-                    break;
-                }
-                case MetricDataType::DOUBLE: {
-                    double value_incl, value_excl;
-                    MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &value_incl, 1, MPI_DOUBLE, MPI_COMM_WORLD);
-                    MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &value_excl, 1, MPI_DOUBLE, MPI_COMM_WORLD);
-                    get<2>(tmp_map.find(id)->second)
-                        ->add_data(rank, metric_id, MetricData{type, value_incl, value_excl});
-                    break;
-                }
-                case MetricDataType::INT64: {
-                    int64_t value_incl, value_excl;
-                    MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &value_incl, 1, MPI_LONG_LONG_INT,
-                               MPI_COMM_WORLD);
-                    MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &value_excl, 1, MPI_LONG_LONG_INT,
-                               MPI_COMM_WORLD);
-                    get<2>(tmp_map.find(id)->second)
-                        ->add_data(rank, metric_id, MetricData{type, value_incl, value_excl});
-                    break;
-                }
-            }
-        }
+    if (0 == alldata.metaData.myRank)
+        MPI_Reduce(MPI_IN_PLACE, values.data(), values.size(), MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    else
+        MPI_Reduce(values.data(), nullptr, values.size(), MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
 
-        /* extra check that doesn't cost too much */
-        fence = 0;
-        MPI_Unpack(buffer, sizes[PACK_TOTAL_SIZE], &position, &fence, 1, MPI_LONG_LONG_INT, MPI_COMM_WORLD);
-        assert(FENCE == fence);
+    for (size_t i = 0; i < counters.size(); ++i) {
+        counters[i].count      = values[3 * i];
+        counters[i].samples    = values[3 * i + 1];
+        counters[i].sampled_ns = values[3 * i + 2];
     }
-
-    alldata.call_path_tree.merge_tree(tmp_tree);
 }
 
 bool ReduceData(AllData& alldata) {
@@ -376,6 +193,9 @@ bool ReduceData(AllData& alldata) {
 
     alldata.verbosePrint(1, true, "reducing data");
 
+    if (alldata.params.self_profile)
+        reduce_callback_profile(alldata);
+
     /* implement reduction myself because MPI and C++ STL don't play with
     each other */
 
@@ -399,52 +219,37 @@ bool ReduceData(AllData& alldata) {
         }
 
         /* send to smaller peer, receive from larger one */
-        uint32_t sizes[PACK_NUM_PACKS];
-        char*    buffer;
+        uint64_t sizes[PACK_NUM_PACKS];
 
         if (alldata.metaData.myRank < peer) {
             MPI_Status status;
 
-            MPI_Recv(sizes, PACK_NUM_PACKS, MPI_UNSIGNED, peer, 4, MPI_COMM_WORLD, &status);
+            MPI_Recv(sizes, PACK_NUM_PACKS, MPI_UINT64_T, peer, 4, MPI_COMM_WORLD, &status);
 
-            // DEBUG
-            // cout << "    round " << round << " recv " << peer << "--> " <<
-            // alldata.myRank << " with " <<
-            // sizes[PACK_TOTAL_SIZE] << " bytes, " <<
-            // sizes[PACK_FUNCTION] << ", " <<
-            // sizes[PACK_FUNCTION_DURATION] << ", " <<
-            // sizes[PACK_COUNTER] << ", " <<
-            // sizes[PACK_MSG_GROUP_PAIR] << "" << endl << flush;
+            prepare_worker_data(sizes);
 
-            buffer = prepare_worker_data(alldata, sizes);
+            double start = MPI_Wtime();
+            if (!receive_worker_data(alldata, peer))
+                error = true;
 
-            msg << ": receiving " << sizes[PACK_TOTAL_SIZE] << " bytes from rank " << peer;
+            msg << ": received & merged " << transfer_rate(sizes[PACK_TOTAL_SIZE], MPI_Wtime() - start)
+                << " from rank " << peer;
             alldata.verbosePrint(2, false, msg.str());
 
-            MPI_Recv(buffer, sizes[PACK_TOTAL_SIZE], MPI_PACKED, peer, 5, MPI_COMM_WORLD, &status);
-
-            unpack_worker_data(alldata, sizes);
-
         } else {
-            alldata.call_path_tree.serialize_data(mapping, f_data, m_data, c_data, met_data);
-
-            buffer = pack_worker_data(alldata, sizes);
+            alldata.call_path_tree.serialize_data(tree_data);
+            io_data.clear();
+            serialize_io_data(alldata, io_data);
 
-            // DEBUG
-            // cout << "    round " << round << " send " << alldata.myRank <<
-            //" --> " << peer << " with " <<
-            // sizes[PACK_TOTAL_SIZE] << " bytes, " <<
-            // sizes[PACK_FUNCTION] << ", " <<
-            // sizes[PACK_FUNCTION_DURATION] << ", " <<
-            // sizes[PACK_COUNTER] << ", " <<
-            // sizes[PACK_MSG_GROUP_PAIR] << "" << endl << flush;
+            get_worker_data_sizes(sizes);
 
-            msg << ": sending " << sizes[PACK_TOTAL_SIZE] << " bytes to rank " << peer;
-            alldata.verbosePrint(2, false, msg.str());
+            MPI_Send(sizes, PACK_NUM_PACKS, MPI_UINT64_T, peer, 4, MPI_COMM_WORLD);
 
-            MPI_Send(sizes, PACK_NUM_PACKS, MPI_UNSIGNED, peer, 4, MPI_COMM_WORLD);
+            double start = MPI_Wtime();
+            send_worker_data(peer);
 
-            MPI_Send(buffer, sizes[PACK_TOTAL_SIZE], MPI_PACKED, peer, 5, MPI_COMM_WORLD);
+            msg << ": sent " << transfer_rate(sizes[PACK_TOTAL_SIZE], MPI_Wtime() - start) << " to rank " << peer;
+            alldata.verbosePrint(2, false, msg.str());
 
             /* every work has to send off its data at most once,
             after that, break from the collective reduction operation */
@@ -454,7 +259,9 @@ bool ReduceData(AllData& alldata) {
         round = round << 1;
     }
 
-    alldata.metaData.freePackBuffer();
+    /* release the buffers of the last round */
+    tree_data = SerializedTree();
+    vector<uint8_t>().swap(io_data);
 
     /* synchronize error indicator with workers */
     /*SyncError( alldata, error );*/
@@ -0,0 +1,228 @@
+/*
+ This is part of the OTF-Profiler. Copyright by ZIH, TU Dresden 2016-2018.
+ Authors: Maximillian Neumann, Denis Hünich, Jens Doleschal
+*/
+
+#include "reduce_io_data.h"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+
+using namespace definitions;
+
+namespace {
+
+/* Appends fixed-width fields & strings to the buffer */
+class Writer {
+   public:
+    explicit Writer(std::vector<uint8_t>& out) : out(out) {}
+
+    template <typename T>
+    void put(T value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    void put_string(const std::string& str) {
+        put<uint64_t>(str.size());
+        out.insert(out.end(), str.begin(), str.end());
+    }
+
+    void put_io_data(const IoData& io_data) {
+        put<uint64_t>(io_data.num_operations);
+        put<uint64_t>(io_data.num_bytes);
+        put<uint64_t>(io_data.transfer_time);
+        put<uint64_t>(io_data.nontransfer_time);
+        put<uint64_t>(io_data.io_handle);
+        put<uint64_t>(io_data.region);
+        put_string(io_data.mode);
+    }
+
+    std::vector<uint8_t>& out;
+};
+
+/* Reads the fields written by @ref Writer, `ok` is false once anything was read beyond the end of the data */
+class Reader {
+   public:
+    Reader(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (sizeof(T) > size - pos) {
+            ok = false;
+            return value;
+        }
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    std::string get_string() {
+        auto length = get<uint64_t>();
+        if (length > size - pos) {
+            ok = false;
+            return {};
+        }
+        std::string str(reinterpret_cast<const char*>(data + pos), length);
+        pos += length;
+        return str;
+    }
+
+    IoData get_io_data() {
+        IoData io_data;
+        io_data.num_operations   = get<uint64_t>();
+        io_data.num_bytes        = get<uint64_t>();
+        io_data.transfer_time    = get<uint64_t>();
+        io_data.nontransfer_time = get<uint64_t>();
+        io_data.io_handle        = get<uint64_t>();
+        io_data.region           = get<uint64_t>();
+        io_data.mode             = get_string();
+        return io_data;
+    }
+
+    const uint8_t* data;
+    size_t         size;
+    size_t         pos = 0;
+    bool           ok  = true;
+};
+
+/* IoHandles with I/O (or created) on this rank, the others are only known by their definition */
+bool has_io(const IoHandle& ioh) {
+    return ioh.location.has_value() || ioh.io_data_stats.num_operations > 0 || !ioh.io_accesses.empty();
+}
+
+}  // namespace
+
+void serialize_io_data(const AllData& alldata, std::vector<uint8_t>& out) {
+    Writer w(out);
+
+    w.put<uint64_t>(alldata.io_data_per_paradigm.size());
+    for (const auto& [paradigm, io_data] : alldata.io_data_per_paradigm) {
+        w.put<uint64_t>(paradigm);
+        w.put_io_data(io_data);
+    }
+
+    w.put<uint64_t>(alldata.io_data_per_location.size());
+    for (const auto& [location, io_data] : alldata.io_data_per_location) {
+        w.put<uint64_t>(location);
+        w.put_io_data(io_data);
+    }
+
+    w.put<uint64_t>(alldata.parent_regions_by_callcount.size());
+    for (const auto& [region, callers] : alldata.parent_regions_by_callcount) {
+        w.put<uint64_t>(region);
+        w.put<uint64_t>(callers.size());
+        for (const auto& [caller, calls] : callers) {
+            w.put<uint64_t>(caller);
+            w.put<uint64_t>(calls);
+        }
+    }
+
+    std::vector<OTF2_IoHandleRef> handles;
+    alldata.definitions.iohandles.for_each([&](OTF2_IoHandleRef id, const IoHandle& ioh) {
+        if (has_io(ioh))
+            handles.push_back(id);
+    });
+    w.put<uint64_t>(handles.size());
+    for (auto id : handles) {
+        const IoHandle& ioh = *alldata.definitions.iohandles.get(id);
+        w.put<uint64_t>(id);
+        w.put_io_data(ioh.io_data_stats);
+        w.put<uint8_t>(ioh.location.has_value());
+        w.put<uint64_t>(ioh.location.value_or(0));
+        w.put<uint64_t>(ioh.modes.size());
+        for (const auto& mode : ioh.modes)
+            w.put_string(mode);
+
+        // the local access pattern is finished here, so the master only has to merge the results
+        auto result = ioh.get_local_access_pattern_stats();
+        w.put<uint64_t>(result.pattern_per_timeinterval.size());
+        for (const auto& [interval, pattern] : result.pattern_per_timeinterval) {
+            w.put<uint64_t>(interval.first);
+            w.put<uint64_t>(interval.second);
+            w.put<uint32_t>(static_cast<uint32_t>(pattern));
+        }
+        w.put<uint64_t>(result.stats_per_pattern.size());
+        for (const auto& [pattern, stats] : result.stats_per_pattern) {
+            w.put<uint32_t>(static_cast<uint32_t>(pattern));
+            w.put<uint64_t>(stats.io_size);
+            w.put<uint64_t>(stats.ticks_spent);
+        }
+
+        ioh.io_accesses.serialize(out);
+    }
+}
+
+bool merge_io_data(AllData& alldata, const uint8_t* data, size_t size) {
+    Reader r(data, size);
+
+    // the loops stop at the first read beyond the end of the data (eg because of a corrupted count)
+    for (auto n = r.get<uint64_t>(); r.ok && n > 0; --n) {
+        auto paradigm = r.get<uint64_t>();
+        alldata.io_data_per_paradigm[paradigm] += r.get_io_data();
+    }
+
+    for (auto n = r.get<uint64_t>(); r.ok && n > 0; --n) {
+        auto location = r.get<uint64_t>();
+        alldata.io_data_per_location[location] += r.get_io_data();
+    }
+
+    for (auto n = r.get<uint64_t>(); r.ok && n > 0; --n) {
+        auto& callers = alldata.parent_regions_by_callcount[r.get<uint64_t>()];
+        for (auto m = r.get<uint64_t>(); r.ok && m > 0; --m) {
+            auto caller = r.get<uint64_t>();
+            callers[caller] += r.get<uint64_t>();
+        }
+    }
+
+    for (auto n = r.get<uint64_t>(); r.ok && n > 0; --n) {
+        auto            id  = r.get<uint64_t>();
+        const IoHandle* ioh = alldata.definitions.iohandles.get(id);
+        if (ioh == nullptr) {
+            std::cerr << "ERROR: Received I/O of undefined IoHandle " << id << std::endl;
+            return false;
+        }
+
+        ioh->io_data_stats += r.get_io_data();
+        bool has_location = r.get<uint8_t>();
+        auto location     = r.get<uint64_t>();
+        if (has_location)
+            ioh->location = location;
+        for (auto m = r.get<uint64_t>(); r.ok && m > 0; --m)
+            ioh->modes.insert(r.get_string());
+
+        AnalysisResult result;
+        for (auto m = r.get<uint64_t>(); r.ok && m > 0; --m) {
+            auto begin   = r.get<uint64_t>();
+            auto end     = r.get<uint64_t>();
+            auto pattern = static_cast<AccessPattern>(r.get<uint32_t>());
+            result.pattern_per_timeinterval[{begin, end}] = pattern;
+        }
+        for (auto m = r.get<uint64_t>(); r.ok && m > 0; --m) {
+            auto pattern = static_cast<AccessPattern>(r.get<uint32_t>());
+            auto io_size = r.get<uint64_t>();
+            result.stats_per_pattern[pattern] += PatternStatistics{io_size, r.get<uint64_t>()};
+        }
+        ioh->access_pattern_detector.merge(result);
+
+        IOAccesses accesses;
+        if (!r.ok || !accesses.deserialize(data, size, r.pos)) {
+            r.ok = false;
+            break;
+        }
+        if (ioh->io_accesses.empty())
+            ioh->io_accesses = std::move(accesses);
+        else
+            ioh->io_accesses.append(accesses);
+    }
+
+    if (!r.ok || r.pos != size) {
+        std::cerr << "ERROR: Received I/O statistics are corrupted" << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,809 @@
+/*
+ Generates synthetic OTF2 traces for benchmarking the OTF-Profiler without Score-P.
+
+ The events of a location are produced by a random walk driven by a generator of its own, seeded from the global seed
+ and the location id: the same seed and options always produce the same archive, independent of the nr of writer
+ threads. Events are streamed into the OTF2 buffers, which are flushed once `--buffer` bytes per location are used,
+ so the size of a trace is only limited by the disk.
+*/
+
+#include <otf2/OTF2_Pthread_Locks.h>
+#include <otf2/otf2.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "otf-profiler-config.h"
+
+namespace {
+
+struct GeneratorParams {
+    std::string output         = "synthetic_trace";
+    uint64_t    seed           = 1;
+    uint64_t    events         = 1000000;  // approx. nr of events of the whole trace
+    uint32_t    nodes          = 1;
+    uint32_t    processes      = 4;
+    uint32_t    threads        = 1;  // locations per process
+    uint32_t    regions        = 32;
+    uint32_t    depth          = 8;
+    uint32_t    fanout         = 4;     // callees per region
+    uint64_t    interval       = 1000;  // mean ticks (ns) between two events
+    double      p2p_rate       = 0.01;
+    double      coll_rate      = 0.001;
+    uint64_t    msg_size       = 4096;
+    uint32_t    io_handles     = 4;  // per location
+    double      io_rate        = 0.02;
+    double      read_ratio     = 0.25;
+    uint64_t    io_size        = 4096;
+    uint64_t    file_size      = 1ull << 30;
+    double      append_rate    = 0;  // share of the writes appended to the end of the file
+    uint32_t    metric_classes = 0;
+    uint32_t    metric_members = 2;  // per class
+    uint32_t    writer_threads = 1;
+    uint64_t    buffer_size    = 8ull << 20;  // OTF2 event buffer per location
+
+    /* weights of the access patterns of the files: contiguous, strided, random */
+    std::array<uint32_t, 3> pattern_mix{1, 1, 1};
+
+    uint32_t locations() const { return processes * threads; }
+
+    bool parseCommandLine(int argc, char** argv);
+};
+
+/* Parses eg "1000", "4k", "2G", the suffixes are powers of `base` */
+bool parse_count(const std::string& value, uint64_t base, uint64_t& result) {
+    size_t pos = 0;
+    try {
+        result = std::stoull(value, &pos);
+    } catch (const std::exception&) {
+        return false;
+    }
+
+    const std::string suffix = value.substr(pos);
+    if (suffix.empty())
+        return true;
+    if (suffix.size() != 1)
+        return false;
+
+    switch (suffix[0]) {
+        case 'G':
+        case 'g':
+            result *= base;
+            [[fallthrough]];
+        case 'M':
+        case 'm':
+            result *= base;
+            [[fallthrough]];
+        case 'k':
+        case 'K':
+            result *= base;
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool GeneratorParams::parseCommandLine(int argc, char** argv) {
+    std::vector<std::string> arguments(argv + 1, argv + argc);
+
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        const auto& arg = arguments[i];
+        if (arg == "--help" || arg == "-h") {
+            std::cout << std::endl
+                      << " " << argv[0] << " - Generates a synthetic OTF2 trace for benchmarking the OTF-Profiler."
+                      << std::endl
+                      << std::endl
+                      << " Syntax: " << argv[0] << " -o <archive dir> [options]" << std::endl
+                      << std::endl
+                      << "   options:" << std::endl
+                      << "      -h, --help              show this help message" << std::endl
+                      << "      -o <dir>                archive directory, the anchor file is <dir>/traces.otf2" << std::endl
+                      << "                              (default: synthetic_trace)" << std::endl
+                      << "      --seed <n>              seed, equal seeds and options give equal traces (default: 1)"
+                      << std::endl
+                      << "      -n, --events <n>        approx. nr of events of the whole trace, suffixes k, M, G"
+                      << std::endl
+                      << "                              (default: 1M)" << std::endl
+                      << std::endl
+                      << "      --nodes <n>             system tree nodes (default: 1)" << std::endl
+                      << "      --processes <n>         processes (MPI ranks), distributed over the nodes (default: 4)"
+                      << std::endl
+                      << "      --threads <n>           locations per process, only the first one calls MPI"
+                      << std::endl
+                      << "                              (default: 1)" << std::endl
+                      << std::endl
+                      << "      --regions <n>           nr of user regions (default: 32)" << std::endl
+                      << "      --depth <n>             max. call depth below main (default: 8)" << std::endl
+                      << "      --fanout <n>            nr of regions a region calls, bounds the size of the call"
+                      << std::endl
+                      << "                              tree (default: 4)" << std::endl
+                      << "      --interval <ticks>      mean time between two enter/leave events in ns (default: 1000)"
+                      << std::endl
+                      << std::endl
+                      << "      --p2p-rate <p>          probability of a MPI_Send/MPI_Recv pair per step (default: 0.01)"
+                      << std::endl
+                      << "      --coll-rate <p>         probability of a MPI_Allreduce per step (default: 0.001)"
+                      << std::endl
+                      << "      --msg-size <bytes>      bytes per message (default: 4k)" << std::endl
+                      << std::endl
+                      << "      --io-handles <n>        I/O handles per location, handle i of all locations accesses"
+                      << std::endl
+                      << "                              file i (default: 4)" << std::endl
+                      << "      --io-rate <p>           probability of an I/O operation per step (default: 0.02)"
+                      << std::endl
+                      << "      --read-ratio <p>        share of reads among the I/O operations (default: 0.25)"
+                      << std::endl
+                      << "      --io-size <bytes>       bytes per I/O operation (default: 4k)" << std::endl
+                      << "      --file-size <bytes>     extent of the accessed files (default: 1G)" << std::endl
+                      << "      --append-rate <p>       share of the writes that seek to the end of the file first"
+                      << std::endl
+                      << "                              (default: 0)" << std::endl
+                      << "      --patterns <c,s,r>      weights of the access patterns contiguous, strided and random"
+                      << std::endl
+                      << "                              of the files (default: 1,1,1)" << std::endl
+                      << std::endl
+                      << "      --metric-classes <n>    metric classes, one metric event per class after each enter"
+                      << std::endl
+                      << "                              and before each leave of a user region (default: 0)"
+                      << std::endl
+                      << "      --metric-members <n>    metrics per class (default: 2)" << std::endl
+                      << std::endl
+                      << "      --writer-threads <n>    nr of threads writing locations (default: 1)" << std::endl
+                      << "      --buffer <bytes>        OTF2 event buffer per location (default: 8M)" << std::endl;
+            return false;
+        }
+
+        if (i + 1 >= arguments.size()) {
+            std::cerr << "ERROR: Unknown option or missing value for '" << arg << "'" << std::endl;
+            return false;
+        }
+        const auto& value = arguments[++i];
+
+        auto count = [&](auto& target, uint64_t base = 1000) {
+            uint64_t result;
+            if (!parse_count(value, base, result))
+                return false;
+            target = result;
+            return true;
+        };
+        auto probability = [&](double& target) {
+            try {
+                target = std::stod(value);
+            } catch (const std::exception&) {
+                return false;
+            }
+            return target >= 0 && target <= 1;
+        };
+
+        bool valid = true;
+        if (arg == "-o") {
+            output = value;
+        } else if (arg == "--seed") {
+            valid = count(seed);
+        } else if (arg == "-n" || arg == "--events") {
+            valid = count(events);
+        } else if (arg == "--nodes") {
+            valid = count(nodes) && nodes > 0;
+        } else if (arg == "--processes") {
+            valid = count(processes) && processes > 0;
+        } else if (arg == "--threads") {
+            valid = count(threads) && threads > 0;
+        } else if (arg == "--regions") {
+            valid = count(regions) && regions > 0;
+        } else if (arg == "--depth") {
+            valid = count(depth) && depth > 0;
+        } else if (arg == "--fanout") {
+            valid = count(fanout) && fanout > 0;
+        } else if (arg == "--interval") {
+            valid = count(interval) && interval > 0;
+        } else if (arg == "--p2p-rate") {
+            valid = probability(p2p_rate);
+        } else if (arg == "--coll-rate") {
+            valid = probability(coll_rate);
+        } else if (arg == "--msg-size") {
+            valid = count(msg_size, 1024);
+        } else if (arg == "--io-handles") {
+            valid = count(io_handles);
+        } else if (arg == "--io-rate") {
+            valid = probability(io_rate);
+        } else if (arg == "--read-ratio") {
+            valid = probability(read_ratio);
+        } else if (arg == "--io-size") {
+            valid = count(io_size, 1024) && io_size > 0;
+        } else if (arg == "--file-size") {
+            valid = count(file_size, 1024) && file_size > 0;
+        } else if (arg == "--append-rate") {
+            valid = probability(append_rate);
+        } else if (arg == "--patterns") {
+            std::array<uint64_t, 3> weights;
+            size_t                  begin = 0;
+            for (size_t p = 0; valid && p < weights.size(); ++p) {
+                const auto end = p + 1 < weights.size() ? value.find(',', begin) : value.size();
+                valid          = end != std::string::npos && parse_count(value.substr(begin, end - begin), 1, weights[p]);
+                begin          = end + 1;
+            }
+            valid = valid && weights[0] + weights[1] + weights[2] > 0;
+            for (size_t p = 0; valid && p < weights.size(); ++p)
+                pattern_mix[p] = weights[p];
+        } else if (arg == "--metric-classes") {
+            valid = count(metric_classes);
+        } else if (arg == "--metric-members") {
+            // nr of metrics of a Metric event is an uint8_t
+            valid = count(metric_members) && metric_members > 0 && metric_members <= 255;
+        } else if (arg == "--writer-threads") {
+            valid = count(writer_threads) && writer_threads > 0;
+        } else if (arg == "--buffer") {
+            valid = count(buffer_size, 1024);
+        } else {
+            std::cerr << "ERROR: Unknown option '" << arg << "'" << std::endl;
+            return false;
+        }
+
+        if (!valid) {
+            std::cerr << "ERROR: Invalid argument '" << value << "' for option '" << arg << "'" << std::endl;
+            return false;
+        }
+    }
+
+    if (io_size > file_size) {
+        std::cerr << "ERROR: --io-size is larger than --file-size" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/* splitmix64, unlike the std distributions its output doesn't depend on the standard library */
+class Rng {
+   public:
+    explicit Rng(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z          = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z          = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    /** Uniform in [0, n) */
+    uint64_t below(uint64_t n) { return n > 0 ? next() % n : 0; }
+
+    /** Uniform in [0, 1) */
+    double uniform() { return (next() >> 11) * 0x1.0p-53; }
+
+    bool chance(double p) { return uniform() < p; }
+
+   private:
+    uint64_t state;
+};
+
+/* Seed of an independent stream, eg of one location */
+uint64_t stream_seed(uint64_t seed, uint64_t stream) { return Rng(seed ^ (stream * 0xd1b54a32d192ed03ull)).next(); }
+
+enum class AccessPattern { CONTIGUOUS, STRIDED, RANDOM };
+
+/* Regions in front of the user regions */
+enum FixedRegion : OTF2_RegionRef {
+    REGION_MAIN,
+    REGION_MPI_SEND,
+    REGION_MPI_RECV,
+    REGION_MPI_ALLREDUCE,
+    REGION_OPEN,
+    REGION_WRITE,
+    REGION_READ,
+    REGION_CLOSE,
+    FIRST_USER_REGION
+};
+
+constexpr OTF2_CommRef       COMM_WORLD = 0;
+constexpr OTF2_IoParadigmRef IO_POSIX   = 0;
+
+/* Ids shared by the event and definition writing */
+struct Layout {
+    const GeneratorParams&     params;
+    std::vector<AccessPattern> file_patterns;  // of file i, accessed via handle i of every location
+
+    explicit Layout(const GeneratorParams& params) : params(params) {
+        Rng rng(stream_seed(params.seed, ~0ull));
+
+        const auto& mix   = params.pattern_mix;
+        const auto  total = mix[0] + mix[1] + mix[2];
+        for (uint32_t f = 0; f < params.io_handles; ++f) {
+            auto pick = rng.below(total);
+            file_patterns.push_back(pick < mix[0]            ? AccessPattern::CONTIGUOUS
+                                    : pick < mix[0] + mix[1] ? AccessPattern::STRIDED
+                                                             : AccessPattern::RANDOM);
+        }
+    }
+
+    uint32_t process(OTF2_LocationRef location) const { return location / params.threads; }
+    bool     is_mpi_location(OTF2_LocationRef location) const { return location % params.threads == 0; }
+    uint32_t node(uint32_t process) const {
+        return static_cast<uint64_t>(process) * params.nodes / params.processes;
+    }
+
+    OTF2_IoHandleRef io_handle(OTF2_LocationRef location, uint32_t file) const {
+        return location * params.io_handles + file;
+    }
+
+    OTF2_RegionRef callee(OTF2_RegionRef caller, uint32_t k) const {
+        return FIRST_USER_REGION + stream_seed(params.seed + caller, k) % params.regions;
+    }
+
+    OTF2_MetricMemberRef metric_member(uint32_t metric_class, uint32_t member) const {
+        return metric_class * params.metric_members + member;
+    }
+};
+
+/* Synthetic time of each location, the post flush callback of OTF2 runs on the writing thread and needs it for the
+ * BufferFlush record, a wall clock time would make the trace nondeterministic */
+struct FlushData {
+    std::vector<OTF2_TimeStamp> location_time;
+};
+
+OTF2_FlushType pre_flush(void* /*userData*/, OTF2_FileType /*fileType*/, OTF2_LocationRef /*location*/,
+                         void* /*callerData*/, bool /*final*/) {
+    return OTF2_FLUSH;
+}
+
+OTF2_TimeStamp post_flush(void* userData, OTF2_FileType /*fileType*/, OTF2_LocationRef location) {
+    auto* data = static_cast<FlushData*>(userData);
+    return location < data->location_time.size() ? data->location_time[location] : 0;
+}
+
+OTF2_FlushCallbacks flush_callbacks = {pre_flush, post_flush};
+
+/* Chunks of one OTF2 buffer, the event buffers are bounded to `--buffer` bytes: once full, OTF2 flushes them to
+ * disk and releases the chunks, otherwise a location's events would be kept in memory until it's closed */
+struct ChunkList {
+    std::vector<void*> chunks;
+};
+
+void* allocate_chunk(void* userData, OTF2_FileType fileType, OTF2_LocationRef /*location*/, void** perBufferData,
+                     uint64_t chunkSize) {
+    const auto buffer_size = *static_cast<uint64_t*>(userData);
+
+    auto*& list = reinterpret_cast<ChunkList*&>(*perBufferData);
+    if (!list)
+        list = new ChunkList;
+    // the definitions are tiny, only the event buffers are bounded
+    if (fileType == OTF2_FILETYPE_EVENTS && !list->chunks.empty() && (list->chunks.size() + 1) * chunkSize > buffer_size)
+        return nullptr;
+
+    auto* chunk = std::malloc(chunkSize);
+    if (chunk)
+        list->chunks.push_back(chunk);
+    return chunk;
+}
+
+void free_chunks(void* /*userData*/, OTF2_FileType /*fileType*/, OTF2_LocationRef /*location*/, void** perBufferData,
+                 bool final) {
+    auto*& list = reinterpret_cast<ChunkList*&>(*perBufferData);
+    if (!list)
+        return;
+
+    for (auto* chunk : list->chunks)
+        std::free(chunk);
+    list->chunks.clear();
+    if (final) {
+        delete list;
+        list = nullptr;
+    }
+}
+
+OTF2_MemoryCallbacks memory_callbacks = {allocate_chunk, free_chunks};
+
+/* Writes the events of one location */
+class LocationGenerator {
+   public:
+    LocationGenerator(const Layout& layout, OTF2_LocationRef location, OTF2_EvtWriter* writer, OTF2_TimeStamp& time)
+        : layout(layout),
+          params(layout.params),
+          location(location),
+          writer(writer),
+          time(time),
+          rng(stream_seed(params.seed, location)),
+          handles(params.io_handles),
+          metric_values(params.metric_classes * params.metric_members, OTF2_MetricValue{}),
+          metric_types(params.metric_members, OTF2_TYPE_UINT64) {}
+
+    /** Writes about `budget` events, returns false if OTF2 failed */
+    bool run(uint64_t budget) {
+        const bool mpi = layout.is_mpi_location(location) && params.processes > 1;
+        const auto p2p_rate  = mpi ? params.p2p_rate : 0.0;
+        const auto coll_rate = mpi ? params.coll_rate : 0.0;
+
+        enter(REGION_MAIN);
+        while (status == OTF2_SUCCESS && written < budget) {
+            const auto step = rng.uniform();
+            if (step < p2p_rate)
+                p2p();
+            else if (step < p2p_rate + coll_rate)
+                collective();
+            else if (step < p2p_rate + coll_rate + params.io_rate && !handles.empty())
+                io_operation();
+            else
+                compute();
+        }
+
+        for (uint32_t file = 0; file < handles.size(); ++file) {
+            if (!handles[file].open)
+                continue;
+            enter(REGION_CLOSE);
+            check(OTF2_EvtWriter_IoDestroyHandle(writer, nullptr, time, layout.io_handle(location, file)));
+            leave();
+        }
+        while (!stack.empty())
+            leave();
+
+        return status == OTF2_SUCCESS;
+    }
+
+   private:
+    struct Handle {
+        bool     open = false;
+        uint64_t fpos = 0;
+        uint64_t ops  = 0;
+    };
+
+    const Layout&          layout;
+    const GeneratorParams& params;
+    OTF2_LocationRef       location;
+    OTF2_EvtWriter*        writer;
+    OTF2_TimeStamp&        time;
+    Rng                    rng;
+
+    std::vector<OTF2_RegionRef>   stack;
+    std::vector<Handle>           handles;
+    std::vector<OTF2_MetricValue> metric_values;
+    std::vector<OTF2_Type>        metric_types;
+    uint64_t                      matching_id = 0;
+    uint64_t                      written     = 0;
+    OTF2_ErrorCode                status      = OTF2_SUCCESS;
+
+    void check(OTF2_ErrorCode code) {
+        ++written;
+        if (code != OTF2_SUCCESS && status == OTF2_SUCCESS) {
+            std::cerr << "ERROR: writing an event of location " << location << " failed: "
+                      << OTF2_Error_GetName(code) << std::endl;
+            status = code;
+        }
+    }
+
+    void advance(uint64_t ticks) { time += ticks; }
+
+    /* mean `--interval` ticks */
+    void advance() { advance(1 + rng.below(2 * params.interval)); }
+
+    void enter(OTF2_RegionRef region) {
+        advance();
+        check(OTF2_EvtWriter_Enter(writer, nullptr, time, region));
+        stack.push_back(region);
+    }
+
+    void leave() {
+        advance();
+        check(OTF2_EvtWriter_Leave(writer, nullptr, time, stack.back()));
+        stack.pop_back();
+    }
+
+    void metrics() {
+        for (uint32_t c = 0; c < params.metric_classes; ++c) {
+            auto* values = &metric_values[c * params.metric_members];
+            for (uint32_t m = 0; m < params.metric_members; ++m)
+                values[m].unsigned_int += rng.below(1000);
+            check(OTF2_EvtWriter_Metric(writer, nullptr, time, c, params.metric_members, metric_types.data(), values));
+        }
+    }
+
+    /* random walk through the call tree below main */
+    void compute() {
+        const auto depth = stack.size() - 1;
+        if (depth == 0 || (depth < params.depth && rng.chance(0.5))) {
+            enter(layout.callee(stack.back(), rng.below(params.fanout)));
+            metrics();
+        } else {
+            metrics();
+            leave();
+        }
+    }
+
+    void p2p() {
+        const auto rank  = layout.process(location);
+        const auto ranks = params.processes;
+
+        enter(REGION_MPI_SEND);
+        check(OTF2_EvtWriter_MpiSend(writer, nullptr, time, (rank + 1) % ranks, COMM_WORLD, 0, params.msg_size));
+        leave();
+        enter(REGION_MPI_RECV);
+        advance(params.msg_size);
+        check(OTF2_EvtWriter_MpiRecv(writer, nullptr, time, (rank + ranks - 1) % ranks, COMM_WORLD, 0,
+                                     params.msg_size));
+        leave();
+    }
+
+    void collective() {
+        enter(REGION_MPI_ALLREDUCE);
+        check(OTF2_EvtWriter_MpiCollectiveBegin(writer, nullptr, time));
+        advance(params.msg_size);
+        check(OTF2_EvtWriter_MpiCollectiveEnd(writer, nullptr, time, OTF2_COLLECTIVE_OP_ALLREDUCE, COMM_WORLD,
+                                              OTF2_UNDEFINED_UINT32, params.msg_size, params.msg_size));
+        leave();
+    }
+
+    uint64_t next_offset(uint32_t file, const Handle& handle) {
+        const uint64_t locations = params.locations();
+        const uint64_t blocks    = params.file_size / params.io_size;
+
+        switch (layout.file_patterns[file]) {
+            case AccessPattern::CONTIGUOUS: {
+                // a segment of the file per location
+                const uint64_t segment = std::max<uint64_t>(blocks / locations, 1);
+                return ((location % blocks) * segment + handle.ops % segment) % blocks * params.io_size;
+            }
+            case AccessPattern::STRIDED:
+                // blocks of the locations interleaved
+                return (handle.ops * locations + location) % blocks * params.io_size;
+            case AccessPattern::RANDOM:
+            default:
+                return rng.below(blocks) * params.io_size;
+        }
+    }
+
+    void io_operation() {
+        const auto file   = static_cast<uint32_t>(rng.below(handles.size()));
+        const auto handle = layout.io_handle(location, file);
+        auto&      h      = handles[file];
+
+        if (!h.open) {
+            enter(REGION_OPEN);
+            check(OTF2_EvtWriter_IoCreateHandle(writer, nullptr, time, handle, OTF2_IO_ACCESS_MODE_READ_WRITE,
+                                                OTF2_IO_CREATION_FLAG_CREATE, OTF2_IO_STATUS_FLAG_NONE));
+            leave();
+            h.open = true;
+        }
+
+        const bool read   = rng.chance(params.read_ratio);
+        // no random number is drawn without --append-rate, so the traces of the other options stay the same
+        const bool append = !read && params.append_rate > 0 && rng.chance(params.append_rate);
+        const auto offset = next_offset(file, h);
+
+        enter(read ? REGION_READ : REGION_WRITE);
+        if (append)
+            // the position at the end of the file depends on the writes of all locations, it is left to the reader
+            check(OTF2_EvtWriter_IoSeek(writer, nullptr, time, handle, 0, OTF2_IO_SEEK_FROM_END, 0));
+        else if (offset != h.fpos)
+            check(OTF2_EvtWriter_IoSeek(writer, nullptr, time, handle, offset, OTF2_IO_SEEK_FROM_START, offset));
+        check(OTF2_EvtWriter_IoOperationBegin(writer, nullptr, time, handle,
+                                              read ? OTF2_IO_OPERATION_MODE_READ : OTF2_IO_OPERATION_MODE_WRITE,
+                                              OTF2_IO_OPERATION_FLAG_NONE, params.io_size, matching_id));
+        // ~1 byte per ns
+        advance(params.io_size);
+        check(OTF2_EvtWriter_IoOperationComplete(writer, nullptr, time, handle, params.io_size, matching_id));
+        leave();
+
+        ++matching_id;
+        // unknown after appending, the next operation seeks from the start again
+        h.fpos = append ? UINT64_MAX : offset + params.io_size;
+        ++h.ops;
+    }
+};
+
+/* Strings of the global definitions, each is written when it's used first */
+class StringTable {
+   public:
+    explicit StringTable(OTF2_GlobalDefWriter* writer) : writer(writer) {}
+
+    OTF2_StringRef operator()(const std::string& str) {
+        auto [it, inserted] = refs.emplace(str, static_cast<OTF2_StringRef>(refs.size()));
+        if (inserted)
+            OTF2_GlobalDefWriter_WriteString(writer, it->second, str.c_str());
+        return it->second;
+    }
+
+   private:
+    OTF2_GlobalDefWriter*                           writer;
+    std::unordered_map<std::string, OTF2_StringRef> refs;
+};
+
+bool write_global_definitions(OTF2_Archive* archive, const Layout& layout, const std::vector<uint64_t>& events,
+                              OTF2_TimeStamp trace_length) {
+    const auto& params = layout.params;
+    auto*       writer = OTF2_Archive_GetGlobalDefWriter(archive);
+    if (!writer)
+        return false;
+    StringTable str(writer);
+
+#if VERSION_OTF2_MAJOR >= 3
+    OTF2_GlobalDefWriter_WriteClockProperties(writer, 1000000000, 0, trace_length, OTF2_UNDEFINED_TIMESTAMP);
+#else
+    OTF2_GlobalDefWriter_WriteClockProperties(writer, 1000000000, 0, trace_length);
+#endif
+
+    auto region = [&](OTF2_RegionRef ref, const std::string& name, OTF2_RegionRole role, OTF2_Paradigm paradigm) {
+        OTF2_GlobalDefWriter_WriteRegion(writer, ref, str(name), str(name), str(""), role, paradigm,
+                                         OTF2_REGION_FLAG_NONE, str("synthetic.c"), 0, 0);
+    };
+    region(REGION_MAIN, "main", OTF2_REGION_ROLE_FUNCTION, OTF2_PARADIGM_USER);
+    region(REGION_MPI_SEND, "MPI_Send", OTF2_REGION_ROLE_POINT2POINT, OTF2_PARADIGM_MPI);
+    region(REGION_MPI_RECV, "MPI_Recv", OTF2_REGION_ROLE_POINT2POINT, OTF2_PARADIGM_MPI);
+    region(REGION_MPI_ALLREDUCE, "MPI_Allreduce", OTF2_REGION_ROLE_COLL_ALL2ALL, OTF2_PARADIGM_MPI);
+    region(REGION_OPEN, "open", OTF2_REGION_ROLE_FILE_IO, OTF2_PARADIGM_USER);
+    region(REGION_WRITE, "pwrite", OTF2_REGION_ROLE_FILE_IO, OTF2_PARADIGM_USER);
+    region(REGION_READ, "pread", OTF2_REGION_ROLE_FILE_IO, OTF2_PARADIGM_USER);
+    region(REGION_CLOSE, "close", OTF2_REGION_ROLE_FILE_IO, OTF2_PARADIGM_USER);
+    for (uint32_t r = 0; r < params.regions; ++r)
+        region(FIRST_USER_REGION + r, "region_" + std::to_string(r), OTF2_REGION_ROLE_FUNCTION, OTF2_PARADIGM_USER);
+
+    // system tree: machine -> nodes -> processes -> threads
+    const OTF2_SystemTreeNodeRef machine = 0;
+    OTF2_GlobalDefWriter_WriteSystemTreeNode(writer, machine, str("synthetic"), str("machine"),
+                                             OTF2_UNDEFINED_SYSTEM_TREE_NODE);
+    for (uint32_t n = 0; n < params.nodes; ++n)
+        OTF2_GlobalDefWriter_WriteSystemTreeNode(writer, 1 + n, str("n" + std::to_string(n)), str("node"), machine);
+
+    std::vector<uint64_t> mpi_locations;
+    for (uint32_t p = 0; p < params.processes; ++p) {
+#if VERSION_OTF2_MAJOR >= 3
+        OTF2_GlobalDefWriter_WriteLocationGroup(writer, p, str("MPI Rank " + std::to_string(p)),
+                                                OTF2_LOCATION_GROUP_TYPE_PROCESS, 1 + layout.node(p),
+                                                OTF2_UNDEFINED_LOCATION_GROUP);
+#else
+        OTF2_GlobalDefWriter_WriteLocationGroup(writer, p, str("MPI Rank " + std::to_string(p)),
+                                                OTF2_LOCATION_GROUP_TYPE_PROCESS, 1 + layout.node(p));
+#endif
+        mpi_locations.push_back(static_cast<uint64_t>(p) * params.threads);
+    }
+    for (OTF2_LocationRef l = 0; l < params.locations(); ++l) {
+        const auto name = l % params.threads == 0 ? std::string("Master thread")
+                                                  : "Pthread thread " + std::to_string(l % params.threads);
+        OTF2_GlobalDefWriter_WriteLocation(writer, l, str(name), OTF2_LOCATION_TYPE_CPU_THREAD, events[l],
+                                           layout.process(l));
+    }
+
+    // MPI_COMM_WORLD: the locations of the ranks, and the ranks as group of the communicator
+    std::vector<uint64_t> ranks(params.processes);
+    for (uint32_t p = 0; p < params.processes; ++p)
+        ranks[p] = p;
+    OTF2_GlobalDefWriter_WriteGroup(writer, 0, str(""), OTF2_GROUP_TYPE_COMM_LOCATIONS, OTF2_PARADIGM_MPI,
+                                    OTF2_GROUP_FLAG_NONE, mpi_locations.size(), mpi_locations.data());
+    OTF2_GlobalDefWriter_WriteGroup(writer, 1, str(""), OTF2_GROUP_TYPE_COMM_GROUP, OTF2_PARADIGM_MPI,
+                                    OTF2_GROUP_FLAG_NONE, ranks.size(), ranks.data());
+#if VERSION_OTF2_MAJOR >= 3
+    OTF2_GlobalDefWriter_WriteComm(writer, COMM_WORLD, str("MPI_COMM_WORLD"), 1, OTF2_UNDEFINED_COMM,
+                                   OTF2_COMM_FLAG_NONE);
+#else
+    OTF2_GlobalDefWriter_WriteComm(writer, COMM_WORLD, str("MPI_COMM_WORLD"), 1, OTF2_UNDEFINED_COMM);
+#endif
+
+    // I/O: file i is accessed via handle i of every location
+    if (params.io_handles > 0) {
+        OTF2_GlobalDefWriter_WriteIoParadigm(writer, IO_POSIX, str("POSIX"), str("POSIX I/O"),
+                                             OTF2_IO_PARADIGM_CLASS_SERIAL, OTF2_IO_PARADIGM_FLAG_OS, 0, nullptr,
+                                             nullptr, nullptr);
+        static const char* PATTERN_NAMES[] = {"contiguous", "strided", "random"};
+        for (uint32_t f = 0; f < params.io_handles; ++f) {
+            const auto name = "/synthetic/" + std::string(PATTERN_NAMES[static_cast<int>(layout.file_patterns[f])]) +
+                              "_" + std::to_string(f) + ".dat";
+            OTF2_GlobalDefWriter_WriteIoRegularFile(writer, f, str(name), machine);
+        }
+        for (OTF2_LocationRef l = 0; l < params.locations(); ++l)
+            for (uint32_t f = 0; f < params.io_handles; ++f)
+                OTF2_GlobalDefWriter_WriteIoHandle(writer, layout.io_handle(l, f), str(""), f, IO_POSIX,
+                                                   OTF2_IO_HANDLE_FLAG_NONE, OTF2_UNDEFINED_COMM,
+                                                   OTF2_UNDEFINED_IO_HANDLE);
+    }
+
+    for (uint32_t c = 0; c < params.metric_classes; ++c) {
+        std::vector<OTF2_MetricMemberRef> members;
+        for (uint32_t m = 0; m < params.metric_members; ++m) {
+            const auto ref  = layout.metric_member(c, m);
+            const auto name = "SYNTH_COUNTER_" + std::to_string(ref);
+            OTF2_GlobalDefWriter_WriteMetricMember(writer, ref, str(name), str("synthetic counter"),
+                                                   OTF2_METRIC_TYPE_PAPI, OTF2_METRIC_ACCUMULATED_START,
+                                                   OTF2_TYPE_UINT64, OTF2_BASE_DECIMAL, 0, str("#"));
+            members.push_back(ref);
+        }
+        OTF2_GlobalDefWriter_WriteMetricClass(writer, c, members.size(), members.data(),
+                                              OTF2_METRIC_SYNCHRONOUS_STRICT, OTF2_RECORDER_KIND_CPU);
+    }
+
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    GeneratorParams params;
+    if (!params.parseCommandLine(argc, argv))
+        return 1;
+
+    const Layout layout(params);
+    const auto   locations = params.locations();
+
+    auto* archive = OTF2_Archive_Open(params.output.c_str(), "traces", OTF2_FILEMODE_WRITE, 1024 * 1024,
+                                      4 * 1024 * 1024, OTF2_SUBSTRATE_POSIX, OTF2_COMPRESSION_NONE);
+    if (!archive) {
+        std::cerr << "ERROR: Failed to create the OTF2 archive " << params.output << std::endl;
+        return 1;
+    }
+
+    FlushData flush_data{std::vector<OTF2_TimeStamp>(locations, 0)};
+    OTF2_Archive_SetFlushCallbacks(archive, &flush_callbacks, &flush_data);
+    OTF2_Archive_SetMemoryCallbacks(archive, &memory_callbacks, &params.buffer_size);
+    OTF2_Archive_SetSerialCollectiveCallbacks(archive);
+    if (params.writer_threads > 1)
+        OTF2_Pthread_Archive_SetLockingCallbacks(archive, nullptr);
+    OTF2_Archive_SetCreator(archive, "otf2-trace-generator");
+
+    OTF2_Archive_OpenEvtFiles(archive);
+
+    // each location is written by one thread, which one doesn't change its events
+    std::vector<uint64_t> events(locations, 0);
+    std::atomic<uint32_t> next_location{0};
+    std::atomic<bool>     failed{false};
+    auto write_locations = [&]() {
+        for (auto l = next_location++; l < locations && !failed; l = next_location++) {
+            auto* writer = OTF2_Archive_GetEvtWriter(archive, l);
+            if (!writer) {
+                failed = true;
+                break;
+            }
+
+            // budget of the trace split evenly over the locations
+            const uint64_t    budget = params.events / locations + (l < params.events % locations ? 1 : 0);
+            LocationGenerator generator(layout, l, writer, flush_data.location_time[l]);
+            if (!generator.run(budget))
+                failed = true;
+
+            OTF2_EvtWriter_GetNumberOfEvents(writer, &events[l]);
+            OTF2_Archive_CloseEvtWriter(archive, writer);
+        }
+    };
+
+    std::vector<std::thread> writers;
+    for (uint32_t t = 1; t < params.writer_threads; ++t)
+        writers.emplace_back(write_locations);
+    write_locations();
+    for (auto& writer : writers)
+        writer.join();
+
+    OTF2_Archive_CloseEvtFiles(archive);
+    if (failed) {
+        OTF2_Archive_Close(archive);
+        return 1;
+    }
+
+    // no local definitions, but every location needs its definition file
+    OTF2_Archive_OpenDefFiles(archive);
+    for (OTF2_LocationRef l = 0; l < locations; ++l) {
+        auto* def_writer = OTF2_Archive_GetDefWriter(archive, l);
+        OTF2_Archive_CloseDefWriter(archive, def_writer);
+    }
+    OTF2_Archive_CloseDefFiles(archive);
+
+    OTF2_TimeStamp trace_length = 0;
+    uint64_t       total_events = 0;
+    for (OTF2_LocationRef l = 0; l < locations; ++l) {
+        trace_length = std::max(trace_length, flush_data.location_time[l] + 1);
+        total_events += events[l];
+    }
+
+    const bool success = write_global_definitions(archive, layout, events, trace_length);
+    OTF2_Archive_Close(archive);
+    if (!success) {
+        std::cerr << "ERROR: Failed to write the global definitions" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << total_events << " events of " << locations << " locations to " << params.output
+              << "/traces.otf2" << std::endl;
+    return 0;
+}
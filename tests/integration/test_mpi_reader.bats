@@ -0,0 +1,41 @@
+LOG_FILE=test_mpi_reader.log
+export SYNTHETIC_PROCESSES=16
+export SYNTHETIC_OPTIONS="-n 4M --processes $SYNTHETIC_PROCESSES --threads 2 --seed 7"
+export MPI_RANKS=4
+
+function setup(){
+	if [ ! -x ../build/otf-profiler-mpi ] || ! command -v mpirun > /dev/null; then
+		skip "otf-profiler-mpi or mpirun not available"
+	fi
+}
+
+# wall time of a command in ms (only logged, it depends on the load of the machine), its output goes to the log
+function run_timed(){
+	local start=$(date +%s%N)
+	"$@" >> $LOG_DIR/$LOG_FILE 2>&1 || return 1
+	echo $(( ($(date +%s%N) - start) / 1000000 ))
+}
+
+# the values of the profile that have to be equal no matter how many ranks read the trace
+function profile_summary(){
+	jq -S '{TotalCalls, TotalFunctions, Functions, Messages, IOOperations, Files: (.Files | length)}' $1
+}
+
+@test "location groups are distributed over the MPI ranks" {
+	../build/otf2-trace-generator -o ${TEST_OUTPUT_DIR}/synthetic_mpi $SYNTHETIC_OPTIONS
+
+	sequential_ms=$(run_timed ../build/otf-profiler --json -i ${TEST_OUTPUT_DIR}/synthetic_mpi/traces.otf2 -o ${TEST_OUTPUT_DIR}/results_sequential)
+	parallel_ms=$(run_timed mpirun -np $MPI_RANKS ../build/otf-profiler-mpi --json -v 2 -i ${TEST_OUTPUT_DIR}/synthetic_mpi/traces.otf2 -o ${TEST_OUTPUT_DIR}/results_mpi)
+	echo "sequential: ${sequential_ms} ms, ${MPI_RANKS} ranks: ${parallel_ms} ms" >> $LOG_DIR/$LOG_FILE
+
+	# every rank ran the parallel loop (with work stealing a rank may end up with 0 groups), together they read every
+	# location group (=process) exactly once
+	for rank in $(seq 0 $((MPI_RANKS - 1))); do
+		grep -E "^\[$rank\] OTF2: reader $rank read [0-9]+ location groups" $LOG_DIR/$LOG_FILE
+	done
+	groups_read=$(grep -E "^\[[0-9]+\] OTF2: reader [0-9]+ read [0-9]+ location groups" $LOG_DIR/$LOG_FILE | awk '{ sum += $6 } END { print sum }')
+	[ "$groups_read" -eq "$SYNTHETIC_PROCESSES" ]
+
+	# the reduced profile is the one of the sequential run
+	diff <(profile_summary ${TEST_OUTPUT_DIR}/results_sequential.json) <(profile_summary ${TEST_OUTPUT_DIR}/results_mpi.json)
+}
@@ -0,0 +1,13 @@
+LOG_FILE=test_threads.log
+# all locations write to the same files (N-1), a part of the writes is appended to the end of the file
+export SYNTHETIC_OPTIONS="-n 200k --processes 8 --threads 2 --io-rate 0.05 --read-ratio 0.1 --append-rate 0.3 --seed 7"
+
+@test "reading with threads gives the profile of a single-threaded run" {
+	../build/otf2-trace-generator -o ${TEST_OUTPUT_DIR}/synthetic_threads $SYNTHETIC_OPTIONS
+
+	../build/otf-profiler --json --threads 1 -i ${TEST_OUTPUT_DIR}/synthetic_threads/traces.otf2 -o ${TEST_OUTPUT_DIR}/results_threads_1
+	for run in 1 2 3; do
+		../build/otf-profiler --json --threads 4 -i ${TEST_OUTPUT_DIR}/synthetic_threads/traces.otf2 -o ${TEST_OUTPUT_DIR}/results_threads_4
+		diff ${TEST_OUTPUT_DIR}/results_threads_1.json ${TEST_OUTPUT_DIR}/results_threads_4.json
+	done
+}
@@ -0,0 +1,19 @@
+LOG_FILE=test_trace_generator.log
+export SYNTHETIC_OPTIONS="-n 100k --processes 4 --threads 2 --metric-classes 1 --seed 7"
+
+@test "synthetic traces are deterministic" {
+	../build/otf2-trace-generator -o ${TEST_OUTPUT_DIR}/synthetic_a $SYNTHETIC_OPTIONS
+	../build/otf2-trace-generator -o ${TEST_OUTPUT_DIR}/synthetic_b $SYNTHETIC_OPTIONS --writer-threads 4
+
+	# the anchor file holds the trace id generated by OTF2, the definitions and events have to be equal
+	diff -r ${TEST_OUTPUT_DIR}/synthetic_a/traces ${TEST_OUTPUT_DIR}/synthetic_b/traces
+	cmp ${TEST_OUTPUT_DIR}/synthetic_a/traces.def ${TEST_OUTPUT_DIR}/synthetic_b/traces.def
+}
+
+@test "synthetic traces can be profiled" {
+	../build/otf2-trace-generator -o ${TEST_OUTPUT_DIR}/synthetic_profiled $SYNTHETIC_OPTIONS
+	../build/otf-profiler --json -i ${TEST_OUTPUT_DIR}/synthetic_profiled/traces.otf2 -o ${TEST_OUTPUT_DIR}/results_synthetic
+
+	synthetic_files=$( jq -r '[.Files[] | select(.FileName | contains("/synthetic/"))] | length' ${TEST_OUTPUT_DIR}/results_synthetic.json)
+	[ "$synthetic_files" -gt "0" ]
+}
@@ -0,0 +1,204 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "binary_profile.h"
+#include "workflow_profile.h"
+
+using namespace binary_profile;
+
+namespace {
+
+/* Writer with the SAX-interface of rapidjson's Writer, prints every call on a line of its own */
+class TextWriter {
+   public:
+	void StartObject() { out << "{\n"; }
+	void EndObject() { out << "}\n"; }
+	void StartArray() { out << "[\n"; }
+	void EndArray() { out << "]\n"; }
+	void Key(const char* k) { out << "key " << k << "\n"; }
+	void String(const char* s) { out << "string " << s << "\n"; }
+	void Uint(uint32_t u) { out << "uint " << u << "\n"; }
+	void Uint64(uint64_t u) { out << "uint64 " << u << "\n"; }
+	void Double(double d) { out << "double " << d << "\n"; }
+	void Bool(bool b) { out << "bool " << b << "\n"; }
+	void Null() { out << "null\n"; }
+
+	std::ostringstream out;
+};
+
+std::string to_text(const WorkflowProfile& profile) {
+	TextWriter w;
+	profile.WriteProfile(w);
+	return w.out.str();
+}
+
+void fill_profile(WorkflowProfile& profile) {
+	profile.filename         = "traces.otf2";
+	profile.traceID          = 0xabcdef;
+	profile.job_id           = 17;
+	profile.node_count       = 2;
+	profile.process_count    = 4;
+	profile.thread_count     = 8;
+	profile.timer_resolution = 1000000000;
+	profile.parallel_region_time = 300;
+	profile.serial_time          = 20;
+	profile.num_functions        = 5;
+	profile.num_invocations      = 50;
+	profile.time_window          = {1000, 5000};
+	profile.filter_ranks         = "0-3";
+	profile.filter_nodes         = {"node n1", "node n2"};
+	profile.counters["PAPI_TOT_CYC"] = 123456;
+
+	profile.functions_by_paradigm["MPI"].entries  = {{"Count", 10}, {"Time", 99}};
+	profile.messages_by_paradigm["COMPUTE"]       = {};  // paradigm without entries
+	profile.io_ops_by_paradigm["POSIX"].entries   = {{"Bytes", 4096}};
+
+	// two files sharing a parent file, which has a parent of its own
+	auto* grandparent     = new FileInfo();
+	grandparent->filename = "/dev/root";
+	auto* parent          = new FileInfo();
+	parent->filename      = "/data";
+	parent->parentfile    = grandparent;
+	for (const std::string name : {"/data/a.txt", "/data/b.txt"}) {
+		auto& file       = profile.file_data[name];
+		file.filename    = name;
+		file.parentfile  = parent;
+		file.paradigm    = {"POSIX", "ISOC"};
+		file.modes       = {"R", "W"};
+		file.locations   = {0, 3, 7};
+		file.bytes_read  = 100;
+		file.bytes_write = 200;
+		file.time_spent_in_ticks = 42;
+		file.ticks_spent_per_access_pattern[AccessPattern::CONTIGUOUS] = 30;
+		file.iosize_per_access_pattern[AccessPattern::STRIDED]         = 300;
+		file.global_ticks_spent_per_access_pattern[AccessPattern::RANDOM] = 12;
+		file.global_iosize_per_access_pattern[AccessPattern::NONE]       = 1;
+	}
+	profile.file_data["/data/b.txt"].parentfile = nullptr;
+
+	for (OTF2_LocationRef loc : {0, 3}) {
+		auto& info    = profile.location_data[loc];
+		info.location = loc;
+		info.pattern_per_timeinterval[{10, 20}] = AccessPattern::CONTIGUOUS;
+		info.pattern_per_timeinterval[{20, 40 + loc}] = AccessPattern::RANDOM;
+	}
+
+	auto& region = profile.io_per_region["write"];
+	region.region_name           = "write";
+	region.region_begin_src_line = "12";
+	region.region_end_src_line   = "?";
+	region.paradigm              = {"POSIX"};
+	region.modes                 = {"W"};
+	region.bytes_write           = 200;
+	region.time_spent_in_ticks   = 7;
+	region.region_callees_top5   = {{"main", 3}, {"flush", 1}};
+}
+
+/* Location infos are compared separately, their intervals are unordered */
+void expect_same_locations(const WorkflowProfile& loaded, const WorkflowProfile& written) {
+	ASSERT_EQ(loaded.location_data.size(), written.location_data.size());
+	for (const auto& [loc, info] : written.location_data) {
+		ASSERT_EQ(loaded.location_data.count(loc), 1);
+		EXPECT_EQ(loaded.location_data.at(loc).location, info.location);
+		EXPECT_EQ(loaded.location_data.at(loc).pattern_per_timeinterval, info.pattern_per_timeinterval);
+	}
+}
+
+}  // namespace
+
+TEST(BinaryProfile, RoundTrip) {
+	const auto path = testing::TempDir() + "binary_profile_round_trip";
+
+	WorkflowProfile written;
+	fill_profile(written);
+	ASSERT_TRUE(WriteBinaryProfile(written, path));
+
+	Reader reader;
+	ASSERT_TRUE(reader.open(path));
+	EXPECT_EQ(reader.version(), VERSION);
+	WorkflowProfile loaded;
+	ASSERT_TRUE(ReadBinaryProfile(reader, loaded));
+	std::filesystem::remove(path);
+
+	expect_same_locations(loaded, written);
+	loaded.location_data.clear();
+	written.location_data.clear();
+	EXPECT_EQ(to_text(loaded), to_text(written));
+
+	// parent files are restored as chain, shared by the files referring to them
+	const auto& a = loaded.file_data.at("/data/a.txt");
+	ASSERT_NE(a.parentfile, nullptr);
+	EXPECT_EQ(a.parentfile->filename, "/data");
+	ASSERT_NE(a.parentfile->parentfile, nullptr);
+	EXPECT_EQ(a.parentfile->parentfile->filename, "/dev/root");
+	EXPECT_EQ(loaded.file_data.at("/data/b.txt").parentfile, nullptr);
+	EXPECT_EQ(a.locations, written.file_data.at("/data/a.txt").locations);
+}
+
+TEST(BinaryProfile, SectionAccess) {
+	const auto path = testing::TempDir() + "binary_profile_section_access";
+
+	WorkflowProfile written;
+	fill_profile(written);
+	ASSERT_TRUE(WriteBinaryProfile(written, path));
+
+	Reader reader;
+	ASSERT_TRUE(reader.open(path));
+	std::filesystem::remove(path);  // stays mapped
+
+	auto locations = reader.section(SectionID::LOCATIONS);
+	ASSERT_EQ(locations.rows(), 2);
+	auto offsets = locations.column<uint64_t>(locations::INTERVAL_OFFSETS);
+	auto begins  = locations.column<uint64_t>(locations::INTERVAL_BEGIN);
+	auto ends    = locations.column<uint64_t>(locations::INTERVAL_END);
+	ASSERT_EQ(offsets.size, 3);
+	EXPECT_EQ(offsets[1], 2);
+	// intervals are sorted
+	EXPECT_EQ(begins[offsets[1]], 10);
+	EXPECT_EQ(ends[offsets[1] + 1], 43);
+
+	auto regions = reader.section(SectionID::REGIONS);
+	ASSERT_EQ(regions.rows(), 1);
+	EXPECT_EQ(reader.string(regions.column<uint32_t>(regions::NAME)[0]), "write");
+	EXPECT_EQ(reader.string(NO_REF), "");
+
+	// column of a different width or beyond the last column
+	EXPECT_EQ(regions.column<uint64_t>(regions::NAME).values, nullptr);
+	EXPECT_EQ(regions.column<uint32_t>(regions::NR_COLUMNS).values, nullptr);
+	EXPECT_FALSE(reader.has(static_cast<SectionID>(99)));
+	EXPECT_EQ(reader.section(static_cast<SectionID>(99)).rows(), 0);
+}
+
+TEST(BinaryProfile, RejectsInvalidFiles) {
+	const auto path = testing::TempDir() + "binary_profile_invalid";
+
+	WorkflowProfile written;
+	fill_profile(written);
+	ASSERT_TRUE(WriteBinaryProfile(written, path));
+	const auto size = std::filesystem::file_size(path);
+
+	// newer version
+	{
+		std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+		file.seekp(sizeof(MAGIC));
+		uint32_t version = VERSION + 1;
+		file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+	}
+	Reader reader;
+	EXPECT_FALSE(reader.open(path));
+
+	// truncated
+	ASSERT_TRUE(WriteBinaryProfile(written, path));
+	std::filesystem::resize_file(path, size - 8);
+	EXPECT_FALSE(reader.open(path));
+
+	// no binary profile at all
+	std::ofstream(path, std::ios::trunc) << "{\"Trace\": {}}\n";
+	EXPECT_FALSE(reader.open(path));
+	std::filesystem::remove(path);
+
+	EXPECT_FALSE(reader.open(path));
+}
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+#include <map>
+#include <vector>
+#include "data_tree.h"
+
+static std::vector<uint64_t> function_ids(data_tree& tree) {
+	std::vector<uint64_t> ids;
+	for (auto& node : tree)
+		ids.push_back(node.function_id);
+	return ids;
+}
+
+TEST(DataTree, GetAndInsertNode) {
+	data_tree tree;
+	EXPECT_TRUE(tree.begin() == tree.end());
+
+	tree_node* main_node = tree.get_node(1, nullptr);
+	tree_node* child     = tree.get_node(2, main_node);
+
+	EXPECT_EQ(tree.get_node(1, nullptr), main_node);
+	EXPECT_EQ(tree.get_node(2, main_node), child);
+	EXPECT_EQ(tree.find_node(2, main_node), child);
+	EXPECT_EQ(tree.find_node(2, nullptr), nullptr);
+	EXPECT_EQ(tree.insert_node(2, main_node), nullptr);
+	EXPECT_EQ(child->parent, main_node);
+	EXPECT_EQ(tree.size(), 2);
+}
+
+TEST(DataTree, PreOrder) {
+	data_tree  tree;
+	tree_node* a = tree.get_node(10, nullptr);
+	tree_node* b = tree.get_node(20, a);
+	tree.get_node(30, b);
+	tree.get_node(40, a);
+	tree.get_node(50, nullptr);
+	tree.get_node(60, b);
+
+	std::vector<uint64_t> ORDER_SHOULD = {10, 20, 30, 60, 40, 50};
+	EXPECT_EQ(function_ids(tree), ORDER_SHOULD);
+}
+
+TEST(DataTree, ManyNodes) {
+	// exceeds one arena chunk and forces the child table to grow several times
+	data_tree  tree;
+	tree_node* root = tree.get_node(0, nullptr);
+	for (uint64_t i = 1; i <= 10000; ++i)
+		tree.get_node(i, root)->add_data(0, FunctionData{1, i, i});
+
+	EXPECT_EQ(tree.size(), 10001);
+	EXPECT_EQ(root->index, 0);
+	for (uint64_t i = 1; i <= 10000; ++i) {
+		tree_node* node = tree.find_node(i, root);
+		ASSERT_NE(node, nullptr);
+		EXPECT_EQ(node->parent, root);
+		EXPECT_EQ(node->node_data.begin()->second.f_data.incl_time, i);
+	}
+}
+
+TEST(DataTree, PerLocationData) {
+	data_tree  tree;
+	tree_node* node = tree.get_node(1, nullptr);
+
+	node->add_data(7, FunctionData{1, 10, 5});
+	node->add_data(3, FunctionData{2, 20, 10});
+	node->add_data(7, FunctionData{1, 10, 5});
+	node->add_data(3, MessageData{1, 0, 64, 0});
+
+	std::map<uint64_t, uint64_t> counts;
+	for (const auto& it : node->node_data)
+		counts[it.first] = it.second.f_data.count;
+
+	std::map<uint64_t, uint64_t> COUNTS_SHOULD = {{3, 2}, {7, 2}};
+	EXPECT_EQ(counts, COUNTS_SHOULD);
+	EXPECT_EQ(node->node_data.size(), 2);
+	EXPECT_TRUE(node->has_p2p);
+	EXPECT_FALSE(node->has_collop);
+}
+
+TEST(DataTree, SpreadLocationIndices) {
+	// 4096 processes call main, only the first & the last one call the function below it
+	data_tree  tree;
+	tree_node* main = tree.get_node(1, nullptr);
+	for (uint64_t loc = 0; loc < 4096; ++loc)
+		main->add_data(loc, FunctionData{1, 10, 5});
+	tree_node* func = tree.get_node(2, main);
+	func->add_data(4095, FunctionData{1, 10, 5});
+	func->add_data(0, FunctionData{2, 20, 10});
+
+	EXPECT_FALSE(main->node_data.sparse());
+	EXPECT_TRUE(func->node_data.sparse());
+	EXPECT_EQ(func->node_data.size(), 2);
+
+	// iterated in order of the location indices, like the dense array
+	std::vector<std::pair<uint64_t, uint64_t>> counts;
+	for (const auto& it : func->node_data)
+		counts.emplace_back(it.first, it.second.f_data.count);
+	std::vector<std::pair<uint64_t, uint64_t>> COUNTS_SHOULD = {{0, 2}, {4095, 1}};
+	EXPECT_EQ(counts, COUNTS_SHOULD);
+
+	EXPECT_NE(func->node_data.find(4095), nullptr);
+	EXPECT_EQ(func->node_data.find(2000), nullptr);
+	EXPECT_EQ(func->node_data.emplace(0, 0).second, false);
+
+	// dense again once half of the range is used
+	NodeDataArray array;
+	array.emplace(0, 100);
+	array.emplace(999, 1099);
+	EXPECT_TRUE(array.sparse());
+	for (uint32_t i = 1; i < 500; ++i)
+		array.emplace(i * 2, 100 + i * 2);
+	EXPECT_FALSE(array.sparse());
+	EXPECT_EQ(array.size(), 501);
+	uint64_t previous = 0, iterated = 0;
+	for (const auto& it : array) {
+		EXPECT_TRUE(iterated == 0 || it.first > previous);
+		previous = it.first;
+		++iterated;
+	}
+	EXPECT_EQ(iterated, 501);
+	ASSERT_NE(array.find(999), nullptr);
+	EXPECT_EQ(array.find(3), nullptr);
+}
+
+TEST(DataTree, Merge) {
+	data_tree  lhs;
+	tree_node* lhs_a = lhs.get_node(1, nullptr);
+	lhs.get_node(2, lhs_a)->add_data(0, FunctionData{1, 10, 10});
+
+	data_tree  rhs;
+	tree_node* rhs_a = rhs.get_node(1, nullptr);
+	rhs.get_node(2, rhs_a)->add_data(1, FunctionData{3, 30, 30});
+	rhs.get_node(3, rhs_a)->add_data(1, CollopData{1, 1, 8, 8});
+	rhs.get_node(4, nullptr);
+
+	lhs.merge_tree(rhs);
+
+	std::vector<uint64_t> ORDER_SHOULD = {1, 2, 3, 4};
+	EXPECT_EQ(function_ids(lhs), ORDER_SHOULD);
+
+	tree_node* merged = lhs.find_node(2, lhs_a);
+	EXPECT_EQ(merged->node_data.size(), 2);
+	merged->add_data(1, FunctionData{1, 1, 1});
+	EXPECT_EQ(merged->last_data->f_data.count, 4);
+	EXPECT_TRUE(lhs.find_node(3, lhs_a)->has_collop);
+}
+
+TEST(DataTree, SerializeRoundTrip) {
+	data_tree  tree;
+	tree_node* a = tree.get_node(1, nullptr);
+	tree.get_node(2, a)->add_data(4, FunctionData{2, 20, 20});
+	tree.get_node(3, nullptr)->add_data(5, FunctionData{1, 5, 5});
+	tree.get_node(2, a)->add_data(6, CollopData{1, 1, 8, 8});
+	tree.get_node(2, a)->add_data(4, 9, MetricData(MetricDataType::DOUBLE, 0, 0, 2.5));
+
+	SerializedTree serialized;
+	tree.serialize_data(serialized);
+
+	ASSERT_EQ(serialized.nodes.size(), 3);
+	EXPECT_EQ(serialized.nodes[0].parent, SerializedTree::NO_PARENT);
+	EXPECT_EQ(serialized.nodes[1].function_id, 2);
+	EXPECT_EQ(serialized.nodes[1].parent, 0);
+	EXPECT_EQ(serialized.functions.size(), 3);
+	// collop data of all locations of the node with collops
+	EXPECT_EQ(serialized.collops.size(), 2);
+	EXPECT_EQ(serialized.metrics.size(), 1);
+
+	// rebuild the tree like ReduceData does on the receiving rank
+	data_tree rebuilt;
+	ASSERT_TRUE(rebuilt.merge_serialized_data(serialized));
+
+	EXPECT_EQ(function_ids(rebuilt), function_ids(tree));
+	tree_node* rebuilt_b = rebuilt.find_node(2, rebuilt.find_node(1, nullptr));
+	EXPECT_EQ(rebuilt_b->node_data.size(), 2);
+	EXPECT_EQ(rebuilt_b->node_data.begin()->first, 4);
+	EXPECT_TRUE(rebuilt_b->has_collop);
+	EXPECT_FALSE(rebuilt_b->has_p2p);
+	EXPECT_DOUBLE_EQ(rebuilt_b->node_data.begin()->second.metrics.at(9).data_incl.d, 2.5);
+	EXPECT_EQ(rebuilt.find_node(3, nullptr)->node_data.begin()->second.f_data.incl_time, 5);
+
+	// records referring to nodes that don't exist (yet)
+	serialized.nodes[0].parent = 1;
+	EXPECT_FALSE(data_tree().merge_serialized_data(serialized));
+	serialized.nodes[0].parent = SerializedTree::NO_PARENT;
+	serialized.functions[0].node = 3;
+	EXPECT_FALSE(data_tree().merge_serialized_data(serialized));
+}
+
+TEST(DataTree, MergeSerializedInParts) {
+	data_tree tree;
+	tree_node* parent = nullptr;
+	for (uint64_t depth = 0; depth < 10; ++depth) {
+		parent = tree.get_node(depth, parent);
+		parent->add_data(depth % 3, FunctionData{1, depth, depth});
+	}
+
+	SerializedTree serialized;
+	tree.serialize_data(serialized);
+
+	// like ReduceData: chunk by chunk, nodes before the data
+	data_tree            rebuilt;
+	SerializedTreeMerger merger(rebuilt);
+	ASSERT_TRUE(merger.add(serialized.nodes.data(), 4));
+	// data of a node that hasn't been added yet
+	EXPECT_FALSE(merger.add(serialized.functions.data() + 4, 1));
+	ASSERT_TRUE(merger.add(serialized.nodes.data() + 4, 6));
+	ASSERT_TRUE(merger.add(serialized.functions.data(), 5));
+	ASSERT_TRUE(merger.add(serialized.functions.data() + 5, 5));
+
+	EXPECT_EQ(function_ids(rebuilt), function_ids(tree));
+	uint64_t depth = 0;
+	for (auto& node : rebuilt) {
+		ASSERT_EQ(node.node_data.size(), 1);
+		EXPECT_EQ(node.node_data.begin()->first, depth % 3);
+		EXPECT_EQ(node.node_data.begin()->second.f_data.incl_time, depth);
+		++depth;
+	}
+}
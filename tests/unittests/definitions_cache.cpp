@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "definitions_cache.h"
+
+using namespace definitions;
+
+namespace {
+
+/* Definitions as left behind by the global definition callbacks of a small trace */
+void fill_definitions(AllData& alldata, std::vector<LocationDef>& locations) {
+	alldata.metaData.timerResolution = 1000000000;
+	alldata.metaData.globalOffset    = 42;
+	alldata.metaData.communicators[0] = 3;
+
+	auto& defs = alldata.definitions;
+	defs.paradigms.add(1, {"MPI"});
+	defs.io_paradigms.add(0, {"POSIX"});
+	defs.regions.add(0, {"main", 0, 10, 20, "main.c"});
+	defs.regions.add(7, {"write", 1, 0, 0, ""});
+	defs.attributes.add(2, {"Offset", "offset of the access", 4});
+	defs.groups.add(3, {"MPI_COMM_WORLD", 2, 1, {0, 1}});
+
+	auto file = std::make_shared<File>("/tmp/out.txt");
+	file->io_handles = {0, 1};
+	defs.filehandles.emplace(file->file_name, file);
+	defs.iohandles.add(0, {0, file, 0, 5, (uint32_t)-1});
+	defs.iohandles.add(1, {1, file, 0, 5, (uint32_t)-1});
+	defs.iohandles.get(1)->modes.insert("W");
+	// IoHandle with a File of its own, not listed in `filehandles`
+	defs.iohandles.add(2, {2, std::make_shared<File>("/tmp/out.txt"), 0, 5, (uint32_t)-1});
+
+	defs.system_tree.insert_node("machine cluster", 0, SystemClass::MACHINE, (uint32_t)-1);
+	defs.system_tree.insert_node("node n1", 1, SystemClass::NODE, 0);
+	defs.system_tree.insert_node("node n2", 2, SystemClass::NODE, 0);
+	defs.system_tree.insert_node("rank 0", 0, SystemClass::LOCATION_GROUP, 2);
+	defs.system_tree.insert_node("rank 1", 1, SystemClass::LOCATION_GROUP, 1);
+	defs.system_tree.insert_node("Master thread", 0, SystemClass::LOCATION, 0);
+	defs.system_tree.insert_node("Master thread", 1, SystemClass::LOCATION, 1);
+
+	locations = {{0, 0, 100}, {1, 1, 200}};
+}
+
+std::vector<std::string> system_tree_paths(const SystemTree& tree) {
+	std::vector<std::string> paths;
+	for (auto it = tree.begin(); it != tree.end(); ++it) {
+		std::string path = it->data.name;
+		for (auto* parent = it->parent; parent != nullptr; parent = parent->parent)
+			path = parent->data.name + "/" + path;
+		paths.push_back(std::to_string(it->data.node_id) + ":" + path);
+	}
+	return paths;
+}
+
+}  // namespace
+
+TEST(DefinitionsCache, RoundTrip) {
+	const auto path = testing::TempDir() + "definitions_cache_round_trip";
+	const DefinitionsCacheKey key{1234, 5678, true};
+
+	AllData                  written;
+	std::vector<LocationDef> written_locations;
+	fill_definitions(written, written_locations);
+	ASSERT_TRUE(definitions_cache::store(path, key, written, written_locations));
+
+	AllData                  loaded;
+	std::vector<LocationDef> loaded_locations;
+	ASSERT_TRUE(definitions_cache::load(path, key, loaded, loaded_locations));
+	std::filesystem::remove(path);
+
+	EXPECT_EQ(loaded.metaData.timerResolution, 1000000000);
+	EXPECT_EQ(loaded.metaData.globalOffset, 42);
+	EXPECT_EQ(loaded.metaData.communicators, written.metaData.communicators);
+
+	const auto& defs = loaded.definitions;
+	EXPECT_EQ(defs.paradigms.get(1)->name, "MPI");
+	EXPECT_EQ(defs.io_paradigms.get(0)->name, "POSIX");
+	ASSERT_NE(defs.regions.get(0), nullptr);
+	EXPECT_EQ(defs.regions.get(0)->name, "main");
+	EXPECT_EQ(defs.regions.get(0)->file_name, "main.c");
+	EXPECT_EQ(defs.regions.get(0)->end_source_line, 20);
+	EXPECT_EQ(defs.regions.get(7)->name, "write");
+	EXPECT_EQ(defs.attributes.get(2)->description, "offset of the access");
+	EXPECT_EQ(defs.groups.get(3)->members, (std::vector<uint64_t>{0, 1}));
+
+	ASSERT_EQ(defs.filehandles.size(), 1);
+	const auto& file = defs.filehandles.at("/tmp/out.txt");
+	EXPECT_EQ(file->io_handles, (std::vector<OTF2_IoHandleRef>{0, 1}));
+	EXPECT_EQ(defs.iohandles.get(0)->file_handle, file);
+	EXPECT_EQ(defs.iohandles.get(1)->file_handle, file);
+	EXPECT_EQ(defs.iohandles.get(1)->modes, std::set<std::string>{"W"});
+	EXPECT_NE(defs.iohandles.get(2)->file_handle, file);
+	EXPECT_EQ(defs.iohandles.get(2)->file_handle->file_name, "/tmp/out.txt");
+
+	EXPECT_EQ(system_tree_paths(defs.system_tree), system_tree_paths(written.definitions.system_tree));
+	EXPECT_EQ(defs.system_tree.all_level(), written.definitions.system_tree.all_level());
+	ASSERT_NE(loaded.definitions.system_tree.location(1), nullptr);
+	EXPECT_EQ(loaded.definitions.system_tree.location(1)->parent->data.name, "rank 1");
+
+	ASSERT_EQ(loaded_locations.size(), 2);
+	EXPECT_EQ(loaded_locations[1].group, 1);
+	EXPECT_EQ(loaded_locations[1].number_of_events, 200);
+}
+
+TEST(DefinitionsCache, KeyMismatch) {
+	const auto path = testing::TempDir() + "definitions_cache_key_mismatch";
+
+	AllData                  written;
+	std::vector<LocationDef> written_locations;
+	fill_definitions(written, written_locations);
+	ASSERT_TRUE(definitions_cache::store(path, {1234, 5678, true}, written, written_locations));
+
+	// trace was rewritten, or metric definitions were skipped when the cache was written
+	AllData                  loaded;
+	std::vector<LocationDef> loaded_locations;
+	EXPECT_FALSE(definitions_cache::load(path, {1234, 9999, true}, loaded, loaded_locations));
+	EXPECT_FALSE(definitions_cache::load(path, {1234, 5678, false}, loaded, loaded_locations));
+	EXPECT_FALSE(definitions_cache::load(path, {4321, 5678, true}, loaded, loaded_locations));
+	EXPECT_EQ(loaded.definitions.regions.size(), 0);
+	EXPECT_TRUE(loaded_locations.empty());
+
+	// a truncated cache is rejected as well
+	std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+	EXPECT_FALSE(definitions_cache::load(path, {1234, 5678, true}, loaded, loaded_locations));
+	std::filesystem::remove(path);
+
+	EXPECT_FALSE(definitions_cache::load(path, {1234, 5678, true}, loaded, loaded_locations));
+}
+
+TEST(DefinitionsCache, SerializeToBuffer) {
+	const DefinitionsCacheKey key{1234, 0, true};
+
+	AllData                  written;
+	std::vector<LocationDef> written_locations;
+	fill_definitions(written, written_locations);
+
+	// the snapshot as broadcast by rank 0 with --bcast-defs
+	std::string buffer;
+	definitions_cache::serialize(key, written, written_locations, buffer);
+
+	AllData                  decoded;
+	std::vector<LocationDef> decoded_locations;
+	EXPECT_FALSE(definitions_cache::deserialize(std::string_view(buffer).substr(0, buffer.size() - 1), key, decoded,
+	                                            decoded_locations));
+	EXPECT_EQ(decoded.definitions.regions.size(), 0);
+	ASSERT_TRUE(definitions_cache::deserialize(buffer, key, decoded, decoded_locations));
+
+	EXPECT_EQ(decoded.metaData.globalOffset, 42);
+	EXPECT_EQ(decoded.definitions.regions.get(7)->name, "write");
+	EXPECT_EQ(system_tree_paths(decoded.definitions.system_tree), system_tree_paths(written.definitions.system_tree));
+	ASSERT_EQ(decoded_locations.size(), 2);
+	EXPECT_EQ(decoded_locations[0].number_of_events, 100);
+}
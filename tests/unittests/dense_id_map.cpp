@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "dense_id_map.h"
+
+TEST(DenseIdMap, FindAndInsert) {
+	DenseIdMap<uint32_t, std::string> map;
+	EXPECT_EQ(map.find(0), nullptr);
+
+	map[3] = "three";
+	map[0] = "zero";
+	map[3] = "drei";
+
+	ASSERT_NE(map.find(3), nullptr);
+	EXPECT_EQ(*map.find(3), "drei");
+	EXPECT_EQ(*map.find(0), "zero");
+	EXPECT_EQ(map.find(1), nullptr);
+	EXPECT_EQ(map.find(100000), nullptr);
+	EXPECT_EQ(map.size(), 2);
+}
+
+TEST(DenseIdMap, SparseIds) {
+	// ids far outside of the dense range (eg OTF2_UNDEFINED_STRING) must not blow up the vector
+	DenseIdMap<uint32_t, int> map;
+	map[(uint32_t)-1] = 1;
+	map[1u << 30]     = 2;
+	map[5]            = 3;
+
+	EXPECT_EQ(*map.find((uint32_t)-1), 1);
+	EXPECT_EQ(*map.find(1u << 30), 2);
+	EXPECT_EQ(*map.find(5), 3);
+	EXPECT_EQ(map.find(6), nullptr);
+	EXPECT_EQ(map.size(), 3);
+}
+
+TEST(DenseIdMap, SparseIdCoveredLater) {
+	// id 3000 is stored sparse first, later the dense part grows over it
+	DenseIdMap<uint64_t, uint64_t> map;
+	map[3000] = 42;
+	for (uint64_t id = 0; id < 4000; ++id) {
+		if (id != 3000)
+			map[id] = id;
+	}
+
+	EXPECT_EQ(map.size(), 4000);
+	EXPECT_EQ(*map.find(3000), 42);
+	map[3000] += 1;
+	EXPECT_EQ(*map.find(3000), 43);
+	EXPECT_EQ(map.size(), 4000);
+}
+
+TEST(DenseIdMap, ForEach) {
+	DenseIdMap<uint32_t, int> map;
+	map[2]            = 20;
+	map[0]            = 0;
+	map[(uint32_t)-1] = -1;
+
+	std::vector<std::pair<uint32_t, int>> visited;
+	map.for_each([&](uint32_t id, const int& value) { visited.emplace_back(id, value); });
+
+	std::vector<std::pair<uint32_t, int>> VISITED_SHOULD = {{0, 0}, {2, 20}, {(uint32_t)-1, -1}};
+	EXPECT_EQ(visited, VISITED_SHOULD);
+}
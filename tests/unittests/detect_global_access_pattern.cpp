@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "access_pattern_detection.h"
+#include "all_data.h"
+
+using namespace access_pattern_detection;
+
+/* Reference: concatenates the accesses of all handles and sorts them by end time (stable -> ties in handle order) */
+static AnalysisResult detect_by_sorting(const std::vector<IOAccesses>& handles) {
+	std::vector<IoAccess> all;
+	for (const auto& handle : handles)
+		all.insert(all.end(), handle.begin(), handle.end());
+	std::stable_sort(all.begin(), all.end(), [](const IoAccess& a, const IoAccess& b) {
+		return a.end_time_ns < b.end_time_ns;
+	});
+
+	IOAccesses sorted;
+	for (const auto& io : all)
+		sorted.push_back(io);
+	return detect_local_access_pattern(sorted);
+}
+
+static std::vector<const IOAccesses*> pointers(const std::vector<IOAccesses>& handles) {
+	std::vector<const IOAccesses*> result;
+	for (const auto& handle : handles)
+		result.push_back(&handle);
+	return result;
+}
+
+TEST(GlobalAccessPattern, InterleavedWritersAreContiguous) {
+	// N-1: 4 locations write blocks of 10 bytes round robin -> each handle is strided, the file is written contiguously
+	std::vector<IOAccesses> handles(4);
+	for (uint64_t i = 0; i < 8; ++i)
+		for (uint64_t h = 0; h < 4; ++h) {
+			const uint64_t t = 10 * (4 * i + h);
+			handles[h].push_back(IoAccess{t, t + 5, (4 * i + h) * 10, 10, 5, false});
+		}
+
+	for (const auto& handle : handles) {
+		auto local = detect_local_access_pattern(handle);
+		EXPECT_EQ(local.stats_per_pattern[AccessPattern::STRIDED], (PatternStatistics{80, 40}));
+	}
+
+	auto result = detect_global_access_pattern(pointers(handles));
+	std::unordered_map<TimeInterval, AccessPattern, pair_hash> PATTERN_SHOULD = {{std::pair(0, 315), AccessPattern::CONTIGUOUS}};
+	EXPECT_EQ(result.pattern_per_timeinterval, PATTERN_SHOULD);
+	EXPECT_EQ(result.stats_per_pattern[AccessPattern::CONTIGUOUS], (PatternStatistics{320, 160}));
+}
+
+TEST(GlobalAccessPattern, SameAsSortedConcatenation) {
+	// many handles with overlapping timestamps (incl. equal end times across handles) and mixed patterns
+	std::vector<IOAccesses> handles(2000);
+	uint64_t seed = 42;
+	for (size_t h = 0; h < handles.size(); ++h) {
+		uint64_t t = h % 7;
+		for (uint64_t i = 0; i < 3 + h % 5; ++i) {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			t += 1 + (seed >> 60);
+			const uint64_t fpos = h % 3 == 0 ? i * 64 : h % 3 == 1 ? i * 256 : (seed >> 40) % 4096 * 64;
+			handles[h].push_back(IoAccess{t, t + 2, fpos, 64, 2, (seed >> 20) % 17 == 0});
+		}
+	}
+
+	auto merged = detect_global_access_pattern(pointers(handles));
+	auto sorted = detect_by_sorting(handles);
+	EXPECT_EQ(merged.pattern_per_timeinterval, sorted.pattern_per_timeinterval);
+	EXPECT_EQ(merged.stats_per_pattern, sorted.stats_per_pattern);
+}
+
+TEST(GlobalAccessPattern, EmptyAndSingleHandle) {
+	std::vector<IOAccesses> handles(3);
+	EXPECT_TRUE(detect_global_access_pattern(pointers(handles)).pattern_per_timeinterval.empty());
+
+	handles[1] = IOAccesses{
+		IoAccess{0, 3, 0, 5, 3, false},
+		IoAccess{8, 30, 5, 1, 7, false},
+		IoAccess{31, 33, 6, 67, 3, false},
+		IoAccess{100, 130, 73, 5, 14, false},
+	};
+	auto global = detect_global_access_pattern(pointers(handles));
+	auto local  = detect_local_access_pattern(handles[1]);
+	EXPECT_EQ(global.pattern_per_timeinterval, local.pattern_per_timeinterval);
+	EXPECT_EQ(global.stats_per_pattern, local.stats_per_pattern);
+}
+
+TEST(GlobalAccessPattern, FileWithSingleHandleKeepsNoAccesses) {
+	AllData alldata(0, 1);
+	auto single = std::make_shared<definitions::File>("/tmp/single.txt");
+	auto shared = std::make_shared<definitions::File>("/tmp/shared.txt");
+	single->io_handles = {0};
+	shared->io_handles = {1, 2};
+	alldata.definitions.iohandles.add(0, {0, single, 0, 0, (uint32_t)-1});
+	EXPECT_FALSE(single->keeps_io_accesses());
+	EXPECT_TRUE(shared->keeps_io_accesses());
+
+	// only the streaming detector is fed (as by the reader), its result is the global pattern of the file
+	const auto* ioh = alldata.definitions.iohandles.get(0);
+	IOAccesses accesses;
+	for (uint64_t i = 0; i < 40; ++i) {
+		const IoAccess io{i * 10, i * 10 + 5, (i < 20 ? i : 3 * i) * 64, 64, 5, false};
+		ioh->access_pattern_detector.add(io);
+		accesses.push_back(io);
+	}
+
+	auto global = detect_global_access_pattern(alldata, *single);
+	auto local  = detect_local_access_pattern(accesses);
+	EXPECT_FALSE(global.pattern_per_timeinterval.empty());
+	EXPECT_EQ(global.pattern_per_timeinterval, local.pattern_per_timeinterval);
+	EXPECT_EQ(global.stats_per_pattern, local.stats_per_pattern);
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <otf2/OTF2_GeneralDefinitions.h>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include "access_pattern_detection.h"
 
 using namespace access_pattern_detection;
@@ -93,3 +95,134 @@ TEST(AccessPattern, Combined) {
 	EXPECT_EQ(result.pattern_per_timeinterval, CONTIGUOUS_AND_STRIDED);
 	EXPECT_EQ(result.stats_per_pattern, COMBINED_SHOULD_STATS);
 }
+
+TEST(AccessPattern, Streaming) {
+	IOAccesses contiguous_and_strided {
+		IoAccess {0, 3, 1000, 5, 3, false},
+		IoAccess {8, 30, 2000, 1, 7, false},
+		IoAccess {31, 33, 3000, 67, 3, false},
+		IoAccess {100, 130, 4000, 5, 14, false},
+		IoAccess {131, 132, 5000, 10, 27, false},
+		IoAccess {132, 135, 6000, 5, 33, false},
+		IoAccess {137, 139, 0, 5, 3, false},
+		IoAccess {140, 141, 5, 1, 7, false},
+		IoAccess {144, 146, 6, 67, 3, false},
+		IoAccess {147, 148, 73, 5, 14, false},
+		IoAccess {150, 151, 78, 10, 27, false},
+		IoAccess {162, 185, 88, 5, 35, false},
+	};
+
+	// result after each access, as computed by the detection over all accesses before it was streamed
+	using Intervals = std::unordered_map<TimeInterval, AccessPattern, access_pattern_detection::pair_hash>;
+	using Stats     = std::unordered_map<AccessPattern, PatternStatistics>;
+	auto strided_stats = [](PatternStatistics stats) {
+		return Stats{{AccessPattern::NONE, {0, 0}}, {AccessPattern::CONTIGUOUS, {0, 0}},
+		             {AccessPattern::STRIDED, stats}, {AccessPattern::RANDOM, {0, 0}}};
+	};
+	auto switched_stats = [](PatternStatistics stats) {
+		return Stats{{AccessPattern::NONE, {0, 0}}, {AccessPattern::CONTIGUOUS, stats},
+		             {AccessPattern::STRIDED, {93, 87}}, {AccessPattern::RANDOM, {0, 0}}};
+	};
+	auto switched = [](uint64_t end) {
+		return Intervals{{std::pair(0, 135), AccessPattern::STRIDED}, {std::pair(137, end), AccessPattern::CONTIGUOUS}};
+	};
+	const std::vector<std::pair<Intervals, Stats>> SHOULD = {
+		{{{std::pair(0, 3), AccessPattern::NONE}}, {{AccessPattern::NONE, {5, 3}}}},
+		{{{std::pair(0, 30), AccessPattern::NONE}}, {{AccessPattern::NONE, {6, 10}}}},
+		{{{std::pair(0, 33), AccessPattern::STRIDED}}, strided_stats({73, 13})},
+		{{{std::pair(0, 130), AccessPattern::STRIDED}}, strided_stats({78, 27})},
+		{{{std::pair(0, 132), AccessPattern::STRIDED}}, strided_stats({88, 54})},
+		{{{std::pair(0, 135), AccessPattern::STRIDED}}, strided_stats({93, 87})},
+		{{{std::pair(0, 139), AccessPattern::STRIDED}}, strided_stats({98, 90})},
+		{switched(141), switched_stats({6, 10})},
+		{switched(146), switched_stats({73, 13})},
+		{switched(148), switched_stats({78, 27})},
+		{switched(151), switched_stats({88, 54})},
+		{switched(185), switched_stats({93, 89})},
+	};
+	ASSERT_EQ(SHOULD.size(), contiguous_and_strided.size());
+
+	LocalAccessPatternDetector detector;
+	size_t                     n = 0;
+	for (const auto& io : contiguous_and_strided) {
+		detector.add(io);
+
+		auto result = detector.result();
+		EXPECT_EQ(result.pattern_per_timeinterval, SHOULD[n].first) << "after " << n + 1 << " accesses";
+		EXPECT_EQ(result.stats_per_pattern, SHOULD[n].second) << "after " << n + 1 << " accesses";
+		++n;
+	}
+	EXPECT_EQ(detector.size(), contiguous_and_strided.size());
+}
+
+/* Stretches of contiguous, strided and random accesses of random length, with meta operations and equal end times */
+static IOAccesses random_stretches(uint64_t seed, size_t nr_stretches) {
+	IOAccesses accesses;
+	uint64_t t = 0, fpos = 0, size = 64;
+	auto next = [&seed]() { return seed = seed * 6364136223846793005ULL + 1442695040888963407ULL; };
+	for (size_t s = 0; s < nr_stretches; ++s) {
+		const uint64_t pattern = next() >> 62, length = 1 + (next() >> 55), stride = 64 + (next() >> 58) * 64;
+		for (uint64_t i = 0; i < length; ++i) {
+			const uint64_t r = next();
+			t += (r >> 60) % 4 == 0 ? 0 : 1 + (r >> 61);
+			fpos = pattern == 0 ? fpos + size : pattern == 1 ? fpos + stride : pattern == 2 ? (r >> 24) : fpos - stride;
+			size = pattern == 0 && (r >> 40) % 7 == 0 ? 1 + (r >> 56) : size;
+			accesses.push_back(IoAccess {t, t + 1 + (r >> 62), fpos, size, 1 + (r >> 62), (r >> 32) % 29 == 0});
+		}
+	}
+	return accesses;
+}
+
+TEST(AccessPattern, SimdClassificationSameAsScalar) {
+	const IOAccesses accesses = random_stretches(3, 100);
+	// every path the CPU supports, not only the one picked by `classify_accesses`
+	for (auto simd : {ClassifySimd::SSE41, ClassifySimd::AVX2}) {
+		IOAccesses::BlockReader reader(accesses);
+		IoAccessBlock block;
+		while (reader.next(block)) {
+			// also blocks whose length is not a multiple of the vector width
+			for (size_t n : {block.nr_accesses, block.nr_accesses / 3, size_t(5), size_t(2)}) {
+				IoAccessBlock partial = block;
+				partial.nr_accesses = std::min(n, block.nr_accesses);
+				AccessClasses vectorized, scalar;
+				if (!classify_accesses(simd, partial, vectorized))
+					break;
+				classify_accesses_scalar(partial, scalar);
+				for (size_t w = 0; w < AccessClasses::WORDS; ++w) {
+					EXPECT_EQ(vectorized.contiguous[w], scalar.contiguous[w]) << "path " << static_cast<int>(simd);
+					EXPECT_EQ(vectorized.strided[w], scalar.strided[w]) << "path " << static_cast<int>(simd);
+					EXPECT_EQ(vectorized.random[w], scalar.random[w]) << "path " << static_cast<int>(simd);
+				}
+			}
+		}
+	}
+
+	// the dispatching one as well
+	IOAccesses::BlockReader reader(accesses);
+	IoAccessBlock block;
+	while (reader.next(block)) {
+		AccessClasses simd, scalar;
+		classify_accesses(block, simd);
+		classify_accesses_scalar(block, scalar);
+		for (size_t w = 0; w < AccessClasses::WORDS; ++w) {
+			EXPECT_EQ(simd.contiguous[w], scalar.contiguous[w]);
+			EXPECT_EQ(simd.strided[w], scalar.strided[w]);
+			EXPECT_EQ(simd.random[w], scalar.random[w]);
+		}
+	}
+}
+
+TEST(AccessPattern, BlocksSameAsSingleAccesses) {
+	for (uint64_t seed = 1; seed <= 20; ++seed) {
+		const IOAccesses accesses = random_stretches(seed, 40);
+
+		LocalAccessPatternDetector detector;
+		for (const auto& io : accesses)
+			detector.add(io);
+		auto should = detector.result();
+
+		auto result = access_pattern_detection::detect_local_access_pattern(accesses);
+		EXPECT_EQ(result.pattern_per_timeinterval, should.pattern_per_timeinterval);
+		EXPECT_EQ(result.stats_per_pattern, should.stats_per_pattern);
+	}
+}
@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+#include "utils.h"
+
+TEST(IdRanges, Parse) {
+	IdRanges ids;
+	ASSERT_TRUE(ids.parse("0-7,12,20-21"));
+
+	EXPECT_TRUE(ids.selects(0));
+	EXPECT_TRUE(ids.selects(7));
+	EXPECT_FALSE(ids.selects(8));
+	EXPECT_TRUE(ids.selects(12));
+	EXPECT_TRUE(ids.selects(21));
+	EXPECT_FALSE(ids.selects(22));
+	EXPECT_EQ(ids.to_string(), "0-7,12,20-21");
+}
+
+TEST(IdRanges, EmptySelectsAll) {
+	IdRanges ids;
+	EXPECT_TRUE(ids.empty());
+	EXPECT_TRUE(ids.selects(16383));
+}
+
+TEST(IdRanges, Invalid) {
+	IdRanges ids;
+	EXPECT_FALSE(ids.parse(""));
+	EXPECT_FALSE(ids.parse("1,"));
+	EXPECT_FALSE(ids.parse("7-3"));
+	EXPECT_FALSE(ids.parse("-3"));
+	EXPECT_FALSE(ids.parse("1-"));
+	EXPECT_FALSE(ids.parse("a"));
+	EXPECT_FALSE(ids.parse("1x"));
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "io_accesses.h"
+
+static bool operator==(const IoAccess& a, const IoAccess& b) {
+	return a.start_time_ns == b.start_time_ns && a.end_time_ns == b.end_time_ns && a.fpos == b.fpos && a.size == b.size
+		&& a.duration == b.duration && a.is_meta == b.is_meta;
+}
+
+TEST(IOAccesses, RoundTrip) {
+	std::vector<IoAccess> SHOULD {
+		IoAccess {100, 130, 4000, 5, 14, false},
+		IoAccess {131, 132, 4005, 10, 27, false},
+		IoAccess {132, 135, 0, 5, 33, true},
+		// fpos & start time decreasing
+		IoAccess {120, 185, 3, 1ull << 40, 35, false},
+		IoAccess {0, 0, ~0ull, 0, 0, false},
+	};
+	IOAccesses accesses;
+	for (const auto& io : SHOULD)
+		accesses.push_back(io);
+
+	ASSERT_EQ(accesses.size(), SHOULD.size());
+	size_t i = 0;
+	for (const auto& io : accesses)
+		EXPECT_TRUE(io == SHOULD[i++]);
+	EXPECT_EQ(i, SHOULD.size());
+	EXPECT_TRUE(accesses.back() == SHOULD.back());
+}
+
+TEST(IOAccesses, Compression) {
+	// checkpoint-like: equally sized, contiguous writes
+	IOAccesses accesses;
+	const uint64_t NR_ACCESSES = 100000;
+	for (uint64_t i = 0; i < NR_ACCESSES; ++i)
+		accesses.push_back(IoAccess {1000000 + i * 2500, 1000000 + i * 2500 + 1800, i * 4096, 4096, 3600, i % 100 == 0});
+
+	EXPECT_LE(accesses.memory_usage() * 5, NR_ACCESSES * sizeof(IoAccess));
+
+	uint64_t i = 0;
+	for (const auto& io : accesses) {
+		EXPECT_EQ(io.fpos, i * 4096);
+		EXPECT_EQ(io.end_time_ns, 1000000 + i * 2500 + 1800);
+		EXPECT_EQ(io.is_meta, i % 100 == 0);
+		++i;
+	}
+}
+
+TEST(IOAccesses, BlockReader) {
+	// long regular stretches (single-byte varints) mixed with irregular accesses, over several blocks
+	IOAccesses accesses;
+	uint64_t seed = 7, t = 0, fpos = 0;
+	for (uint64_t i = 0; i < 1000; ++i) {
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		const bool irregular = (i / 100) % 2 == 1 && (seed >> 61) == 0;
+		t += irregular ? seed >> 40 : 100;
+		fpos = irregular ? seed >> 20 : fpos + 512;
+		accesses.push_back(IoAccess {t, t + 50, fpos, irregular ? 1 + (seed >> 50) : 512, 50, (seed >> 30) % 13 == 0});
+	}
+
+	IOAccesses::BlockReader reader(accesses);
+	IoAccessBlock block;
+	auto it = accesses.begin();
+	size_t nr_blocks = 0;
+	while (reader.next(block)) {
+		++nr_blocks;
+		for (size_t i = 0; i < block.nr_accesses; ++i, ++it)
+			EXPECT_TRUE(block[i] == *it);
+	}
+	EXPECT_TRUE(it == accesses.end());
+	EXPECT_EQ(nr_blocks, (1000 + IoAccessBlock::CAPACITY - 1) / IoAccessBlock::CAPACITY);
+	EXPECT_EQ(block.nr_accesses, 0);
+}
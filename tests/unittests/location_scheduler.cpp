@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "location_scheduler.h"
+
+TEST(LocationScheduler, LargestFirst) {
+	// location group 3 holds most events -> one worker exclusively reads it
+	LocationScheduler scheduler({10, 20, 5, 100, 15}, 2);
+
+	std::vector<size_t> QUEUE0_SHOULD = {3};
+	std::vector<size_t> QUEUE1_SHOULD = {1, 4, 0, 2};
+	EXPECT_EQ(scheduler.queue(0), QUEUE0_SHOULD);
+	EXPECT_EQ(scheduler.queue(1), QUEUE1_SHOULD);
+	EXPECT_EQ(scheduler.pending_weight(1, 0), 50);
+	EXPECT_EQ(scheduler.pending_weight(1, 2), 15);
+	EXPECT_EQ(scheduler.pending_weight(1, 4), 0);
+}
+
+TEST(LocationScheduler, Stealing) {
+	LocationScheduler   scheduler({10, 20, 5, 100, 15}, 2);
+	LocalSchedulerHeads heads(2);
+	bool                stolen;
+
+	EXPECT_EQ(scheduler.next(0, heads, stolen), 3);
+	EXPECT_FALSE(stolen);
+	// worker 0 ran out of work -> steals pending location groups of worker 1 in its order
+	EXPECT_EQ(scheduler.next(0, heads, stolen), 1);
+	EXPECT_TRUE(stolen);
+	EXPECT_EQ(scheduler.next(1, heads, stolen), 4);
+	EXPECT_FALSE(stolen);
+	EXPECT_EQ(scheduler.next(0, heads, stolen), 0);
+	EXPECT_EQ(scheduler.next(1, heads, stolen), 2);
+	EXPECT_EQ(scheduler.next(0, heads, stolen), std::nullopt);
+	EXPECT_EQ(scheduler.next(1, heads, stolen), std::nullopt);
+}
+
+TEST(LocationScheduler, EveryGroupOnce) {
+	std::vector<uint64_t> weights;
+	for (uint64_t i = 0; i < 1000; ++i)
+		weights.push_back((i * 7919) % 101);
+
+	const uint32_t      NUM_WORKERS = 8;
+	LocationScheduler   scheduler(weights, NUM_WORKERS);
+	LocalSchedulerHeads heads(NUM_WORKERS);
+
+	std::vector<std::vector<size_t>> read(NUM_WORKERS);
+	std::vector<std::thread>         workers;
+	for (uint32_t t = 0; t < NUM_WORKERS; ++t)
+		workers.emplace_back([&, t]() {
+			bool stolen;
+			while (auto group = scheduler.next(t, heads, stolen))
+				read[t].push_back(*group);
+		});
+	for (auto& worker : workers)
+		worker.join();
+
+	std::vector<size_t> all;
+	for (const auto& r : read)
+		all.insert(all.end(), r.begin(), r.end());
+	std::sort(all.begin(), all.end());
+
+	ASSERT_EQ(all.size(), weights.size());
+	for (size_t i = 0; i < all.size(); ++i)
+		EXPECT_EQ(all[i], i);
+}
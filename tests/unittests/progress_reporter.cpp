@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "progress_reporter.h"
+
+TEST(ProgressReporter, Format) {
+	// 1 KiB per event
+	ProgressReporter progress(1000000, 1024);
+
+	EXPECT_EQ(progress.format(250000, 10), "OTF2: 25.0% of 1000000 events, 25000 events/s, 24.4 MB/s, ETA 0:00:30");
+	EXPECT_EQ(progress.format(1000, 10), "OTF2: 0.1% of 1000000 events, 100 events/s, 0.1 MB/s, ETA 2:46:30");
+	// no ETA once done or before the first events are read
+	EXPECT_EQ(progress.format(1000000, 40), "OTF2: 100.0% of 1000000 events, 25000 events/s, 24.4 MB/s");
+	EXPECT_EQ(progress.format(0, 0), "OTF2: 0.0% of 1000000 events, 0 events/s, 0.0 MB/s");
+
+	EXPECT_EQ(progress.format_summary(1000000, 40), "OTF2: read 1000000 events in 40.0 s (25000 events/s, 24.4 MB/s)");
+}
+
+TEST(ProgressReporter, UnknownEventSize) {
+	ProgressReporter progress(100, 0);
+	EXPECT_EQ(progress.format(50, 5), "OTF2: 50.0% of 100 events, 10 events/s, ETA 0:00:05");
+}
+
+TEST(ProgressReporter, ConcurrentBatches) {
+	ProgressReporter progress(4 * 1000 * 64, 0, 3600);
+
+	std::vector<std::thread> readers;
+	for (int t = 0; t < 4; ++t)
+		readers.emplace_back([&]() {
+			for (int batch = 0; batch < 1000; ++batch)
+				progress.add(64);
+		});
+	for (auto& reader : readers)
+		reader.join();
+
+	EXPECT_EQ(progress.events_processed(), 4 * 1000 * 64);
+	// first report only after the interval
+	EXPECT_FALSE(progress.report_due());
+}
+
+TEST(ProgressReporter, ReportDueOncePerInterval) {
+	ProgressReporter progress(100, 0, 0.02);
+	EXPECT_FALSE(progress.report_due(0));
+	EXPECT_FALSE(progress.report_due(19));
+
+	EXPECT_TRUE(progress.report_due(30));
+	EXPECT_FALSE(progress.report_due(30));
+	// the next interval starts at the report
+	EXPECT_FALSE(progress.report_due(49));
+	EXPECT_TRUE(progress.report_due(50));
+}
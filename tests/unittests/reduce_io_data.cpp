@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+#include "all_data.h"
+#include "reduce_io_data.h"
+
+using namespace definitions;
+
+namespace {
+
+/* Both ranks know all IoHandles, since the definitions are read by every rank */
+void define_io_handles(AllData& alldata) {
+	auto file = std::make_shared<File>("/tmp/out.txt");
+	file->io_handles = {0, 1, 2};
+	alldata.definitions.filehandles.emplace(file->file_name, file);
+	for (OTF2_IoHandleRef id : {0, 1, 2})
+		alldata.definitions.iohandles.add(id, {id, file, 0, 5, (uint32_t)-1});
+}
+
+/* Contiguous writes of 4 KiB on `ioh`, starting at `fpos` */
+void write_contiguous(const IoHandle& ioh, uint64_t t, uint64_t fpos, uint64_t nr_writes) {
+	for (uint64_t i = 0; i < nr_writes; ++i) {
+		IoAccess io {t + i * 100, t + i * 100 + 50, fpos + i * 4096, 4096, 50, false};
+		ioh.access_pattern_detector.add(io);
+		ioh.io_accesses.push_back(io);
+		IoData stats(ioh.self);
+		stats.num_operations = 1;
+		stats.num_bytes      = 4096;
+		stats.transfer_time  = 50;
+		ioh.io_data_stats += stats;
+	}
+	ioh.modes.insert("W");
+}
+
+IoData io_data(uint64_t num_operations, uint64_t num_bytes) {
+	IoData data;
+	data.num_operations   = num_operations;
+	data.num_bytes        = num_bytes;
+	data.transfer_time    = 10;
+	data.nontransfer_time = 1;
+	return data;
+}
+
+}  // namespace
+
+TEST(ReduceIoData, MergesWorkerData) {
+	AllData master(0, 2), worker(1, 2);
+	define_io_handles(master);
+	define_io_handles(worker);
+
+	// IoHandle 0 is used on both ranks, 1 only on the worker & 2 on none
+	write_contiguous(*master.definitions.iohandles.get(0), 0, 0, 20);
+	master.definitions.iohandles.get(0)->location = 0;
+	write_contiguous(*worker.definitions.iohandles.get(0), 10000, 20 * 4096, 30);
+	write_contiguous(*worker.definitions.iohandles.get(1), 500, 0, 15);
+	worker.definitions.iohandles.get(1)->location = 3;
+
+	master.io_data_per_paradigm[1]  = io_data(20, 20 * 4096);
+	worker.io_data_per_paradigm[1]  = io_data(45, 45 * 4096);
+	worker.io_data_per_paradigm[2]  = io_data(1, 8);
+	worker.io_data_per_location[3]  = io_data(45, 45 * 4096);
+	master.parent_regions_by_callcount[7][1] = 2;
+	worker.parent_regions_by_callcount[7][1] = 3;
+	worker.parent_regions_by_callcount[8][7] = 1;
+
+	const auto worker_result = worker.definitions.iohandles.get(1)->get_local_access_pattern_stats();
+	const auto master_stats  = master.definitions.iohandles.get(0)->get_local_access_pattern_stats().stats_per_pattern;
+	const auto worker_stats  = worker.definitions.iohandles.get(0)->get_local_access_pattern_stats().stats_per_pattern;
+
+	std::vector<uint8_t> buffer;
+	serialize_io_data(worker, buffer);
+	ASSERT_TRUE(merge_io_data(master, buffer.data(), buffer.size()));
+
+	EXPECT_EQ(master.io_data_per_paradigm[1].num_operations, 65);
+	EXPECT_EQ(master.io_data_per_paradigm[2].num_bytes, 8);
+	EXPECT_EQ(master.io_data_per_location[3].num_operations, 45);
+	EXPECT_EQ(master.parent_regions_by_callcount[7][1], 5);
+	EXPECT_EQ(master.parent_regions_by_callcount[8][7], 1);
+
+	// IoHandle used on both ranks: sums & the accesses of the worker after the ones of the master
+	const IoHandle& both = *master.definitions.iohandles.get(0);
+	EXPECT_EQ(both.io_data_stats.num_operations, 50);
+	EXPECT_EQ(both.io_data_stats.num_bytes, 50 * 4096);
+	EXPECT_EQ(both.location, 0);
+	ASSERT_EQ(both.io_accesses.size(), 50);
+	EXPECT_EQ(both.io_accesses.back().start_time_ns, 10000 + 29 * 100);
+	EXPECT_EQ(both.io_accesses.back().fpos, 49 * 4096);
+	for (const auto& [pattern, stats] : both.get_local_access_pattern_stats().stats_per_pattern) {
+		const auto expected_ticks = (master_stats.count(pattern) ? master_stats.at(pattern).ticks_spent : 0)
+			+ (worker_stats.count(pattern) ? worker_stats.at(pattern).ticks_spent : 0);
+		EXPECT_EQ(stats.ticks_spent, expected_ticks);
+	}
+
+	// IoHandle only used on the worker: taken over as is
+	const IoHandle& worker_only = *master.definitions.iohandles.get(1);
+	EXPECT_EQ(worker_only.io_data_stats.num_operations, 15);
+	EXPECT_EQ(worker_only.location, 3);
+	EXPECT_EQ(worker_only.modes, std::set<std::string>{"W"});
+	EXPECT_EQ(worker_only.io_accesses.size(), 15);
+	const auto result = worker_only.get_local_access_pattern_stats();
+	EXPECT_EQ(result.pattern_per_timeinterval, worker_result.pattern_per_timeinterval);
+	EXPECT_EQ(result.stats_per_pattern.size(), worker_result.stats_per_pattern.size());
+
+	const IoHandle& unused = *master.definitions.iohandles.get(2);
+	EXPECT_FALSE(unused.location.has_value());
+	EXPECT_TRUE(unused.io_accesses.empty());
+}
+
+TEST(ReduceIoData, RejectsCorruptedData) {
+	AllData master(0, 2), worker(1, 2);
+	define_io_handles(master);
+	define_io_handles(worker);
+	write_contiguous(*worker.definitions.iohandles.get(1), 0, 0, 10);
+	worker.io_data_per_paradigm[1] = io_data(10, 10 * 4096);
+
+	std::vector<uint8_t> buffer;
+	serialize_io_data(worker, buffer);
+
+	EXPECT_FALSE(merge_io_data(master, buffer.data(), buffer.size() - 1));
+
+	// trailing bytes
+	AllData master2(0, 2);
+	define_io_handles(master2);
+	buffer.push_back(0);
+	EXPECT_FALSE(merge_io_data(master2, buffer.data(), buffer.size()));
+	buffer.pop_back();
+
+	// IoHandle the master doesn't know
+	AllData master3(0, 2);
+	EXPECT_FALSE(merge_io_data(master3, buffer.data(), buffer.size()));
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "utils.h"
+
+TEST(TimeMeasurement, NestedScopes) {
+	TimeMeasurement tm;
+	tm.registerScope(ScopeID::TOTAL, "total");
+	tm.registerScope(ScopeID::COLLECT, "collect");
+	tm.registerScope(ScopeID::DEFINITIONS, "definitions");
+	tm.registerScope(ScopeID::EVENTS, "events");
+	tm.registerScope(ScopeID::JSON, "json");
+
+	tm.start(ScopeID::TOTAL);
+	tm.start(ScopeID::COLLECT);
+	tm.start(ScopeID::DEFINITIONS);
+	tm.stop(ScopeID::DEFINITIONS);
+	tm.start(ScopeID::EVENTS);
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	tm.stop(ScopeID::EVENTS);
+	tm.stop(ScopeID::COLLECT);
+	tm.start(ScopeID::JSON);
+	// not registered -> not measured
+	tm.start(ScopeID::DOT);
+	tm.stop(ScopeID::DOT);
+
+	std::vector<std::pair<std::string, int>> visited;
+	tm.forEachScope([&](ScopeID, const TimeMeasurement::Scope& scope) {
+		visited.emplace_back(scope.desc, scope.depth);
+	});
+	std::vector<std::pair<std::string, int>> VISITED_SHOULD = {
+		{"total", 0}, {"collect", 1}, {"definitions", 2}, {"events", 2}, {"json", 1}};
+	EXPECT_EQ(visited, VISITED_SHOULD);
+
+	EXPECT_EQ(*tm.getScope(ScopeID::EVENTS).parent, ScopeID::COLLECT);
+	EXPECT_EQ(*tm.getScope(ScopeID::JSON).parent, ScopeID::TOTAL);
+	EXPECT_FALSE(tm.getScope(ScopeID::TOTAL).parent.has_value());
+
+	EXPECT_GE(tm.getScope(ScopeID::EVENTS).seconds(), 0.005);
+	EXPECT_GE(tm.getScope(ScopeID::COLLECT).seconds(), tm.getScope(ScopeID::EVENTS).seconds());
+	EXPECT_TRUE(tm.getScope(ScopeID::JSON).running);
+	EXPECT_FALSE(tm.getScope(ScopeID::COLLECT).running);
+	EXPECT_GT(tm.getScope(ScopeID::COLLECT).peak_rss, 0);
+}
+
+TEST(TimeMeasurement, RepeatedScope) {
+	TimeMeasurement tm;
+	tm.registerScope(ScopeID::REDUCE, "reduce");
+
+	for (int i = 0; i < 3; ++i) {
+		tm.start(ScopeID::REDUCE);
+		tm.stop(ScopeID::REDUCE);
+	}
+	// stopping a scope that isn't running is ignored
+	tm.stop(ScopeID::REDUCE);
+
+	EXPECT_EQ(tm.getScope(ScopeID::REDUCE).count, 3);
+}
+
+TEST(CallbackProfile, Sampling) {
+	CallbackProfile profile;
+	for (int i = 0; i < 1000; ++i)
+		CallbackTimer timer(profile, CallbackID::ENTER);
+	EXPECT_EQ(profile.counters[static_cast<size_t>(CallbackID::ENTER)].count, 0);
+
+	profile.enabled = true;
+	for (int i = 0; i < 1000; ++i)
+		CallbackTimer timer(profile, CallbackID::ENTER);
+	{ CallbackTimer timer(profile, CallbackID::IO_OPERATION_COMPLETE); }
+
+	const auto& enter = profile.counters[static_cast<size_t>(CallbackID::ENTER)];
+	EXPECT_EQ(enter.count, 1000);
+	// invocation 0, 64, .., 960
+	EXPECT_EQ(enter.samples, 16);
+	EXPECT_EQ(profile.counters[static_cast<size_t>(CallbackID::IO_OPERATION_COMPLETE)].samples, 1);
+
+	CallbackProfile other;
+	other.merge(profile);
+	other.merge(profile);
+	EXPECT_EQ(other.counters[static_cast<size_t>(CallbackID::ENTER)].count, 2000);
+	EXPECT_EQ(other.counters[static_cast<size_t>(CallbackID::ENTER)].samples, 32);
+	EXPECT_STREQ(callbackName(CallbackID::IO_OPERATION_COMPLETE), "IoOperationComplete");
+}
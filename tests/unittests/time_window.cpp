@@ -0,0 +1,30 @@
+#include <gtest/gtest.h>
+#include "utils.h"
+
+TEST(TimeBound, Seconds) {
+	TimeBound bound;
+	ASSERT_TRUE(bound.parse("1.5"));
+	EXPECT_TRUE(bound.set);
+	EXPECT_FALSE(bound.in_ticks);
+	// 1.5 s at 1 GHz after the start of the trace
+	EXPECT_EQ(bound.resolve(1000000000, 500), 1500000500);
+}
+
+TEST(TimeBound, Ticks) {
+	TimeBound bound;
+	ASSERT_TRUE(bound.parse("123456t"));
+	EXPECT_TRUE(bound.in_ticks);
+	// raw ticks are absolute timestamps
+	EXPECT_EQ(bound.resolve(1000000000, 500), 123456);
+}
+
+TEST(TimeBound, Invalid) {
+	TimeBound bound;
+	EXPECT_FALSE(bound.parse(""));
+	EXPECT_FALSE(bound.parse("t"));
+	EXPECT_FALSE(bound.parse("abc"));
+	EXPECT_FALSE(bound.parse("12s"));
+	EXPECT_FALSE(bound.parse("-3"));
+	EXPECT_FALSE(bound.parse("-3t"));
+	EXPECT_FALSE(bound.set);
+}